@@ -0,0 +1,46 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+// Lighting subpass of the merged deferred render pass, the G-buffer is read from input attachments
+layout (input_attachment_index = 0, set = 0, binding = 0) uniform subpassInput depthInput;
+layout (input_attachment_index = 1, set = 0, binding = 1) uniform subpassInput normalInput;
+layout (input_attachment_index = 2, set = 0, binding = 2) uniform subpassInput albedoInput;
+layout (set = 0, binding = 3) uniform sampler2D shadowMap;
+
+#define CLUSTER_SET 2
+#include "lighting.glsl"
+#include "packing.glsl"
+
+layout (set = 1, binding = 0) uniform UBO {
+    mat4 inverseViewProjection;
+    vec3 viewPosition;
+    DirectionLightParams directionLight;
+} ubo;
+
+layout(push_constant) uniform Push {
+    mat4 lightSpaceMatrix;
+} push;
+
+layout (location = 0) in vec2 inUV;
+
+layout (location = 0) out vec4 outColor;
+
+void main() {
+    vec3 fragPos = reconstructPosition(inUV, subpassLoad(depthInput).r, ubo.inverseViewProjection);
+    vec3 normal = octDecode(subpassLoad(normalInput).rg);
+    vec4 albedo = subpassLoad(albedoInput); // alpha is the specular intensity
+    vec3 viewDir = normalize(ubo.viewPosition - fragPos);
+
+    vec4 fragPosLightSpace = push.lightSpaceMatrix * vec4(fragPos, 1.0);
+
+    // 1. Calculate direction light
+    vec3 result = vec3(ambientIntensity) + calcDirLight(ubo.directionLight, normal, viewDir, albedo.a);
+
+    // 2. Calculate point lights affecting the cluster of this fragment
+    result += calcClusteredPointLights(inUV, fragPos, normal, viewDir, albedo.a);
+
+    // 3. Shadows
+    float shadow = calcShadows(fragPosLightSpace, normal, normalize(ubo.directionLight.direction));
+
+    outColor = vec4((1.0 + ambientIntensity - shadow) * albedo.rgb * result, 1.0);
+}
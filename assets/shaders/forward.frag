@@ -0,0 +1,54 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : enable
+#extension GL_GOOGLE_include_directive : require
+
+layout(set = 1, binding = 0) uniform sampler2D vGlobalTextures[];
+layout(set = 2, binding = 0) uniform sampler2D shadowMap;
+
+#define CLUSTER_SET 3
+#include "lighting.glsl"
+
+layout(set = 0, binding = 0) uniform UniformBufferObject {
+    mat4 view;
+    mat4 proj;
+    mat4 lightSpaceMatrix;
+    vec3 viewPosition;
+    DirectionLightParams directionLight;
+    vec2 invScreenSize;
+} ubo;
+
+layout(push_constant) uniform Push {
+    mat4 modelMatrix;
+    vec3 color;
+    uint diffuseTexIndex;
+    uint normalMapIndex;
+} push;
+
+layout(location = 0) in vec2 fragTexCoord;
+layout(location = 1) in vec3 fragPosWorld;
+layout(location = 2) in mat3 fragTBN;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    // Material
+    vec3 normal = texture(vGlobalTextures[int(push.normalMapIndex)], fragTexCoord).rgb;
+    normal = normal * 2.0 - 1.0;
+    normal = normalize(fragTBN * normal);
+
+    vec3 albedo = texture(vGlobalTextures[int(push.diffuseTexIndex)], fragTexCoord).rgb;
+    vec3 viewDir = normalize(ubo.viewPosition - fragPosWorld);
+
+    vec4 fragPosLightSpace = ubo.lightSpaceMatrix * vec4(fragPosWorld, 1.0);
+
+    // 1. Calculate direction light
+    vec3 result = vec3(ambientIntensity) + calcDirLight(ubo.directionLight, normal, viewDir, 1.0);
+
+    // 2. Calculate point lights affecting the cluster of this fragment
+    result += calcClusteredPointLights(gl_FragCoord.xy * ubo.invScreenSize, fragPosWorld, normal, viewDir, 1.0);
+
+    // 3. Shadows
+    float shadow = calcShadows(fragPosLightSpace, normal, normalize(ubo.directionLight.direction));
+
+    outColor = vec4((1.0 + ambientIntensity - shadow) * albedo * result, 1.0);
+}
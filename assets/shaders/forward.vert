@@ -0,0 +1,46 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "packing.glsl"
+
+layout(set = 0, binding = 0) uniform UniformBufferObject {
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+layout(push_constant) uniform Push {
+    mat4 modelMatrix;
+    vec3 color;
+    uint diffuseTexIndex;
+    uint normalMapIndex;
+} push;
+
+// NOTE: Must match Vertex3D
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec2 inNormal; // octahedral
+layout(location = 2) in vec2 inTangent; // octahedral, y carries the bitangent sign
+layout(location = 3) in vec2 inTexCoord;
+
+layout(location = 0) out vec2 fragTexCoord;
+layout(location = 1) out vec3 fragPosWorld;
+layout(location = 2) out mat3 fragTBN;
+
+// The depth pre-pass and the shading pass must produce bit-identical depth values
+invariant gl_Position;
+
+void main() {
+    vec4 positionWorld = push.modelMatrix * vec4(inPosition, 1.0);
+    gl_Position = ubo.proj * ubo.view * positionWorld;
+
+    fragTexCoord = inTexCoord;
+    fragPosWorld = positionWorld.xyz;
+
+    // Tangent space calculations
+    vec3 normal, tangent, biTangent;
+    decodeTangentFrame(inNormal, inTangent, normal, tangent, biTangent);
+
+    vec3 T = normalize(vec3(push.modelMatrix * vec4(tangent, 0.0)));
+    vec3 B = normalize(vec3(push.modelMatrix * vec4(biTangent, 0.0)));
+    vec3 N = normalize(vec3(push.modelMatrix * vec4(normal, 0.0)));
+    fragTBN = mat3(T, B, N);
+}
@@ -1,47 +1,52 @@
 #version 450
 #extension GL_EXT_nonuniform_qualifier : enable
+#extension GL_GOOGLE_include_directive : require
 
-struct PointLightParams {
-    vec3 position;
-    vec4 color; // w component is intensity
-};
+#include "packing.glsl"
 
 layout(set = 0, binding = 0) uniform UniformBufferObject {
     mat4 view;
-    mat4 proj;
+    mat4 proj; // jittered when upsampling temporally
+    mat4 viewProjection; // unjittered
+    mat4 previousViewProjection;
 } ubo;
 
 layout(set = 1, binding = 0) uniform sampler2D vGlobalTextures[];
 
-layout(push_constant) uniform Push {
+struct DrawData {
     mat4 modelMatrix;
-	vec3 color;
+    vec3 color;
     uint diffuseTexIndex;
     uint normalMapIndex;
-} push;
+};
+
+layout(std430, set = 0, binding = 1) readonly buffer DrawBuffer {
+    DrawData draws[];
+} drawBuffer;
 
 layout(location = 0) in vec2 fragTexCoord;
-layout(location = 1) in vec3 fragPosWorld;
-layout(location = 2) in mat3 fragTBN;
+layout(location = 1) in mat3 fragTBN;
+layout(location = 4) in vec4 fragCurrentPosition;
+layout(location = 5) in vec4 fragPreviousPosition;
+layout(location = 6) flat in uint fragDrawIndex;
 
-layout(location = 0) out vec4 outPosition;
-layout(location = 1) out vec4 outNormal;
-layout(location = 2) out vec4 outDiffuse;
-layout(location = 3) out vec4 outSpecular;
+// NOTE: Position is reconstructed from depth in the lighting pass
+layout(location = 0) out vec2 outNormal;
+layout(location = 1) out vec4 outDiffuse;
+layout(location = 2) out vec2 outMotion; // discarded when the pass has no motion vector target
 
 void main() {
-    // Position buffer
-    outPosition = vec4(fragPosWorld, 1.0);
-    
-    // Normal buffer
-    vec3 surfaceNormal = texture(vGlobalTextures[int(push.normalMapIndex)], fragTexCoord).rgb;
+    DrawData draw = drawBuffer.draws[fragDrawIndex];
+
+    // Normal buffer (octahedral encoding)
+    vec3 surfaceNormal = texture(vGlobalTextures[int(draw.normalMapIndex)], fragTexCoord).rgb;
     surfaceNormal = surfaceNormal * 2.0 - 1.0;
     surfaceNormal = normalize(fragTBN * surfaceNormal);
-    outNormal = vec4(surfaceNormal, 1.0);
+    outNormal = octEncode(surfaceNormal);
 
-    // Diffuse buffer
-    outDiffuse = texture(vGlobalTextures[int(push.diffuseTexIndex)], fragTexCoord);
+    // Diffuse buffer, alpha holds the specular intensity
+    outDiffuse = vec4(texture(vGlobalTextures[int(draw.diffuseTexIndex)], fragTexCoord).rgb, 1.0);
 
-    // Specular buffer
-    outSpecular = vec4(1.0);
+    // Motion from the previous frame in UV units
+    outMotion = (fragCurrentPosition.xy / fragCurrentPosition.w - fragPreviousPosition.xy / fragPreviousPosition.w) * 0.5;
 }
\ No newline at end of file
@@ -1,42 +1,58 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 
-struct PointLightParams {
-    vec3 position;
-    vec4 color; // w component is intensity
-};
+#include "packing.glsl"
 
 layout(set = 0, binding = 0) uniform UniformBufferObject {
     mat4 view;
-    mat4 proj;
+    mat4 proj; // jittered when upsampling temporally
+    mat4 viewProjection; // unjittered
+    mat4 previousViewProjection;
 } ubo;
 
-layout(push_constant) uniform Push {
+struct DrawData {
     mat4 modelMatrix;
     vec3 color;
     uint diffuseTexIndex;
     uint normalMapIndex;
-} push;
+};
+
+// Indexed by the first instance of the draw, so recorded draws do not change with transforms
+layout(std430, set = 0, binding = 1) readonly buffer DrawBuffer {
+    DrawData draws[];
+} drawBuffer;
 
+// NOTE: Must match Vertex3D
 layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inNormal;
-layout(location = 2) in vec3 inTangent;
-layout(location = 3) in vec3 inBiTangent;
-layout(location = 4) in vec2 inTexCoord;
+layout(location = 1) in vec2 inNormal; // octahedral
+layout(location = 2) in vec2 inTangent; // octahedral, y carries the bitangent sign
+layout(location = 3) in vec2 inTexCoord;
 
 layout(location = 0) out vec2 fragTexCoord;
-layout(location = 1) out vec3 fragPosWorld;
-layout(location = 2) out mat3 fragTBN;
+layout(location = 1) out mat3 fragTBN;
+layout(location = 4) out vec4 fragCurrentPosition;
+layout(location = 5) out vec4 fragPreviousPosition;
+layout(location = 6) flat out uint fragDrawIndex;
 
 void main() {
-    vec4 positionWorld = push.modelMatrix * vec4(inPosition, 1.0);
+    mat4 modelMatrix = drawBuffer.draws[gl_InstanceIndex].modelMatrix;
+    fragDrawIndex = uint(gl_InstanceIndex);
+
+    vec4 positionWorld = modelMatrix * vec4(inPosition, 1.0);
     gl_Position = ubo.proj * ubo.view * positionWorld;
 
+    // NOTE: Only camera motion, objects are assumed static between frames
+    fragCurrentPosition = ubo.viewProjection * positionWorld;
+    fragPreviousPosition = ubo.previousViewProjection * positionWorld;
+
     fragTexCoord = inTexCoord;
-    fragPosWorld = positionWorld.xyz;
 
     // Tangent space calculations
-    vec3 T = normalize(vec3(push.modelMatrix * vec4(inTangent, 0.0)));
-    vec3 B = normalize(vec3(push.modelMatrix * vec4(inBiTangent, 0.0)));
-    vec3 N = normalize(vec3(push.modelMatrix * vec4(inNormal, 0.0)));
+    vec3 normal, tangent, biTangent;
+    decodeTangentFrame(inNormal, inTangent, normal, tangent, biTangent);
+
+    vec3 T = normalize(vec3(modelMatrix * vec4(tangent, 0.0)));
+    vec3 B = normalize(vec3(modelMatrix * vec4(biTangent, 0.0)));
+    vec3 N = normalize(vec3(modelMatrix * vec4(normal, 0.0)));
     fragTBN = mat3(T, B, N);
 }
\ No newline at end of file
@@ -0,0 +1,148 @@
+// Shared lighting functions for the deferred and forward shading paths.
+// The including shader must declare a sampler2D named "shadowMap" before including this file,
+// and may define CLUSTER_SET to choose the descriptor set holding the light clusters.
+
+#ifndef CLUSTER_SET
+#define CLUSTER_SET 2
+#endif
+
+struct DirectionLightParams {
+    vec3 direction;
+    vec3 color;
+};
+
+struct PointLightParams {
+    vec4 positionRadius; // w component is the radius of influence
+    vec4 color; // w component is intensity
+};
+
+layout (set = CLUSTER_SET, binding = 0) uniform ClusterParams {
+    mat4 view;
+    mat4 inverseProjection;
+    uvec4 gridSize; // w component is the point light count
+    float zNear;
+    float zFar;
+} clusterParams;
+
+layout (std430, set = CLUSTER_SET, binding = 1) readonly buffer LightBuffer {
+    PointLightParams lights[];
+};
+
+layout (std430, set = CLUSTER_SET, binding = 2) readonly buffer LightGrid {
+    uvec2 lightGrid[]; // x = offset into light indices, y = light count
+};
+
+layout (std430, set = CLUSTER_SET, binding = 3) readonly buffer LightIndices {
+    uint lightIndices[];
+};
+
+// Quality switches, specialized per pipeline variant (see getLightingPermutation()) so the branches on them
+// are compiled out. The constant IDs must match the C++ side.
+layout (constant_id = 0) const bool USE_PCF = true;
+layout (constant_id = 1) const int PCF_RADIUS = 1; // (2 * PCF_RADIUS + 1)^2 shadow map taps
+layout (constant_id = 2) const float ambientIntensity = 0.3;
+
+float calcShadowPCF(vec3 projCoords, float currentDepth, float bias) {
+    float shadow = 0.0;
+    vec2 texelSize = 1.0 / textureSize(shadowMap, 0);
+
+    for(int x = -PCF_RADIUS; x <= PCF_RADIUS; ++x)
+    {
+        for(int y = -PCF_RADIUS; y <= PCF_RADIUS; ++y)
+        {
+            float pcfDepth = texture(shadowMap, projCoords.xy + vec2(x, y) * texelSize).r; 
+            shadow += currentDepth - bias > pcfDepth  ? 1.0 : 0.0;        
+        }    
+    }
+
+    shadow /= float((2 * PCF_RADIUS + 1) * (2 * PCF_RADIUS + 1));
+
+    return shadow;
+}
+
+float calcShadows(vec4 fragPosLightSpace, vec3 normal, vec3 lightDir) {
+    vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
+    projCoords = vec3(projCoords.xy * 0.5 + 0.5, projCoords.z);
+
+    float closestDepth = texture(shadowMap, projCoords.xy).r;
+    float currentDepth = projCoords.z;
+
+    float bias = max(0.05 * (1.0 - dot(normal, lightDir)), 0.005);
+    float shadow = 0.0;
+
+    if (USE_PCF) {
+        shadow = calcShadowPCF(projCoords, currentDepth, bias);
+    }
+    else {
+        shadow = currentDepth - bias > closestDepth ? 1.0 : 0.0;
+    }
+
+    if (projCoords.z > 1.0) {
+        shadow = 0.0;
+    }
+
+    return shadow;
+}
+
+vec3 calcDirLight(DirectionLightParams light, vec3 normal, vec3 viewDir, float specularIntensity) {
+    vec3 lightDir = normalize(light.direction);
+
+    // 1. Diffuse lighting
+    float diffuse = max(dot(normal, lightDir), 0.0);
+
+    // 2. Specular lighting
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float specular = pow(max(dot(viewDir, reflectDir), 0.0), 32.0) * specularIntensity;
+
+    return (diffuse * light.color + specular * light.color);
+}
+
+vec3 calcPointLight(PointLightParams light, vec3 normal, vec3 fragPos, vec3 viewDir, float specularIntensity) {
+    vec3 directionToLight = light.positionRadius.xyz - fragPos;
+    float distanceSquared = dot(directionToLight, directionToLight);
+    float attenuation = 1.0 / distanceSquared;
+
+    // Smoothly fade out towards the radius of influence used for culling
+    float falloff = distanceSquared / (light.positionRadius.w * light.positionRadius.w);
+    attenuation *= pow(clamp(1.0 - falloff * falloff, 0.0, 1.0), 2.0);
+
+    directionToLight = normalize(directionToLight);
+
+    float cosAngIncidence = max(dot(normal, directionToLight), 0.0);
+    vec3 intensity = light.color.xyz * light.color.w * attenuation;
+
+    // Specular component
+    vec3 halfAngle = normalize(directionToLight + viewDir);
+    float blinnTerm = dot(normal, halfAngle);
+    blinnTerm = clamp(blinnTerm, 0, 1);
+    blinnTerm = pow(blinnTerm, 32.0); // higher values -> sharper highlights
+
+    vec3 diffuseLight = intensity * cosAngIncidence;
+    vec3 specularLight = intensity * blinnTerm * specularIntensity;
+
+    return (diffuseLight + specularLight);
+}
+
+uint calcClusterIndex(vec2 uv, vec3 fragPos) {
+    float viewDepth = -(clusterParams.view * vec4(fragPos, 1.0)).z;
+    float slice = log(max(viewDepth, clusterParams.zNear) / clusterParams.zNear) *
+        float(clusterParams.gridSize.z) / log(clusterParams.zFar / clusterParams.zNear);
+
+    uvec3 cluster = uvec3(
+        min(uvec2(uv * vec2(clusterParams.gridSize.xy)), clusterParams.gridSize.xy - 1u),
+        min(uint(slice), clusterParams.gridSize.z - 1u)
+    );
+
+    return cluster.x + cluster.y * clusterParams.gridSize.x + cluster.z * clusterParams.gridSize.x * clusterParams.gridSize.y;
+}
+
+vec3 calcClusteredPointLights(vec2 uv, vec3 fragPos, vec3 normal, vec3 viewDir, float specularIntensity) {
+    uvec2 cluster = lightGrid[calcClusterIndex(uv, fragPos)];
+    vec3 result = vec3(0.0);
+
+    for (uint i = 0; i < cluster.y; i++) {
+        result += calcPointLight(lights[lightIndices[cluster.x + i]], normal, fragPos, viewDir, specularIntensity);
+    }
+
+    return result;
+}
@@ -0,0 +1,35 @@
+// Shared G-buffer packing functions.
+
+vec2 signNotZero(vec2 v) {
+    return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+// Octahedral normal encoding, maps a unit vector onto [-1, 1]^2
+vec2 octEncode(vec3 n) {
+    vec2 p = n.xy * (1.0 / (abs(n.x) + abs(n.y) + abs(n.z)));
+    return (n.z <= 0.0) ? ((1.0 - abs(p.yx)) * signNotZero(p)) : p;
+}
+
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+
+    if (n.z < 0.0) {
+        n.xy = (1.0 - abs(n.yx)) * signNotZero(n.xy);
+    }
+
+    return normalize(n);
+}
+
+// Tangent frame of the compact vertex format, the sign of the encoded tangent's y is the bitangent sign.
+// NOTE: Must match Vertex3D::pack()
+void decodeTangentFrame(vec2 encodedNormal, vec2 encodedTangent, out vec3 normal, out vec3 tangent, out vec3 biTangent) {
+    normal = octDecode(encodedNormal);
+    tangent = octDecode(vec2(encodedTangent.x, abs(encodedTangent.y) * 2.0 - 1.0));
+    biTangent = cross(normal, tangent) * (encodedTangent.y < 0.0 ? -1.0 : 1.0);
+}
+
+// World-space position from a depth buffer sample and the inverse view-projection matrix
+vec3 reconstructPosition(vec2 uv, float depth, mat4 inverseViewProjection) {
+    vec4 position = inverseViewProjection * vec4(uv * 2.0 - 1.0, depth, 1.0);
+    return position.xyz / position.w;
+}
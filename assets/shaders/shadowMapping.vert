@@ -12,17 +12,15 @@ layout(set = 0, binding = 0) uniform UniformBufferObject {
     DirectionLightParams directionLight;
 } ubo;
 
-layout(push_constant) uniform Push {
-    mat4 modelMatrix;
-} push;
+// Indexed by the first instance of the draw, so recorded draws do not change with transforms
+layout(std430, set = 0, binding = 1) readonly buffer DrawBuffer {
+    mat4 modelMatrices[];
+} drawBuffer;
 
+// Position stream only
 layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inNormal;
-layout(location = 2) in vec3 inTangent;
-layout(location = 3) in vec3 inBiTangent;
-layout(location = 4) in vec2 inTexCoord;
 
 void main() {
-    vec4 positionWorld = push.modelMatrix * vec4(inPosition, 1.0);
+    vec4 positionWorld = drawBuffer.modelMatrices[gl_InstanceIndex] * vec4(inPosition, 1.0);
     gl_Position = ubo.proj * ubo.view * positionWorld;
 }
\ No newline at end of file
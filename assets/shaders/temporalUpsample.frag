@@ -0,0 +1,79 @@
+#version 450
+
+// Temporal upsampling: reconstructs the output resolution from the jittered, lower resolution lighting output by
+// accumulating the reprojected history, which is clipped to the neighborhood of the current frame against ghosting
+layout (set = 0, binding = 0) uniform sampler2D currentColor;
+layout (set = 0, binding = 1) uniform sampler2D motionVectors;
+layout (set = 0, binding = 2) uniform sampler2D history;
+
+layout(push_constant) uniform Push {
+    vec2 jitter; // UV units
+    vec2 renderSize; // pixels rendered this frame
+    vec2 inputSize; // size of the input targets, at least renderSize
+    float currentWeight;
+    uint historyValid;
+} push;
+
+layout (location = 0) in vec2 inUV;
+
+layout (location = 0) out vec4 outColor;
+
+vec3 rgbToYCoCg(vec3 color) {
+    return vec3(
+        0.25 * color.r + 0.5 * color.g + 0.25 * color.b,
+        0.5 * color.r - 0.5 * color.b,
+        -0.25 * color.r + 0.5 * color.g - 0.25 * color.b
+    );
+}
+
+vec3 yCoCgToRgb(vec3 color) {
+    return vec3(
+        color.x + color.y - color.z,
+        color.x + color.z,
+        color.x - color.y - color.z
+    );
+}
+
+// Moves the history towards the center of the neighborhood box until it is inside, unlike a per-channel clamp
+// this keeps the hue of the history
+vec3 clipToBox(vec3 color, vec3 minimum, vec3 maximum) {
+    vec3 center = 0.5 * (maximum + minimum);
+    vec3 extents = 0.5 * (maximum - minimum) + 0.0001;
+    vec3 offset = color - center;
+    vec3 units = abs(offset / extents);
+    float maxUnit = max(units.x, max(units.y, units.z));
+
+    return maxUnit > 1.0 ? center + offset / maxUnit : color;
+}
+
+void main() {
+    // Position of this output pixel in the jittered input
+    vec2 inputPixel = (inUV + push.jitter) * push.renderSize;
+    ivec2 maxTexel = ivec2(push.renderSize) - 1;
+    ivec2 centerTexel = clamp(ivec2(inputPixel), ivec2(0), maxTexel);
+
+    vec3 current = rgbToYCoCg(texture(currentColor, clamp(inputPixel, vec2(0.5), push.renderSize - 0.5) / push.inputSize).rgb);
+
+    // 3x3 neighborhood bounds
+    vec3 minimum = current;
+    vec3 maximum = current;
+
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            vec3 neighbor = rgbToYCoCg(texelFetch(currentColor, clamp(centerTexel + ivec2(x, y), ivec2(0), maxTexel), 0).rgb);
+            minimum = min(minimum, neighbor);
+            maximum = max(maximum, neighbor);
+        }
+    }
+
+    vec2 previousUV = inUV - texelFetch(motionVectors, centerTexel, 0).rg;
+
+    if (push.historyValid == 0 || any(lessThan(previousUV, vec2(0.0))) || any(greaterThan(previousUV, vec2(1.0)))) {
+        outColor = vec4(yCoCgToRgb(current), 1.0);
+        return;
+    }
+
+    vec3 previous = clipToBox(rgbToYCoCg(texture(history, previousUV).rgb), minimum, maximum);
+
+    outColor = vec4(yCoCgToRgb(mix(previous, current, push.currentWeight)), 1.0);
+}
\ No newline at end of file
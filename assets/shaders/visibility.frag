@@ -0,0 +1,16 @@
+#version 450
+
+// NOTE: Must match VisibilityBufferPass
+#define TRIANGLE_ID_BITS 20
+
+layout(push_constant) uniform Push {
+    mat4 modelMatrix;
+    uint drawID;
+} push;
+
+layout(location = 0) out uint outVisibility;
+
+void main() {
+    // Zero is reserved for empty pixels, hence the offset of the draw ID
+    outVisibility = ((push.drawID + 1) << TRIANGLE_ID_BITS) | uint(gl_PrimitiveID);
+}
@@ -0,0 +1,17 @@
+#version 450
+
+layout(set = 0, binding = 0) uniform UniformBufferObject {
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+layout(push_constant) uniform Push {
+    mat4 modelMatrix;
+    uint drawID;
+} push;
+
+layout(location = 0) in vec3 inPosition;
+
+void main() {
+    gl_Position = ubo.proj * ubo.view * push.modelMatrix * vec4(inPosition, 1.0);
+}
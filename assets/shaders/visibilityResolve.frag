@@ -0,0 +1,201 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : enable
+#extension GL_GOOGLE_include_directive : require
+
+// NOTE: Must match VisibilityBufferPass
+#define TRIANGLE_ID_BITS 20
+#define TRIANGLE_ID_MASK ((1u << TRIANGLE_ID_BITS) - 1u)
+
+// NOTE: std430 layout matches Vertex3D (16 bytes), positions are a separate stream
+struct Vertex {
+    uint normal; // 2x SNORM16, octahedral
+    uint tangent; // 2x SNORM16, octahedral, y carries the bitangent sign
+    vec2 texCoord;
+};
+
+struct DrawData {
+    mat4 modelMatrix;
+    uint baseIndex;
+    int baseVertex;
+    uint diffuseTexIndex;
+    uint normalMapIndex;
+    uint shortIndices; // indices are read from the 16-bit buffer
+};
+
+layout (set = 0, binding = 0) uniform usampler2D visibilityBuffer;
+layout (set = 0, binding = 3) uniform sampler2D shadowMap;
+
+#define CLUSTER_SET 3
+#include "lighting.glsl"
+#include "packing.glsl"
+
+layout (set = 0, binding = 1) uniform UBO {
+    mat4 view;
+    mat4 proj;
+    mat4 lightSpaceMatrix;
+    vec3 viewPosition;
+    DirectionLightParams directionLight;
+    vec2 screenSize;
+} ubo;
+
+layout (std430, set = 0, binding = 2) readonly buffer DrawBuffer {
+    DrawData draws[];
+};
+
+layout (set = 1, binding = 0) uniform sampler2D vGlobalTextures[];
+
+// Geometry of every model, see GeometryStore
+layout (std430, set = 2, binding = 0) readonly buffer VertexBuffer {
+    Vertex vertices[];
+};
+
+layout (std430, set = 2, binding = 1) readonly buffer IndexBuffer {
+    uint indices[];
+};
+
+// Tightly packed vec3 positions, a vec3 array would have a 16 byte stride in std430
+layout (std430, set = 2, binding = 2) readonly buffer PositionBuffer {
+    float positions[];
+};
+
+// 16-bit indices, two per word
+layout (std430, set = 2, binding = 3) readonly buffer ShortIndexBuffer {
+    uint shortIndices[];
+};
+
+layout (location = 0) in vec2 inUV;
+
+layout (location = 0) out vec4 outColor;
+
+// Perspective-correct barycentrics of a pixel along with their screen-space derivatives
+struct BarycentricDeriv {
+    vec3 lambda;
+    vec3 ddx;
+    vec3 ddy;
+};
+
+BarycentricDeriv calcBarycentrics(vec4 clip0, vec4 clip1, vec4 clip2, vec2 pixelNdc, vec2 screenSize) {
+    BarycentricDeriv result;
+
+    vec3 invW = 1.0 / vec3(clip0.w, clip1.w, clip2.w);
+    vec2 ndc0 = clip0.xy * invW.x;
+    vec2 ndc1 = clip1.xy * invW.y;
+    vec2 ndc2 = clip2.xy * invW.z;
+
+    // Gradients of lambda / w along the NDC axes
+    float invDet = 1.0 / determinant(mat2(ndc2 - ndc1, ndc0 - ndc1));
+    result.ddx = vec3(ndc1.y - ndc2.y, ndc2.y - ndc0.y, ndc0.y - ndc1.y) * invDet * invW;
+    result.ddy = vec3(ndc2.x - ndc1.x, ndc0.x - ndc2.x, ndc1.x - ndc0.x) * invDet * invW;
+    float ddxSum = dot(result.ddx, vec3(1.0));
+    float ddySum = dot(result.ddy, vec3(1.0));
+
+    vec2 delta = pixelNdc - ndc0;
+    float interpInvW = invW.x + delta.x * ddxSum + delta.y * ddySum;
+    float interpW = 1.0 / interpInvW;
+
+    result.lambda.x = interpW * (invW.x + delta.x * result.ddx.x + delta.y * result.ddy.x);
+    result.lambda.y = interpW * (delta.x * result.ddx.y + delta.y * result.ddy.y);
+    result.lambda.z = interpW * (delta.x * result.ddx.z + delta.y * result.ddy.z);
+
+    // Convert to per-pixel derivatives (one pixel is 2 / size in NDC)
+    result.ddx *= 2.0 / screenSize.x;
+    result.ddy *= 2.0 / screenSize.y;
+    ddxSum *= 2.0 / screenSize.x;
+    ddySum *= 2.0 / screenSize.y;
+
+    float interpWddx = 1.0 / (interpInvW + ddxSum);
+    float interpWddy = 1.0 / (interpInvW + ddySum);
+
+    result.ddx = interpWddx * (result.lambda * interpInvW + result.ddx) - result.lambda;
+    result.ddy = interpWddy * (result.lambda * interpInvW + result.ddy) - result.lambda;
+
+    return result;
+}
+
+uint fetchIndex(uint i, bool isShort) {
+    if (isShort) {
+        uint packed = shortIndices[i >> 1];
+        return (packed >> ((i & 1u) * 16u)) & 0xFFFFu;
+    }
+
+    return indices[i];
+}
+
+vec3 fetchPosition(int vertexIndex) {
+    int i = vertexIndex * 3;
+    return vec3(positions[i + 0], positions[i + 1], positions[i + 2]);
+}
+
+vec3 interpolate(BarycentricDeriv bary, vec3 v0, vec3 v1, vec3 v2) {
+    return bary.lambda.x * v0 + bary.lambda.y * v1 + bary.lambda.z * v2;
+}
+
+void main() {
+    uint visibility = texelFetch(visibilityBuffer, ivec2(gl_FragCoord.xy), 0).r;
+
+    if (visibility == 0) {
+        outColor = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+
+    // 1. Fetch triangle
+    DrawData draw = draws[(visibility >> TRIANGLE_ID_BITS) - 1];
+    uint triangleID = visibility & TRIANGLE_ID_MASK;
+
+    uint firstIndex = draw.baseIndex + triangleID * 3;
+    bool isShort = draw.shortIndices != 0;
+    int i0 = int(fetchIndex(firstIndex + 0, isShort)) + draw.baseVertex;
+    int i1 = int(fetchIndex(firstIndex + 1, isShort)) + draw.baseVertex;
+    int i2 = int(fetchIndex(firstIndex + 2, isShort)) + draw.baseVertex;
+
+    Vertex v0 = vertices[i0];
+    Vertex v1 = vertices[i1];
+    Vertex v2 = vertices[i2];
+
+    vec3 world0 = (draw.modelMatrix * vec4(fetchPosition(i0), 1.0)).xyz;
+    vec3 world1 = (draw.modelMatrix * vec4(fetchPosition(i1), 1.0)).xyz;
+    vec3 world2 = (draw.modelMatrix * vec4(fetchPosition(i2), 1.0)).xyz;
+
+    mat4 viewProj = ubo.proj * ubo.view;
+    vec2 pixelNdc = (gl_FragCoord.xy / ubo.screenSize) * 2.0 - 1.0;
+
+    // 2. Reconstruct barycentrics and interpolate attributes
+    BarycentricDeriv bary = calcBarycentrics(
+        viewProj * vec4(world0, 1.0),
+        viewProj * vec4(world1, 1.0),
+        viewProj * vec4(world2, 1.0),
+        pixelNdc, ubo.screenSize);
+
+    vec3 fragPos = interpolate(bary, world0, world1, world2);
+
+    vec2 uv = bary.lambda.x * v0.texCoord + bary.lambda.y * v1.texCoord + bary.lambda.z * v2.texCoord;
+    vec2 uvDdx = bary.ddx.x * v0.texCoord + bary.ddx.y * v1.texCoord + bary.ddx.z * v2.texCoord;
+    vec2 uvDdy = bary.ddy.x * v0.texCoord + bary.ddy.y * v1.texCoord + bary.ddy.z * v2.texCoord;
+
+    vec3 n0, t0, b0, n1, t1, b1, n2, t2, b2;
+    decodeTangentFrame(unpackSnorm2x16(v0.normal), unpackSnorm2x16(v0.tangent), n0, t0, b0);
+    decodeTangentFrame(unpackSnorm2x16(v1.normal), unpackSnorm2x16(v1.tangent), n1, t1, b1);
+    decodeTangentFrame(unpackSnorm2x16(v2.normal), unpackSnorm2x16(v2.tangent), n2, t2, b2);
+
+    mat3 normalMatrix = mat3(draw.modelMatrix);
+    vec3 T = normalize(normalMatrix * interpolate(bary, t0, t1, t2));
+    vec3 B = normalize(normalMatrix * interpolate(bary, b0, b1, b2));
+    vec3 N = normalize(normalMatrix * interpolate(bary, n0, n1, n2));
+
+    // 3. Material
+    vec3 normal = textureGrad(vGlobalTextures[nonuniformEXT(draw.normalMapIndex)], uv, uvDdx, uvDdy).rgb;
+    normal = normalize(mat3(T, B, N) * (normal * 2.0 - 1.0));
+
+    vec3 albedo = textureGrad(vGlobalTextures[nonuniformEXT(draw.diffuseTexIndex)], uv, uvDdx, uvDdy).rgb;
+    vec3 viewDir = normalize(ubo.viewPosition - fragPos);
+
+    vec4 fragPosLightSpace = ubo.lightSpaceMatrix * vec4(fragPos, 1.0);
+
+    // 4. Shading, identical to the deferred and forward paths
+    vec3 result = vec3(ambientIntensity) + calcDirLight(ubo.directionLight, normal, viewDir, 1.0);
+    result += calcClusteredPointLights(inUV, fragPos, normal, viewDir, 1.0);
+
+    float shadow = calcShadows(fragPosLightSpace, normal, normalize(ubo.directionLight.direction));
+
+    outColor = vec4((1.0 + ambientIntensity - shadow) * albedo * result, 1.0);
+}
@@ -4,16 +4,18 @@ setlocal enabledelayedexpansion
 REM Change to the source folder
 cd assets\shaders
 
-REM Loop through all .vert and .frag files in the folder
-for %%f in (*.vert *.frag) do (
+REM Loop through all .vert, .frag and .comp files in the folder
+for %%f in (*.vert *.frag *.comp) do (
     REM Extract the file name without extension
     set "FILE_NAME=%%~nf"
 
-    REM Compile .vert and .frag files to .spv with the desired output filename
+    REM Compile .vert, .frag and .comp files to .spv with the desired output filename
     if "%%~xf"==".vert" (
         "%VK_SDK_PATH%\Bin\glslc.exe" "%%f" -o "!FILE_NAME!.vert.spv"
     ) else if "%%~xf"==".frag" (
         "%VK_SDK_PATH%\Bin\glslc.exe" "%%f" -o "!FILE_NAME!.frag.spv"
+    ) else if "%%~xf"==".comp" (
+        "%VK_SDK_PATH%\Bin\glslc.exe" "%%f" -o "!FILE_NAME!.comp.spv"
     )
 )
 
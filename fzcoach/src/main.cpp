@@ -2,6 +2,7 @@
 
 // std
 #include <iostream>
+#include <cstring>
 #include <memory>
 
 // primwalk
@@ -9,7 +10,7 @@
 
 class Sandbox final : public pw::Application {
 public:
-	Sandbox() : pw::Application() {};
+	Sandbox(const pw::RenderSettings& settings) : pw::Application(settings) {};
 
 	void onStart() override {
 		// Resources
@@ -87,8 +88,28 @@ private:
 	std::shared_ptr<pw::Model> cubeModel = nullptr;
 };
 
-int main() {
-	Sandbox* application = new Sandbox();
+int main(int argc, char* argv[]) {
+	pw::RenderSettings settings{};
+
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--forward-plus") == 0) {
+			settings.renderPath = pw::RenderPath::ForwardPlus;
+		}
+		else if (std::strcmp(argv[i], "--visibility-buffer") == 0) {
+			settings.renderPath = pw::RenderPath::VisibilityBuffer;
+		}
+		else if (std::strcmp(argv[i], "--merge-deferred") == 0) {
+			settings.mergeDeferredPasses = true;
+		}
+		else if (std::strcmp(argv[i], "--dynamic-resolution") == 0) {
+			settings.dynamicResolution = true;
+		}
+		else if (std::strcmp(argv[i], "--temporal-upsampling") == 0) {
+			settings.temporalUpsampling = true;
+		}
+	}
+
+	Sandbox* application = new Sandbox(settings);
 	application->run();
 	delete application;
 
@@ -7,16 +7,23 @@
 #include "components/tag.hpp"
 #include "components/transform.hpp"
 #include "ui/editor.hpp"
+#include "rendering/pipelineCache.hpp"
 
 #include "math/pwmath.hpp"
 
 // std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <thread>
 #include <iostream>
+#include <sstream>
 
 namespace pw {
 
-	Application::Application() {
+	Application::Application(const RenderSettings& settings) : m_RenderSettings(settings) {
+		m_StartTime = std::chrono::high_resolution_clock::now();
+
 		m_Window = std::make_unique<pw::Window>("Primwalk Engine", 1080, 720);
 		m_Device = std::make_unique<GraphicsDevice_Vulkan>(*m_Window);
 		pw::GetDevice() = m_Device.get();
@@ -34,9 +41,34 @@ namespace pw {
 		m_UIRenderSystem = std::make_unique<UIRenderSystem>((GraphicsDevice_Vulkan&)(*m_Device), m_Renderer->getVkRenderPass());
 
 		// Renderpasses
-		m_GBufferPass = std::make_unique<GBufferPass>(m_Window->getWidth() / 2, m_Window->getHeight() / 2, *((GraphicsDevice_Vulkan*)m_Device.get()));
 		m_ShadowPass = std::make_unique<ShadowPass>(*((GraphicsDevice_Vulkan*)m_Device.get()), 1024);
-		m_LightingPass = std::make_unique<LightingPass>(m_Window->getWidth() / 2, m_Window->getHeight() / 2, *((GraphicsDevice_Vulkan*)m_Device.get()));
+		m_LightCullingPass = std::make_unique<LightCullingPass>(*((GraphicsDevice_Vulkan*)m_Device.get()));
+
+		if (m_RenderSettings.renderPath == RenderPath::Deferred && m_RenderSettings.mergeDeferredPasses) {
+			m_DeferredPass = std::make_unique<DeferredPass>(m_Window->getWidth() / 2, m_Window->getHeight() / 2, *((GraphicsDevice_Vulkan*)m_Device.get()), *m_LightCullingPass, m_RenderSettings.shadingQuality);
+		}
+		else if (m_RenderSettings.renderPath == RenderPath::Deferred) {
+			// With dynamic resolution the targets are over-allocated once, scaling down only shrinks the viewport
+			m_RenderScale = getAllocationScale();
+			uint32_t width = static_cast<uint32_t>(m_Window->getWidth() / 2 * m_RenderScale);
+			uint32_t height = static_cast<uint32_t>(m_Window->getHeight() / 2 * m_RenderScale);
+
+			m_GBufferPass = std::make_unique<GBufferPass>(width, height, *((GraphicsDevice_Vulkan*)m_Device.get()), m_RenderSettings.temporalUpsampling);
+			m_LightingPass = std::make_unique<LightingPass>(width, height, *((GraphicsDevice_Vulkan*)m_Device.get()), *m_LightCullingPass, m_RenderSettings.shadingQuality);
+
+			if (m_RenderSettings.temporalUpsampling) {
+				m_TemporalUpsamplePass = std::make_unique<TemporalUpsamplePass>(m_Window->getWidth() / 2, m_Window->getHeight() / 2, *((GraphicsDevice_Vulkan*)m_Device.get()));
+			}
+		}
+		else if (m_RenderSettings.renderPath == RenderPath::ForwardPlus) {
+			m_ForwardPass = std::make_unique<ForwardPass>(m_Window->getWidth() / 2, m_Window->getHeight() / 2, *((GraphicsDevice_Vulkan*)m_Device.get()), *m_LightCullingPass, m_RenderSettings.shadingQuality);
+		}
+		else {
+			m_VisibilityBufferPass = std::make_unique<VisibilityBufferPass>(m_Window->getWidth() / 2, m_Window->getHeight() / 2, *((GraphicsDevice_Vulkan*)m_Device.get()), *m_LightCullingPass, m_RenderSettings.shadingQuality);
+		}
+
+		m_RenderGraph = std::make_unique<RenderGraph>(*((GraphicsDevice_Vulkan*)m_Device.get()));
+		buildRenderGraph();
 
 		initialize();
 	}
@@ -77,13 +109,28 @@ namespace pw {
 		m_Window->setResizeCallback([this](int width, int height) {
 			m_Renderer->resizeSwapChain((uint32_t)width, (uint32_t)height);
 
-			m_UIRenderSystem->removeImage(m_GBufferPass->getPositionBuffer());
-			m_UIRenderSystem->removeImage(m_GBufferPass->getNormalBuffer());
-			m_UIRenderSystem->removeImage(m_GBufferPass->getAlbedoBuffer());
-			m_UIRenderSystem->removeImage(m_LightingPass->getOutputImage());
+			if (m_DeferredPass) {
+				m_DeferredPass->resize(width / 2, height / 2);
+			}
+			else if (m_RenderSettings.renderPath == RenderPath::Deferred) {
+				uint32_t targetWidth = static_cast<uint32_t>(width / 2 * getAllocationScale());
+				uint32_t targetHeight = static_cast<uint32_t>(height / 2 * getAllocationScale());
+
+				m_GBufferPass->resize(targetWidth, targetHeight);
+				m_LightingPass->resize(targetWidth, targetHeight);
 
-			m_GBufferPass->resize(width / 2, height / 2);
-			m_LightingPass->resize(width / 2, height / 2);
+				if (m_TemporalUpsamplePass) {
+					m_TemporalUpsamplePass->resize(width / 2, height / 2);
+				}
+			}
+			else if (m_RenderSettings.renderPath == RenderPath::ForwardPlus) {
+				m_ForwardPass->resize(width / 2, height / 2);
+			}
+			else {
+				m_VisibilityBufferPass->resize(width / 2, height / 2);
+			}
+
+			buildRenderGraph();
 		});
 
 		// Game loop
@@ -124,10 +171,43 @@ namespace pw {
 				m_DebugMode = !m_DebugMode;
 			}
 
+			// Cheap shadows, switches to the specialized variant without PCF
+			if (pw::input::isDown(KeyCode::KeyboardButtonLControl) && pw::input::isDownOnce(KeyCode::KeyboardButtonQ)) {
+				ShadingQuality quality = m_RenderSettings.shadingQuality;
+				quality.pcfShadows = !quality.pcfShadows;
+				setShadingQuality(quality);
+			}
+
+			// Meshlet culling rates of the last completed frame
+			if (pw::input::isDown(KeyCode::KeyboardButtonLControl) && pw::input::isDownOnce(KeyCode::KeyboardButtonM)) {
+				MeshletCullingPass* meshletCulling = m_GBufferPass ? m_GBufferPass->getMeshletCulling() : nullptr;
+
+				if (meshletCulling) {
+					const auto& stats = meshletCulling->getStats();
+					std::cout << "Meshlet culling: " << stats.draws << " draws, " << stats.meshlets << " meshlets, "
+						<< stats.frustumCulled << " frustum culled, " << stats.backfaceCulled << " backface culled ("
+						<< static_cast<int>(stats.getCullRate() * 100.0f) << "% culled)\n";
+				}
+				else {
+					std::cout << "Meshlet culling is only available in the deferred path with draw indirect count support\n";
+				}
+			}
+
+			if (pw::input::isDown(KeyCode::KeyboardButtonLControl) && pw::input::isDownOnce(KeyCode::KeyboardButtonG)) {
+				m_ShowGBufferPreviews = !m_ShowGBufferPreviews;
+
+				m_Device->waitForGPU();
+				buildRenderGraph();
+			}
+
 			if (m_ScenePaused) {
 				dt = 0.0f;
 			}
 
+			if (m_TemporalUpsamplePass) {
+				camera->setJitter(true, glm::vec2(m_GBufferPass->getRenderWidth(), m_GBufferPass->getRenderHeight()));
+			}
+
 			camera->update(m_Window->getWidth(), m_Window->getHeight());
 
 			onUpdate(dt);
@@ -136,6 +216,14 @@ namespace pw {
 			// Rendering
 			onRender(dt);
 
+			if (firstPaint) {
+				// Most of this goes into compiling pipelines, which a warm pipeline cache skips
+				float startupTime = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - m_StartTime).count();
+				bool warmCache = ((GraphicsDevice_Vulkan*)m_Device.get())->getPipelineCache().isWarm();
+				std::cout << "First frame after " << startupTime << " ms (" << (warmCache ? "warm" : "cold") << " pipeline cache)\n";
+				firstPaint = false;
+			}
+
 			m_Window->pollEvents();
 		}
 
@@ -143,10 +231,31 @@ namespace pw {
 		Editor::getInstance().destroy();
 	}
 
+	void Application::setShadingQuality(const ShadingQuality& quality) {
+		m_RenderSettings.shadingQuality = quality;
+
+		// Only the passes of the active render path exist
+		if (m_LightingPass) {
+			m_LightingPass->setShadingQuality(quality);
+		}
+
+		if (m_DeferredPass) {
+			m_DeferredPass->setShadingQuality(quality);
+		}
+
+		if (m_ForwardPass) {
+			m_ForwardPass->setShadingQuality(quality);
+		}
+
+		if (m_VisibilityBufferPass) {
+			m_VisibilityBufferPass->setShadingQuality(quality);
+		}
+	}
+
 	Entity* Application::createEntity(const std::string& name) {
 		m_Entities.push_back(std::make_unique<Entity>(name, m_ComponentManager, m_EntityManager));
 
-		m_GBufferPass->m_Entities.insert((*(m_Entities.end() - 1))->getID());
+		m_EntityIDs.insert((*(m_Entities.end() - 1))->getID());
 
 		return (*(m_Entities.end() - 1)).get();
 	}
@@ -156,7 +265,7 @@ namespace pw {
 		entity->addComponent<PointLight>().color = { 1.0f, 1.0f, 1.0f, 0.1f };
 		m_Entities.push_back(std::move(entity));
 
-		m_GBufferPass->m_Entities.insert((*(m_Entities.end() - 1))->getID());
+		m_EntityIDs.insert((*(m_Entities.end() - 1))->getID());
 
 		return (*(m_Entities.end() - 1)).get();
 	}
@@ -168,49 +277,297 @@ namespace pw {
 		{
 			size_t frameIndex = m_Renderer->getFrameIndex();
 
-			// Update
+			m_FrameTime = dt;
+			updateRenderScale();
+
+			m_RenderGraph->execute(commandBuffer, frameIndex);
+		}
+
+		m_Renderer->endFrame();
+	}
+
+	void Application::buildRenderGraph() {
+		m_RenderGraph->reset();
+
+		RenderGraph& graph = *m_RenderGraph;
+
+		// The shadow map is previewed by the UI pass every frame, the G-buffer only in the separate deferred path
+		RenderGraphResource shadowMap = graph.importImage("ShadowMap", m_ShadowPass->getOutputImage());
+		RenderGraphResource clusters = graph.importBuffer("LightClusters", [this](size_t frameIndex) {
+			return m_LightCullingPass->getClusterBuffers(frameIndex);
+		});
+		RenderGraphResource output = graph.importImage("Output", getOutputImage());
+
+		graph.addPass("Shadow", [this](VkCommandBuffer commandBuffer, size_t frameIndex) {
+			m_ShadowPass->draw(commandBuffer, frameIndex, m_EntityIDs, m_ComponentManager);
+		}).write(shadowMap, ResourceUsage::DepthAttachment, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+
+		graph.addPass("LightCulling", [this](VkCommandBuffer commandBuffer, size_t frameIndex) {
+			m_LightCullingPass->dispatch(commandBuffer, frameIndex, m_EntityIDs, m_ComponentManager);
+		}).write(clusters, ResourceUsage::StorageWriteCompute).setAsyncCompute(); // overlaps with the shadow pass
+
+		std::vector<RenderGraphResource> previews;
+
+		if (m_DeferredPass) {
+			graph.addPass("Deferred", [this](VkCommandBuffer commandBuffer, size_t frameIndex) {
+				m_DeferredPass->draw(commandBuffer, frameIndex, m_EntityIDs, m_ComponentManager,
+					m_ShadowPass->getOutputImage(),
+					m_ShadowPass->getLightSpaceMatrix()
+				);
+			})
+				.read(shadowMap, ResourceUsage::SampledFragment)
+				.read(clusters, ResourceUsage::StorageReadFragment)
+				.write(output, ResourceUsage::ColorAttachment);
+		}
+		else if (m_RenderSettings.renderPath == RenderPath::Deferred) {
+			RenderGraphResource depth = graph.importImage("GBufferDepth", m_GBufferPass->getDepthBuffer());
+			RenderGraphResource normal = graph.importImage("GBufferNormal", m_GBufferPass->getNormalBuffer());
+			RenderGraphResource albedo = graph.importImage("GBufferAlbedo", m_GBufferPass->getAlbedoBuffer());
+
+			if (m_ShowGBufferPreviews) {
+				previews = { depth, normal, albedo };
+			}
+
+			// With temporal upsampling the lighting output is only an intermediate, reconstructed into the output
+			RenderGraphResource sceneColor = output;
+			RenderGraphResource motionVectors{};
+
+			if (m_TemporalUpsamplePass) {
+				sceneColor = graph.importImage("SceneColor", m_LightingPass->getOutputImage());
+				motionVectors = graph.importImage("MotionVectors", m_GBufferPass->getMotionBuffer());
+			}
+
+			RenderGraph::PassBuilder gBufferPass = graph.addPass("GBuffer", [this](VkCommandBuffer commandBuffer, size_t frameIndex) {
+				m_GBufferPass->draw(commandBuffer, frameIndex, m_EntityIDs, m_ComponentManager);
+			});
+
+			gBufferPass
+				.write(normal, ResourceUsage::ColorAttachment)
+				.write(albedo, ResourceUsage::ColorAttachment)
+				.write(depth, ResourceUsage::DepthAttachment, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+
+			if (m_TemporalUpsamplePass) {
+				gBufferPass.write(motionVectors, ResourceUsage::ColorAttachment);
+			}
+
+			graph.addPass("Lighting", [this](VkCommandBuffer commandBuffer, size_t frameIndex) {
+				m_LightingPass->draw(commandBuffer, frameIndex, m_EntityIDs, m_ComponentManager,
+					m_GBufferPass->getDepthBuffer(),
+					m_GBufferPass->getNormalBuffer(),
+					m_GBufferPass->getAlbedoBuffer(),
+					m_ShadowPass->getOutputImage(),
+					m_ShadowPass->getLightSpaceMatrix()
+				);
+			})
+				.read(depth, ResourceUsage::SampledFragment)
+				.read(normal, ResourceUsage::SampledFragment)
+				.read(albedo, ResourceUsage::SampledFragment)
+				.read(shadowMap, ResourceUsage::SampledFragment)
+				.read(clusters, ResourceUsage::StorageReadFragment)
+				.write(sceneColor, ResourceUsage::ColorAttachment);
+
+			if (m_TemporalUpsamplePass) {
+				graph.addPass("TemporalUpsample", [this](VkCommandBuffer commandBuffer, size_t frameIndex) {
+					m_Renderer->getProfiler().begin(commandBuffer, "TemporalUpsample");
+					m_TemporalUpsamplePass->draw(commandBuffer, frameIndex,
+						m_LightingPass->getOutputImage(),
+						m_GBufferPass->getMotionBuffer(),
+						m_LightingPass->getRenderWidth(),
+						m_LightingPass->getRenderHeight(),
+						Camera::MainCamera->getJitter()
+					);
+					m_Renderer->getProfiler().end(commandBuffer, "TemporalUpsample");
+				})
+					.read(sceneColor, ResourceUsage::SampledFragment)
+					.read(motionVectors, ResourceUsage::SampledFragment)
+					.write(output, ResourceUsage::ColorAttachment);
+			}
+		}
+		else if (m_RenderSettings.renderPath == RenderPath::ForwardPlus) {
+			graph.addPass("Forward", [this](VkCommandBuffer commandBuffer, size_t frameIndex) {
+				m_ForwardPass->draw(commandBuffer, frameIndex, m_EntityIDs, m_ComponentManager,
+					m_ShadowPass->getOutputImage(),
+					m_ShadowPass->getLightSpaceMatrix()
+				);
+			})
+				.read(shadowMap, ResourceUsage::SampledFragment)
+				.read(clusters, ResourceUsage::StorageReadFragment)
+				.write(output, ResourceUsage::ColorAttachment);
+		}
+		else {
+			graph.addPass("VisibilityBuffer", [this](VkCommandBuffer commandBuffer, size_t frameIndex) {
+				m_VisibilityBufferPass->draw(commandBuffer, frameIndex, m_EntityIDs, m_ComponentManager,
+					m_ShadowPass->getOutputImage(),
+					m_ShadowPass->getLightSpaceMatrix()
+				);
+			})
+				.read(shadowMap, ResourceUsage::SampledFragment)
+				.read(clusters, ResourceUsage::StorageReadFragment)
+				.write(output, ResourceUsage::ColorAttachment);
+		}
+
+		// Main renderpass (swapchain)
+		RenderGraph::PassBuilder uiPass = graph.addPass("UI", [this](VkCommandBuffer commandBuffer, size_t frameIndex) {
 			FrameInfo frameInfo{};
 			frameInfo.frameIndex = static_cast<int>(frameIndex);
-			frameInfo.frameTime = dt;
+			frameInfo.frameTime = m_FrameTime;
 			frameInfo.commandBuffer = commandBuffer;
 			frameInfo.windowWidth = static_cast<float>(m_Window->getWidth());
 			frameInfo.windowHeight = static_cast<float>(m_Window->getHeight());
 
-			// Renderpasses (TODO: Proper render graph)
-			m_GBufferPass->draw(commandBuffer, frameIndex, m_ComponentManager);
-			m_ShadowPass->draw(commandBuffer, frameIndex, m_GBufferPass->m_Entities, m_ComponentManager);
-			m_LightingPass->draw(commandBuffer, frameIndex, m_GBufferPass->m_Entities, m_ComponentManager,
-				m_GBufferPass->getPositionBuffer(),
-				m_GBufferPass->getNormalBuffer(),
-				m_GBufferPass->getAlbedoBuffer(),
-				m_ShadowPass->getOutputImage(),
-				m_ShadowPass->getLightSpaceMatrix()
-			);
-
-			// Main renderpass (swapchain)
+			Image* outputImage = getOutputImage();
+			glm::vec2 renderExtent = getRenderExtent();
+			glm::vec2 outputExtent = m_TemporalUpsamplePass ? glm::vec2(1.0f) : renderExtent; // already reconstructed
+			int outputWidth = m_Window->getWidth() / 2;
+			int outputHeight = m_Window->getHeight() / 2;
+
+			// Upscales to the output size when rendering at a lower resolution
 			m_Renderer->beginRenderPass(commandBuffer);
-			m_UIRenderSystem->drawFramebuffer(m_LightingPass->getOutputImage(), { m_Window->getWidth() / 4, 0 });
+			m_UIRenderSystem->drawFramebuffer(outputImage, { m_Window->getWidth() / 4, 0 }, outputWidth, outputHeight, outputExtent);
 
 			// Draw G-Buffer resources
-			float aspect =  static_cast<float>(m_LightingPass->getOutputImage()->getHeight()) / m_LightingPass->getOutputImage()->getWidth();
+			float aspect =  static_cast<float>(outputHeight) / outputWidth;
 			int elemWidth = (m_Window->getWidth() / 2) / 3;
 			int elemHeight = elemWidth * aspect;
-			glm::vec2 groupOrigin = { m_Window->getWidth() / 4, 100 + m_LightingPass->getOutputImage()->getHeight() };
+			glm::vec2 groupOrigin = { m_Window->getWidth() / 4, 100 + outputHeight };
+
+			if (m_GBufferPass && m_ShowGBufferPreviews) { // the merged deferred pass has no stored G-buffer to preview
+				m_UIRenderSystem->drawFramebuffer(m_GBufferPass->getDepthBuffer(), groupOrigin, elemWidth, elemHeight, renderExtent);
+				m_UIRenderSystem->drawFramebuffer(m_GBufferPass->getNormalBuffer(), groupOrigin + glm::vec2(elemWidth, 0), elemWidth, elemHeight, renderExtent);
+				m_UIRenderSystem->drawFramebuffer(m_GBufferPass->getAlbedoBuffer(), groupOrigin + glm::vec2(elemWidth * 2, 0), elemWidth, elemHeight, renderExtent);
+			}
 
-			m_UIRenderSystem->drawFramebuffer(m_GBufferPass->getPositionBuffer(), groupOrigin, elemWidth, elemHeight);
-			m_UIRenderSystem->drawFramebuffer(m_GBufferPass->getNormalBuffer(), groupOrigin + glm::vec2(elemWidth, 0), elemWidth, elemHeight);
-			m_UIRenderSystem->drawFramebuffer(m_GBufferPass->getAlbedoBuffer(), groupOrigin + glm::vec2(elemWidth * 2, 0), elemWidth, elemHeight);
 			m_UIRenderSystem->drawFramebuffer(m_ShadowPass->getOutputImage(), groupOrigin + glm::vec2(elemWidth * 3, 0), 256, 256);
 
+			// GPU timings, lagging a few frames behind
+			if (m_Renderer->getProfiler().isSupported()) {
+				std::ostringstream timings;
+				timings.precision(2);
+				timings << std::fixed << "GPU frame: " << m_Renderer->getGPUFrameTime() << " ms";
+
+				if (m_TemporalUpsamplePass) {
+					timings << ", temporal upsampling: " << m_Renderer->getProfiler().getTime("TemporalUpsample") << " ms";
+				}
+
+				m_UIRenderSystem->drawText(groupOrigin + glm::vec2(0, elemHeight + 20), timings.str(), 12, Color::White);
+			}
+
 			// Editor UI
 			Editor::getInstance().draw(*m_UIRenderSystem);
 
 			m_UIRenderSystem->onUpdate(frameInfo);
 			m_UIRenderSystem->onRender(frameInfo);
 			m_Renderer->endRenderPass(commandBuffer);
+		});
+
+		uiPass.setSideEffects()
+			.read(output, ResourceUsage::SampledFragment)
+			.read(shadowMap, ResourceUsage::SampledFragment);
+
+		for (auto preview : previews) {
+			uiPass.read(preview, ResourceUsage::SampledFragment);
 		}
 
-		m_Renderer->endFrame();
+		graph.compile();
+
+		// Only reported in debug mode, the graph is rebuilt on every resize and settings change
+		if (m_DebugMode) {
+			const auto& stats = graph.getStats();
+			std::cout << "Render graph: " << stats.passCount - stats.culledPasses << "/" << stats.passCount << " passes, "
+				<< stats.barrierBatches << " barrier batches (" << stats.imageBarriers << " image, " << stats.memoryBarriers << " memory), "
+				<< stats.asyncComputePasses << " async compute passes (" << stats.queueTransfers << " queue transfers)\n";
+		}
+
+		// Device memory once the render targets are (re)created
+		if (m_DebugMode) {
+			auto heapStats = ((GraphicsDevice_Vulkan*)m_Device.get())->getMemoryAllocator().getHeapStats();
+
+			for (size_t i = 0; i < heapStats.size(); i++) {
+				const auto& heap = heapStats[i];
+
+				if (heap.blockCount == 0 && heap.dedicatedCount == 0) {
+					continue;
+				}
+
+				std::cout << "Memory heap " << i << ": " << heap.usedBytes / 1024 << "/" << heap.blockBytes / 1024 << " KiB used in "
+					<< heap.blockCount << " blocks (" << heap.allocationCount << " allocations, "
+					<< static_cast<int>(heap.fragmentation * 100.0f) << "% fragmented), "
+					<< heap.dedicatedBytes / 1024 << " KiB in " << heap.dedicatedCount << " dedicated allocations\n";
+			}
+		}
+	}
+
+	void Application::updateRenderScale() {
+		if (!m_RenderSettings.dynamicResolution || !m_GBufferPass) {
+			return;
+		}
+
+		float gpuTime = m_Renderer->getGPUFrameTime();
+
+		if (gpuTime <= 0.0f) { // no measurement yet, or timestamps are unsupported
+			return;
+		}
+
+		// The shading cost grows with the pixel count, i.e. the square of the scale. Aim slightly below the budget
+		// and only move part of the way per frame, the measurement lags behind by the frames in flight.
+		float targetScale = m_RenderScale * std::sqrt(m_RenderSettings.gpuFrameBudget * 0.9f / gpuTime);
+		targetScale = std::clamp(targetScale, m_RenderSettings.minRenderScale, m_RenderSettings.maxRenderScale);
+		m_RenderScale += (targetScale - m_RenderScale) * 0.1f;
+
+		uint32_t width = static_cast<uint32_t>(m_Window->getWidth() / 2 * m_RenderScale);
+		uint32_t height = static_cast<uint32_t>(m_Window->getHeight() / 2 * m_RenderScale);
+
+		m_GBufferPass->setRenderSize(width, height);
+		m_LightingPass->setRenderSize(width, height);
+	}
+
+	float Application::getAllocationScale() const {
+		if (m_RenderSettings.dynamicResolution) {
+			return m_RenderSettings.maxRenderScale;
+		}
+
+		return m_RenderSettings.temporalUpsampling ? m_RenderSettings.temporalRenderScale : 1.0f;
+	}
+
+	Image* Application::getOutputImage() {
+		if (m_TemporalUpsamplePass) {
+			return m_TemporalUpsamplePass->getOutputImage();
+		}
+
+		if (m_DeferredPass) {
+			return m_DeferredPass->getOutputImage();
+		}
+
+		if (m_RenderSettings.renderPath == RenderPath::Deferred) {
+			return m_LightingPass->getOutputImage();
+		}
+
+		if (m_RenderSettings.renderPath == RenderPath::ForwardPlus) {
+			return m_ForwardPass->getOutputImage();
+		}
+
+		return m_VisibilityBufferPass->getOutputImage();
+	}
+
+	glm::vec2 Application::getRenderExtent() {
+		if (m_LightingPass) {
+			Image* outputImage = m_LightingPass->getOutputImage();
+			glm::vec2 imageSize = glm::vec2(outputImage->getWidth(), outputImage->getHeight());
+			glm::vec2 renderSize = glm::vec2(m_LightingPass->getRenderWidth(), m_LightingPass->getRenderHeight());
+
+			// Pull in by half a texel when partially rendered, so bilinear upscaling never blends in stale texels
+			if (renderSize.x < imageSize.x) {
+				renderSize.x -= 0.5f;
+			}
+
+			if (renderSize.y < imageSize.y) {
+				renderSize.y -= 0.5f;
+			}
+
+			return renderSize / imageSize;
+		}
+
+		return { 1.0f, 1.0f };
 	}
 
 }
@@ -9,17 +9,26 @@
 #include "managers/entityManager.hpp"
 #include "rendering/graphicsDevice_Vulkan.hpp"
 #include "rendering/renderer.hpp"
+#include "rendering/renderGraph.hpp"
+#include "rendering/renderSettings.hpp"
 #include "rendering/systems/uiRenderSystem.hpp"
+#include "rendering/renderpasses/deferredPass.hpp"
+#include "rendering/renderpasses/forwardPass.hpp"
 #include "rendering/renderpasses/gBufferPass.hpp"
+#include "rendering/renderpasses/lightCullingPass.hpp"
 #include "rendering/renderpasses/lightingPass.hpp"
 #include "rendering/renderpasses/shadowPass.hpp"
+#include "rendering/renderpasses/temporalUpsamplePass.hpp"
+#include "rendering/renderpasses/visibilityBufferPass.hpp"
 #include "ui/uiEvent.hpp"
 
 // std
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -27,7 +36,7 @@
 namespace pw {
 	class PW_API Application {
 	public:
-		Application();
+		Application(const RenderSettings& settings = {});
 		virtual ~Application();
 
 		/* Called once at application startup */
@@ -41,6 +50,9 @@ namespace pw {
 
 		void run();
 
+		/* Selects the specialized shader variants of the lighting passes, a variant is compiled the first time it is selected */
+		void setShadingQuality(const ShadingQuality& quality);
+
 		/* Helper Functions */
 		Entity* createEntity(const std::string& name);
 		Entity* createLightEntity(const std::string& name);
@@ -48,6 +60,11 @@ namespace pw {
 	private:
 		void initialize();
 		void onRender(float dt);
+		void buildRenderGraph(); // rebuilt whenever the passes recreate their images
+		void updateRenderScale();
+		float getAllocationScale() const; // size of the internal render targets relative to half the window size
+		Image* getOutputImage();
+		glm::vec2 getRenderExtent(); // part of the internal render targets that was rendered to, in texture coordinates
 
 		std::unique_ptr<Window> m_Window;
 		std::unique_ptr<GraphicsDevice> m_Device;
@@ -55,17 +72,29 @@ namespace pw {
 		std::unique_ptr<UIRenderSystem> m_UIRenderSystem;
 
 		// Renderpasses
-		std::unique_ptr<GBufferPass> m_GBufferPass;
+		RenderSettings m_RenderSettings{};
+		std::unique_ptr<GBufferPass> m_GBufferPass; // deferred only
 		std::unique_ptr<ShadowPass> m_ShadowPass;
-		std::unique_ptr<LightingPass> m_LightingPass;
+		std::unique_ptr<LightCullingPass> m_LightCullingPass;
+		std::unique_ptr<LightingPass> m_LightingPass; // deferred only
+		std::unique_ptr<DeferredPass> m_DeferredPass; // merged deferred only
+		std::unique_ptr<ForwardPass> m_ForwardPass; // Forward+ only
+		std::unique_ptr<VisibilityBufferPass> m_VisibilityBufferPass; // visibility buffer only
+		std::unique_ptr<TemporalUpsamplePass> m_TemporalUpsamplePass; // temporal upsampling only
+		std::unique_ptr<RenderGraph> m_RenderGraph;
+		float m_FrameTime = 0.0f;
+		std::chrono::high_resolution_clock::time_point m_StartTime{}; // construction, for the time to the first frame
+		float m_RenderScale = 1.0f; // dynamic resolution, relative to half the window size
 
 		bool m_ScenePaused = false;
 		bool m_DebugMode = false;
 		bool m_ShowHitboxes = false;
 		bool m_EnableShadows = true;
+		bool m_ShowGBufferPreviews = true;
 
 		// Entities
 		std::vector<std::unique_ptr<Entity>> m_Entities{};
+		std::set<entity_id> m_EntityIDs{};
 		std::shared_ptr<Texture2D> icons = nullptr;
 
 		ComponentManager m_ComponentManager{};
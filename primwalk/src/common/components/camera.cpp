@@ -6,6 +6,21 @@
 
 namespace pw {
 
+	static constexpr uint32_t JITTER_SAMPLES = 8;
+
+	static float halton(uint32_t index, uint32_t base) {
+		float result = 0.0f;
+		float fraction = 1.0f;
+
+		while (index > 0) {
+			fraction /= static_cast<float>(base);
+			result += fraction * static_cast<float>(index % base);
+			index /= base;
+		}
+
+		return result;
+	}
+
 	// TODO: Optimization: do as little matrix computations on CPU side as possible
 	void Camera::update(float width, float height)
 	{
@@ -18,9 +33,29 @@ namespace pw {
 		m_Right = glm::normalize(glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), m_Forward));
 		m_Up = glm::normalize(glm::cross(m_Forward, m_Right));
 
+		m_PreviousViewProjection = getUnjitteredViewProjection();
+
 		m_FovRatio = width / height;
 		m_ViewMatrix = glm::lookAt(position, position + m_Forward, -m_Up);
 		m_ProjectionMatrix = glm::perspective(glm::radians(fov), m_FovRatio, nearClip, farClip);
+		m_UnjitteredProjectionMatrix = m_ProjectionMatrix;
+
+		// Halton (2, 3) offsets within one pixel, applied in NDC after the projection
+		if (m_JitterEnabled) {
+			m_JitterIndex = (m_JitterIndex + 1) % JITTER_SAMPLES;
+
+			glm::vec2 offset = { halton(m_JitterIndex + 1, 2) - 0.5f, halton(m_JitterIndex + 1, 3) - 0.5f };
+			m_Jitter = offset * 2.0f / m_JitterResolution;
+			m_ProjectionMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(m_Jitter, 0.0f)) * m_ProjectionMatrix;
+		}
+		else {
+			m_Jitter = glm::vec2(0.0f);
+		}
+	}
+
+	void Camera::setJitter(bool enabled, glm::vec2 renderSize) {
+		m_JitterEnabled = enabled;
+		m_JitterResolution = glm::max(renderSize, glm::vec2(1.0f));
 	}
 
 	std::array<glm::vec4, 8> Camera::getFrustum() const {
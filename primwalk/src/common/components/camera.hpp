@@ -5,6 +5,7 @@
 
 // std
 #include <array>
+#include <cstdint>
 #include <memory>
 
 // vendor
@@ -20,7 +21,10 @@ namespace pw {
 		void update(float width, float height);
 
 		inline glm::mat4 getViewMatrix() const { return m_ViewMatrix; }
-		inline glm::mat4 getProjectionMatrix() const { return m_ProjectionMatrix; }
+		inline glm::mat4 getProjectionMatrix() const { return m_ProjectionMatrix; } // jittered when jitter is enabled
+		inline glm::mat4 getUnjitteredViewProjection() const { return m_UnjitteredProjectionMatrix * m_ViewMatrix; }
+		inline glm::mat4 getPreviousViewProjection() const { return m_PreviousViewProjection; } // unjittered, of the previous update
+		inline glm::vec2 getJitter() const { return m_Jitter; } // NDC offset of this frame
 
 		inline float getYaw() const { return m_Yaw; }
 		inline float getPitch() const { return m_Pitch; }
@@ -33,6 +37,9 @@ namespace pw {
 		inline void setYaw(float radians) { m_Yaw = glm::mod(radians, glm::two_pi<float>()); }
 		inline void setPitch(float radians) { m_Pitch = glm::clamp(radians, -1.57f, 1.57f); }
 
+		/* Sub-pixel projection offsets for temporal upsampling, renderSize is the resolution the jitter is relative to */
+		void setJitter(bool enabled, glm::vec2 renderSize = glm::vec2(1.0f));
+
 		inline static std::shared_ptr<Camera> MainCamera = std::make_shared<Camera>();
 
 		glm::vec3 position = glm::vec3(0.0f);
@@ -51,5 +58,12 @@ namespace pw {
 
 		glm::mat4 m_ViewMatrix = glm::mat4(1.0f);
 		glm::mat4 m_ProjectionMatrix = glm::mat4(1.0f);
+		glm::mat4 m_UnjitteredProjectionMatrix = glm::mat4(1.0f);
+		glm::mat4 m_PreviousViewProjection = glm::mat4(1.0f);
+
+		bool m_JitterEnabled = false;
+		glm::vec2 m_JitterResolution = glm::vec2(1.0f);
+		glm::vec2 m_Jitter = glm::vec2(0.0f);
+		uint32_t m_JitterIndex = 0;
 	};
 }
\ No newline at end of file
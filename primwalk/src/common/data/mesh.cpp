@@ -1,5 +1,17 @@
 #include "mesh.hpp"
 
+// std
+#include <algorithm>
+
 namespace pw {
 
+	Mesh Mesh::getLOD(uint32_t level) const {
+		Mesh mesh = *this;
+		const MeshLOD& lod = lods[std::min(level, lodCount - 1)];
+
+		mesh.indices = lod.indices;
+		mesh.baseIndex = lod.baseIndex;
+		return mesh;
+	}
+
 }
\ No newline at end of file
@@ -4,13 +4,51 @@
 #include "../../core.hpp"
 
 // std
+#include <array>
 #include <cstdint>
 
+// vendor
+#include <glm/glm.hpp>
+
 namespace pw {
+	struct PW_API MeshLOD {
+		uint32_t indices = 0;
+		uint32_t baseIndex = 0;
+		float error = 0.0f; // geometric deviation from the full detail mesh, in model units
+	};
+
+	// Cluster of a mesh for GPU culling, laid out as read by meshletCulling.comp
+	struct PW_API Meshlet {
+		alignas(16) glm::vec3 center{ 0.0f }; // bounding sphere in model space
+		alignas(4) float radius = 0.0f;
+		alignas(16) glm::vec3 coneApex{ 0.0f }; // backface cone, every triangle faces away if
+		alignas(4) float coneCutoff = 2.0f; // dot(normalize(coneApex - eye), coneAxis) >= coneCutoff
+		alignas(16) glm::vec3 coneAxis{ 0.0f };
+		alignas(4) uint32_t firstIndex = 0; // relative to the mesh's base index
+		alignas(4) uint32_t indexCount = 0;
+	};
+
+	static_assert(sizeof(Meshlet) == 64, "Meshlet must match the Meshlet struct in meshletCulling.comp");
+
 	struct PW_API Mesh {
 		uint32_t indices = 0;
+		uint32_t vertices = 0;
 		uint32_t materialIndex = 0;
-		uint32_t baseVertex = 0;
+		uint32_t baseVertex = 0; // into the geometry store once uploaded, into the model's arrays before
 		uint32_t baseIndex = 0;
+
+		// Bounding sphere in model space
+		glm::vec3 center{ 0.0f };
+		float radius = 0.0f;
+
+		// Coarser levels index the same vertices, lods[0] is the full mesh
+		std::array<MeshLOD, 4> lods{};
+		uint32_t lodCount = 1;
+
+		// Clusters of the full detail level, ranges of its indices
+		uint32_t meshletOffset = 0; // into the model's meshlets
+		uint32_t meshletCount = 0;
+
+		Mesh getLOD(uint32_t level) const; // copy whose indices and base index draw the given level
 	};
 }
\ No newline at end of file
@@ -0,0 +1,688 @@
+#include "meshOptimizer.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace pw {
+
+	VertexCacheStatistics& VertexCacheStatistics::operator+=(const VertexCacheStatistics& other) {
+		vertexTransforms += other.vertexTransforms;
+		triangles += other.triangles;
+		vertices += other.vertices;
+		return *this;
+	}
+
+	namespace {
+		// Hashes and compares vertices by the bytes of all their streams
+		struct VertexHasher {
+			const std::vector<MeshOptimizer::VertexStream>* streams;
+
+			size_t operator()(uint32_t vertex) const {
+				// FNV-1a over the bytes
+				uint64_t hash = 14695981039346656037ull;
+
+				for (const auto& stream : *streams) {
+					const uint8_t* data = static_cast<const uint8_t*>(stream.data) + vertex * stream.stride;
+
+					for (size_t i = 0; i < stream.stride; i++) {
+						hash ^= data[i];
+						hash *= 1099511628211ull;
+					}
+				}
+
+				return static_cast<size_t>(hash);
+			}
+
+			bool operator()(uint32_t a, uint32_t b) const {
+				for (const auto& stream : *streams) {
+					const uint8_t* data = static_cast<const uint8_t*>(stream.data);
+
+					if (std::memcmp(data + a * stream.stride, data + b * stream.stride, stream.stride) != 0) {
+						return false;
+					}
+				}
+
+				return true;
+			}
+		};
+
+		// Symmetric 4x4 error quadric, the sum of squared distances to a set of planes
+		struct Quadric {
+			double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+			double b2 = 0.0, bc = 0.0, bd = 0.0;
+			double c2 = 0.0, cd = 0.0;
+			double d2 = 0.0;
+
+			static Quadric fromPlane(const glm::vec3& normal, double d) {
+				Quadric q;
+				q.a2 = double(normal.x) * normal.x; q.ab = double(normal.x) * normal.y; q.ac = double(normal.x) * normal.z; q.ad = normal.x * d;
+				q.b2 = double(normal.y) * normal.y; q.bc = double(normal.y) * normal.z; q.bd = normal.y * d;
+				q.c2 = double(normal.z) * normal.z; q.cd = normal.z * d;
+				q.d2 = d * d;
+				return q;
+			}
+
+			Quadric& operator+=(const Quadric& q) {
+				a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+				b2 += q.b2; bc += q.bc; bd += q.bd;
+				c2 += q.c2; cd += q.cd;
+				d2 += q.d2;
+				return *this;
+			}
+
+			double evaluate(const glm::vec3& p) const {
+				double x = p.x, y = p.y, z = p.z;
+				double error = a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x
+					+ b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y
+					+ c2 * z * z + 2.0 * cd * z
+					+ d2;
+				return std::max(error, 0.0);
+			}
+		};
+
+		struct Collapse {
+			uint32_t from = 0;
+			uint32_t to = 0;
+			double cost = 0.0;
+		};
+	}
+
+	uint32_t MeshOptimizer::generateVertexRemap(std::vector<uint32_t>& remap, const std::vector<uint32_t>& indices, size_t vertexCount,
+		const std::vector<VertexStream>& streams) {
+		remap.assign(vertexCount, INVALID_INDEX);
+
+		VertexHasher hasher{ &streams };
+		std::unordered_map<uint32_t, uint32_t, VertexHasher, VertexHasher> unique(vertexCount, hasher, hasher);
+		uint32_t uniqueCount = 0;
+
+		// Walk the indices rather than the vertices so unreferenced vertices are dropped
+		for (uint32_t index : indices) {
+			if (remap[index] != INVALID_INDEX) {
+				continue;
+			}
+
+			auto result = unique.insert({ index, uniqueCount });
+
+			if (result.second) {
+				remap[index] = uniqueCount++;
+			}
+			else {
+				remap[index] = result.first->second;
+			}
+		}
+
+		return uniqueCount;
+	}
+
+	uint32_t MeshOptimizer::optimizeVertexFetch(std::vector<uint32_t>& remap, const std::vector<uint32_t>& indices, size_t vertexCount) {
+		remap.assign(vertexCount, INVALID_INDEX);
+		uint32_t nextVertex = 0;
+
+		for (uint32_t index : indices) {
+			if (remap[index] == INVALID_INDEX) {
+				remap[index] = nextVertex++;
+			}
+		}
+
+		return nextVertex;
+	}
+
+	void MeshOptimizer::remapIndices(std::vector<uint32_t>& indices, const std::vector<uint32_t>& remap) {
+		for (auto& index : indices) {
+			index = remap[index];
+		}
+	}
+
+	void MeshOptimizer::optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>* clusters) {
+		const size_t triangleCount = indices.size() / 3;
+
+		if (clusters) {
+			clusters->assign(1, 0);
+		}
+
+		if (triangleCount == 0) {
+			return;
+		}
+
+		// Vertex to triangle adjacency, liveTriangles counts the ones not emitted yet
+		std::vector<uint32_t> liveTriangles(vertexCount, 0);
+
+		for (uint32_t index : indices) {
+			liveTriangles[index]++;
+		}
+
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+
+		for (size_t i = 0; i < vertexCount; i++) {
+			adjacencyOffsets[i + 1] = adjacencyOffsets[i] + liveTriangles[i];
+		}
+
+		std::vector<uint32_t> adjacency(indices.size());
+		std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+		for (size_t i = 0; i < indices.size(); i++) {
+			adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		std::vector<uint32_t> cacheTime(vertexCount, 0);
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<uint32_t> deadEnds;
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+		deadEnds.reserve(indices.size());
+
+		uint32_t timestamp = CACHE_SIZE + 1;
+		uint32_t cursor = 0; // of the scan for vertices with live triangles, once the dead-end stack ran dry
+		uint32_t fanning = indices[0];
+
+		while (fanning != INVALID_INDEX) {
+			candidates.clear();
+
+			// Emit every remaining triangle around the fanning vertex
+			for (uint32_t i = adjacencyOffsets[fanning]; i < adjacencyOffsets[fanning + 1]; i++) {
+				uint32_t triangle = adjacency[i];
+
+				if (emitted[triangle]) {
+					continue;
+				}
+
+				for (uint32_t j = 0; j < 3; j++) {
+					uint32_t vertex = indices[triangle * 3 + j];
+
+					result.push_back(vertex);
+					deadEnds.push_back(vertex);
+					candidates.push_back(vertex);
+					liveTriangles[vertex]--;
+
+					if (timestamp - cacheTime[vertex] > CACHE_SIZE) {
+						cacheTime[vertex] = timestamp++;
+					}
+				}
+
+				emitted[triangle] = true;
+			}
+
+			// Next fanning vertex, the one that stays in the cache longest among those that can still
+			// have all their triangles emitted before falling out of it
+			uint32_t next = INVALID_INDEX;
+			int64_t bestPriority = -1;
+
+			for (uint32_t vertex : candidates) {
+				if (liveTriangles[vertex] == 0) {
+					continue;
+				}
+
+				int64_t priority = 0;
+
+				if (timestamp - cacheTime[vertex] + 2 * liveTriangles[vertex] <= CACHE_SIZE) {
+					priority = timestamp - cacheTime[vertex];
+				}
+
+				if (priority > bestPriority) {
+					bestPriority = priority;
+					next = vertex;
+				}
+			}
+
+			// Dead end, restart from a recently used vertex or any vertex with triangles left
+			if (next == INVALID_INDEX) {
+				while (!deadEnds.empty() && next == INVALID_INDEX) {
+					uint32_t vertex = deadEnds.back();
+					deadEnds.pop_back();
+
+					if (liveTriangles[vertex] > 0) {
+						next = vertex;
+					}
+				}
+
+				while (next == INVALID_INDEX && cursor < vertexCount) {
+					if (liveTriangles[cursor] > 0) {
+						next = cursor;
+					}
+
+					cursor++;
+				}
+
+				if (clusters && next != INVALID_INDEX) {
+					clusters->push_back(static_cast<uint32_t>(result.size() / 3));
+				}
+			}
+
+			fanning = next;
+		}
+
+		indices = std::move(result);
+	}
+
+	void MeshOptimizer::optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& clusters) {
+		const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+		if (clusters.size() <= 1) {
+			return;
+		}
+
+		struct Cluster {
+			uint32_t begin = 0;
+			uint32_t end = 0;
+			glm::vec3 centroid{ 0.0f };
+			glm::vec3 normal{ 0.0f }; // area weighted
+			float area = 0.0f;
+			float sortKey = 0.0f;
+		};
+
+		std::vector<Cluster> sorted(clusters.size());
+		glm::vec3 meshCentroid(0.0f);
+		float meshArea = 0.0f;
+
+		for (size_t i = 0; i < clusters.size(); i++) {
+			Cluster& cluster = sorted[i];
+			cluster.begin = clusters[i];
+			cluster.end = i + 1 < clusters.size() ? clusters[i + 1] : triangleCount;
+
+			for (uint32_t triangle = cluster.begin; triangle < cluster.end; triangle++) {
+				const glm::vec3& p0 = positions[indices[triangle * 3 + 0]];
+				const glm::vec3& p1 = positions[indices[triangle * 3 + 1]];
+				const glm::vec3& p2 = positions[indices[triangle * 3 + 2]];
+
+				glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+				float area = glm::length(normal) * 0.5f;
+
+				cluster.centroid += (p0 + p1 + p2) * (area / 3.0f);
+				cluster.normal += normal;
+				cluster.area += area;
+			}
+
+			meshCentroid += cluster.centroid;
+			meshArea += cluster.area;
+
+			if (cluster.area > 0.0f) {
+				cluster.centroid /= cluster.area;
+			}
+		}
+
+		if (meshArea > 0.0f) {
+			meshCentroid /= meshArea;
+		}
+
+		// Clusters facing away from the mesh center tend to occlude the rest, so they go first
+		for (auto& cluster : sorted) {
+			float normalLength = glm::length(cluster.normal);
+
+			if (normalLength > 0.0f) {
+				cluster.sortKey = glm::dot(cluster.centroid - meshCentroid, cluster.normal / normalLength);
+			}
+		}
+
+		std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) {
+			return a.sortKey > b.sortKey;
+		});
+
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+
+		for (const auto& cluster : sorted) {
+			result.insert(result.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+		}
+
+		indices = std::move(result);
+	}
+
+	std::vector<uint32_t> MeshOptimizer::simplify(const std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions,
+		size_t targetIndexCount, float targetError, float* resultError) {
+		const size_t vertexCount = positions.size();
+		std::vector<uint32_t> result = indices;
+		double maxCost = 0.0;
+
+		// Quadrics of the planes around each vertex
+		std::vector<Quadric> quadrics(vertexCount);
+
+		for (size_t i = 0; i + 2 < result.size(); i += 3) {
+			const glm::vec3& p0 = positions[result[i + 0]];
+			glm::vec3 normal = glm::cross(positions[result[i + 1]] - p0, positions[result[i + 2]] - p0);
+			float length = glm::length(normal);
+
+			if (length == 0.0f) {
+				continue;
+			}
+
+			normal /= length;
+			Quadric plane = Quadric::fromPlane(normal, -double(glm::dot(normal, p0)));
+
+			for (size_t j = 0; j < 3; j++) {
+				quadrics[result[i + j]] += plane;
+			}
+		}
+
+		// Edges not shared by exactly two triangles are borders, seams (split vertices) or non-manifold
+		std::vector<bool> locked(vertexCount, false);
+		{
+			std::vector<uint64_t> edges;
+			edges.reserve(result.size());
+
+			for (size_t i = 0; i < result.size(); i += 3) {
+				for (size_t j = 0; j < 3; j++) {
+					uint32_t a = result[i + j];
+					uint32_t b = result[i + (j + 1) % 3];
+					edges.push_back((uint64_t(std::min(a, b)) << 32) | std::max(a, b));
+				}
+			}
+
+			std::sort(edges.begin(), edges.end());
+
+			for (size_t i = 0; i < edges.size();) {
+				size_t count = 1;
+
+				while (i + count < edges.size() && edges[i + count] == edges[i]) {
+					count++;
+				}
+
+				if (count != 2) {
+					locked[uint32_t(edges[i] >> 32)] = true;
+					locked[uint32_t(edges[i])] = true;
+				}
+
+				i += count;
+			}
+		}
+
+		const double maxAllowedCost = double(targetError) * targetError;
+		std::vector<uint32_t> remap(vertexCount);
+		std::vector<bool> touched(vertexCount);
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+		std::vector<uint32_t> adjacency;
+		std::vector<Collapse> collapses;
+
+		// Each pass collapses a set of independent edges, cheapest first, then rebuilds the index list
+		while (result.size() > targetIndexCount) {
+			// Vertex to triangle adjacency of the current result
+			std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+
+			for (uint32_t index : result) {
+				adjacencyOffsets[index + 1]++;
+			}
+
+			for (size_t i = 0; i < vertexCount; i++) {
+				adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+			}
+
+			adjacency.resize(result.size());
+			std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+			for (size_t i = 0; i < result.size(); i++) {
+				adjacency[fill[result[i]]++] = static_cast<uint32_t>(i / 3);
+			}
+
+			// Both directions of every edge, the surviving vertex keeps its position
+			collapses.clear();
+
+			for (size_t i = 0; i < result.size(); i += 3) {
+				for (size_t j = 0; j < 3; j++) {
+					uint32_t a = result[i + j];
+					uint32_t b = result[i + (j + 1) % 3];
+
+					for (int direction = 0; direction < 2; direction++) {
+						uint32_t from = direction == 0 ? a : b;
+						uint32_t to = direction == 0 ? b : a;
+
+						if (locked[from]) {
+							continue;
+						}
+
+						Quadric quadric = quadrics[from];
+						quadric += quadrics[to];
+						collapses.push_back({ from, to, quadric.evaluate(positions[to]) });
+					}
+				}
+			}
+
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+				return a.cost < b.cost;
+			});
+
+			for (size_t i = 0; i < vertexCount; i++) {
+				remap[i] = static_cast<uint32_t>(i);
+			}
+
+			std::fill(touched.begin(), touched.end(), false);
+
+			// An interior collapse removes two triangles
+			size_t collapseBudget = std::max<size_t>((result.size() - targetIndexCount) / 6, 1);
+			size_t collapseCount = 0;
+
+			for (const auto& collapse : collapses) {
+				if (collapse.cost > maxAllowedCost || collapseCount == collapseBudget) {
+					break;
+				}
+
+				if (touched[collapse.from] || touched[collapse.to]) {
+					continue;
+				}
+
+				// Reject collapses that flip a remaining triangle around the moved vertex, or nearly do
+				bool flips = false;
+
+				for (uint32_t k = adjacencyOffsets[collapse.from]; k < adjacencyOffsets[collapse.from + 1] && !flips; k++) {
+					const uint32_t* triangle = &result[adjacency[k] * 3];
+
+					if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to) {
+						continue; // becomes degenerate
+					}
+
+					glm::vec3 before[3];
+					glm::vec3 after[3];
+
+					for (uint32_t j = 0; j < 3; j++) {
+						before[j] = positions[triangle[j]];
+						after[j] = triangle[j] == collapse.from ? positions[collapse.to] : before[j];
+					}
+
+					glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+					glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+
+					// More than ~75 degrees of rotation counts as a flip, sliver triangles tend to get there first
+					flips = glm::dot(normalBefore, normalAfter) < 0.25f * glm::length(normalBefore) * glm::length(normalAfter);
+				}
+
+				if (flips) {
+					continue;
+				}
+
+				// Nothing around the moved vertex may change again this pass, or the flip test above would be stale
+				for (uint32_t k = adjacencyOffsets[collapse.from]; k < adjacencyOffsets[collapse.from + 1]; k++) {
+					const uint32_t* triangle = &result[adjacency[k] * 3];
+					touched[triangle[0]] = true;
+					touched[triangle[1]] = true;
+					touched[triangle[2]] = true;
+				}
+
+				remap[collapse.from] = collapse.to;
+				quadrics[collapse.to] += quadrics[collapse.from];
+				maxCost = std::max(maxCost, collapse.cost);
+				collapseCount++;
+			}
+
+			if (collapseCount == 0) {
+				break;
+			}
+
+			// Apply the collapses and drop the triangles that became degenerate
+			size_t writeIndex = 0;
+
+			for (size_t i = 0; i < result.size(); i += 3) {
+				uint32_t a = remap[result[i + 0]];
+				uint32_t b = remap[result[i + 1]];
+				uint32_t c = remap[result[i + 2]];
+
+				if (a == b || b == c || c == a) {
+					continue;
+				}
+
+				result[writeIndex++] = a;
+				result[writeIndex++] = b;
+				result[writeIndex++] = c;
+			}
+
+			result.resize(writeIndex);
+		}
+
+		if (resultError) {
+			*resultError = static_cast<float>(std::sqrt(maxCost));
+		}
+
+		return result;
+	}
+
+	std::vector<Meshlet> MeshOptimizer::buildMeshlets(const std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions,
+		uint32_t maxVertices, uint32_t maxTriangles) {
+		std::vector<Meshlet> meshlets;
+
+		auto finishMeshlet = [&](size_t begin, size_t end) {
+			Meshlet meshlet{};
+			meshlet.firstIndex = static_cast<uint32_t>(begin);
+			meshlet.indexCount = static_cast<uint32_t>(end - begin);
+
+			// Bounding sphere around the center of the bounding box
+			glm::vec3 min = positions[indices[begin]];
+			glm::vec3 max = min;
+
+			for (size_t i = begin; i < end; i++) {
+				min = glm::min(min, positions[indices[i]]);
+				max = glm::max(max, positions[indices[i]]);
+			}
+
+			meshlet.center = (min + max) * 0.5f;
+
+			for (size_t i = begin; i < end; i++) {
+				meshlet.radius = std::max(meshlet.radius, glm::length(positions[indices[i]] - meshlet.center));
+			}
+
+			// Normal cone, the axis is the average triangle normal and the cutoff the sine of the widest deviation from it
+			std::vector<glm::vec3> normals;
+			normals.reserve((end - begin) / 3);
+			glm::vec3 axis(0.0f);
+
+			for (size_t i = begin; i < end; i += 3) {
+				const glm::vec3& p0 = positions[indices[i + 0]];
+				glm::vec3 normal = glm::cross(positions[indices[i + 1]] - p0, positions[indices[i + 2]] - p0);
+				float length = glm::length(normal);
+
+				if (length > 0.0f) {
+					normals.push_back(normal / length);
+					axis += normals.back();
+				}
+				else {
+					normals.push_back(glm::vec3(0.0f)); // degenerate, never visible
+				}
+			}
+
+			float axisLength = glm::length(axis);
+
+			if (axisLength <= 0.0f) {
+				meshlets.push_back(meshlet);
+				return;
+			}
+
+			axis /= axisLength;
+			float minDot = 1.0f;
+
+			for (const auto& normal : normals) {
+				if (normal != glm::vec3(0.0f)) {
+					minDot = std::min(minDot, glm::dot(normal, axis));
+				}
+			}
+
+			// Wider than about 84 degrees is never entirely back facing in practice, keep the cone disabled
+			if (minDot > 0.1f) {
+				// Move the apex behind every triangle plane, so all of them face away whenever the apex does
+				float maxT = 0.0f;
+
+				for (size_t i = begin, t = 0; i < end; i += 3, t++) {
+					if (normals[t] != glm::vec3(0.0f)) {
+						maxT = std::max(maxT, glm::dot(meshlet.center - positions[indices[i]], normals[t]) / glm::dot(axis, normals[t]));
+					}
+				}
+
+				meshlet.coneApex = meshlet.center - axis * maxT;
+				meshlet.coneAxis = axis;
+				meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+			}
+
+			meshlets.push_back(meshlet);
+		};
+
+		// Consecutive triangles are grouped, the index order already keeps neighbouring triangles together
+		std::vector<uint32_t> stamps(positions.size(), INVALID_INDEX);
+		uint32_t meshletID = 0;
+		uint32_t meshletVertices = 0;
+		size_t begin = 0;
+
+		for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+			auto countNewVertices = [&]() {
+				uint32_t count = 0;
+
+				for (size_t k = 0; k < 3; k++) {
+					const uint32_t index = indices[i + k];
+					bool repeated = (k > 0 && index == indices[i]) || (k > 1 && index == indices[i + 1]);
+
+					if (stamps[index] != meshletID && !repeated) {
+						count++;
+					}
+				}
+
+				return count;
+			};
+
+			uint32_t newVertices = countNewVertices();
+
+			if (meshletVertices + newVertices > maxVertices || (i - begin) / 3 >= maxTriangles) {
+				finishMeshlet(begin, i);
+
+				begin = i;
+				meshletID++;
+				meshletVertices = 0;
+				newVertices = countNewVertices();
+			}
+
+			for (size_t k = 0; k < 3; k++) {
+				stamps[indices[i + k]] = meshletID;
+			}
+
+			meshletVertices += newVertices;
+		}
+
+		if (begin + 2 < indices.size()) {
+			finishMeshlet(begin, indices.size() / 3 * 3);
+		}
+
+		return meshlets;
+	}
+
+	VertexCacheStatistics MeshOptimizer::analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize) {
+		VertexCacheStatistics statistics{};
+		statistics.triangles = static_cast<uint32_t>(indices.size() / 3);
+
+		// FIFO cache, a vertex is cached if it was one of the last cacheSize misses
+		std::vector<uint32_t> cacheTime(vertexCount, 0);
+		std::vector<bool> referenced(vertexCount, false);
+		uint32_t timestamp = cacheSize + 1;
+
+		for (uint32_t index : indices) {
+			if (timestamp - cacheTime[index] > cacheSize) {
+				cacheTime[index] = timestamp++;
+				statistics.vertexTransforms++;
+			}
+
+			if (!referenced[index]) {
+				referenced[index] = true;
+				statistics.vertices++;
+			}
+		}
+
+		return statistics;
+	}
+
+}
\ No newline at end of file
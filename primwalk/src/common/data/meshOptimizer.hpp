@@ -0,0 +1,87 @@
+#pragma once
+
+// primwalk
+#include "../../core.hpp"
+#include "mesh.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+// vendor
+#include <glm/glm.hpp>
+
+namespace pw {
+	// Simulated post-transform vertex cache behaviour of an index buffer
+	struct PW_API VertexCacheStatistics {
+		uint32_t vertexTransforms = 0; // cache misses
+		uint32_t triangles = 0;
+		uint32_t vertices = 0; // referenced by the indices
+
+		float getACMR() const { return triangles > 0 ? float(vertexTransforms) / float(triangles) : 0.0f; } // 0.5 at best, 3 at worst
+		float getATVR() const { return vertices > 0 ? float(vertexTransforms) / float(vertices) : 0.0f; } // 1 at best
+
+		VertexCacheStatistics& operator+=(const VertexCacheStatistics& other);
+	};
+
+	/*
+	* Import-time index and vertex reordering for triangle lists, run once per mesh in this order:
+	* 1. generateVertexRemap() + remapVertices()/remapIndices(), merges bit-identical vertices
+	* 2. optimizeVertexCache(), Tipsify (Sander et al. 2007), also returns the clusters for the next step
+	* 3. optimizeOverdraw(), sorts those clusters so outward facing ones are drawn first
+	* 4. optimizeVertexFetch() + remapVertices()/remapIndices(), stores vertices in the order they are first used
+	* Remaps map old vertex indices to new ones, unreferenced vertices map to INVALID_INDEX and are dropped.
+	* simplify() then derives detail levels from the result that share its vertices, buildMeshlets() clusters it for culling.
+	*/
+	class PW_API MeshOptimizer {
+	public:
+		struct VertexStream {
+			const void* data = nullptr;
+			size_t stride = 0; // compared byte-wise, so padding must be zeroed
+		};
+
+		static uint32_t generateVertexRemap(std::vector<uint32_t>& remap, const std::vector<uint32_t>& indices, size_t vertexCount,
+			const std::vector<VertexStream>& streams); // returns the unique vertex count
+		static uint32_t optimizeVertexFetch(std::vector<uint32_t>& remap, const std::vector<uint32_t>& indices, size_t vertexCount);
+		static void remapIndices(std::vector<uint32_t>& indices, const std::vector<uint32_t>& remap);
+
+		template<typename T>
+		static std::vector<T> remapVertices(const std::vector<T>& vertices, const std::vector<uint32_t>& remap, uint32_t uniqueCount) {
+			std::vector<T> result(uniqueCount);
+
+			for (size_t i = 0; i < vertices.size(); i++) {
+				if (remap[i] != INVALID_INDEX) {
+					result[remap[i]] = vertices[i];
+				}
+			}
+
+			return result;
+		}
+
+		// clusters receives the first triangle of each cluster, split wherever the fan had to restart elsewhere
+		static void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>* clusters = nullptr);
+		static void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& clusters);
+
+		// Edge collapse with quadric error metrics (Garland and Heckbert 1997). Vertices only collapse onto other vertices,
+		// so the result indexes the same vertex buffer. Vertices on borders, attribute seams and non-manifold edges stay
+		// in place. Stops at targetIndexCount or once the next collapse would exceed targetError, in model units.
+		static std::vector<uint32_t> simplify(const std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions,
+			size_t targetIndexCount, float targetError, float* resultError = nullptr);
+
+		// Splits a triangle list into ranges of at most maxVertices unique vertices and maxTriangles triangles, in
+		// index order, with their bounding spheres and normal cones. Meant to run on the vertex cache optimized order.
+		static std::vector<Meshlet> buildMeshlets(const std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions,
+			uint32_t maxVertices = MAX_MESHLET_VERTICES, uint32_t maxTriangles = MAX_MESHLET_TRIANGLES);
+
+		static VertexCacheStatistics analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = CACHE_SIZE);
+
+		static constexpr uint32_t INVALID_INDEX = ~0u;
+		static constexpr uint32_t CACHE_SIZE = 16; // FIFO entries, conservative for current GPUs
+		static constexpr uint32_t MAX_MESHLET_VERTICES = 64;
+		static constexpr uint32_t MAX_MESHLET_TRIANGLES = 124; // 64 and 124 fit the output limits of mesh shaders as well
+
+	private:
+		MeshOptimizer() = default;
+		~MeshOptimizer() = default;
+	};
+}
\ No newline at end of file
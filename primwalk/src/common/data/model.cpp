@@ -2,7 +2,11 @@
 #include <assimp/scene.h>
 
 // std
+#include <algorithm>
+#include <atomic>
+#include <iostream>
 #include <stdexcept>
+#include <utility>
 
 // vendor
 #include <assimp/Importer.hpp>
@@ -32,15 +36,33 @@ namespace pw {
 		initFromScene(scene);
 		initMaterials(scene, modelDir);
 
-		createVertexBuffer(m_Vertices);
-		createIndexBuffer(m_Indices);
+		uint32_t importedVertices = static_cast<uint32_t>(m_Vertices.size());
+		VertexCacheStatistics before{}, after{};
+		optimizeMeshes(before, after);
+
+		createGeometry();
+		createMeshletBuffer(m_Meshlets);
+
+		std::cout << "Optimized " << path << ": " << importedVertices << " -> " << m_Vertices.size() << " vertices, ACMR "
+			<< before.getACMR() << " -> " << after.getACMR() << ", ATVR " << before.getATVR() << " -> " << after.getATVR()
+			<< ", " << m_Meshlets.size() << " meshlets" << (getIndexType() == VK_INDEX_TYPE_UINT16 ? ", 16-bit indices\n" : "\n");
+	}
+
+	Model::Model() {
+		static std::atomic<uint64_t> nextID{ 1 };
+		m_ID = nextID++;
+	}
+
+	Model::~Model() {
+		if (m_Geometry.isValid() || m_MeshletBuffer) {
+			GraphicsDevice_Vulkan* device = (GraphicsDevice_Vulkan*&)pw::GetDevice();
+			device->getGeometryStore().free(m_Geometry, std::move(m_MeshletBuffer));
+		}
 	}
 
-	void Model::bind(VkCommandBuffer commandBuffer) {
-		VkBuffer buffers[] = { m_VertexBuffer->getBuffer() };
-		VkDeviceSize offsets[] = { 0 };
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
-		vkCmdBindIndexBuffer(commandBuffer, m_IndexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+	bool Model::isReady() const {
+		GraphicsDevice_Vulkan* device = (GraphicsDevice_Vulkan*&)pw::GetDevice();
+		return device->getUploadManager().isComplete(m_UploadTicket);
 	}
 
 	std::shared_ptr<pw::Texture2D> Model::getDiffuseMap(uint32_t materialIndex) {
@@ -59,63 +81,51 @@ namespace pw {
 		return m_NormalMaps[materialIndex];
 	}
 
-	void Model::createVertexBuffer(const std::vector<Vertex3D>& vertices) {
+	void Model::createGeometry() {
 		GraphicsDevice_Vulkan* device = (GraphicsDevice_Vulkan*&)pw::GetDevice();
+		GeometryStore& geometryStore = device->getGeometryStore();
 
-		uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+		uint32_t vertexCount = static_cast<uint32_t>(m_Positions.size());
 		assert(vertexCount >= 3 && "VULKAN ASSERTION FAILED: Vertex count must be >= 3");
 
-		VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-		uint32_t vertexSize = sizeof(vertices[0]);
-
-		Buffer stagingBuffer = {
-			*device,
-			vertexSize,
-			vertexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-		};
+		// Indices are relative to the mesh's base vertex, so 16 bits suffice if no mesh has more vertices
+		bool shortIndices = std::all_of(m_Meshes.begin(), m_Meshes.end(), [](const Mesh& mesh) {
+			return mesh.vertices <= 65536;
+		});
 
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*)vertices.data());
+		m_Geometry = geometryStore.allocate(vertexCount, static_cast<uint32_t>(m_Indices.size()),
+			shortIndices ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32);
+		m_UploadTicket = geometryStore.upload(m_Geometry, m_Positions.data(), m_Vertices.data(), m_Indices.data());
 
-		m_VertexBuffer = std::make_unique<Buffer>(
-			*device,
-			vertexSize,
-			vertexCount,
-			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		// Meshes are drawn straight from the shared buffers, meshlet ranges stay relative to their mesh
+		for (Mesh& mesh : m_Meshes) {
+			mesh.baseVertex += m_Geometry.baseVertex;
+			mesh.baseIndex += m_Geometry.baseIndex;
 
-		device->copyBuffer(stagingBuffer.getBuffer(), m_VertexBuffer->getBuffer(), bufferSize);
+			for (MeshLOD& lod : mesh.lods) {
+				lod.baseIndex += m_Geometry.baseIndex;
+			}
+		}
 	}
 
-	void Model::createIndexBuffer(const std::vector<uint32_t>& indices) {
+	void Model::createMeshletBuffer(const std::vector<Meshlet>& meshlets) {
 		GraphicsDevice_Vulkan* device = (GraphicsDevice_Vulkan*&)pw::GetDevice();
 
-		uint32_t indexCount = static_cast<uint32_t>(indices.size());
-
-		VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
-		uint32_t indexSize = sizeof(indices[0]);
-
-		Buffer stagingBuffer = {
-			*device,
-			indexSize,
-			indexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-		};
+		if (meshlets.empty()) {
+			return;
+		}
 
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*)indices.data());
+		uint32_t meshletCount = static_cast<uint32_t>(meshlets.size());
+		VkDeviceSize bufferSize = sizeof(meshlets[0]) * meshletCount;
 
-		m_IndexBuffer = std::make_unique<Buffer>(
+		m_MeshletBuffer = std::make_unique<Buffer>(
 			*device,
-			indexSize,
-			indexCount,
-			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			sizeof(meshlets[0]),
+			meshletCount,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-		device->copyBuffer(stagingBuffer.getBuffer(), m_IndexBuffer->getBuffer(), bufferSize);
+		m_UploadTicket = device->getUploadManager().uploadBuffer(*m_MeshletBuffer, meshlets.data(), bufferSize);
 	}
 
 	void Model::initFromScene(const aiScene* scene) {
@@ -143,21 +153,17 @@ namespace pw {
 			for (size_t j = 0; j < mesh->mNumVertices; j++) {
 				const aiVector3D& position = mesh->mVertices[j];
 				const aiVector3D& normal = mesh->mNormals[j];
-				const aiVector3D& tangent = mesh->mTangents[j];
-				const aiVector3D& bitangent = mesh->mBitangents[j];
+				// Meshes without texture coordinates have no tangents, packing picks one
+				const aiVector3D& tangent = mesh->mTangents != nullptr ? mesh->mTangents[j] : zero3D;
+				const aiVector3D& bitangent = mesh->mBitangents != nullptr ? mesh->mBitangents[j] : zero3D;
 				const aiVector3D& texCoord = mesh->HasTextureCoords(0) ? mesh->mTextureCoords[0][j] : zero3D;
 
-				m_Vertices[vertexID].position = glm::vec3(position.x, position.y, position.z);
-				m_Vertices[vertexID].normal = glm::vec3(normal.x, normal.y, normal.z);
-
-				if (mesh->mTangents != nullptr) {
-					m_Vertices[vertexID].tangent = glm::vec3(tangent.x, tangent.y, tangent.z);
-				}
-
-				if (mesh->mBitangents != nullptr) {
-					m_Vertices[vertexID].bitangent = glm::vec3(bitangent.x, bitangent.y, bitangent.z);
-				}
-				m_Vertices[vertexID].texCoord = glm::vec2(texCoord.x, texCoord.y);
+				m_Positions[vertexID] = glm::vec3(position.x, position.y, position.z);
+				m_Vertices[vertexID] = Vertex3D::pack(
+					glm::vec3(normal.x, normal.y, normal.z),
+					glm::vec3(tangent.x, tangent.y, tangent.z),
+					glm::vec3(bitangent.x, bitangent.y, bitangent.z),
+					glm::vec2(texCoord.x, texCoord.y));
 				vertexID++;
 			}
 
@@ -174,6 +180,129 @@ namespace pw {
 		}
 	}
 
+	void Model::optimizeMeshes(VertexCacheStatistics& before, VertexCacheStatistics& after) {
+		std::vector<glm::vec3> positions;
+		std::vector<Vertex3D> vertices;
+		std::vector<uint32_t> indices;
+		std::vector<Meshlet> meshlets;
+		positions.reserve(m_Positions.size());
+		vertices.reserve(m_Vertices.size());
+		indices.reserve(m_Indices.size());
+
+		std::vector<uint32_t> remap;
+		std::vector<uint32_t> clusters;
+
+		for (auto& mesh : m_Meshes) {
+			std::vector<glm::vec3> meshPositions(m_Positions.begin() + mesh.baseVertex, m_Positions.begin() + mesh.baseVertex + mesh.vertices);
+			std::vector<Vertex3D> meshVertices(m_Vertices.begin() + mesh.baseVertex, m_Vertices.begin() + mesh.baseVertex + mesh.vertices);
+			std::vector<uint32_t> meshIndices(m_Indices.begin() + mesh.baseIndex, m_Indices.begin() + mesh.baseIndex + mesh.indices);
+
+			before += MeshOptimizer::analyzeVertexCache(meshIndices, meshVertices.size());
+
+			// 1. Merge identical vertices, Assimp emits them per face
+			std::vector<MeshOptimizer::VertexStream> streams = {
+				{ meshPositions.data(), sizeof(glm::vec3) },
+				{ meshVertices.data(), sizeof(Vertex3D) }
+			};
+
+			uint32_t uniqueCount = MeshOptimizer::generateVertexRemap(remap, meshIndices, meshVertices.size(), streams);
+			meshPositions = MeshOptimizer::remapVertices(meshPositions, remap, uniqueCount);
+			meshVertices = MeshOptimizer::remapVertices(meshVertices, remap, uniqueCount);
+			MeshOptimizer::remapIndices(meshIndices, remap);
+
+			// 2. Post-transform cache, then 3. overdraw on the resulting clusters
+			MeshOptimizer::optimizeVertexCache(meshIndices, uniqueCount, &clusters);
+			MeshOptimizer::optimizeOverdraw(meshIndices, meshPositions, clusters);
+
+			// 4. Vertex fetch locality
+			uniqueCount = MeshOptimizer::optimizeVertexFetch(remap, meshIndices, uniqueCount);
+			meshPositions = MeshOptimizer::remapVertices(meshPositions, remap, uniqueCount);
+			meshVertices = MeshOptimizer::remapVertices(meshVertices, remap, uniqueCount);
+			MeshOptimizer::remapIndices(meshIndices, remap);
+
+			after += MeshOptimizer::analyzeVertexCache(meshIndices, uniqueCount);
+
+			mesh.baseVertex = static_cast<uint32_t>(vertices.size());
+			mesh.baseIndex = static_cast<uint32_t>(indices.size());
+			mesh.vertices = uniqueCount;
+			mesh.indices = static_cast<uint32_t>(meshIndices.size());
+
+			computeBounds(mesh, meshPositions);
+
+			// 5. Clusters of the full detail level for GPU culling, before the coarser levels are appended
+			std::vector<Meshlet> meshMeshlets = MeshOptimizer::buildMeshlets(meshIndices, meshPositions);
+			mesh.meshletOffset = static_cast<uint32_t>(meshlets.size());
+			mesh.meshletCount = static_cast<uint32_t>(meshMeshlets.size());
+			meshlets.insert(meshlets.end(), meshMeshlets.begin(), meshMeshlets.end());
+
+			generateLODs(mesh, meshPositions, meshIndices);
+
+			positions.insert(positions.end(), meshPositions.begin(), meshPositions.end());
+			vertices.insert(vertices.end(), meshVertices.begin(), meshVertices.end());
+			indices.insert(indices.end(), meshIndices.begin(), meshIndices.end());
+		}
+
+		m_Positions = std::move(positions);
+		m_Vertices = std::move(vertices);
+		m_Indices = std::move(indices);
+		m_Meshlets = std::move(meshlets);
+	}
+
+	void Model::computeBounds(Mesh& mesh, const std::vector<glm::vec3>& positions) {
+		if (positions.empty()) {
+			return;
+		}
+
+		glm::vec3 min = positions[0];
+		glm::vec3 max = positions[0];
+
+		for (const auto& position : positions) {
+			min = glm::min(min, position);
+			max = glm::max(max, position);
+		}
+
+		mesh.center = (min + max) * 0.5f;
+		mesh.radius = 0.0f;
+
+		for (const auto& position : positions) {
+			mesh.radius = std::max(mesh.radius, glm::length(position - mesh.center));
+		}
+	}
+
+	void Model::generateLODs(Mesh& mesh, const std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices) {
+		const std::vector<uint32_t> fullIndices(indices.begin(), indices.begin() + mesh.indices);
+
+		mesh.lods[0] = { mesh.indices, mesh.baseIndex, 0.0f };
+		mesh.lodCount = 1;
+
+		size_t previousCount = fullIndices.size();
+
+		// Every level halves the triangles of the previous one, all are simplified from the full mesh
+		for (uint32_t level = 1; level < mesh.lods.size(); level++) {
+			size_t target = (previousCount / 2) / 3 * 3;
+
+			if (target < MIN_LOD_INDICES) {
+				break;
+			}
+
+			float error = 0.0f;
+			std::vector<uint32_t> lodIndices = MeshOptimizer::simplify(fullIndices, positions, target, mesh.radius * MAX_LOD_ERROR, &error);
+
+			// Not worth another level, the mesh is locked by seams or already too coarse for the error budget
+			if (lodIndices.size() > previousCount * 3 / 4) {
+				break;
+			}
+
+			MeshOptimizer::optimizeVertexCache(lodIndices, positions.size());
+
+			mesh.lods[level] = { static_cast<uint32_t>(lodIndices.size()), mesh.baseIndex + static_cast<uint32_t>(indices.size()), error };
+			mesh.lodCount++;
+			previousCount = lodIndices.size();
+
+			indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+		}
+	}
+
 	void Model::initMaterials(const aiScene* scene, const std::string& modelDir) {
 		for (uint32_t i = 0; i < scene->mNumMaterials; i++) {
 			const aiMaterial* material = scene->mMaterials[i];
@@ -190,15 +319,17 @@ namespace pw {
 		for (size_t i = 0; i < m_Meshes.size(); i++) {
 			m_Meshes[i].materialIndex = static_cast<uint32_t>(scene->mMeshes[i]->mMaterialIndex);
 			m_Meshes[i].indices = static_cast<uint32_t>(scene->mMeshes[i]->mNumFaces * 3);
+			m_Meshes[i].vertices = static_cast<uint32_t>(scene->mMeshes[i]->mNumVertices);
 			m_Meshes[i].baseVertex = numVertices; // first vertex of current mesh
 			m_Meshes[i].baseIndex = numIndices; // first index of current mesh
 
-			numVertices += static_cast<uint32_t>(scene->mMeshes[i]->mNumVertices);
+			numVertices += m_Meshes[i].vertices;
 			numIndices += m_Meshes[i].indices;
 		}
 	}
 
 	void Model::reserveSpace(const uint32_t& numVertices, const uint32_t& numIndices) {
+		m_Positions.resize(numVertices);
 		m_Vertices.resize(numVertices);
 		m_Indices.resize(numIndices);
 	}
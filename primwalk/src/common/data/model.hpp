@@ -3,9 +3,12 @@
 // primwalk
 #include "../../core.hpp"
 #include "mesh.hpp"
+#include "meshOptimizer.hpp"
 #include "../rendering/buffer.hpp"
+#include "../rendering/geometryStore.hpp"
 #include "../rendering/vertex3d.hpp"
 #include "../rendering/texture2D.hpp"
+#include "../rendering/uploadManager.hpp"
 
 // std
 #include <cstdint>
@@ -20,21 +23,28 @@
 namespace pw {
 	class PW_API Model {
 	public:
-		Model() {};
-		~Model() = default;
+		Model();
+		~Model();
 
 		void loadFromFile(const std::string& path);
-		void bind(VkCommandBuffer commandBuffer);
 
 		std::vector<Mesh>& getMeshes() { return m_Meshes; }
 		std::shared_ptr<Texture2D> getDiffuseMap(uint32_t materialIndex);
 		std::shared_ptr<Texture2D> getNormalMap(uint32_t materialIndex);
+		inline const GeometryAllocation& getGeometry() const { return m_Geometry; } // range in the device's GeometryStore
+		inline Buffer* getMeshletBuffer() const { return m_MeshletBuffer.get(); } // nullptr if the model has no triangles
+		inline uint64_t getID() const { return m_ID; } // unique for the lifetime of the process, unlike the address
+		inline VkIndexType getIndexType() const { return m_Geometry.indexType; } // 16-bit if every mesh allows it
+		bool isReady() const; // vertices and indices were uploaded, frames can draw the model before that already
 
 	private:
-		void createVertexBuffer(const std::vector<Vertex3D>& vertices);
-		void createIndexBuffer(const std::vector<uint32_t>& indices);
+		void createGeometry(); // offsets the meshes by the allocated range
+		void createMeshletBuffer(const std::vector<Meshlet>& meshlets);
 		void initFromScene(const aiScene* scene);
 		void initMeshes(const aiScene* scene);
+		void optimizeMeshes(VertexCacheStatistics& before, VertexCacheStatistics& after);
+		void computeBounds(Mesh& mesh, const std::vector<glm::vec3>& positions);
+		void generateLODs(Mesh& mesh, const std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices); // appends the levels to indices
 		void initMaterials(const aiScene* scene, const std::string& modelDir);
 		void countVerticesIndices(const aiScene* scene, uint32_t& numVertices, uint32_t& numIndices);
 		void reserveSpace(const uint32_t& numVertices, const uint32_t& numIndices);
@@ -42,12 +52,19 @@ namespace pw {
 		std::shared_ptr<Texture2D> getEmbeddedTexture(const aiMaterial* material, const aiScene* scene, const aiTextureType& texType, const std::string& modelDir);
 
 		std::vector<Mesh> m_Meshes{};
+		std::vector<glm::vec3> m_Positions{};
 		std::vector<Vertex3D> m_Vertices{};
 		std::vector<uint32_t> m_Indices{};
+		std::vector<Meshlet> m_Meshlets{};
 		std::unordered_map<uint32_t, std::shared_ptr<Texture2D>> m_DiffuseMaps{};
 		std::unordered_map<uint32_t, std::shared_ptr<Texture2D>> m_NormalMaps{};
 
-		std::unique_ptr<Buffer> m_VertexBuffer;
-		std::unique_ptr<Buffer> m_IndexBuffer;
+		uint64_t m_ID = 0;
+		GeometryAllocation m_Geometry{};
+		std::unique_ptr<Buffer> m_MeshletBuffer;
+		UploadTicket m_UploadTicket = 0; // of the last upload
+
+		static constexpr size_t MIN_LOD_INDICES = 3 * 64;
+		static constexpr float MAX_LOD_ERROR = 0.1f; // relative to the mesh radius
 	};
 }
\ No newline at end of file
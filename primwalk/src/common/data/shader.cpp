@@ -2,12 +2,282 @@
 #include "shader.hpp"
 
 // std
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <stdexcept>
+#include <unordered_map>
 
 namespace pw {
 
 	// ------ Vulkan ------
+	namespace {
+		// The parts of the SPIR-V specification the reflection needs
+		namespace spv {
+			constexpr uint32_t MAGIC = 0x07230203;
+			constexpr uint32_t HEADER_WORDS = 5;
+
+			// Opcodes
+			constexpr uint32_t OP_ENTRY_POINT = 15;
+			constexpr uint32_t OP_TYPE_BOOL = 20;
+			constexpr uint32_t OP_TYPE_INT = 21;
+			constexpr uint32_t OP_TYPE_FLOAT = 22;
+			constexpr uint32_t OP_TYPE_VECTOR = 23;
+			constexpr uint32_t OP_TYPE_MATRIX = 24;
+			constexpr uint32_t OP_TYPE_IMAGE = 25;
+			constexpr uint32_t OP_TYPE_SAMPLER = 26;
+			constexpr uint32_t OP_TYPE_SAMPLED_IMAGE = 27;
+			constexpr uint32_t OP_TYPE_ARRAY = 28;
+			constexpr uint32_t OP_TYPE_RUNTIME_ARRAY = 29;
+			constexpr uint32_t OP_TYPE_STRUCT = 30;
+			constexpr uint32_t OP_TYPE_POINTER = 32;
+			constexpr uint32_t OP_CONSTANT = 43;
+			constexpr uint32_t OP_VARIABLE = 59;
+			constexpr uint32_t OP_DECORATE = 71;
+			constexpr uint32_t OP_MEMBER_DECORATE = 72;
+			constexpr uint32_t OP_TYPE_ACCELERATION_STRUCTURE = 5341;
+
+			// Decorations
+			constexpr uint32_t DECORATION_BLOCK = 2;
+			constexpr uint32_t DECORATION_BUFFER_BLOCK = 3;
+			constexpr uint32_t DECORATION_ARRAY_STRIDE = 6;
+			constexpr uint32_t DECORATION_MATRIX_STRIDE = 7;
+			constexpr uint32_t DECORATION_BUILT_IN = 11;
+			constexpr uint32_t DECORATION_LOCATION = 30;
+			constexpr uint32_t DECORATION_BINDING = 33;
+			constexpr uint32_t DECORATION_DESCRIPTOR_SET = 34;
+			constexpr uint32_t DECORATION_OFFSET = 35;
+
+			// Storage classes
+			constexpr uint32_t STORAGE_UNIFORM_CONSTANT = 0;
+			constexpr uint32_t STORAGE_INPUT = 1;
+			constexpr uint32_t STORAGE_UNIFORM = 2;
+			constexpr uint32_t STORAGE_PUSH_CONSTANT = 9;
+			constexpr uint32_t STORAGE_STORAGE_BUFFER = 12;
+
+			// Image dimensions
+			constexpr uint32_t DIM_BUFFER = 5;
+			constexpr uint32_t DIM_SUBPASS_DATA = 6;
+		}
+
+		constexpr uint32_t UNDECORATED = UINT32_MAX;
+
+		struct SpirvType {
+			uint32_t opcode = 0;
+			std::vector<uint32_t> operands; // following the result id
+		};
+
+		struct SpirvDecorations {
+			uint32_t set = UNDECORATED;
+			uint32_t binding = UNDECORATED;
+			uint32_t location = UNDECORATED;
+			uint32_t arrayStride = 0;
+			bool builtIn = false;
+			bool block = false;
+			bool bufferBlock = false;
+		};
+
+		struct SpirvMemberDecorations {
+			uint32_t offset = 0;
+			uint32_t matrixStride = 0;
+		};
+
+		struct SpirvVariable {
+			uint32_t id = 0;
+			uint32_t pointerType = 0;
+			uint32_t storageClass = 0;
+		};
+
+		struct SpirvModule {
+			VkShaderStageFlags stages = 0;
+			std::unordered_map<uint32_t, SpirvType> types;
+			std::unordered_map<uint32_t, uint32_t> constants; // lowest word, enough for array lengths
+			std::unordered_map<uint32_t, SpirvDecorations> decorations;
+			std::unordered_map<uint64_t, SpirvMemberDecorations> memberDecorations; // by struct id and member index
+			std::vector<SpirvVariable> variables;
+
+			const SpirvType& getType(uint32_t id) const {
+				auto it = types.find(id);
+				if (it == types.end()) {
+					throw std::runtime_error("VULKAN SHADER ERROR: Reflection found an unknown SPIR-V type!");
+				}
+
+				return it->second;
+			}
+
+			SpirvDecorations getDecorations(uint32_t id) const {
+				auto it = decorations.find(id);
+				return it != decorations.end() ? it->second : SpirvDecorations{};
+			}
+
+			SpirvMemberDecorations getMemberDecorations(uint32_t id, uint32_t member) const {
+				auto it = memberDecorations.find((uint64_t(id) << 32) | member);
+				return it != memberDecorations.end() ? it->second : SpirvMemberDecorations{};
+			}
+
+			// Size as laid out in memory by the explicit offsets and strides
+			uint32_t getSize(uint32_t id, uint32_t matrixStride = 0) const {
+				const SpirvType& type = getType(id);
+
+				switch (type.opcode) {
+				case spv::OP_TYPE_BOOL:
+					return 4;
+				case spv::OP_TYPE_INT:
+				case spv::OP_TYPE_FLOAT:
+					return type.operands[0] / 8;
+				case spv::OP_TYPE_VECTOR:
+					return type.operands[1] * getSize(type.operands[0]);
+				case spv::OP_TYPE_MATRIX:
+					return type.operands[1] * (matrixStride != 0 ? matrixStride : getSize(type.operands[0]));
+				case spv::OP_TYPE_ARRAY: {
+					uint32_t stride = getDecorations(id).arrayStride;
+					return constants.at(type.operands[1]) * (stride != 0 ? stride : getSize(type.operands[0], matrixStride));
+				}
+				case spv::OP_TYPE_STRUCT: {
+					uint32_t size = 0;
+					for (uint32_t member = 0; member < type.operands.size(); member++) {
+						SpirvMemberDecorations memberDecorations = getMemberDecorations(id, member);
+						size = std::max(size, memberDecorations.offset + getSize(type.operands[member], memberDecorations.matrixStride));
+					}
+
+					return size;
+				}
+				default:
+					return 0; // runtime arrays and opaque types
+				}
+			}
+		};
+
+		VkShaderStageFlags getShaderStage(uint32_t executionModel) {
+			switch (executionModel) {
+			case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+			case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+			case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+			case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+			case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+			case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+			case 5364: return VK_SHADER_STAGE_TASK_BIT_EXT;
+			case 5365: return VK_SHADER_STAGE_MESH_BIT_EXT;
+			default:
+				throw std::runtime_error("VULKAN SHADER ERROR: Reflection found an unsupported execution model!");
+			}
+		}
+
+		VkDescriptorType getDescriptorType(const SpirvModule& module, uint32_t id, uint32_t storageClass) {
+			const SpirvType& type = module.getType(id);
+
+			if (storageClass == spv::STORAGE_STORAGE_BUFFER) {
+				return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			}
+
+			if (storageClass == spv::STORAGE_UNIFORM) {
+				return module.getDecorations(id).bufferBlock ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			}
+
+			switch (type.opcode) {
+			case spv::OP_TYPE_SAMPLER:
+				return VK_DESCRIPTOR_TYPE_SAMPLER;
+			case spv::OP_TYPE_SAMPLED_IMAGE:
+				return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			case spv::OP_TYPE_ACCELERATION_STRUCTURE:
+				return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+			case spv::OP_TYPE_IMAGE: {
+				uint32_t dim = type.operands[1];
+				bool storage = type.operands[5] == 2; // otherwise sampled
+
+				if (dim == spv::DIM_SUBPASS_DATA) {
+					return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+				}
+
+				if (dim == spv::DIM_BUFFER) {
+					return storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+				}
+
+				return storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+			}
+			default:
+				throw std::runtime_error("VULKAN SHADER ERROR: Reflection found an unsupported descriptor type!");
+			}
+		}
+
+		VkFormat getVertexFormat(const SpirvModule& module, uint32_t id) {
+			const SpirvType& type = module.getType(id);
+			uint32_t componentCount = 1;
+			const SpirvType* component = &type;
+
+			if (type.opcode == spv::OP_TYPE_VECTOR) {
+				componentCount = type.operands[1];
+				component = &module.getType(type.operands[0]);
+			}
+
+			if ((component->opcode != spv::OP_TYPE_FLOAT && component->opcode != spv::OP_TYPE_INT) ||
+				component->operands[0] != 32 || componentCount > 4) {
+				return VK_FORMAT_UNDEFINED; // matrices, arrays and other widths take several or unusual attributes
+			}
+
+			static const VkFormat floatFormats[] = {
+				VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+			static const VkFormat intFormats[] = {
+				VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+			static const VkFormat uintFormats[] = {
+				VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+			if (component->opcode == spv::OP_TYPE_FLOAT) {
+				return floatFormats[componentCount - 1];
+			}
+
+			return component->operands[1] != 0 ? intFormats[componentCount - 1] : uintFormats[componentCount - 1];
+		}
+	}
+
+	void ShaderReflection::merge(const ShaderReflection& other) {
+		stages |= other.stages;
+
+		for (const auto& binding : other.bindings) {
+			auto it = std::find_if(bindings.begin(), bindings.end(), [&](const ShaderBinding& existing) {
+				return existing.set == binding.set && existing.binding == binding.binding;
+			});
+
+			if (it == bindings.end()) {
+				bindings.push_back(binding);
+				continue;
+			}
+
+			if (it->type != binding.type || it->count != binding.count) {
+				throw std::runtime_error("VULKAN SHADER ERROR: Shader stages declare the same binding differently!");
+			}
+
+			it->stages |= binding.stages;
+		}
+
+		std::sort(bindings.begin(), bindings.end(), [](const ShaderBinding& a, const ShaderBinding& b) {
+			return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+		});
+
+		// A stage may only appear in one push constant range
+		for (const auto& range : other.pushConstants) {
+			auto it = std::find_if(pushConstants.begin(), pushConstants.end(), [&](const VkPushConstantRange& existing) {
+				return (existing.stageFlags & range.stageFlags) != 0 ||
+					(existing.offset == range.offset && existing.size == range.size);
+			});
+
+			if (it == pushConstants.end()) {
+				pushConstants.push_back(range);
+				continue;
+			}
+
+			uint32_t end = std::max(it->offset + it->size, range.offset + range.size);
+			it->offset = std::min(it->offset, range.offset);
+			it->size = end - it->offset;
+			it->stageFlags |= range.stageFlags;
+		}
+
+		vertexInputs.insert(vertexInputs.end(), other.vertexInputs.begin(), other.vertexInputs.end());
+		std::sort(vertexInputs.begin(), vertexInputs.end(), [](const ShaderVertexInput& a, const ShaderVertexInput& b) {
+			return a.location < b.location;
+		});
+	}
+
 	std::vector<char> Shader_Vulkan::readFile(const std::string& path) {
 		std::string truePath = BASE_DIR + path;
 		std::ifstream file(truePath, std::ios::ate | std::ios::binary);
@@ -25,4 +295,155 @@ namespace pw {
 
 		return buffer;
 	}
+
+	ShaderReflection Shader_Vulkan::reflect(const std::vector<char>& code) {
+		if (code.size() % sizeof(uint32_t) != 0 || code.size() < spv::HEADER_WORDS * sizeof(uint32_t)) {
+			throw std::runtime_error("VULKAN SHADER ERROR: Shader code is not valid SPIR-V!");
+		}
+
+		std::vector<uint32_t> words(code.size() / sizeof(uint32_t));
+		std::memcpy(words.data(), code.data(), code.size());
+
+		if (words[0] != spv::MAGIC) {
+			throw std::runtime_error("VULKAN SHADER ERROR: Shader code is not valid SPIR-V!");
+		}
+
+		// Collect the types, decorations and global variables
+		SpirvModule module;
+		for (size_t i = spv::HEADER_WORDS; i < words.size();) {
+			uint32_t opcode = words[i] & 0xFFFF;
+			uint32_t wordCount = words[i] >> 16;
+
+			if (wordCount == 0 || i + wordCount > words.size()) {
+				throw std::runtime_error("VULKAN SHADER ERROR: Shader code is not valid SPIR-V!");
+			}
+
+			const uint32_t* operands = &words[i + 1];
+			uint32_t operandCount = wordCount - 1;
+
+			switch (opcode) {
+			case spv::OP_ENTRY_POINT:
+				module.stages |= getShaderStage(operands[0]);
+				break;
+			case spv::OP_TYPE_BOOL:
+			case spv::OP_TYPE_INT:
+			case spv::OP_TYPE_FLOAT:
+			case spv::OP_TYPE_VECTOR:
+			case spv::OP_TYPE_MATRIX:
+			case spv::OP_TYPE_IMAGE:
+			case spv::OP_TYPE_SAMPLER:
+			case spv::OP_TYPE_SAMPLED_IMAGE:
+			case spv::OP_TYPE_ARRAY:
+			case spv::OP_TYPE_RUNTIME_ARRAY:
+			case spv::OP_TYPE_STRUCT:
+			case spv::OP_TYPE_POINTER:
+			case spv::OP_TYPE_ACCELERATION_STRUCTURE:
+				module.types[operands[0]] = { opcode, std::vector<uint32_t>(operands + 1, operands + operandCount) };
+				break;
+			case spv::OP_CONSTANT:
+				module.constants[operands[1]] = operands[2];
+				break;
+			case spv::OP_VARIABLE:
+				module.variables.push_back({ operands[1], operands[0], operands[2] });
+				break;
+			case spv::OP_DECORATE: {
+				SpirvDecorations& decorations = module.decorations[operands[0]];
+				switch (operands[1]) {
+				case spv::DECORATION_BLOCK: decorations.block = true; break;
+				case spv::DECORATION_BUFFER_BLOCK: decorations.bufferBlock = true; break;
+				case spv::DECORATION_ARRAY_STRIDE: decorations.arrayStride = operands[2]; break;
+				case spv::DECORATION_BUILT_IN: decorations.builtIn = true; break;
+				case spv::DECORATION_LOCATION: decorations.location = operands[2]; break;
+				case spv::DECORATION_BINDING: decorations.binding = operands[2]; break;
+				case spv::DECORATION_DESCRIPTOR_SET: decorations.set = operands[2]; break;
+				}
+				break;
+			}
+			case spv::OP_MEMBER_DECORATE: {
+				SpirvMemberDecorations& decorations = module.memberDecorations[(uint64_t(operands[0]) << 32) | operands[1]];
+				if (operands[2] == spv::DECORATION_OFFSET) {
+					decorations.offset = operands[3];
+				}
+				else if (operands[2] == spv::DECORATION_MATRIX_STRIDE) {
+					decorations.matrixStride = operands[3];
+				}
+				break;
+			}
+			}
+
+			i += wordCount;
+		}
+
+		// Turn the global variables into the interface
+		ShaderReflection reflection;
+		reflection.stages = module.stages;
+
+		for (const auto& variable : module.variables) {
+			const SpirvType& pointer = module.getType(variable.pointerType);
+			uint32_t typeId = pointer.operands[1];
+			SpirvDecorations decorations = module.getDecorations(variable.id);
+
+			switch (variable.storageClass) {
+			case spv::STORAGE_UNIFORM_CONSTANT:
+			case spv::STORAGE_UNIFORM:
+			case spv::STORAGE_STORAGE_BUFFER: {
+				if (decorations.set == UNDECORATED || decorations.binding == UNDECORATED) {
+					break;
+				}
+
+				ShaderBinding binding{};
+				binding.set = decorations.set;
+				binding.binding = decorations.binding;
+				binding.stages = module.stages;
+
+				// Arrays of descriptors, nested arrays are flattened
+				const SpirvType* type = &module.getType(typeId);
+				while (type->opcode == spv::OP_TYPE_ARRAY || type->opcode == spv::OP_TYPE_RUNTIME_ARRAY) {
+					binding.count = type->opcode == spv::OP_TYPE_ARRAY ? binding.count * module.constants.at(type->operands[1]) : 0;
+					typeId = type->operands[0];
+					type = &module.getType(typeId);
+				}
+
+				binding.type = getDescriptorType(module, typeId, variable.storageClass);
+				reflection.bindings.push_back(binding);
+				break;
+			}
+			case spv::STORAGE_PUSH_CONSTANT: {
+				const SpirvType& type = module.getType(typeId);
+				uint32_t offset = UINT32_MAX;
+				for (uint32_t member = 0; member < type.operands.size(); member++) {
+					offset = std::min(offset, module.getMemberDecorations(typeId, member).offset);
+				}
+
+				uint32_t size = module.getSize(typeId);
+				if (size > 0) {
+					reflection.pushConstants.push_back({ module.stages, offset, size - offset });
+				}
+				break;
+			}
+			case spv::STORAGE_INPUT: {
+				if (!(module.stages & VK_SHADER_STAGE_VERTEX_BIT) || decorations.builtIn || decorations.location == UNDECORATED) {
+					break;
+				}
+
+				reflection.vertexInputs.push_back({ decorations.location, getVertexFormat(module, typeId) });
+				break;
+			}
+			}
+		}
+
+		// Sorts the bindings and vertex inputs
+		ShaderReflection sorted;
+		sorted.merge(reflection);
+		return sorted;
+	}
+
+	ShaderReflection Shader_Vulkan::reflectFiles(const std::vector<std::string>& paths) {
+		ShaderReflection reflection;
+		for (const auto& path : paths) {
+			reflection.merge(reflect(readFile(path)));
+		}
+
+		return reflection;
+	}
 }
@@ -4,19 +4,50 @@
 #include "../../core.hpp"
 
 // std
+#include <cstdint>
 #include <string>
 #include <vector>
 
 // vendor
 #include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
 
 namespace pw {
 	// ------ Vulkan ------
+	struct PW_API ShaderBinding {
+		uint32_t set = 0;
+		uint32_t binding = 0;
+		VkDescriptorType type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+		uint32_t count = 1; // 0 for runtime arrays
+		VkShaderStageFlags stages = 0;
+	};
+
+	struct PW_API ShaderVertexInput {
+		uint32_t location = 0;
+		VkFormat format = VK_FORMAT_UNDEFINED;
+	};
+
+	/*
+	* Interface of one or more shader stages as declared in their SPIR-V. Merging the reflections of all stages of a
+	* pipeline gives everything its layout needs, see PipelineLayoutCache.
+	*/
+	struct PW_API ShaderReflection {
+		VkShaderStageFlags stages = 0;
+		std::vector<ShaderBinding> bindings; // sorted by set and binding
+		std::vector<VkPushConstantRange> pushConstants;
+		std::vector<ShaderVertexInput> vertexInputs; // vertex stage only, sorted by location
+
+		void merge(const ShaderReflection& other); // throws if both declare the same binding differently
+	};
+
 	class PW_API Shader_Vulkan {
 	public:
 		Shader_Vulkan() {};
 		~Shader_Vulkan() {};
 
 		static std::vector<char> readFile(const std::string& path);
+
+		static ShaderReflection reflect(const std::vector<char>& code);
+		static ShaderReflection reflectFiles(const std::vector<std::string>& paths); // merged over all files
 	};
 }
@@ -1,5 +1,9 @@
 #include "buffer.hpp"
 
+// std
+#include <cstring>
+#include <stdexcept>
+
 namespace pw {
 
 	Buffer::Buffer(
@@ -8,30 +12,35 @@ namespace pw {
 		uint32_t instanceCount,
 		VkBufferUsageFlags usageFlags,
 		VkMemoryPropertyFlags memoryPropertyFlags,
-		VkDeviceSize minOffsetAlignment) :
+		VkDeviceSize minOffsetAlignment,
+		bool sharedWithAsyncCompute) :
 	m_Device(device), m_InstanceSize(instanceSize), m_InstanceCount(instanceCount),
 	m_UsageFlags(usageFlags), m_MemoryPropertyFlags(memoryPropertyFlags) {
 		m_AlignmentSize = getAlignment(instanceSize, minOffsetAlignment);
 		m_BufferSize = m_AlignmentSize * instanceCount;
 
-		m_Device.createBuffer(m_BufferSize, m_UsageFlags, m_MemoryPropertyFlags, m_Buffer, m_Memory);
+		m_Device.createBuffer(m_BufferSize, m_UsageFlags, m_MemoryPropertyFlags, m_Buffer, m_Memory, sharedWithAsyncCompute);
 	}
 
 	Buffer::~Buffer() {
 		unmap();
+
+		m_Device.getDescriptorBatcher().forgetBuffer(m_Buffer);
 		vkDestroyBuffer(m_Device.getDevice(), m_Buffer, nullptr);
-		vkFreeMemory(m_Device.getDevice(), m_Memory, nullptr);
+		m_Device.getMemoryAllocator().free(m_Memory);
 	}
 
 	void Buffer::map(VkDeviceSize size /*= VK_WHOLE_SIZE*/, VkDeviceSize offset /*= 0*/) {
-		vkMapMemory(m_Device.getDevice(), m_Memory, offset, size, 0, &m_Mapped);
+		// Host visible memory is mapped by the allocator for its whole lifetime
+		if (!m_Memory.mapped) {
+			throw std::runtime_error("VULKAN ERROR: Failed to map buffer memory!");
+		}
+
+		m_Mapped = static_cast<char*>(m_Memory.mapped) + offset;
 	}
 
 	void Buffer::unmap() {
-		if (m_Mapped) {
-			vkUnmapMemory(m_Device.getDevice(), m_Memory);
-			m_Mapped = nullptr;
-		}
+		m_Mapped = nullptr;
 	}
 
 	void Buffer::writeToBuffer(void* data, VkDeviceSize size /*= VK_WHOLE_SIZE*/, VkDeviceSize offset /*= 0*/) {
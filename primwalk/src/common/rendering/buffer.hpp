@@ -17,7 +17,8 @@ namespace pw {
 		uint32_t instanceCount,
 		VkBufferUsageFlags usageFlags,
 		VkMemoryPropertyFlags memoryPropertyFlags,
-		VkDeviceSize minOffsetAlignment = 1);
+		VkDeviceSize minOffsetAlignment = 1,
+		bool sharedWithAsyncCompute = false); // concurrent sharing between the graphics and async compute queue
 		~Buffer();
 
 		void map(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
@@ -30,6 +31,7 @@ namespace pw {
 		inline VkDeviceSize getBufferSize() const { return m_BufferSize; }
 		inline VkBufferUsageFlags getUsageFlags() const { return m_UsageFlags; }
 		inline VkMemoryPropertyFlags getMemoryPropertyFlags() const { return m_MemoryPropertyFlags; }
+		inline void* getMappedMemory() const { return m_Mapped; }
 		VkDescriptorBufferInfo getDescriptorInfo(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
 
 	private:
@@ -38,7 +40,7 @@ namespace pw {
 		GraphicsDevice_Vulkan& m_Device;
 		void* m_Mapped = nullptr;
 		VkBuffer m_Buffer = VK_NULL_HANDLE;
-		VkDeviceMemory m_Memory = VK_NULL_HANDLE;
+		MemoryAllocation m_Memory{};
 
 		VkDeviceSize m_BufferSize;
 		VkDeviceSize m_InstanceSize;
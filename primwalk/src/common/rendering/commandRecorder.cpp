@@ -0,0 +1,319 @@
+#include "commandRecorder.hpp"
+#include "graphicsDevice_Vulkan.hpp"
+
+// std
+#include <algorithm>
+#include <stdexcept>
+
+namespace pw {
+
+	CommandCache::~CommandCache() {
+		for (auto& entry : m_Entries) {
+			release(entry);
+		}
+	}
+
+	void CommandCache::invalidate() {
+		// Freed once re-recorded, the GPU might still execute them
+		for (auto& entry : m_Entries) {
+			entry.valid = false;
+		}
+	}
+
+	uint64_t CommandCache::combine(uint64_t version, uint64_t value) {
+		// splitmix64 finalizer, so that similar inputs (e.g. neighbouring handles) spread over all bits
+		value += 0x9e3779b97f4a7c15ull + (version << 6) + (version >> 2);
+		value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+		value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+
+		return version ^ (value ^ (value >> 31));
+	}
+
+	void CommandCache::release(Entry& entry) {
+		for (size_t i = 0; i < entry.commandBuffers.size(); i++) {
+			if (entry.commandBuffers[i] != VK_NULL_HANDLE) { // chunks that failed before allocating
+				vkFreeCommandBuffers(m_Device, entry.commandPools[i], 1, &entry.commandBuffers[i]);
+			}
+		}
+
+		entry.commandBuffers.clear();
+		entry.commandPools.clear();
+		entry.valid = false;
+	}
+
+	CommandRecorder::CommandRecorder(GraphicsDevice_Vulkan& device, uint32_t workerCount) : m_Device(device) {
+		QueueFamilyIndices queueFamilyIndices = m_Device.findPhysicalQueueFamilies();
+
+		// Command pools are externally synchronized, every thread gets its own
+		m_Threads.resize(workerCount + 1);
+
+		for (auto& thread : m_Threads) {
+			thread.commandPools.resize(GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE);
+			thread.commandBuffers.resize(GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT);
+			thread.usedCommandBuffers.resize(GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT, 0);
+
+			for (auto& commandPool : thread.commandPools) {
+				VkCommandPoolCreateInfo poolInfo{};
+				poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+				poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT; // reset as a whole every frame
+				poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+
+				if (vkCreateCommandPool(m_Device.getDevice(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+					throw std::runtime_error("VULKAN ERROR: Failed to create recording thread command pool!");
+				}
+			}
+
+			VkCommandPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+
+			if (vkCreateCommandPool(m_Device.getDevice(), &poolInfo, nullptr, &thread.persistentPool) != VK_SUCCESS) {
+				throw std::runtime_error("VULKAN ERROR: Failed to create recording thread command pool!");
+			}
+		}
+
+		for (uint32_t i = 0; i < workerCount; i++) {
+			m_Workers.emplace_back(&CommandRecorder::workerLoop, this, i);
+		}
+	}
+
+	CommandRecorder::~CommandRecorder() {
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stop = true;
+		}
+
+		m_WorkAvailable.notify_all();
+
+		for (auto& worker : m_Workers) {
+			worker.join();
+		}
+
+		// Destroying the pools frees their command buffers
+		for (auto& thread : m_Threads) {
+			for (auto commandPool : thread.commandPools) {
+				vkDestroyCommandPool(m_Device.getDevice(), commandPool, nullptr);
+			}
+
+			vkDestroyCommandPool(m_Device.getDevice(), thread.persistentPool, nullptr);
+		}
+	}
+
+	void CommandRecorder::beginFrame(size_t frameIndex) {
+		m_FrameIndex = frameIndex;
+
+		for (auto& thread : m_Threads) {
+			vkResetCommandPool(m_Device.getDevice(), thread.commandPools[m_FrameIndex], 0);
+			thread.usedCommandBuffers[m_FrameIndex] = 0;
+		}
+	}
+
+	void CommandRecorder::record(VkCommandBuffer commandBuffer, const ParallelRecordInfo& info, const RecordFunction& function) {
+		CommandCache* cache = info.cache;
+
+		if (cache) {
+			if (cache->m_Entries.empty()) {
+				cache->m_Device = m_Device.getDevice();
+				cache->m_Entries.resize(GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT);
+			}
+
+			CommandCache::Entry& entry = cache->m_Entries[m_FrameIndex];
+
+			if (entry.valid && entry.version == info.contentVersion) {
+				if (!entry.commandBuffers.empty()) {
+					vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(entry.commandBuffers.size()), entry.commandBuffers.data());
+				}
+
+				return;
+			}
+
+			// The previous submission of this frame has completed, the workers are idle
+			cache->release(entry);
+			entry.version = info.contentVersion;
+			entry.valid = true;
+		}
+
+		if (info.itemCount == 0) {
+			return;
+		}
+
+		// One chunk per thread at most, fewer if the chunks would get too small
+		uint32_t minItemsPerChunk = std::max(info.minItemsPerChunk, 1u);
+		uint32_t chunkCount = std::min((info.itemCount + minItemsPerChunk - 1) / minItemsPerChunk, getThreadCount());
+		uint32_t chunkSize = (info.itemCount + chunkCount - 1) / chunkCount;
+
+		std::vector<VkCommandBuffer> secondaryCommandBuffers(chunkCount, VK_NULL_HANDLE);
+		std::vector<VkCommandPool> commandPools(chunkCount, VK_NULL_HANDLE);
+
+		auto job = [&](uint32_t chunk, uint32_t threadIndex) {
+			uint32_t first = chunk * chunkSize;
+			uint32_t last = std::min(first + chunkSize, info.itemCount);
+
+			VkCommandBufferInheritanceInfo inheritanceInfo{};
+			inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+			inheritanceInfo.renderPass = info.renderPass.getVulkanRenderPass();
+			inheritanceInfo.subpass = info.subpass;
+			inheritanceInfo.framebuffer = info.framebuffer.getVkFramebuffer();
+
+			VkCommandBufferBeginInfo beginInfo{};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+			beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+			VkCommandBuffer secondary = VK_NULL_HANDLE;
+
+			if (cache) {
+				secondary = allocateCachedCommandBuffer(threadIndex);
+				commandPools[chunk] = m_Threads[threadIndex].persistentPool;
+			}
+			else {
+				secondary = getSecondaryCommandBuffer(threadIndex);
+				beginInfo.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			}
+
+			secondaryCommandBuffers[chunk] = secondary; // also if recording fails, so that the cache frees it
+
+			if (vkBeginCommandBuffer(secondary, &beginInfo) != VK_SUCCESS) {
+				throw std::runtime_error("VULKAN ERROR: Failed to begin recording secondary command buffer!");
+			}
+
+			RenderPass::setViewport(secondary, info.framebuffer, info.viewport);
+			function(secondary, first, last);
+
+			if (vkEndCommandBuffer(secondary) != VK_SUCCESS) {
+				throw std::runtime_error("VULKAN ERROR: Failed to record secondary command buffer!");
+			}
+		};
+
+		std::exception_ptr error;
+
+		// Not worth waking the workers for
+		if (chunkCount == 1) {
+			try {
+				job(0, getThreadCount() - 1);
+			}
+			catch (...) {
+				error = std::current_exception();
+			}
+		}
+		else {
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_Job = job;
+				m_ChunkCount = chunkCount;
+				m_NextChunk = 0;
+				m_PendingChunks = chunkCount;
+			}
+
+			m_WorkAvailable.notify_all();
+			recordChunks(getThreadCount() - 1);
+
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_WorkDone.wait(lock, [this]() { return m_PendingChunks == 0; });
+			m_Job = nullptr;
+			m_ChunkCount = 0;
+			error = m_Error;
+			m_Error = nullptr;
+		}
+
+		if (cache) {
+			CommandCache::Entry& entry = cache->m_Entries[m_FrameIndex];
+			entry.commandBuffers = secondaryCommandBuffers;
+			entry.commandPools = commandPools;
+			entry.valid = !error; // a failed recording is retried next time
+		}
+
+		if (error) {
+			std::rethrow_exception(error);
+		}
+
+		vkCmdExecuteCommands(commandBuffer, chunkCount, secondaryCommandBuffers.data());
+	}
+
+	void CommandRecorder::workerLoop(uint32_t threadIndex) {
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_WorkAvailable.wait(lock, [this]() { return m_Stop || m_NextChunk < m_ChunkCount; });
+
+				if (m_Stop) {
+					return;
+				}
+			}
+
+			recordChunks(threadIndex);
+		}
+	}
+
+	void CommandRecorder::recordChunks(uint32_t threadIndex) {
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		while (m_NextChunk < m_ChunkCount) {
+			uint32_t chunk = m_NextChunk++;
+
+			lock.unlock();
+
+			// Thrown on a worker it would terminate the application, record() rethrows it instead
+			try {
+				m_Job(chunk, threadIndex);
+			}
+			catch (...) {
+				lock.lock();
+
+				if (!m_Error) {
+					m_Error = std::current_exception();
+				}
+
+				lock.unlock();
+			}
+
+			lock.lock();
+
+			if (--m_PendingChunks == 0) {
+				m_WorkDone.notify_one();
+			}
+		}
+	}
+
+	VkCommandBuffer CommandRecorder::getSecondaryCommandBuffer(uint32_t threadIndex) {
+		ThreadData& thread = m_Threads[threadIndex];
+		std::vector<VkCommandBuffer>& commandBuffers = thread.commandBuffers[m_FrameIndex];
+		uint32_t& used = thread.usedCommandBuffers[m_FrameIndex];
+
+		// Command buffers are kept across frames, the pool reset only rewinds them
+		if (used == commandBuffers.size()) {
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandPool = thread.commandPools[m_FrameIndex];
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+
+			if (vkAllocateCommandBuffers(m_Device.getDevice(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+				throw std::runtime_error("VULKAN ERROR: Failed to allocate secondary command buffer!");
+			}
+
+			commandBuffers.push_back(commandBuffer);
+		}
+
+		return commandBuffers[used++];
+	}
+
+	VkCommandBuffer CommandRecorder::allocateCachedCommandBuffer(uint32_t threadIndex) {
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		allocInfo.commandPool = m_Threads[threadIndex].persistentPool;
+		allocInfo.commandBufferCount = 1;
+
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+
+		if (vkAllocateCommandBuffers(m_Device.getDevice(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to allocate cached secondary command buffer!");
+		}
+
+		return commandBuffer;
+	}
+
+}
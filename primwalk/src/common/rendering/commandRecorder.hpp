@@ -0,0 +1,128 @@
+#pragma once
+
+// primwalk
+#include "../../core.hpp"
+#include "renderpass.hpp"
+
+// std
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// vendor
+#include <vulkan/vulkan.h>
+
+namespace pw {
+	// Forward declarations
+	class GraphicsDevice_Vulkan;
+
+	/*
+	* Secondary command buffers of a pass that are kept across frames and replayed as long as the content version
+	* computed by the pass stays the same. Everything baked into the commands (draw list, pipelines, descriptor sets,
+	* framebuffer, viewport) has to go into the version, data changing every frame has to come from buffers instead.
+	* There is one entry per frame in flight, the commands reference the descriptor sets of their frame.
+	*/
+	class PW_API CommandCache {
+	public:
+		CommandCache() = default;
+		~CommandCache();
+
+		// Forbid copy and move semantics
+		CommandCache(const CommandCache&) = delete;
+		CommandCache& operator=(const CommandCache&) = delete;
+
+		// Forces re-recording, e.g. after recreating resources whose handles the driver might hand out again
+		void invalidate();
+
+		static uint64_t combine(uint64_t version, uint64_t value);
+
+	private:
+		friend class CommandRecorder;
+
+		struct Entry {
+			uint64_t version = 0;
+			bool valid = false;
+			std::vector<VkCommandBuffer> commandBuffers;
+			std::vector<VkCommandPool> commandPools; // the persistent pool of the thread that recorded each buffer
+		};
+
+		void release(Entry& entry);
+
+		VkDevice m_Device = VK_NULL_HANDLE;
+		std::vector<Entry> m_Entries; // per frame in flight
+	};
+
+	// Describes the subpass the secondary command buffers continue and how the recorded items are split up
+	struct ParallelRecordInfo {
+		RenderPass& renderPass;
+		Framebuffer& framebuffer;
+		Viewport viewport{};
+		uint32_t subpass = 0;
+		uint32_t itemCount = 0;
+		uint32_t minItemsPerChunk = 256; // smaller chunks cost more in thread handoff than they save
+		CommandCache* cache = nullptr; // replays the cached commands if contentVersion did not change
+		uint64_t contentVersion = 0;
+	};
+
+	/*
+	* Records large passes on multiple threads. The items of a pass (usually draws) are split into contiguous chunks,
+	* every chunk is recorded into its own secondary command buffer by whichever thread picks it up, and the
+	* secondaries are executed from the primary command buffer in chunk order, so the result does not depend on the
+	* scheduling. Every thread owns one command pool per frame in flight, the pools are reset at the start of a frame
+	* once its previous submission has completed.
+	*/
+	class PW_API CommandRecorder {
+	public:
+		// Called for the items [first, last) of one chunk. Secondary command buffers inherit no state but the
+		// viewport and scissor, pipelines and descriptor sets have to be bound in every chunk.
+		using RecordFunction = std::function<void(VkCommandBuffer commandBuffer, uint32_t first, uint32_t last)>;
+
+		CommandRecorder(GraphicsDevice_Vulkan& device, uint32_t workerCount);
+		~CommandRecorder();
+
+		// Forbid copy and move semantics
+		CommandRecorder(const CommandRecorder&) = delete;
+		CommandRecorder& operator=(const CommandRecorder&) = delete;
+
+		void beginFrame(size_t frameIndex);
+
+		// The subpass must have been begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS. Blocks until every
+		// chunk is recorded, the calling thread records chunks as well. Exceptions of the chunks are rethrown here.
+		void record(VkCommandBuffer commandBuffer, const ParallelRecordInfo& info, const RecordFunction& function);
+
+		inline uint32_t getThreadCount() const { return static_cast<uint32_t>(m_Threads.size()); } // workers + calling thread
+
+	private:
+		struct ThreadData {
+			std::vector<VkCommandPool> commandPools; // per frame in flight
+			std::vector<std::vector<VkCommandBuffer>> commandBuffers;
+			std::vector<uint32_t> usedCommandBuffers;
+			VkCommandPool persistentPool = VK_NULL_HANDLE; // cached command buffers, freed individually
+		};
+
+		void workerLoop(uint32_t threadIndex);
+		void recordChunks(uint32_t threadIndex); // records until no chunk is left, expects the mutex to be unlocked
+		VkCommandBuffer getSecondaryCommandBuffer(uint32_t threadIndex);
+		VkCommandBuffer allocateCachedCommandBuffer(uint32_t threadIndex);
+
+		GraphicsDevice_Vulkan& m_Device;
+		size_t m_FrameIndex = 0;
+
+		std::vector<ThreadData> m_Threads; // the calling thread uses the last one
+		std::vector<std::thread> m_Workers;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_WorkAvailable;
+		std::condition_variable m_WorkDone;
+		std::function<void(uint32_t chunk, uint32_t threadIndex)> m_Job;
+		uint32_t m_ChunkCount = 0;
+		uint32_t m_NextChunk = 0;
+		uint32_t m_PendingChunks = 0;
+		std::exception_ptr m_Error; // first exception thrown by a chunk, rethrown by record()
+		bool m_Stop = false;
+	};
+}
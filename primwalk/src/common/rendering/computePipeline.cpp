@@ -0,0 +1,62 @@
+#include "computePipeline.hpp"
+#include "graphicsDevice_Vulkan.hpp"
+#include "pipelineCache.hpp"
+#include "../data/shader.hpp"
+
+// std
+#include <stdexcept>
+
+namespace pw {
+
+	ComputePipeline::ComputePipeline(GraphicsDevice_Vulkan& device, const std::string& path, VkPipelineLayout pipelineLayout) :
+		m_Device(device) {
+
+		auto shaderCode = Shader_Vulkan::readFile(path);
+
+		// Shader module
+		VkShaderModuleCreateInfo moduleInfo{};
+		moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		moduleInfo.codeSize = shaderCode.size();
+		moduleInfo.pCode = reinterpret_cast<const uint32_t*>(shaderCode.data());
+
+		VkShaderModule shaderModule;
+		if (vkCreateShaderModule(m_Device.getDevice(), &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to create shader module!");
+		}
+
+		VkPipelineShaderStageCreateInfo stageInfo{};
+		stageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		stageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		stageInfo.module = shaderModule;
+		stageInfo.pName = "main";
+		stageInfo.pSpecializationInfo = nullptr; // optional
+
+		// Compute pipeline
+		VkComputePipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage = stageInfo;
+		pipelineInfo.layout = pipelineLayout;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // optional
+		pipelineInfo.basePipelineIndex = -1; // optional
+
+		if (vkCreateComputePipelines(m_Device.getDevice(), m_Device.getPipelineCache().getVkPipelineCache(), 1, &pipelineInfo, nullptr, &m_ComputePipeline) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to create compute pipeline!");
+		}
+
+		// Cleanup
+		vkDestroyShaderModule(m_Device.getDevice(), shaderModule, nullptr);
+	}
+
+	ComputePipeline::~ComputePipeline() {
+		vkDestroyPipeline(m_Device.getDevice(), m_ComputePipeline, nullptr);
+	}
+
+	void ComputePipeline::bind(VkCommandBuffer commandBuffer) {
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline);
+	}
+
+	void ComputePipeline::dispatch(VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) {
+		vkCmdDispatch(commandBuffer, groupCountX, groupCountY, groupCountZ);
+	}
+
+}
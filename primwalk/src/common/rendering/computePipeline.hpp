@@ -0,0 +1,30 @@
+#pragma once
+
+// primwalk
+#include "../../core.hpp"
+
+// std
+#include <cstdint>
+#include <string>
+
+// vendor
+#include <vulkan/vulkan.h>
+
+namespace pw {
+	// Forward declarations
+	class GraphicsDevice_Vulkan;
+
+	class PW_API ComputePipeline {
+	public:
+		ComputePipeline(GraphicsDevice_Vulkan& device, const std::string& path, VkPipelineLayout pipelineLayout);
+		~ComputePipeline();
+
+		void bind(VkCommandBuffer commandBuffer);
+		void dispatch(VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY = 1, uint32_t groupCountZ = 1);
+
+	private:
+		GraphicsDevice_Vulkan& m_Device;
+		VkPipeline m_ComputePipeline = VK_NULL_HANDLE;
+	};
+}
+
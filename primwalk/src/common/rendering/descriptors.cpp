@@ -122,6 +122,11 @@ namespace pw {
 	}
 
 	DescriptorPool::~DescriptorPool() {
+		// Writes still queued for the sets must not be applied anymore
+		for (auto set : m_AllocatedSets) {
+			m_Device.getDescriptorBatcher().reset(set);
+		}
+
 		vkDestroyDescriptorPool(m_Device.getDevice(), m_DescriptorPool, nullptr);
 	}
 
@@ -136,11 +141,12 @@ namespace pw {
 			return false;
 		}
 
+		m_AllocatedSets.push_back(descriptor);
 		return true;
 	}
 
 	// ******** Descriptor Writer ********
-	DescriptorWriter& DescriptorWriter::writeBuffer(uint32_t binding, VkDescriptorBufferInfo* bufferInfo) {
+	DescriptorWriter& DescriptorWriter::writeBuffer(uint32_t binding, VkDescriptorBufferInfo* bufferInfo, uint32_t index) {
 		auto& bindingDescription = m_SetLayout.m_Bindings[binding];
 
 		VkWriteDescriptorSet write{};
@@ -148,6 +154,7 @@ namespace pw {
 		write.descriptorType = bindingDescription.descriptorType;
 		write.descriptorCount = 1;
 		write.dstBinding = binding;
+		write.dstArrayElement = index;
 		write.pBufferInfo = bufferInfo;
 
 		m_Writes.push_back(write);
@@ -175,16 +182,214 @@ namespace pw {
 			return false;
 		}
 
+		m_Pool.m_Device.getDescriptorBatcher().reset(set);
 		overwrite(set);
 		return true;
 	}
 
 	void DescriptorWriter::overwrite(VkDescriptorSet& set) {
+		bool updateAfterBind = true;
+
 		for (auto& write : m_Writes) {
 			write.dstSet = set;
+
+			if (!(m_SetLayout.m_BindingFlags[write.dstBinding] & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT)) {
+				updateAfterBind = false;
+			}
+		}
+
+		m_Pool.m_Device.getDescriptorBatcher().write(m_Writes, updateAfterBind);
+	}
+
+	// ******** Descriptor Update Batcher ********
+	bool DescriptorUpdateBatcher::Descriptor::operator==(const Descriptor& other) const {
+		return type == other.type &&
+			imageInfo.sampler == other.imageInfo.sampler &&
+			imageInfo.imageView == other.imageInfo.imageView &&
+			imageInfo.imageLayout == other.imageInfo.imageLayout &&
+			bufferInfo.buffer == other.bufferInfo.buffer &&
+			bufferInfo.offset == other.bufferInfo.offset &&
+			bufferInfo.range == other.bufferInfo.range;
+	}
+
+	void DescriptorUpdateBatcher::write(const std::vector<VkWriteDescriptorSet>& writes, bool updateAfterBind) {
+		std::vector<VkWriteDescriptorSet> immediateWrites;
+		std::vector<Descriptor> immediateDescriptors;
+		immediateWrites.reserve(writes.size());
+		immediateDescriptors.reserve(writes.size()); // keeps the infos alive until the update
+
+		for (const auto& write : writes) {
+			SetState& state = m_Sets[write.dstSet];
+
+			for (uint32_t element = 0; element < write.descriptorCount; element++) {
+				uint64_t key = getKey(write.dstBinding, write.dstArrayElement + element);
+				Descriptor descriptor = getDescriptor(write, element);
+
+				auto written = state.written.find(key);
+				bool unchanged = written != state.written.end() && written->second == descriptor;
+
+				if (updateAfterBind) {
+					auto pending = state.pending.find(key);
+
+					if (pending != state.pending.end()) { // the queued write is replaced, or dropped if it is back to what was written
+						if (unchanged) {
+							state.pending.erase(pending);
+							m_PendingCount--;
+						}
+						else {
+							pending->second = descriptor;
+						}
+
+						m_FrameSkippedWrites++;
+					}
+					else if (unchanged) {
+						m_FrameSkippedWrites++;
+					}
+					else {
+						state.pending.insert({ key, descriptor });
+						m_PendingCount++;
+					}
+				}
+				else if (unchanged) {
+					m_FrameSkippedWrites++;
+				}
+				else {
+					state.written[key] = descriptor;
+					immediateDescriptors.push_back(descriptor);
+					immediateWrites.push_back(getWrite(write.dstSet, key, descriptor));
+				}
+			}
+		}
+
+		if (immediateWrites.empty()) {
+			return;
+		}
+
+		// The writes point into the vector, it is not resized anymore
+		for (size_t i = 0; i < immediateWrites.size(); i++) {
+			immediateWrites[i].pImageInfo = &immediateDescriptors[i].imageInfo;
+			immediateWrites[i].pBufferInfo = &immediateDescriptors[i].bufferInfo;
 		}
 
-		vkUpdateDescriptorSets(m_Pool.m_Device.getDevice(), m_Writes.size(), m_Writes.data(), 0, nullptr);
+		vkUpdateDescriptorSets(m_Device.getDevice(), static_cast<uint32_t>(immediateWrites.size()), immediateWrites.data(), 0, nullptr);
+		m_FrameWrites += static_cast<uint32_t>(immediateWrites.size());
+	}
+
+	void DescriptorUpdateBatcher::flush() {
+		if (m_PendingCount == 0) {
+			return;
+		}
+
+		std::vector<VkWriteDescriptorSet> writes;
+		writes.reserve(m_PendingCount);
+
+		// Move the pending descriptors over first, the writes point into the written map
+		for (auto& [set, state] : m_Sets) {
+			for (auto& [key, descriptor] : state.pending) {
+				Descriptor& written = state.written[key];
+				written = descriptor;
+
+				writes.push_back(getWrite(set, key, written));
+			}
+
+			state.pending.clear();
+		}
+
+		vkUpdateDescriptorSets(m_Device.getDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+		m_FrameWrites += static_cast<uint32_t>(writes.size());
+		m_PendingCount = 0;
+	}
+
+	void DescriptorUpdateBatcher::beginFrame() {
+		flush();
+
+		m_LastFrameWrites = m_FrameWrites;
+		m_LastFrameSkippedWrites = m_FrameSkippedWrites;
+		m_FrameWrites = 0;
+		m_FrameSkippedWrites = 0;
+	}
+
+	void DescriptorUpdateBatcher::reset(VkDescriptorSet set) {
+		auto search = m_Sets.find(set);
+
+		if (search == m_Sets.end()) {
+			return;
+		}
+
+		m_PendingCount -= search->second.pending.size();
+		m_Sets.erase(search);
+	}
+
+	template<typename Predicate>
+	void DescriptorUpdateBatcher::forget(Predicate references) {
+		for (auto& [set, state] : m_Sets) {
+			// Written descriptors keep referencing the destroyed object until they are written again
+			for (auto it = state.written.begin(); it != state.written.end();) {
+				if (references(it->second)) {
+					it = state.written.erase(it);
+				}
+				else {
+					++it;
+				}
+			}
+
+			// Queued writes would reference a destroyed object
+			for (auto it = state.pending.begin(); it != state.pending.end();) {
+				if (references(it->second)) {
+					it = state.pending.erase(it);
+					m_PendingCount--;
+				}
+				else {
+					++it;
+				}
+			}
+		}
+	}
+
+	void DescriptorUpdateBatcher::forgetImageView(VkImageView imageView) {
+		forget([imageView](const Descriptor& descriptor) { return descriptor.imageInfo.imageView == imageView; });
+	}
+
+	void DescriptorUpdateBatcher::forgetBuffer(VkBuffer buffer) {
+		forget([buffer](const Descriptor& descriptor) { return descriptor.bufferInfo.buffer == buffer; });
+	}
+
+	void DescriptorUpdateBatcher::forgetSampler(VkSampler sampler) {
+		forget([sampler](const Descriptor& descriptor) { return descriptor.imageInfo.sampler == sampler; });
+	}
+
+	uint64_t DescriptorUpdateBatcher::getKey(uint32_t binding, uint32_t arrayElement) {
+		return (static_cast<uint64_t>(binding) << 32) | arrayElement;
+	}
+
+	DescriptorUpdateBatcher::Descriptor DescriptorUpdateBatcher::getDescriptor(const VkWriteDescriptorSet& write, uint32_t element) {
+		Descriptor descriptor{};
+		descriptor.type = write.descriptorType;
+
+		if (write.pImageInfo) {
+			descriptor.imageInfo = write.pImageInfo[element];
+		}
+
+		if (write.pBufferInfo) {
+			descriptor.bufferInfo = write.pBufferInfo[element];
+		}
+
+		return descriptor;
+	}
+
+	VkWriteDescriptorSet DescriptorUpdateBatcher::getWrite(VkDescriptorSet set, uint64_t key, const Descriptor& descriptor) {
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = set;
+		write.dstBinding = static_cast<uint32_t>(key >> 32);
+		write.dstArrayElement = static_cast<uint32_t>(key & 0xffffffffull);
+		write.descriptorCount = 1;
+		write.descriptorType = descriptor.type;
+		write.pImageInfo = &descriptor.imageInfo;
+		write.pBufferInfo = &descriptor.bufferInfo;
+
+		return write;
 	}
 
 }
\ No newline at end of file
@@ -97,6 +97,7 @@ namespace pw {
 	private:
 		GraphicsDevice_Vulkan& m_Device;
 		VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
+		mutable std::vector<VkDescriptorSet> m_AllocatedSets;
 
 		friend class DescriptorWriter;
 	};
@@ -108,16 +109,79 @@ namespace pw {
 			m_SetLayout(setLayout), m_Pool(pool) {};
 		~DescriptorWriter() = default;
 
-		DescriptorWriter& writeBuffer(uint32_t binding, VkDescriptorBufferInfo* bufferInfo);
+		DescriptorWriter& writeBuffer(uint32_t binding, VkDescriptorBufferInfo* bufferInfo, uint32_t index = 0);
 		DescriptorWriter& writeImage(uint32_t binding, VkDescriptorImageInfo* imageInfo, uint32_t index = 0);
 
 		bool build(VkDescriptorSet& set);
-		void overwrite(VkDescriptorSet& set);
+		void overwrite(VkDescriptorSet& set); // goes through the device's DescriptorUpdateBatcher
 
 	private:
 		std::vector<VkWriteDescriptorSet> m_Writes;
 		DescriptorSetLayout& m_SetLayout;
 		DescriptorPool& m_Pool;
 	};
-}
 
+	// ******** Descriptor Update Batcher ********
+	/*
+	* Collects the descriptor writes of a frame. Writes to bindings with VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+	* are queued and applied with a single vkUpdateDescriptorSets call by flush(), which the renderer calls before it
+	* starts recording and again before submitting. Other bindings may not change once bound, so they are written
+	* right away. A descriptor that is written several times before a flush is only updated once, and writes that
+	* would not change what the descriptor already holds are skipped.
+	*/
+	class PW_API DescriptorUpdateBatcher {
+	public:
+		DescriptorUpdateBatcher(GraphicsDevice_Vulkan& device) : m_Device(device) {};
+		~DescriptorUpdateBatcher() = default;
+
+		// Forbid copy and move semantics
+		DescriptorUpdateBatcher(const DescriptorUpdateBatcher&) = delete;
+		DescriptorUpdateBatcher& operator=(const DescriptorUpdateBatcher&) = delete;
+
+		void write(const std::vector<VkWriteDescriptorSet>& writes, bool updateAfterBind);
+		void flush();
+		void beginFrame(); // flushes and starts counting the writes of a new frame
+
+		// A freshly allocated set might reuse the handle of a set from a destroyed pool
+		void reset(VkDescriptorSet set);
+
+		// Destroyed objects might hand their handles to new ones, descriptors referencing them have to be written again
+		void forgetImageView(VkImageView imageView);
+		void forgetBuffer(VkBuffer buffer);
+		void forgetSampler(VkSampler sampler);
+
+		// Getters (of the previous frame)
+		inline uint32_t getWriteCount() const { return m_LastFrameWrites; }
+		inline uint32_t getSkippedWriteCount() const { return m_LastFrameSkippedWrites; }
+
+	private:
+		struct Descriptor {
+			VkDescriptorType type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+			VkDescriptorImageInfo imageInfo{};
+			VkDescriptorBufferInfo bufferInfo{};
+
+			bool operator==(const Descriptor& other) const;
+		};
+
+		struct SetState {
+			std::unordered_map<uint64_t, Descriptor> written; // by binding and array element
+			std::unordered_map<uint64_t, Descriptor> pending;
+		};
+
+		static uint64_t getKey(uint32_t binding, uint32_t arrayElement);
+		static Descriptor getDescriptor(const VkWriteDescriptorSet& write, uint32_t element);
+		static VkWriteDescriptorSet getWrite(VkDescriptorSet set, uint64_t key, const Descriptor& descriptor);
+
+		template<typename Predicate>
+		void forget(Predicate references);
+
+		GraphicsDevice_Vulkan& m_Device;
+		std::unordered_map<VkDescriptorSet, SetState> m_Sets;
+		size_t m_PendingCount = 0;
+
+		uint32_t m_FrameWrites = 0;
+		uint32_t m_FrameSkippedWrites = 0;
+		uint32_t m_LastFrameWrites = 0;
+		uint32_t m_LastFrameSkippedWrites = 0;
+	};
+}
@@ -0,0 +1,296 @@
+#include "geometryStore.hpp"
+
+// primwalk
+#include "buffer.hpp"
+#include "graphicsDevice_Vulkan.hpp"
+
+// std
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace pw {
+
+	namespace {
+		// 16-bit ranges are kept at whole 32-bit words, the visibility resolve reads them as such
+		uint32_t getIndexRangeSize(uint32_t indexCount, VkIndexType indexType) {
+			return indexType == VK_INDEX_TYPE_UINT16 ? (indexCount + 1) & ~1u : indexCount;
+		}
+
+		VkDeviceSize getIndexSize(VkIndexType indexType) {
+			return indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+		}
+	}
+
+	RangeAllocator::RangeAllocator(uint32_t capacity) : m_Capacity(capacity) {
+		if (capacity > 0) {
+			m_FreeRanges[0] = capacity;
+		}
+	}
+
+	bool RangeAllocator::allocate(uint32_t count, uint32_t& offset) {
+		for (auto it = m_FreeRanges.begin(); it != m_FreeRanges.end(); it++) {
+			if (it->second < count) {
+				continue;
+			}
+
+			offset = it->first;
+			uint32_t remaining = it->second - count;
+			m_FreeRanges.erase(it);
+
+			if (remaining > 0) {
+				m_FreeRanges[offset + count] = remaining;
+			}
+
+			m_Used += count;
+			return true;
+		}
+
+		return false;
+	}
+
+	void RangeAllocator::free(uint32_t offset, uint32_t count) {
+		m_Used -= count;
+		insertRange(offset, count);
+	}
+
+	void RangeAllocator::grow(uint32_t capacity) {
+		if (capacity <= m_Capacity) {
+			return;
+		}
+
+		insertRange(m_Capacity, capacity - m_Capacity);
+		m_Capacity = capacity;
+	}
+
+	uint32_t RangeAllocator::getLargestFreeRange() const {
+		uint32_t largest = 0;
+
+		for (const auto& range : m_FreeRanges) {
+			largest = std::max(largest, range.second);
+		}
+
+		return largest;
+	}
+
+	void RangeAllocator::insertRange(uint32_t offset, uint32_t count) {
+		if (count == 0) {
+			return;
+		}
+
+		// Merge with the free range behind, then with the one in front
+		auto next = m_FreeRanges.lower_bound(offset);
+
+		if (next != m_FreeRanges.end() && offset + count == next->first) {
+			count += next->second;
+			next = m_FreeRanges.erase(next);
+		}
+
+		if (next != m_FreeRanges.begin()) {
+			auto previous = std::prev(next);
+
+			if (previous->first + previous->second == offset) {
+				previous->second += count;
+				return;
+			}
+		}
+
+		m_FreeRanges[offset] = count;
+	}
+
+	GeometryStore::GeometryStore(GraphicsDevice_Vulkan& device, uint32_t vertexCapacity, uint32_t indexCapacity) :
+		m_Device(device), m_VertexAllocator(vertexCapacity), m_IndexAllocator(indexCapacity),
+		m_ShortIndexAllocator(getIndexRangeSize(indexCapacity, VK_INDEX_TYPE_UINT16)) {
+		m_PositionBuffer = createArena(sizeof(glm::vec3), vertexCapacity, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+		m_VertexBuffer = createArena(sizeof(Vertex3D), vertexCapacity, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+		m_IndexBuffer = createArena(sizeof(uint32_t), m_IndexAllocator.getCapacity(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+		m_ShortIndexBuffer = createArena(sizeof(uint16_t), m_ShortIndexAllocator.getCapacity(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+	}
+
+	GeometryStore::~GeometryStore() = default; // Buffer is incomplete in the header
+
+	GeometryAllocation GeometryStore::allocate(uint32_t vertexCount, uint32_t indexCount, VkIndexType indexType) {
+		GeometryAllocation allocation{};
+
+		if (vertexCount == 0) {
+			return allocation;
+		}
+
+		uint32_t indexRangeSize = getIndexRangeSize(indexCount, indexType);
+		RangeAllocator& indexAllocator = getIndexAllocator(indexType);
+		bool reclaimed = false;
+
+		// Out of space: reclaim whatever was freed by frames still in flight first, reallocate only if that does not suffice
+		auto reclaimAll = [&]() {
+			if (reclaimed || m_ReleasedAllocations.empty()) {
+				return;
+			}
+
+			m_Device.waitForGPU();
+
+			for (const auto& released : m_ReleasedAllocations) {
+				reclaim(released.allocation);
+			}
+
+			m_ReleasedAllocations.clear();
+			reclaimed = true;
+		};
+
+		if (!m_VertexAllocator.allocate(vertexCount, allocation.baseVertex)) {
+			reclaimAll();
+
+			if (!m_VertexAllocator.allocate(vertexCount, allocation.baseVertex)) {
+				growVertices(m_VertexAllocator.getCapacity() + vertexCount);
+				m_VertexAllocator.allocate(vertexCount, allocation.baseVertex);
+			}
+		}
+
+		if (!indexAllocator.allocate(indexRangeSize, allocation.baseIndex)) {
+			reclaimAll();
+
+			if (!indexAllocator.allocate(indexRangeSize, allocation.baseIndex)) {
+				growIndices(indexType, indexAllocator.getCapacity() + indexRangeSize);
+				indexAllocator.allocate(indexRangeSize, allocation.baseIndex);
+			}
+		}
+
+		allocation.vertexCount = vertexCount;
+		allocation.indexCount = indexCount;
+		allocation.indexType = indexType;
+		m_AllocationCount++;
+
+		return allocation;
+	}
+
+	void GeometryStore::free(GeometryAllocation& allocation, std::unique_ptr<Buffer> meshletBuffer) {
+		if (!allocation.isValid() && !meshletBuffer) {
+			return;
+		}
+
+		if (allocation.isValid()) {
+			m_AllocationCount--;
+		}
+
+		// Frames in flight may still draw from the ranges and cull against the meshlets
+		m_ReleasedAllocations.push_back({ allocation, std::move(meshletBuffer), m_Device.getFrameCount() });
+		allocation = {};
+	}
+
+	UploadTicket GeometryStore::upload(const GeometryAllocation& allocation, const glm::vec3* positions, const Vertex3D* vertices,
+		const uint32_t* indices) {
+		UploadManager& uploadManager = m_Device.getUploadManager();
+		UploadTicket ticket = 0;
+
+		ticket = std::max(ticket, uploadManager.uploadBuffer(*m_PositionBuffer, positions,
+			sizeof(glm::vec3) * allocation.vertexCount, sizeof(glm::vec3) * allocation.baseVertex));
+		ticket = std::max(ticket, uploadManager.uploadBuffer(*m_VertexBuffer, vertices,
+			sizeof(Vertex3D) * allocation.vertexCount, sizeof(Vertex3D) * allocation.baseVertex));
+
+		if (allocation.indexType == VK_INDEX_TYPE_UINT16) {
+			std::vector<uint16_t> shortIndices(indices, indices + allocation.indexCount);
+			shortIndices.resize(getIndexRangeSize(allocation.indexCount, allocation.indexType), 0);
+
+			ticket = std::max(ticket, uploadManager.uploadBuffer(*m_ShortIndexBuffer, shortIndices.data(),
+				sizeof(uint16_t) * shortIndices.size(), sizeof(uint16_t) * allocation.baseIndex));
+		}
+		else {
+			ticket = std::max(ticket, uploadManager.uploadBuffer(*m_IndexBuffer, indices,
+				sizeof(uint32_t) * allocation.indexCount, sizeof(uint32_t) * allocation.baseIndex));
+		}
+
+		m_UploadTicket = std::max(m_UploadTicket, ticket);
+		return ticket;
+	}
+
+	void GeometryStore::update() {
+		// Called once the fence of the frame was waited for, older frames have completed as well
+		uint64_t frameCount = m_Device.getFrameCount();
+
+		while (!m_ReleasedAllocations.empty() &&
+			m_ReleasedAllocations.front().frame + GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT <= frameCount) {
+			reclaim(m_ReleasedAllocations.front().allocation);
+			m_ReleasedAllocations.pop_front();
+		}
+	}
+
+	void GeometryStore::bind(VkCommandBuffer commandBuffer, VkIndexType indexType) {
+		VkBuffer buffers[] = { m_PositionBuffer->getBuffer(), m_VertexBuffer->getBuffer() };
+		VkDeviceSize offsets[] = { 0, 0 };
+		vkCmdBindVertexBuffers(commandBuffer, 0, 2, buffers, offsets);
+		vkCmdBindIndexBuffer(commandBuffer, getIndexBuffer(indexType)->getBuffer(), 0, indexType);
+	}
+
+	void GeometryStore::bindPositions(VkCommandBuffer commandBuffer, VkIndexType indexType) {
+		VkBuffer buffers[] = { m_PositionBuffer->getBuffer() };
+		VkDeviceSize offsets[] = { 0 };
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+		vkCmdBindIndexBuffer(commandBuffer, getIndexBuffer(indexType)->getBuffer(), 0, indexType);
+	}
+
+	GeometryStore::Stats GeometryStore::getStats() const {
+		Stats stats{};
+		stats.allocations = m_AllocationCount;
+		stats.usedVertices = m_VertexAllocator.getUsed();
+		stats.vertexCapacity = m_VertexAllocator.getCapacity();
+		stats.usedIndices[0] = m_ShortIndexAllocator.getUsed();
+		stats.usedIndices[1] = m_IndexAllocator.getUsed();
+		stats.indexCapacity[0] = m_ShortIndexAllocator.getCapacity();
+		stats.indexCapacity[1] = m_IndexAllocator.getCapacity();
+		stats.freeRanges = m_VertexAllocator.getFreeRangeCount() + m_IndexAllocator.getFreeRangeCount() +
+			m_ShortIndexAllocator.getFreeRangeCount();
+
+		return stats;
+	}
+
+	void GeometryStore::reclaim(const GeometryAllocation& allocation) {
+		m_VertexAllocator.free(allocation.baseVertex, allocation.vertexCount);
+		getIndexAllocator(allocation.indexType).free(allocation.baseIndex, getIndexRangeSize(allocation.indexCount, allocation.indexType));
+	}
+
+	void GeometryStore::growVertices(uint32_t minCapacity) {
+		uint32_t capacity = std::max(m_VertexAllocator.getCapacity() * 2, minCapacity);
+
+		m_PositionBuffer = resizeArena(*m_PositionBuffer, sizeof(glm::vec3), capacity);
+		m_VertexBuffer = resizeArena(*m_VertexBuffer, sizeof(Vertex3D), capacity);
+		m_VertexAllocator.grow(capacity);
+		m_Generation++;
+	}
+
+	void GeometryStore::growIndices(VkIndexType indexType, uint32_t minCapacity) {
+		RangeAllocator& allocator = getIndexAllocator(indexType);
+		uint32_t capacity = getIndexRangeSize(std::max(allocator.getCapacity() * 2, minCapacity), indexType);
+
+		if (indexType == VK_INDEX_TYPE_UINT16) {
+			m_ShortIndexBuffer = resizeArena(*m_ShortIndexBuffer, getIndexSize(indexType), capacity);
+		}
+		else {
+			m_IndexBuffer = resizeArena(*m_IndexBuffer, getIndexSize(indexType), capacity);
+		}
+
+		allocator.grow(capacity);
+		m_Generation++;
+	}
+
+	std::unique_ptr<Buffer> GeometryStore::createArena(VkDeviceSize elementSize, uint32_t capacity, VkBufferUsageFlags usage) {
+		return std::make_unique<Buffer>(
+			m_Device,
+			elementSize,
+			capacity,
+			usage | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	}
+
+	std::unique_ptr<Buffer> GeometryStore::resizeArena(const Buffer& arena, VkDeviceSize elementSize, uint32_t capacity) {
+		// Pending uploads and frames in flight use the old buffer, it is destroyed by the caller right after
+		m_Device.getUploadManager().wait(m_UploadTicket);
+		m_Device.waitForGPU();
+
+		std::unique_ptr<Buffer> resized = createArena(elementSize, capacity, arena.getUsageFlags());
+		m_Device.copyBuffer(arena.getBuffer(), resized->getBuffer(), arena.getBufferSize());
+
+		return resized;
+	}
+
+}
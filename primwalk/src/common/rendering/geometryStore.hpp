@@ -0,0 +1,137 @@
+#pragma once
+
+// primwalk
+#include "../../core.hpp"
+#include "uploadManager.hpp"
+#include "vertex3d.hpp"
+
+// std
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+
+// vendor
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+
+namespace pw {
+	// Forward declarations
+	class Buffer;
+	class GraphicsDevice_Vulkan;
+
+	// First fit over a free list sorted by offset, in elements. Freed ranges are merged with their free neighbours.
+	class PW_API RangeAllocator {
+	public:
+		RangeAllocator(uint32_t capacity);
+		~RangeAllocator() = default;
+
+		bool allocate(uint32_t count, uint32_t& offset);
+		void free(uint32_t offset, uint32_t count);
+		void grow(uint32_t capacity); // appends free space at the end
+
+		// Getters
+		inline uint32_t getCapacity() const { return m_Capacity; }
+		inline uint32_t getUsed() const { return m_Used; }
+		inline uint32_t getFreeRangeCount() const { return static_cast<uint32_t>(m_FreeRanges.size()); }
+		uint32_t getLargestFreeRange() const;
+
+	private:
+		void insertRange(uint32_t offset, uint32_t count); // merges with the free neighbours
+
+		std::map<uint32_t, uint32_t> m_FreeRanges{}; // offset -> count
+		uint32_t m_Capacity = 0;
+		uint32_t m_Used = 0;
+	};
+
+	// Range of one model in the geometry store
+	struct PW_API GeometryAllocation {
+		uint32_t baseVertex = 0; // into the position and vertex arenas
+		uint32_t vertexCount = 0;
+		uint32_t baseIndex = 0; // into the index arena of the index type
+		uint32_t indexCount = 0;
+		VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+
+		inline bool isValid() const { return vertexCount > 0; }
+	};
+
+	/*
+	* Device local arenas holding the geometry of every model: the two vertex streams (positions and Vertex3D) share
+	* one range of the vertex arena, indices go into the arena of their type. Meshes draw with global base vertices
+	* and indices, so a pass binds the arenas once and only rebinds the index buffer when the index type changes.
+	* 16-bit indices stay relative to the mesh's base vertex, the draws add it as vertex offset.
+	*
+	* Freed ranges return to their arena once no frame in flight can read them anymore. An arena that is out of space
+	* reclaims every freed range after waiting for the GPU, and is reallocated at twice the size if that does not
+	* suffice. Reallocation changes the buffer handles, users that baked them into descriptors or cached commands
+	* compare getGeneration(). Main thread only, allocate() must not be called while a frame is being recorded.
+	*/
+	class PW_API GeometryStore {
+	public:
+		struct Stats {
+			uint32_t allocations = 0;
+			uint32_t usedVertices = 0;
+			uint32_t vertexCapacity = 0;
+			uint32_t usedIndices[2] = { 0, 0 }; // 16-bit, 32-bit
+			uint32_t indexCapacity[2] = { 0, 0 };
+			uint32_t freeRanges = 0; // over all arenas, a measure of fragmentation
+		};
+
+		GeometryStore(GraphicsDevice_Vulkan& device, uint32_t vertexCapacity = DEFAULT_VERTEX_CAPACITY, uint32_t indexCapacity = DEFAULT_INDEX_CAPACITY);
+		~GeometryStore();
+
+		// Forbid copy and move semantics
+		GeometryStore(const GeometryStore&) = delete;
+		GeometryStore& operator=(const GeometryStore&) = delete;
+
+		GeometryAllocation allocate(uint32_t vertexCount, uint32_t indexCount, VkIndexType indexType);
+		// The range is reused, and the model's meshlet buffer destroyed, once no frame in flight can read them
+		void free(GeometryAllocation& allocation, std::unique_ptr<Buffer> meshletBuffer = nullptr);
+		UploadTicket upload(const GeometryAllocation& allocation, const glm::vec3* positions, const Vertex3D* vertices,
+			const uint32_t* indices); // narrowed to the allocation's index type
+		void update(); // reclaims freed ranges, called at the start of every frame
+
+		void bind(VkCommandBuffer commandBuffer, VkIndexType indexType);
+		void bindPositions(VkCommandBuffer commandBuffer, VkIndexType indexType); // position stream only, for depth-only passes
+
+		// Getters
+		inline Buffer* getPositionBuffer() const { return m_PositionBuffer.get(); }
+		inline Buffer* getVertexBuffer() const { return m_VertexBuffer.get(); }
+		inline Buffer* getIndexBuffer(VkIndexType indexType) const { return indexType == VK_INDEX_TYPE_UINT16 ? m_ShortIndexBuffer.get() : m_IndexBuffer.get(); }
+		inline uint64_t getGeneration() const { return m_Generation; } // changes whenever a buffer is reallocated
+		Stats getStats() const;
+
+		static constexpr uint32_t DEFAULT_VERTEX_CAPACITY = 1u << 20;
+		static constexpr uint32_t DEFAULT_INDEX_CAPACITY = 1u << 22; // per index type
+
+	private:
+		struct ReleasedAllocation {
+			GeometryAllocation allocation{};
+			std::unique_ptr<Buffer> meshletBuffer; // bound in the meshlet culling descriptors
+			uint64_t frame = 0; // frame count at the time of the release
+		};
+
+		void reclaim(const GeometryAllocation& allocation);
+		void growVertices(uint32_t minCapacity);
+		void growIndices(VkIndexType indexType, uint32_t minCapacity);
+		std::unique_ptr<Buffer> createArena(VkDeviceSize elementSize, uint32_t capacity, VkBufferUsageFlags usage);
+		std::unique_ptr<Buffer> resizeArena(const Buffer& arena, VkDeviceSize elementSize, uint32_t capacity); // copies the old contents
+		RangeAllocator& getIndexAllocator(VkIndexType indexType) { return indexType == VK_INDEX_TYPE_UINT16 ? m_ShortIndexAllocator : m_IndexAllocator; }
+
+		GraphicsDevice_Vulkan& m_Device;
+
+		std::unique_ptr<Buffer> m_PositionBuffer;
+		std::unique_ptr<Buffer> m_VertexBuffer;
+		std::unique_ptr<Buffer> m_IndexBuffer;
+		std::unique_ptr<Buffer> m_ShortIndexBuffer; // 16-bit, ranges start at even indices so they are word aligned
+
+		RangeAllocator m_VertexAllocator;
+		RangeAllocator m_IndexAllocator;
+		RangeAllocator m_ShortIndexAllocator;
+
+		std::deque<ReleasedAllocation> m_ReleasedAllocations{}; // in release order
+		uint32_t m_AllocationCount = 0;
+		uint64_t m_Generation = 0;
+		UploadTicket m_UploadTicket = 0; // of the last upload, reallocation waits for it
+	};
+}
@@ -0,0 +1,112 @@
+#include "gpuProfiler.hpp"
+#include "graphicsDevice_Vulkan.hpp"
+
+// std
+#include <array>
+#include <stdexcept>
+
+namespace pw {
+
+	GPUProfiler::GPUProfiler(GraphicsDevice_Vulkan& device, uint32_t maxRegions) :
+		m_Device(device), m_MaxRegions(maxRegions) {
+
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(m_Device.getPhysicalDevice(), &properties);
+
+		m_TimestampPeriod = properties.limits.timestampPeriod;
+		m_Supported = properties.limits.timestampComputeAndGraphics == VK_TRUE;
+
+		m_Written.resize(GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT, std::vector<bool>(m_MaxRegions, false));
+		m_Times.resize(m_MaxRegions, 0.0f);
+
+		if (!m_Supported) {
+			return;
+		}
+
+		VkQueryPoolCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		createInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		createInfo.queryCount = GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT * m_MaxRegions * 2;
+
+		if (vkCreateQueryPool(m_Device.getDevice(), &createInfo, nullptr, &m_QueryPool) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to create timestamp query pool!");
+		}
+	}
+
+	GPUProfiler::~GPUProfiler() {
+		vkDestroyQueryPool(m_Device.getDevice(), m_QueryPool, nullptr);
+	}
+
+	void GPUProfiler::beginFrame(VkCommandBuffer commandBuffer, size_t frameIndex) {
+		m_FrameIndex = frameIndex;
+
+		if (!m_Supported) {
+			return;
+		}
+
+		// The fence of this frame slot has been waited on, so its previous results are final
+		for (uint32_t region = 0; region < m_MaxRegions; region++) {
+			if (!m_Written[m_FrameIndex][region]) {
+				continue;
+			}
+
+			std::array<uint64_t, 2> timestamps{};
+			VkResult result = vkGetQueryPoolResults(m_Device.getDevice(), m_QueryPool, getQueryIndex(region), 2,
+				sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+			if (result == VK_SUCCESS) {
+				m_Times[region] = static_cast<float>(timestamps[1] - timestamps[0]) * m_TimestampPeriod / 1000000.0f;
+			}
+
+			m_Written[m_FrameIndex][region] = false;
+		}
+
+		vkCmdResetQueryPool(commandBuffer, m_QueryPool, getQueryIndex(0), m_MaxRegions * 2);
+	}
+
+	void GPUProfiler::begin(VkCommandBuffer commandBuffer, const std::string& region) {
+		if (!m_Supported) {
+			return;
+		}
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_QueryPool, getQueryIndex(getRegionIndex(region)));
+	}
+
+	void GPUProfiler::end(VkCommandBuffer commandBuffer, const std::string& region) {
+		if (!m_Supported) {
+			return;
+		}
+
+		uint32_t regionIndex = getRegionIndex(region);
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_QueryPool, getQueryIndex(regionIndex) + 1);
+		m_Written[m_FrameIndex][regionIndex] = true;
+	}
+
+	float GPUProfiler::getTime(const std::string& region) const {
+		auto it = m_RegionIndices.find(region);
+		return it != m_RegionIndices.end() ? m_Times[it->second] : 0.0f;
+	}
+
+	uint32_t GPUProfiler::getRegionIndex(const std::string& region) {
+		auto it = m_RegionIndices.find(region);
+
+		if (it != m_RegionIndices.end()) {
+			return it->second;
+		}
+
+		if (m_RegionIndices.size() >= m_MaxRegions) {
+			throw std::runtime_error("VULKAN ERROR: Exceeded the maximum number of profiler regions!");
+		}
+
+		uint32_t index = static_cast<uint32_t>(m_RegionIndices.size());
+		m_RegionIndices[region] = index;
+
+		return index;
+	}
+
+	uint32_t GPUProfiler::getQueryIndex(uint32_t regionIndex) const {
+		return static_cast<uint32_t>(m_FrameIndex) * m_MaxRegions * 2 + regionIndex * 2;
+	}
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+// primwalk
+#include "../../core.hpp"
+
+// std
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// vendor
+#include <vulkan/vulkan.h>
+
+namespace pw {
+	// Forward declarations
+	class GraphicsDevice_Vulkan;
+
+	/*
+	* Measures GPU time of named regions with timestamp queries. Every frame in flight has its own queries, the
+	* results are collected when the frame slot is reused, so the reported times lag MAX_FRAMES_IN_FLIGHT frames
+	* behind but reading them never stalls.
+	*/
+	class PW_API GPUProfiler {
+	public:
+		GPUProfiler(GraphicsDevice_Vulkan& device, uint32_t maxRegions = 16);
+		~GPUProfiler();
+
+		void beginFrame(VkCommandBuffer commandBuffer, size_t frameIndex); // must be recorded before any region
+		void begin(VkCommandBuffer commandBuffer, const std::string& region);
+		void end(VkCommandBuffer commandBuffer, const std::string& region);
+
+		float getTime(const std::string& region) const; // milliseconds, 0 until the first result is available
+		inline bool isSupported() const { return m_Supported; }
+
+	private:
+		uint32_t getRegionIndex(const std::string& region);
+		uint32_t getQueryIndex(uint32_t regionIndex) const;
+
+		GraphicsDevice_Vulkan& m_Device;
+		VkQueryPool m_QueryPool = VK_NULL_HANDLE;
+		uint32_t m_MaxRegions = 0;
+		float m_TimestampPeriod = 1.0f; // nanoseconds per tick
+		bool m_Supported = false;
+		size_t m_FrameIndex = 0;
+
+		std::unordered_map<std::string, uint32_t> m_RegionIndices;
+		std::vector<std::vector<bool>> m_Written; // per frame in flight, per region
+		std::vector<float> m_Times;
+	};
+}
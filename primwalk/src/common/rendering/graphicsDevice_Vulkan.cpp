@@ -1,4 +1,11 @@
 #include "graphicsDevice_Vulkan.hpp"
+#include "commandRecorder.hpp"
+#include "geometryStore.hpp"
+#include "pipelineCache.hpp"
+#include "pipelineCompiler.hpp"
+#include "pipelineLayoutCache.hpp"
+#include "sampler.hpp"
+#include "uploadManager.hpp"
 
 // std
 #include <algorithm>
@@ -6,6 +13,7 @@
 #include <limits>
 #include <set>
 #include <stdexcept>
+#include <thread>
 
 // vendor
 #include <glm/gtc/matrix_transform.hpp>
@@ -18,10 +26,34 @@ namespace pw {
 		pickPhysicalDevice();
 		createLogicalDevice();
 		createCommandPool();
+
+		m_MemoryAllocator = std::make_unique<MemoryAllocator>(*this);
+		m_PipelineCache = std::make_unique<PipelineCache>(*this, std::string(BASE_DIR) + "pipeline.cache");
+		m_PipelineCompiler = std::make_unique<PipelineCompiler>(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+
+		m_DescriptorBatcher = std::make_unique<DescriptorUpdateBatcher>(*this);
 		createDescriptorPool();
+		createBindlessTextureSet();
+		m_PipelineLayoutCache = std::make_unique<PipelineLayoutCache>(*this);
+
+		// The main thread records as well
+		uint32_t threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+		m_CommandRecorder = std::make_unique<CommandRecorder>(*this, threadCount - 1);
+
+		m_UploadManager = std::make_unique<UploadManager>(*this);
+		m_GeometryStore = std::make_unique<GeometryStore>(*this);
 	}
 
 	CommandList GraphicsDevice_Vulkan::beginFrame() {
+		m_FrameCount++;
+
+		// Called once the fence of the frame was waited for, older frames have completed as well
+		while (!m_ReleasedBindlessIndices.empty() &&
+			m_ReleasedBindlessIndices.front().frame + MAX_FRAMES_IN_FLIGHT <= m_FrameCount) {
+			m_FreeBindlessIndices.push_back(m_ReleasedBindlessIndices.front().index);
+			m_ReleasedBindlessIndices.pop_front();
+		}
+
 		CommandList cmd = {};
 		return cmd;
 	}
@@ -32,10 +64,79 @@ namespace pw {
 
 	void GraphicsDevice_Vulkan::waitForGPU() {
 		vkDeviceWaitIdle(m_Device);
+
+		for (const auto& released : m_ReleasedBindlessIndices) {
+			m_FreeBindlessIndices.push_back(released.index);
+		}
+
+		m_ReleasedBindlessIndices.clear();
+	}
+
+	uint32_t GraphicsDevice_Vulkan::registerBindlessImage(VkImageView imageView) {
+		if (m_FreeBindlessIndices.empty()) {
+			throw std::runtime_error("VULKAN ERROR: Out of bindless image descriptors!");
+		}
+
+		uint32_t index = m_FreeBindlessIndices.back();
+		m_FreeBindlessIndices.pop_back();
+
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = imageView;
+		imageInfo.sampler = m_BindlessSampler->getVkSampler();
+
+		DescriptorWriter(*m_BindlessTextureSetLayout, *m_BindlessDescriptorPool)
+			.writeImage(0, &imageInfo, index)
+			.overwrite(m_BindlessTextureSet);
+
+		return index;
+	}
+
+	void GraphicsDevice_Vulkan::releaseBindlessImage(uint32_t index) {
+		if (index == INVALID_BINDLESS_INDEX || index == DEFAULT_BINDLESS_INDEX) {
+			return;
+		}
+
+		// The descriptor is left as is, it is not sampled anymore and gets overwritten on reuse
+		m_ReleasedBindlessIndices.push_back({ index, m_FrameCount });
+	}
+
+	void GraphicsDevice_Vulkan::setDefaultBindlessImage(VkImageView imageView) {
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = imageView;
+		imageInfo.sampler = m_BindlessSampler->getVkSampler();
+
+		DescriptorWriter(*m_BindlessTextureSetLayout, *m_BindlessDescriptorPool)
+			.writeImage(0, &imageInfo, DEFAULT_BINDLESS_INDEX)
+			.overwrite(m_BindlessTextureSet);
+	}
+
+	void GraphicsDevice_Vulkan::addFrameWaitSemaphore(VkSemaphore semaphore, VkPipelineStageFlags waitStage) {
+		m_FrameWaitSemaphores.push_back(semaphore);
+		m_FrameWaitStages.push_back(waitStage);
+	}
+
+	void GraphicsDevice_Vulkan::takeFrameWaitSemaphores(std::vector<VkSemaphore>& semaphores, std::vector<VkPipelineStageFlags>& waitStages) {
+		semaphores.insert(semaphores.end(), m_FrameWaitSemaphores.begin(), m_FrameWaitSemaphores.end());
+		waitStages.insert(waitStages.end(), m_FrameWaitStages.begin(), m_FrameWaitStages.end());
+
+		m_FrameWaitSemaphores.clear();
+		m_FrameWaitStages.clear();
 	}
 
 	GraphicsDevice_Vulkan::~GraphicsDevice_Vulkan() {
+		m_UploadManager.reset(); // waits for the uploads in flight
+		m_GeometryStore.reset();
+		m_BindlessSampler.reset();
+		m_PipelineLayoutCache.reset();
+		m_BindlessTextureSetLayout.reset();
 		m_BindlessDescriptorPool.reset();
+		m_DescriptorBatcher.reset();
+		m_CommandRecorder.reset();
+		m_MemoryAllocator.reset();
+		m_PipelineCompiler.reset();
+		m_PipelineCache.reset(); // written to disk
 
 		vkDestroyCommandPool(m_Device, m_CommandPool, nullptr);
 		vkDestroyDevice(m_Device, nullptr);
@@ -164,6 +265,14 @@ namespace pw {
 		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 		std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value() };
 
+		if (indices.transferFamily.has_value()) {
+			uniqueQueueFamilies.insert(indices.transferFamily.value());
+		}
+
+		if (indices.computeFamily.has_value()) {
+			uniqueQueueFamilies.insert(indices.computeFamily.value());
+		}
+
 		// Queue specification
 		float queuePriority = 1.0f;
 		for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -176,18 +285,20 @@ namespace pw {
 		}
 
 		// Device feature specification
-		VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures{};
-		descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
-		descriptorIndexingFeatures.pNext = nullptr;
+		// Descriptor indexing and draw indirect count are both part of the Vulkan 1.2 features
+		VkPhysicalDeviceVulkan12Features vulkan12Features{};
+		vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		vulkan12Features.pNext = nullptr;
 
 		VkPhysicalDeviceFeatures2 deviceFeatures;
 		deviceFeatures.features.samplerAnisotropy = VK_TRUE;
 		deviceFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
-		deviceFeatures.pNext = &descriptorIndexingFeatures;
+		deviceFeatures.pNext = &vulkan12Features;
 		vkGetPhysicalDeviceFeatures2(m_PhysicalDevice, &deviceFeatures);
 
 		// TODO: If descriptor indexing is not available, use another approach
-		m_BindlessSupported = descriptorIndexingFeatures.descriptorBindingPartiallyBound && descriptorIndexingFeatures.runtimeDescriptorArray;
+		m_BindlessSupported = vulkan12Features.descriptorBindingPartiallyBound && vulkan12Features.runtimeDescriptorArray;
+		m_DrawIndirectCountSupported = vulkan12Features.drawIndirectCount;
 
 		// Logical device creation
 		VkDeviceCreateInfo createInfo{};
@@ -211,6 +322,12 @@ namespace pw {
 
 		vkGetDeviceQueue(m_Device, indices.graphicsFamily.value(), 0, &m_GraphicsQueue);
 		vkGetDeviceQueue(m_Device, indices.presentFamily.value(), 0, &m_PresentQueue);
+
+		m_DedicatedTransferQueue = indices.transferFamily.has_value();
+		vkGetDeviceQueue(m_Device, indices.transferFamily.value_or(indices.graphicsFamily.value()), 0, &m_TransferQueue);
+
+		m_AsyncComputeQueue = indices.computeFamily.has_value();
+		vkGetDeviceQueue(m_Device, indices.computeFamily.value_or(indices.graphicsFamily.value()), 0, &m_ComputeQueue);
 	}
 
 	void GraphicsDevice_Vulkan::createCommandPool() {
@@ -236,6 +353,29 @@ namespace pw {
 			.build();
 	}
 
+	void GraphicsDevice_Vulkan::createBindlessTextureSet() {
+		// Slots of released images are rewritten while older frames might still be executing
+		m_BindlessTextureSetLayout = DescriptorSetLayout::Builder(*this)
+			.setLayoutFlags(VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, MAX_IMAGE_DESCRIPTORS,
+				VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+				VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT)
+			.build();
+
+		DescriptorWriter(*m_BindlessTextureSetLayout, *m_BindlessDescriptorPool)
+			.build(m_BindlessTextureSet);
+
+		SamplerCreateInfo samplerInfo{};
+		m_BindlessSampler = std::make_unique<Sampler>(samplerInfo, *this);
+
+		// Popped from the back, the lowest indices are handed out first
+		m_FreeBindlessIndices.reserve(MAX_IMAGE_DESCRIPTORS);
+
+		for (uint32_t index = MAX_IMAGE_DESCRIPTORS - 1; index > DEFAULT_BINDLESS_INDEX; index--) {
+			m_FreeBindlessIndices.push_back(index);
+		}
+	}
+
 	std::vector<std::string> GraphicsDevice_Vulkan::getRequiredVulkanInstanceExtensions() {
 		#if defined(PW_WIN32)
 			std::vector<std::string> extensions = {
@@ -279,7 +419,7 @@ namespace pw {
 		return true;
 	}
 
-	void GraphicsDevice_Vulkan::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory) {
+	void GraphicsDevice_Vulkan::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, MemoryAllocation& bufferMemory, bool sharedWithAsyncCompute) {
 		// Buffer creation
 		VkBufferCreateInfo bufferInfo{};
 		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -287,25 +427,25 @@ namespace pw {
 		bufferInfo.usage = usage;
 		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-		if (vkCreateBuffer(m_Device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
-			throw std::runtime_error("VULKAN ERROR: Failed to create buffer!");
-		}
+		// Read by both queues without ownership transfers, e.g. host written data that is never handed over
+		uint32_t queueFamilyIndices[2]{};
 
-		// Memory requirements
-		VkMemoryRequirements memRequirements;
-		vkGetBufferMemoryRequirements(m_Device, buffer, &memRequirements);
+		if (sharedWithAsyncCompute && m_AsyncComputeQueue) {
+			QueueFamilyIndices indices = findQueueFamilies(m_PhysicalDevice);
+			queueFamilyIndices[0] = indices.graphicsFamily.value();
+			queueFamilyIndices[1] = indices.computeFamily.value();
 
-		// Memory allocation
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+			bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			bufferInfo.queueFamilyIndexCount = 2;
+			bufferInfo.pQueueFamilyIndices = queueFamilyIndices;
+		}
 
-		if (vkAllocateMemory(m_Device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-			throw std::runtime_error("VUlKAN ERROR: Failed to allocate buffer memory!");
+		if (vkCreateBuffer(m_Device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to create buffer!");
 		}
 
-		vkBindBufferMemory(m_Device, buffer, bufferMemory, 0);
+		// Memory allocation, sub-allocated from a block shared with other buffers
+		bufferMemory = m_MemoryAllocator->allocateBufferMemory(buffer, properties);
 	}
 
 	void GraphicsDevice_Vulkan::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
@@ -353,6 +493,13 @@ namespace pw {
 			sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
 			destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
 		}
+		else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+			sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		}
 		else if (oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
 			barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
 			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
@@ -501,6 +648,26 @@ namespace pw {
 			i++;
 		}
 
+		// Transfer-only families are backed by copy engines, which run alongside the graphics queue
+		for (uint32_t family = 0; family < queueFamilyCount; family++) {
+			VkQueueFlags flags = queueFamilies[family].queueFlags;
+
+			if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+				indices.transferFamily = family;
+				break;
+			}
+		}
+
+		// Compute families without graphics are scheduled independently of the graphics queue
+		for (uint32_t family = 0; family < queueFamilyCount; family++) {
+			VkQueueFlags flags = queueFamilies[family].queueFlags;
+
+			if ((flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT)) {
+				indices.computeFamily = family;
+				break;
+			}
+		}
+
 		return indices;
 	}
 
@@ -558,6 +725,19 @@ namespace pw {
 		throw std::runtime_error("VULKAN ERROR: Failed to find a suitable memory type!");
 	}
 
+	bool GraphicsDevice_Vulkan::hasMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+		VkPhysicalDeviceMemoryProperties memProperties;
+		vkGetPhysicalDeviceMemoryProperties(m_PhysicalDevice, &memProperties);
+
+		for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+			if (typeFilter & (1 << i) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
 	VkFormat GraphicsDevice_Vulkan::getSupportedDepthFormat() {
 		VkFormat depthFormat = VK_FORMAT_UNDEFINED;
 
@@ -14,8 +14,11 @@
 #include "graphicsDevice.hpp"
 #include "image.hpp"
 #include "descriptors.hpp"
+#include "memoryAllocator.hpp"
 
 // std
+#include <cstdint>
+#include <deque>
 #include <memory>
 #include <optional>
 #include <set>
@@ -42,6 +45,15 @@ typedef VkResult(*PFN_vkCreateMetalSurfaceEXT)(VkInstance, const VkMetalSurfaceC
 #endif
 
 namespace pw {
+	// Forward declarations
+	class CommandRecorder;
+	class GeometryStore;
+	class PipelineCache;
+	class PipelineCompiler;
+	class PipelineLayoutCache;
+	class Sampler;
+	class UploadManager;
+
 	struct CommandList_Vulkan {
 		VkCommandBuffer commandList = VK_NULL_HANDLE;
 	};
@@ -55,6 +67,8 @@ namespace pw {
 	struct PW_API QueueFamilyIndices {
 		std::optional<uint32_t> graphicsFamily;
 		std::optional<uint32_t> presentFamily;
+		std::optional<uint32_t> transferFamily; // transfer-only, not every device has one
+		std::optional<uint32_t> computeFamily; // compute without graphics, not every device has one
 
 		inline bool isComplete() const {
 			return graphicsFamily.has_value() && presentFamily.has_value();
@@ -77,18 +91,28 @@ namespace pw {
 		void waitForGPU() override;
 
 		void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
-			VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+			VkBuffer& buffer, MemoryAllocation& bufferMemory, bool sharedWithAsyncCompute = false);
 		void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
 		void transitionImageLayout(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
 		void endSingleTimeCommands(VkCommandBuffer commandBuffer);
 		VkCommandBuffer beginSingleTimeCommands();
 		uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+		bool hasMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
 		VkFormat getSupportedDepthFormat();
 
 		VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
 		VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
 		VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
 
+		// Bindless textures, every sampled 2D image registers itself when its view is created (see Image::getBindlessIndex())
+		uint32_t registerBindlessImage(VkImageView imageView);
+		void releaseBindlessImage(uint32_t index); // the slot is handed out again once no frame in flight can sample it
+		void setDefaultBindlessImage(VkImageView imageView);
+
+		// Semaphores the next frame submission waits on besides the swapchain image, e.g. async compute work it consumes
+		void addFrameWaitSemaphore(VkSemaphore semaphore, VkPipelineStageFlags waitStage);
+		void takeFrameWaitSemaphores(std::vector<VkSemaphore>& semaphores, std::vector<VkPipelineStageFlags>& waitStages); // appends and clears
+
 		// Getters
 		inline VkDevice getDevice() const { return m_Device; }
 		inline VkPhysicalDevice getPhysicalDevice() const { return m_PhysicalDevice; }
@@ -96,14 +120,32 @@ namespace pw {
 		inline VkSurfaceKHR getSurface() const { return m_Surface; }
 		inline VkQueue getGraphicsQueue() const { return m_GraphicsQueue; }
 		inline VkQueue getPresentQueue() const { return m_PresentQueue; }
+		inline VkQueue getTransferQueue() const { return m_TransferQueue; } // the graphics queue without a dedicated one
+		inline bool hasDedicatedTransferQueue() const { return m_DedicatedTransferQueue; }
+		inline VkQueue getComputeQueue() const { return m_ComputeQueue; } // the graphics queue without an async one
+		inline bool hasAsyncComputeQueue() const { return m_AsyncComputeQueue; }
+		inline bool hasDrawIndirectCount() const { return m_DrawIndirectCountSupported; } // GPU-driven draw counts, see MeshletCullingPass
 		inline SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(m_PhysicalDevice); }
 		inline QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(m_PhysicalDevice); }
 		inline DescriptorPool& getBindlessPool() { return *m_BindlessDescriptorPool; }
+		inline DescriptorUpdateBatcher& getDescriptorBatcher() { return *m_DescriptorBatcher; }
+		inline MemoryAllocator& getMemoryAllocator() { return *m_MemoryAllocator; }
+		inline PipelineCache& getPipelineCache() { return *m_PipelineCache; } // persisted across runs
+		inline PipelineCompiler& getPipelineCompiler() { return *m_PipelineCompiler; } // compiles graphics pipelines on worker threads
+		inline PipelineLayoutCache& getPipelineLayoutCache() { return *m_PipelineLayoutCache; } // layouts from shader reflection
+		inline UploadManager& getUploadManager() { return *m_UploadManager; } // batched, non-blocking uploads through a staging ring
+		inline GeometryStore& getGeometryStore() { return *m_GeometryStore; } // vertices and indices of every model
+		inline CommandRecorder& getCommandRecorder() { return *m_CommandRecorder; } // multi-threaded recording of large passes
+		inline DescriptorSetLayout& getBindlessTextureSetLayout() { return *m_BindlessTextureSetLayout; }
+		inline VkDescriptorSet getBindlessTextureSet() const { return m_BindlessTextureSet; }
+		inline uint64_t getFrameCount() const { return m_FrameCount; } // frames begun so far
 
 		static constexpr size_t MAX_FRAMES_IN_FLIGHT = 2;
 		static constexpr uint32_t MAX_IMAGE_DESCRIPTORS = 4096;
 		static constexpr uint32_t MAX_UBO_DESCRIPTORS = 32;
 		static constexpr uint32_t MAX_SSBO_DESCRIPTORS = 32;
+		static constexpr uint32_t DEFAULT_BINDLESS_INDEX = 0; // 1x1 white texture, used by materials without a texture
+		static constexpr uint32_t INVALID_BINDLESS_INDEX = UINT32_MAX;
 
 	private:
 		void createInstance();
@@ -113,6 +155,7 @@ namespace pw {
 		void createLogicalDevice();
 		void createCommandPool();
 		void createDescriptorPool();
+		void createBindlessTextureSet();
 		static std::vector<std::string> getRequiredVulkanInstanceExtensions();
 
 		void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
@@ -141,9 +184,37 @@ namespace pw {
 		VkDevice m_Device = VK_NULL_HANDLE;
 		VkQueue m_GraphicsQueue = VK_NULL_HANDLE;
 		VkQueue m_PresentQueue = VK_NULL_HANDLE;
-		VkCommandPool m_CommandPool = VK_NULL_HANDLE;
+		VkQueue m_TransferQueue = VK_NULL_HANDLE;
+		bool m_DedicatedTransferQueue = false;
+		VkQueue m_ComputeQueue = VK_NULL_HANDLE;
+		bool m_AsyncComputeQueue = false;
+		VkCommandPool m_CommandPool = VK_NULL_HANDLE; // main thread only
+		std::unique_ptr<MemoryAllocator> m_MemoryAllocator{};
+		std::unique_ptr<PipelineCache> m_PipelineCache{};
+		std::unique_ptr<PipelineCompiler> m_PipelineCompiler{};
+		std::unique_ptr<PipelineLayoutCache> m_PipelineLayoutCache{};
+		std::unique_ptr<CommandRecorder> m_CommandRecorder{};
+		std::unique_ptr<UploadManager> m_UploadManager{};
+		std::unique_ptr<GeometryStore> m_GeometryStore{};
 		std::unique_ptr<DescriptorPool> m_BindlessDescriptorPool{};
-		
+		std::unique_ptr<DescriptorUpdateBatcher> m_DescriptorBatcher{};
+
+		// Bindless texture registry
+		struct ReleasedBindlessIndex {
+			uint32_t index = INVALID_BINDLESS_INDEX;
+			uint64_t frame = 0; // frame count at the time of the release
+		};
+
+		std::unique_ptr<DescriptorSetLayout> m_BindlessTextureSetLayout{};
+		VkDescriptorSet m_BindlessTextureSet = VK_NULL_HANDLE;
+		std::unique_ptr<Sampler> m_BindlessSampler{};
+		std::vector<uint32_t> m_FreeBindlessIndices{}; // used as a stack
+		std::deque<ReleasedBindlessIndex> m_ReleasedBindlessIndices{}; // in release order
+		uint64_t m_FrameCount = 0;
+
+		std::vector<VkSemaphore> m_FrameWaitSemaphores{};
+		std::vector<VkPipelineStageFlags> m_FrameWaitStages{};
+
 		Window& m_Window;
 
 		std::vector<const char*> m_DesiredInstanceExtensions = {
@@ -155,6 +226,7 @@ namespace pw {
 		std::vector<std::string> m_RequiredExtensions;
 		std::vector<const char*> m_ExtensionPointers;
 		bool m_BindlessSupported = false;
+		bool m_DrawIndirectCountSupported = false;
 
 		static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
 			VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
@@ -171,9 +243,6 @@ namespace pw {
 			"VK_LAYER_KHRONOS_validation"
 		};
 
-		//std::unordered_map<Image*, uint32_t> m_TextureIDs{};
-		//std::set<uint32_t> m_VacantTextureIDs{};
-
 		#ifdef NDEBUG
 		const bool m_EnableValidationLayers = false;
 		#else
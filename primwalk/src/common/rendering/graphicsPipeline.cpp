@@ -1,5 +1,7 @@
 #include "graphicsPipeline.hpp"
 #include "graphicsDevice_Vulkan.hpp"
+#include "pipelineCache.hpp"
+#include "pipelineCompiler.hpp"
 #include "vertex.hpp"
 #include "../data/shader.hpp"
 
@@ -7,6 +9,74 @@
 #include <stdexcept>
 
 namespace pw {
+	// Everything vkCreateGraphicsPipelines reads, copied so that the config info can go out of scope before the compile
+	struct GraphicsPipelineDescription {
+		std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
+		std::vector<VkShaderModule> shaderModules; // owned, destroyed once compiled
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+		VkPipelineViewportStateCreateInfo viewportInfo{};
+		std::vector<VkViewport> viewports;
+		std::vector<VkRect2D> scissors;
+		VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo{};
+		VkPipelineRasterizationStateCreateInfo rasterizationInfo{};
+		VkPipelineMultisampleStateCreateInfo multisampleInfo{};
+		std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments;
+		VkPipelineColorBlendStateCreateInfo colorBlendInfo{};
+		VkPipelineDepthStencilStateCreateInfo depthStencilInfo{};
+		std::vector<VkDynamicState> dynamicStates;
+		VkPipelineDynamicStateCreateInfo dynamicStateInfo{};
+		VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		uint32_t subpass = 0;
+		ShaderPermutation permutation;
+		VkSpecializationInfo specializationInfo{};
+
+		GraphicsPipelineDescription(const PipelineConfigInfo& configInfo) {
+			bindingDescriptions = configInfo.bindingDescriptions;
+			attributeDescriptions = configInfo.attributeDescriptions;
+
+			vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+			vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
+			vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
+			vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+			vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+			viewportInfo = configInfo.viewportInfo;
+
+			if (viewportInfo.pViewports) {
+				viewports.assign(viewportInfo.pViewports, viewportInfo.pViewports + viewportInfo.viewportCount);
+				viewportInfo.pViewports = viewports.data();
+			}
+
+			if (viewportInfo.pScissors) {
+				scissors.assign(viewportInfo.pScissors, viewportInfo.pScissors + viewportInfo.scissorCount);
+				viewportInfo.pScissors = scissors.data();
+			}
+
+			inputAssemblyInfo = configInfo.inputAssemblyInfo;
+			rasterizationInfo = configInfo.rasterizationInfo;
+			multisampleInfo = configInfo.multisampleInfo;
+			depthStencilInfo = configInfo.depthStencilInfo;
+
+			colorBlendInfo = configInfo.colorBlendInfo;
+			colorBlendAttachments.assign(colorBlendInfo.pAttachments, colorBlendInfo.pAttachments + colorBlendInfo.attachmentCount);
+			colorBlendInfo.pAttachments = colorBlendAttachments.data();
+
+			dynamicStateInfo = configInfo.dynamicStateInfo;
+			dynamicStates.assign(dynamicStateInfo.pDynamicStates, dynamicStateInfo.pDynamicStates + dynamicStateInfo.dynamicStateCount);
+			dynamicStateInfo.pDynamicStates = dynamicStates.data();
+
+			pipelineLayout = configInfo.pipelineLayout;
+			renderPass = configInfo.renderPass;
+			subpass = configInfo.subpass;
+
+			permutation = configInfo.permutation;
+			specializationInfo = permutation.getSpecializationInfo();
+		}
+	};
+
 	GraphicsPipeline::GraphicsPipeline(GraphicsDevice_Vulkan& device,
 		const std::string& vertPath,
 		const std::string& fragPath,
@@ -17,53 +87,86 @@ namespace pw {
 
 	GraphicsPipeline::GraphicsPipeline(GraphicsDevice_Vulkan& device,
 		const std::vector<VkPipelineShaderStageCreateInfo>& shaderStages,
-		const PipelineConfigInfo& configInfo) : m_Device(device) {
+		const PipelineConfigInfo& configInfo,
+		std::vector<VkShaderModule> shaderModules) : m_Device(device) {
 
-		// Vertex input
-		auto& bindingDescriptions = configInfo.bindingDescriptions;
-		auto& attributeDescriptions = configInfo.attributeDescriptions;
+		auto description = std::make_shared<GraphicsPipelineDescription>(configInfo);
+		description->shaderStages = shaderStages;
+		description->shaderModules = std::move(shaderModules);
 
-		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-		vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
-		vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
-		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-		vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
-
-		// ... TODO. Pipeline layout create info moved to renderer
-
-		// Graphics pipeline
-		VkGraphicsPipelineCreateInfo pipelineInfo{};
-		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
-		pipelineInfo.pStages = shaderStages.data();
-		pipelineInfo.pVertexInputState = &vertexInputInfo;
-		pipelineInfo.pInputAssemblyState = &configInfo.inputAssemblyInfo;
-		pipelineInfo.pViewportState = &configInfo.viewportInfo;
-		pipelineInfo.pRasterizationState = &configInfo.rasterizationInfo;
-		pipelineInfo.pMultisampleState = &configInfo.multisampleInfo;
-		pipelineInfo.pColorBlendState = &configInfo.colorBlendInfo;
-		pipelineInfo.pDepthStencilState = &configInfo.depthStencilInfo;
-		pipelineInfo.pDynamicState = &configInfo.dynamicStateInfo;
-
-		pipelineInfo.layout = configInfo.pipelineLayout;
-		pipelineInfo.renderPass = configInfo.renderPass;
-		pipelineInfo.subpass = configInfo.subpass;
-
-		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // optional
-		pipelineInfo.basePipelineIndex = -1; // optional
-
-		if (vkCreateGraphicsPipelines(m_Device.getDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_GraphicsPipeline) != VK_SUCCESS) {
-			throw std::runtime_error("VULKAN ERROR: Failed to create graphics pipeline!");
-		}
+		compile(description);
 	}
 
 	GraphicsPipeline::~GraphicsPipeline() {
-		vkDestroyPipeline(m_Device.getDevice(), m_GraphicsPipeline, nullptr);
+		m_Device.getPipelineCompiler().wait(*m_Job);
+		vkDestroyPipeline(m_Device.getDevice(), m_Job->pipeline, nullptr);
 	}
 
 	void GraphicsPipeline::bind(VkCommandBuffer commandBuffer) {
-		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicsPipeline);
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, getVkPipeline());
+	}
+
+	VkPipeline GraphicsPipeline::getVkPipeline() {
+		m_Device.getPipelineCompiler().wait(*m_Job);
+
+		if (m_Job->error) {
+			std::rethrow_exception(m_Job->error);
+		}
+
+		return m_Job->pipeline;
+	}
+
+	bool GraphicsPipeline::isReady() const {
+		return m_Job->done.load(std::memory_order_acquire);
+	}
+
+	void GraphicsPipeline::compile(std::shared_ptr<GraphicsPipelineDescription> description) {
+		GraphicsDevice_Vulkan& device = m_Device;
+
+		m_Job = m_Device.getPipelineCompiler().submit([&device, description]() {
+			GraphicsPipelineDescription& desc = *description;
+
+			if (!desc.permutation.isEmpty()) {
+				for (auto& stage : desc.shaderStages) {
+					stage.pSpecializationInfo = &desc.specializationInfo;
+				}
+			}
+
+			// Graphics pipeline
+			VkGraphicsPipelineCreateInfo pipelineInfo{};
+			pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+			pipelineInfo.stageCount = static_cast<uint32_t>(desc.shaderStages.size());
+			pipelineInfo.pStages = desc.shaderStages.data();
+			pipelineInfo.pVertexInputState = &desc.vertexInputInfo;
+			pipelineInfo.pInputAssemblyState = &desc.inputAssemblyInfo;
+			pipelineInfo.pViewportState = &desc.viewportInfo;
+			pipelineInfo.pRasterizationState = &desc.rasterizationInfo;
+			pipelineInfo.pMultisampleState = &desc.multisampleInfo;
+			pipelineInfo.pColorBlendState = &desc.colorBlendInfo;
+			pipelineInfo.pDepthStencilState = &desc.depthStencilInfo;
+			pipelineInfo.pDynamicState = &desc.dynamicStateInfo;
+
+			pipelineInfo.layout = desc.pipelineLayout;
+			pipelineInfo.renderPass = desc.renderPass;
+			pipelineInfo.subpass = desc.subpass;
+
+			pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // optional
+			pipelineInfo.basePipelineIndex = -1; // optional
+
+			VkPipeline pipeline = VK_NULL_HANDLE;
+			VkResult result = vkCreateGraphicsPipelines(device.getDevice(), device.getPipelineCache().getVkPipelineCache(), 1, &pipelineInfo, nullptr, &pipeline);
+
+			// Cleanup
+			for (VkShaderModule module : desc.shaderModules) {
+				vkDestroyShaderModule(device.getDevice(), module, nullptr);
+			}
+
+			if (result != VK_SUCCESS) {
+				throw std::runtime_error("VULKAN ERROR: Failed to create graphics pipeline!");
+			}
+
+			return pipeline;
+		});
 	}
 
 	void GraphicsPipeline::defaultPipelineConfigInfo(PipelineConfigInfo& configInfo) {
@@ -170,49 +273,11 @@ namespace pw {
 		fragShaderStageInfo.pName = "main";
 		fragShaderStageInfo.pSpecializationInfo = nullptr; // optional
 
-		VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
-
-		// Vertex input
-		auto& bindingDescriptions = configInfo.bindingDescriptions;
-		auto& attributeDescriptions = configInfo.attributeDescriptions;
+		auto description = std::make_shared<GraphicsPipelineDescription>(configInfo);
+		description->shaderStages = { vertShaderStageInfo, fragShaderStageInfo };
+		description->shaderModules = { vertShaderModule, fragShaderModule };
 
-		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-		vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
-		vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
-		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-		vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
-
-		// ... TODO. Pipeline layout create info moved to renderer
-
-		// Graphics pipeline
-		VkGraphicsPipelineCreateInfo pipelineInfo{};
-		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		pipelineInfo.stageCount = 2;
-		pipelineInfo.pStages = shaderStages;
-		pipelineInfo.pVertexInputState = &vertexInputInfo;
-		pipelineInfo.pInputAssemblyState = &configInfo.inputAssemblyInfo;
-		pipelineInfo.pViewportState = &configInfo.viewportInfo;
-		pipelineInfo.pRasterizationState = &configInfo.rasterizationInfo;
-		pipelineInfo.pMultisampleState = &configInfo.multisampleInfo;
-		pipelineInfo.pColorBlendState = &configInfo.colorBlendInfo;
-		pipelineInfo.pDepthStencilState = &configInfo.depthStencilInfo;
-		pipelineInfo.pDynamicState = &configInfo.dynamicStateInfo;
-
-		pipelineInfo.layout = configInfo.pipelineLayout;
-		pipelineInfo.renderPass = configInfo.renderPass;
-		pipelineInfo.subpass = configInfo.subpass;
-
-		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // optional
-		pipelineInfo.basePipelineIndex = -1; // optional
-
-		if (vkCreateGraphicsPipelines(m_Device.getDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_GraphicsPipeline) != VK_SUCCESS) {
-			throw std::runtime_error("VULKAN ERROR: Failed to create graphics pipeline!");
-		}
-
-		// Cleanup
-		vkDestroyShaderModule(m_Device.getDevice(), vertShaderModule, nullptr);
-		vkDestroyShaderModule(m_Device.getDevice(), fragShaderModule, nullptr);
+		compile(description);
 	}
 
 	VkShaderModule GraphicsPipeline::createShaderModule(const std::vector<char>& code) {
@@ -269,7 +334,11 @@ namespace pw {
 	}
 
 	std::unique_ptr<GraphicsPipeline> GraphicsPipeline::Builder::build() {
-		return std::make_unique<GraphicsPipeline>(m_Device, m_ShaderStages, m_ConfigInfo);
+		// The modules are destroyed by the pipeline once it is compiled
+		auto pipeline = std::make_unique<GraphicsPipeline>(m_Device, m_ShaderStages, m_ConfigInfo, std::move(m_ShaderModules));
+		m_ShaderModules.clear();
+
+		return pipeline;
 	}
 
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 // primwalk
 #include "../../core.hpp"
+#include "pipelineCompiler.hpp"
+#include "shaderPermutation.hpp"
 
 // std
 #include <cstdint>
@@ -33,11 +35,18 @@ namespace pw {
 		VkPipelineLayout pipelineLayout = nullptr;
 		VkRenderPass renderPass = nullptr;
 		uint32_t subpass = 0;
+		ShaderPermutation permutation{}; // specialization constants, applied to every stage
 	};
 
 	// Forward declarations
 	class GraphicsDevice_Vulkan;
+	struct GraphicsPipelineDescription;
 
+	/*
+	* The pipeline is compiled asynchronously by the device's PipelineCompiler, the constructor only copies the
+	* description. bind() waits for the compile if it is still running, so passes create their pipelines up front
+	* and only the frame that first needs one blocks on it.
+	*/
 	class PW_API GraphicsPipeline {
 	public:
 		GraphicsPipeline(GraphicsDevice_Vulkan& device,
@@ -45,9 +54,11 @@ namespace pw {
 			const std::string& fragPath,
 			const PipelineConfigInfo& configInfo);
 
+		// Modules that are not handed over have to outlive the compile (see isReady())
 		GraphicsPipeline(GraphicsDevice_Vulkan& device,
 			const std::vector<VkPipelineShaderStageCreateInfo>& shaderStages,
-			const PipelineConfigInfo& configInfo);
+			const PipelineConfigInfo& configInfo,
+			std::vector<VkShaderModule> shaderModules = {});
 
 		~GraphicsPipeline();
 		
@@ -68,14 +79,17 @@ namespace pw {
 		};
 
 		void bind(VkCommandBuffer commandBuffer);
+		VkPipeline getVkPipeline(); // waits for the compile, rethrows its error
+		bool isReady() const;
 		static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
 
 	private:
 		void createPipeline(const std::string& vertPath, const std::string& fragPath, const PipelineConfigInfo& configInfo);
+		void compile(std::shared_ptr<GraphicsPipelineDescription> description);
 		VkShaderModule createShaderModule(const std::vector<char>& code);
 
 		GraphicsDevice_Vulkan& m_Device;
-		VkPipeline m_GraphicsPipeline = VK_NULL_HANDLE;
+		std::shared_ptr<PipelineCompiler::Job> m_Job;
 	};
 }
 
@@ -47,18 +47,17 @@ namespace pw {
 		VkMemoryRequirements memRequirements;
 		vkGetImageMemoryRequirements(device->getDevice(), m_Image, &memRequirements);
 
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = device->findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		// Transient attachments may never be backed by physical memory on tile-based GPUs
+		VkMemoryPropertyFlags memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
-		if (vkAllocateMemory(device->getDevice(), &allocInfo, nullptr, &m_ImageMemory) != VK_SUCCESS) {
-			throw std::runtime_error("VULKAN ERROR: Failed to allocate image memory!");
+		if (createInfo.usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT &&
+			device->hasMemoryType(memRequirements.memoryTypeBits, memoryProperties | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)) {
+			memoryProperties |= VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
 		}
 
-		if (vkBindImageMemory(device->getDevice(), m_Image, m_ImageMemory, 0) != VK_SUCCESS) {
-			throw std::runtime_error("VULKAN ERROR: Failed to bind image memory!");
-		}
+		bool renderTarget = (createInfo.usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)) != 0;
+		m_ImageMemory = device->getMemoryAllocator().allocateImageMemory(m_Image, memoryProperties,
+			createInfo.tiling == VK_IMAGE_TILING_LINEAR, renderTarget);
 
 		createImageView();
 	}
@@ -90,11 +89,15 @@ namespace pw {
 	void Image::destroy() {
 		GraphicsDevice_Vulkan* device = (GraphicsDevice_Vulkan*&)pw::GetDevice();
 
+		device->releaseBindlessImage(m_BindlessIndex);
+		m_BindlessIndex = GraphicsDevice_Vulkan::INVALID_BINDLESS_INDEX;
+
+		device->getDescriptorBatcher().forgetImageView(m_ImageView);
 		vkDestroyImageView(device->getDevice(), m_ImageView, nullptr);
 
 		if (!m_SwapchainImage) {
 			vkDestroyImage(device->getDevice(), m_Image, nullptr);
-			vkFreeMemory(device->getDevice(), m_ImageMemory, nullptr);
+			device->getMemoryAllocator().free(m_ImageMemory);
 		}
 	}
 
@@ -186,6 +189,14 @@ namespace pw {
 		if (vkCreateImageView(device->getDevice(), &viewInfo, nullptr, &m_ImageView) != VK_SUCCESS) {
 			throw std::runtime_error("VULKAN ERROR: Failed to create image view!");
 		}
+
+		// Draws refer to the image by its index, so it stays the same for the lifetime of the image
+		bool sampled2D = !m_SwapchainImage && (m_Usage & VK_IMAGE_USAGE_SAMPLED_BIT) &&
+			m_Type == VK_IMAGE_TYPE_2D && m_LayerCount == 1 && m_Sampling == VK_SAMPLE_COUNT_1_BIT;
+
+		if (sampled2D) {
+			m_BindlessIndex = device->registerBindlessImage(m_ImageView);
+		}
 	}
 
 }
\ No newline at end of file
@@ -2,8 +2,10 @@
 
 // primwalk
 #include "../../core.hpp"
+#include "memoryAllocator.hpp"
 
 // std
+#include <cstdint>
 #include <memory>
 
 // vendor
@@ -51,15 +53,18 @@ namespace pw {
 		[[nodiscard]] inline uint32_t getHeight() const { return m_Height; }
 		[[nodiscard]] inline uint32_t getDepth() const { return m_Depth; }
 		[[nodiscard]] inline uint32_t getLayerCount() const { return m_LayerCount; }
+		[[nodiscard]] inline uint32_t getMipLevels() const { return m_MipLevels; }
 		[[nodiscard]] inline VkFormat getFormat() const { return m_Format; }
 		[[nodiscard]] inline VkSampleCountFlagBits getSampling() const { return m_Sampling; }
 		[[nodiscard]] inline VkImageUsageFlags getUsage() const { return m_Usage; }
 		[[nodiscard]] inline VkImageCreateFlags getCreateFlags() const { return m_Flags; }
 		[[nodiscard]] inline VkImage getVulkanImage() const { return m_Image; }
 		[[nodiscard]] inline VkImageView getVulkanImageView() const { return m_ImageView; }
+		[[nodiscard]] inline uint32_t getBindlessIndex() const { return m_BindlessIndex; } // into the device's bindless texture set
 
 		/* Setters */
 		void transitionLayout(VkCommandBuffer commandBuffer, VkImageLayout newLayout);
+		inline void setLayout(VkImageLayout layout) { m_Layout = layout; } // after a transition recorded elsewhere, e.g. in a queue family ownership transfer
 
 	private:
 		void createImageView();
@@ -79,7 +84,8 @@ namespace pw {
 		VkImageLayout m_Layout = VK_IMAGE_LAYOUT_UNDEFINED;
 		VkImage m_Image = VK_NULL_HANDLE;
 		VkImageView m_ImageView = VK_NULL_HANDLE;
-		VkDeviceMemory m_ImageMemory = VK_NULL_HANDLE;
+		MemoryAllocation m_ImageMemory{}; // empty for swapchain images
+		uint32_t m_BindlessIndex = UINT32_MAX; // only sampled 2D images are registered
 	};
 }
 
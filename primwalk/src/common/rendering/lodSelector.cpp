@@ -0,0 +1,59 @@
+#include "lodSelector.hpp"
+
+// primwalk
+#include "../components/camera.hpp"
+#include "../components/transform.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+
+namespace pw {
+
+	void LODSelector::setView(const Camera& camera, float viewportHeight) {
+		m_ViewPosition = camera.position;
+		m_PixelsPerUnit = viewportHeight / (2.0f * std::tan(glm::radians(camera.fov) * 0.5f));
+		m_NearClip = camera.nearClip;
+	}
+
+	uint32_t LODSelector::select(entity_id entity, uint32_t meshIndex, const Mesh& mesh, const Transform& transform) {
+		if (mesh.lodCount <= 1) {
+			return 0;
+		}
+
+		float scale = std::max({ std::abs(transform.scale.x), std::abs(transform.scale.y), std::abs(transform.scale.z) });
+		glm::vec3 center = transform.position + mesh.center * transform.scale;
+		float distance = std::max(glm::length(center - m_ViewPosition) - mesh.radius * scale, m_NearClip);
+
+		// Coarsest level that is still below the threshold
+		uint32_t target = 0;
+
+		for (uint32_t level = mesh.lodCount - 1; level > 0; level--) {
+			if (getProjectedError(mesh.lods[level], scale, distance) <= m_ErrorThreshold) {
+				target = level;
+				break;
+			}
+		}
+
+		uint64_t key = (static_cast<uint64_t>(entity) << 32) | meshIndex;
+		auto search = m_Levels.find(key);
+		uint32_t level = target;
+
+		if (search != m_Levels.end() && target > search->second) {
+			// Step coarser only as far as the error stays clear of the threshold
+			level = search->second;
+
+			while (level < target && getProjectedError(mesh.lods[level + 1], scale, distance) <= m_ErrorThreshold * (1.0f - HYSTERESIS)) {
+				level++;
+			}
+		}
+
+		m_Levels[key] = level;
+		return std::min(level + m_Bias, mesh.lodCount - 1);
+	}
+
+	float LODSelector::getProjectedError(const MeshLOD& lod, float scale, float distance) const {
+		return lod.error * scale * m_PixelsPerUnit / distance;
+	}
+
+}
\ No newline at end of file
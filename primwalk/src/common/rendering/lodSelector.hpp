@@ -0,0 +1,46 @@
+#pragma once
+
+// primwalk
+#include "../../core.hpp"
+#include "../components/component.hpp"
+#include "../data/mesh.hpp"
+
+// std
+#include <cstdint>
+#include <unordered_map>
+
+// vendor
+#include <glm/glm.hpp>
+
+namespace pw {
+	// Forward declarations
+	class Camera;
+	struct Transform;
+
+	/*
+	* Picks a detail level per mesh instance from the projected size of each level's geometric error, so triangle
+	* counts follow screen coverage. A coarser level is only taken once its error is well below the threshold and a
+	* finer one as soon as the current one exceeds it, so instances near a transition do not flicker between levels.
+	*/
+	class PW_API LODSelector {
+	public:
+		LODSelector(uint32_t bias = 0) : m_Bias(bias) {} // levels added to every choice, e.g. for shadows
+
+		void setView(const Camera& camera, float viewportHeight); // once per frame, before select()
+		uint32_t select(entity_id entity, uint32_t meshIndex, const Mesh& mesh, const Transform& transform);
+
+		inline void setErrorThreshold(float pixels) { m_ErrorThreshold = pixels; }
+
+	private:
+		float getProjectedError(const MeshLOD& lod, float scale, float distance) const; // in pixels
+
+		std::unordered_map<uint64_t, uint32_t> m_Levels; // of the last frame, by entity and mesh
+		glm::vec3 m_ViewPosition{ 0.0f };
+		float m_PixelsPerUnit = 1.0f; // at a distance of one
+		float m_NearClip = 0.1f;
+		float m_ErrorThreshold = 1.0f;
+		uint32_t m_Bias = 0;
+
+		static constexpr float HYSTERESIS = 0.25f; // of the threshold
+	};
+}
\ No newline at end of file
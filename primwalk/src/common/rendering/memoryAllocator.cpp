@@ -0,0 +1,363 @@
+#include "memoryAllocator.hpp"
+#include "graphicsDevice_Vulkan.hpp"
+
+// std
+#include <algorithm>
+#include <stdexcept>
+
+namespace pw {
+
+	MemoryAllocator::MemoryAllocator(GraphicsDevice_Vulkan& device) : m_Device(device) {
+		vkGetPhysicalDeviceMemoryProperties(m_Device.getPhysicalDevice(), &m_MemoryProperties);
+		m_DedicatedStats.resize(m_MemoryProperties.memoryTypeCount);
+	}
+
+	MemoryAllocator::~MemoryAllocator() {
+		for (auto& block : m_Blocks) {
+			destroyBlock(*block);
+		}
+	}
+
+	MemoryAllocation MemoryAllocator::allocateBufferMemory(VkBuffer buffer, VkMemoryPropertyFlags properties) {
+		VkBufferMemoryRequirementsInfo2 requirementsInfo{};
+		requirementsInfo.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+		requirementsInfo.buffer = buffer;
+
+		VkMemoryDedicatedRequirements dedicatedRequirements{};
+		dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+		VkMemoryRequirements2 requirements{};
+		requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+		requirements.pNext = &dedicatedRequirements;
+
+		vkGetBufferMemoryRequirements2(m_Device.getDevice(), &requirementsInfo, &requirements);
+
+		bool dedicated = dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation;
+		MemoryAllocation allocation = allocateMemory(requirements.memoryRequirements, properties, true, dedicated, buffer, VK_NULL_HANDLE);
+
+		if (vkBindBufferMemory(m_Device.getDevice(), buffer, allocation.memory, allocation.offset) != VK_SUCCESS) {
+			free(allocation);
+			throw std::runtime_error("VULKAN ERROR: Failed to bind buffer memory!");
+		}
+
+		return allocation;
+	}
+
+	MemoryAllocation MemoryAllocator::allocateImageMemory(VkImage image, VkMemoryPropertyFlags properties, bool linear, bool renderTarget) {
+		VkImageMemoryRequirementsInfo2 requirementsInfo{};
+		requirementsInfo.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+		requirementsInfo.image = image;
+
+		VkMemoryDedicatedRequirements dedicatedRequirements{};
+		dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+		VkMemoryRequirements2 requirements{};
+		requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+		requirements.pNext = &dedicatedRequirements;
+
+		vkGetImageMemoryRequirements2(m_Device.getDevice(), &requirementsInfo, &requirements);
+
+		// Large render targets live as long as the swapchain and gain nothing from sharing a block
+		bool dedicated = dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation ||
+			(renderTarget && requirements.memoryRequirements.size >= DEDICATED_RENDER_TARGET_SIZE);
+
+		MemoryAllocation allocation = allocateMemory(requirements.memoryRequirements, properties, linear, dedicated, VK_NULL_HANDLE, image);
+
+		if (vkBindImageMemory(m_Device.getDevice(), image, allocation.memory, allocation.offset) != VK_SUCCESS) {
+			free(allocation);
+			throw std::runtime_error("VULKAN ERROR: Failed to bind image memory!");
+		}
+
+		return allocation;
+	}
+
+	void MemoryAllocator::free(MemoryAllocation& allocation) {
+		if (allocation.memory == VK_NULL_HANDLE) {
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (allocation.block == nullptr) {
+			if (allocation.mapped) {
+				vkUnmapMemory(m_Device.getDevice(), allocation.memory);
+			}
+
+			vkFreeMemory(m_Device.getDevice(), allocation.memory, nullptr);
+
+			DedicatedStats& stats = m_DedicatedStats[allocation.memoryType];
+			stats.bytes -= allocation.size;
+			stats.count--;
+
+			allocation = {};
+			return;
+		}
+
+		Block& block = *static_cast<Block*>(allocation.block);
+		block.usedBytes -= block.size >> allocation.level;
+		block.requestedBytes -= allocation.size;
+		block.allocationCount--;
+
+		// Merge with the buddy as long as it is free
+		VkDeviceSize offset = allocation.offset;
+		uint32_t level = allocation.level;
+
+		while (level > 0) {
+			VkDeviceSize buddy = offset ^ (block.size >> level);
+			auto it = block.freeRanges[level].find(buddy);
+
+			if (it == block.freeRanges[level].end()) {
+				break;
+			}
+
+			block.freeRanges[level].erase(it);
+			offset = std::min(offset, buddy);
+			level--;
+		}
+
+		block.freeRanges[level].insert(offset);
+		allocation = {};
+
+		// One empty block per memory type and kind is kept around, so that a resource being recreated does not
+		// allocate and free a whole block every time
+		if (block.allocationCount == 0) {
+			auto other = std::find_if(m_Blocks.begin(), m_Blocks.end(), [&](const std::unique_ptr<Block>& candidate) {
+				return candidate.get() != &block && candidate->allocationCount == 0 &&
+					candidate->memoryType == block.memoryType && candidate->linear == block.linear;
+			});
+
+			if (other != m_Blocks.end()) {
+				destroyBlock(block);
+				m_Blocks.erase(std::find_if(m_Blocks.begin(), m_Blocks.end(), [&](const std::unique_ptr<Block>& candidate) {
+					return candidate.get() == &block;
+				}));
+			}
+		}
+	}
+
+	std::vector<MemoryHeapStats> MemoryAllocator::getHeapStats() const {
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		std::vector<MemoryHeapStats> heapStats(m_MemoryProperties.memoryHeapCount);
+		std::vector<VkDeviceSize> freeBytes(m_MemoryProperties.memoryHeapCount, 0);
+
+		for (uint32_t i = 0; i < m_MemoryProperties.memoryHeapCount; i++) {
+			heapStats[i].heapSize = m_MemoryProperties.memoryHeaps[i].size;
+		}
+
+		for (const auto& block : m_Blocks) {
+			MemoryHeapStats& stats = heapStats[m_MemoryProperties.memoryTypes[block->memoryType].heapIndex];
+			stats.blockBytes += block->size;
+			stats.usedBytes += block->usedBytes;
+			stats.requestedBytes += block->requestedBytes;
+			stats.blockCount++;
+			stats.allocationCount += block->allocationCount;
+
+			freeBytes[m_MemoryProperties.memoryTypes[block->memoryType].heapIndex] += block->size - block->usedBytes;
+
+			// The lowest level with a free range holds the largest one
+			for (size_t level = 0; level < block->freeRanges.size(); level++) {
+				if (!block->freeRanges[level].empty()) {
+					stats.largestFreeRange = std::max(stats.largestFreeRange, block->size >> level);
+					break;
+				}
+			}
+		}
+
+		for (uint32_t i = 0; i < m_MemoryProperties.memoryTypeCount; i++) {
+			MemoryHeapStats& stats = heapStats[m_MemoryProperties.memoryTypes[i].heapIndex];
+			stats.dedicatedBytes += m_DedicatedStats[i].bytes;
+			stats.dedicatedCount += m_DedicatedStats[i].count;
+		}
+
+		for (uint32_t i = 0; i < m_MemoryProperties.memoryHeapCount; i++) {
+			if (freeBytes[i] > 0) {
+				heapStats[i].fragmentation = 1.0f - static_cast<float>(heapStats[i].largestFreeRange) / static_cast<float>(freeBytes[i]);
+			}
+		}
+
+		return heapStats;
+	}
+
+	MemoryAllocation MemoryAllocator::allocateMemory(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear, bool dedicated,
+		VkBuffer dedicatedBuffer, VkImage dedicatedImage) {
+		uint32_t memoryType = m_Device.findMemoryType(requirements.memoryTypeBits, properties);
+		VkDeviceSize rangeSize = getRangeSize(requirements.size, requirements.alignment);
+
+		// Lazily allocated memory is only backed when the GPU needs it, sharing a block would defeat that
+		bool lazy = (m_MemoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0;
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (dedicated || lazy || rangeSize > getBlockSize(memoryType) / 2) {
+			return allocateDedicated(requirements.size, memoryType, dedicatedBuffer, dedicatedImage);
+		}
+
+		MemoryAllocation allocation{};
+
+		for (auto& block : m_Blocks) {
+			if (block->memoryType == memoryType && block->linear == linear &&
+				allocateFromBlock(*block, rangeSize, requirements.size, allocation)) {
+				return allocation;
+			}
+		}
+
+		if (!allocateFromBlock(createBlock(memoryType, linear), rangeSize, requirements.size, allocation)) {
+			throw std::runtime_error("VULKAN ERROR: Failed to sub-allocate device memory!");
+		}
+
+		return allocation;
+	}
+
+	MemoryAllocation MemoryAllocator::allocateDedicated(VkDeviceSize size, uint32_t memoryType, VkBuffer buffer, VkImage image) {
+		VkMemoryDedicatedAllocateInfo dedicatedInfo{};
+		dedicatedInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+		dedicatedInfo.buffer = buffer;
+		dedicatedInfo.image = image;
+
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryType;
+
+		// Only a single resource can be named
+		if (buffer != VK_NULL_HANDLE || image != VK_NULL_HANDLE) {
+			allocInfo.pNext = &dedicatedInfo;
+		}
+
+		MemoryAllocation allocation{};
+		allocation.size = size;
+		allocation.memoryType = memoryType;
+
+		if (vkAllocateMemory(m_Device.getDevice(), &allocInfo, nullptr, &allocation.memory) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to allocate dedicated device memory!");
+		}
+
+		if (m_MemoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+			if (vkMapMemory(m_Device.getDevice(), allocation.memory, 0, VK_WHOLE_SIZE, 0, &allocation.mapped) != VK_SUCCESS) {
+				vkFreeMemory(m_Device.getDevice(), allocation.memory, nullptr);
+				throw std::runtime_error("VULKAN ERROR: Failed to map dedicated device memory!");
+			}
+		}
+
+		DedicatedStats& stats = m_DedicatedStats[memoryType];
+		stats.bytes += size;
+		stats.count++;
+
+		return allocation;
+	}
+
+	bool MemoryAllocator::allocateFromBlock(Block& block, VkDeviceSize rangeSize, VkDeviceSize requestedSize, MemoryAllocation& allocation) {
+		uint32_t level = 0;
+
+		while ((block.size >> level) > rangeSize) {
+			level++;
+		}
+
+		// Find the smallest free range that fits, then split it down to the requested level
+		uint32_t source = level + 1;
+
+		while (source > 0 && block.freeRanges[source - 1].empty()) {
+			source--;
+		}
+
+		if (source == 0) {
+			return false;
+		}
+
+		source--;
+
+		VkDeviceSize offset = *block.freeRanges[source].begin();
+		block.freeRanges[source].erase(block.freeRanges[source].begin());
+
+		// Every split keeps the lower half and frees the upper one
+		for (uint32_t split = source + 1; split <= level; split++) {
+			block.freeRanges[split].insert(offset + (block.size >> split));
+		}
+
+		block.usedBytes += block.size >> level;
+		block.requestedBytes += requestedSize;
+		block.allocationCount++;
+
+		allocation.memory = block.memory;
+		allocation.offset = offset;
+		allocation.size = requestedSize;
+		allocation.mapped = block.mapped ? static_cast<char*>(block.mapped) + offset : nullptr;
+		allocation.block = &block;
+		allocation.memoryType = block.memoryType;
+		allocation.level = level;
+
+		return true;
+	}
+
+	MemoryAllocator::Block& MemoryAllocator::createBlock(uint32_t memoryType, bool linear) {
+		auto block = std::make_unique<Block>();
+		block->size = getBlockSize(memoryType);
+		block->memoryType = memoryType;
+		block->linear = linear;
+
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = block->size;
+		allocInfo.memoryTypeIndex = memoryType;
+
+		if (vkAllocateMemory(m_Device.getDevice(), &allocInfo, nullptr, &block->memory) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to allocate device memory block!");
+		}
+
+		// Mapped once for the lifetime of the block, a VkDeviceMemory can only be mapped once at a time
+		if (m_MemoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+			if (vkMapMemory(m_Device.getDevice(), block->memory, 0, VK_WHOLE_SIZE, 0, &block->mapped) != VK_SUCCESS) {
+				vkFreeMemory(m_Device.getDevice(), block->memory, nullptr);
+				throw std::runtime_error("VULKAN ERROR: Failed to map device memory block!");
+			}
+		}
+
+		uint32_t levelCount = 1;
+
+		while ((block->size >> (levelCount - 1)) > MIN_ALLOCATION_SIZE) {
+			levelCount++;
+		}
+
+		block->freeRanges.resize(levelCount);
+		block->freeRanges[0].insert(0);
+
+		m_Blocks.push_back(std::move(block));
+		return *m_Blocks.back();
+	}
+
+	void MemoryAllocator::destroyBlock(Block& block) {
+		if (block.mapped) {
+			vkUnmapMemory(m_Device.getDevice(), block.memory);
+		}
+
+		vkFreeMemory(m_Device.getDevice(), block.memory, nullptr);
+		block.memory = VK_NULL_HANDLE;
+		block.mapped = nullptr;
+	}
+
+	VkDeviceSize MemoryAllocator::getBlockSize(uint32_t memoryType) const {
+		VkDeviceSize heapSize = m_MemoryProperties.memoryHeaps[m_MemoryProperties.memoryTypes[memoryType].heapIndex].size;
+
+		// Small heaps (e.g. the 256 MiB of host visible device memory without resizable BAR) get smaller blocks
+		VkDeviceSize blockSize = MAX_BLOCK_SIZE;
+
+		while (blockSize > heapSize / 8 && blockSize > MIN_ALLOCATION_SIZE * 1024) {
+			blockSize >>= 1;
+		}
+
+		return blockSize;
+	}
+
+	VkDeviceSize MemoryAllocator::getRangeSize(VkDeviceSize size, VkDeviceSize alignment) {
+		VkDeviceSize minSize = std::max({ size, alignment, MIN_ALLOCATION_SIZE });
+		VkDeviceSize rangeSize = MIN_ALLOCATION_SIZE;
+
+		while (rangeSize < minSize) {
+			rangeSize <<= 1;
+		}
+
+		return rangeSize;
+	}
+
+}
\ No newline at end of file
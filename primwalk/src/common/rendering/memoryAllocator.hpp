@@ -0,0 +1,110 @@
+#pragma once
+
+// primwalk
+#include "../../core.hpp"
+
+// std
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+// vendor
+#include <vulkan/vulkan.h>
+
+namespace pw {
+	// Forward declarations
+	class GraphicsDevice_Vulkan;
+
+	// A range of device memory, either part of a block shared with other resources or a dedicated VkDeviceMemory
+	struct PW_API MemoryAllocation {
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0; // as requested, the range reserved in the block can be larger
+		void* mapped = nullptr; // host visible memory stays mapped, already offset to the start of the range
+
+		// Owned by the allocator
+		void* block = nullptr; // nullptr for dedicated allocations
+		uint32_t memoryType = UINT32_MAX;
+		uint32_t level = 0;
+	};
+
+	struct PW_API MemoryHeapStats {
+		VkDeviceSize heapSize = 0;
+		VkDeviceSize blockBytes = 0; // allocated as blocks
+		VkDeviceSize usedBytes = 0; // handed out from the blocks, including the rounding to a power of two
+		VkDeviceSize requestedBytes = 0; // what the resources in the blocks asked for
+		VkDeviceSize dedicatedBytes = 0;
+		VkDeviceSize largestFreeRange = 0;
+		uint32_t blockCount = 0;
+		uint32_t allocationCount = 0; // in blocks
+		uint32_t dedicatedCount = 0;
+		float fragmentation = 0.0f; // 0 if the free memory of the blocks is a single range, towards 1 the more it is split up
+	};
+
+	/*
+	* Sub-allocates buffers and images from large VkDeviceMemory blocks, so that creating a resource does not cost a
+	* vkAllocateMemory call and the driver's allocation count limit is never in reach. Every block is managed as a
+	* buddy system: ranges are powers of two and aligned to their own size, which covers the alignment requirement
+	* of any resource. Linear resources (buffers, linearly tiled images) and optimally tiled images never share a
+	* block, so neighbouring ranges never have to be padded to bufferImageGranularity. Resources the driver wants
+	* dedicated memory for, large render targets and everything over half a block get their own VkDeviceMemory.
+	*/
+	class PW_API MemoryAllocator {
+	public:
+		MemoryAllocator(GraphicsDevice_Vulkan& device);
+		~MemoryAllocator();
+
+		// Forbid copy and move semantics
+		MemoryAllocator(const MemoryAllocator&) = delete;
+		MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+
+		// Allocates and binds memory for the resource
+		MemoryAllocation allocateBufferMemory(VkBuffer buffer, VkMemoryPropertyFlags properties);
+		MemoryAllocation allocateImageMemory(VkImage image, VkMemoryPropertyFlags properties, bool linear, bool renderTarget);
+
+		void free(MemoryAllocation& allocation); // the resource must be destroyed, or at least not in use anymore
+
+		std::vector<MemoryHeapStats> getHeapStats() const; // indexed by memory heap
+
+		static constexpr VkDeviceSize MAX_BLOCK_SIZE = 64ull * 1024 * 1024;
+		static constexpr VkDeviceSize MIN_ALLOCATION_SIZE = 256;
+		static constexpr VkDeviceSize DEDICATED_RENDER_TARGET_SIZE = 4ull * 1024 * 1024;
+
+	private:
+		struct Block {
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			void* mapped = nullptr;
+			VkDeviceSize size = 0;
+			uint32_t memoryType = 0;
+			bool linear = true;
+
+			std::vector<std::unordered_set<VkDeviceSize>> freeRanges; // offsets per level, level 0 is the whole block
+			VkDeviceSize usedBytes = 0;
+			VkDeviceSize requestedBytes = 0;
+			uint32_t allocationCount = 0;
+		};
+
+		struct DedicatedStats {
+			VkDeviceSize bytes = 0;
+			uint32_t count = 0;
+		};
+
+		MemoryAllocation allocateMemory(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear, bool dedicated,
+			VkBuffer dedicatedBuffer, VkImage dedicatedImage);
+		MemoryAllocation allocateDedicated(VkDeviceSize size, uint32_t memoryType, VkBuffer buffer, VkImage image);
+		bool allocateFromBlock(Block& block, VkDeviceSize rangeSize, VkDeviceSize requestedSize, MemoryAllocation& allocation);
+		Block& createBlock(uint32_t memoryType, bool linear);
+		void destroyBlock(Block& block);
+		VkDeviceSize getBlockSize(uint32_t memoryType) const;
+		static VkDeviceSize getRangeSize(VkDeviceSize size, VkDeviceSize alignment);
+
+		GraphicsDevice_Vulkan& m_Device;
+		VkPhysicalDeviceMemoryProperties m_MemoryProperties{};
+
+		mutable std::mutex m_Mutex;
+		std::vector<std::unique_ptr<Block>> m_Blocks;
+		std::vector<DedicatedStats> m_DedicatedStats; // per memory type
+	};
+}
@@ -0,0 +1,155 @@
+#include "pipelineCache.hpp"
+#include "graphicsDevice_Vulkan.hpp"
+
+// std
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+namespace pw {
+
+	PipelineCache::PipelineCache(GraphicsDevice_Vulkan& device, const std::string& path) : m_Device(device), m_Path(path) {
+		std::vector<uint8_t> data;
+		FileHeader expected = getDeviceHeader();
+		std::ifstream file(m_Path, std::ios::ate | std::ios::binary);
+
+		// A missing or stale file only means a cold start
+		if (file.is_open()) {
+			uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+			file.seekg(0);
+
+			FileHeader header{};
+			file.read(reinterpret_cast<char*>(&header), sizeof(FileHeader));
+
+			if (file && validateHeader(header, expected) && header.dataSize == fileSize - sizeof(FileHeader)) {
+				data.resize(static_cast<size_t>(header.dataSize));
+				file.read(reinterpret_cast<char*>(data.data()), data.size());
+
+				if (!file || hash(data.data(), data.size()) != header.dataHash) {
+					data.clear();
+				}
+			}
+
+			file.close();
+		}
+
+		// The driver validates its own header as well, but not every driver rejects foreign data gracefully
+		if (data.size() >= sizeof(VkPipelineCacheHeaderVersionOne)) {
+			VkPipelineCacheHeaderVersionOne driverHeader{};
+			std::memcpy(&driverHeader, data.data(), sizeof(VkPipelineCacheHeaderVersionOne));
+
+			if (driverHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+				driverHeader.vendorID != expected.vendorID || driverHeader.deviceID != expected.deviceID ||
+				std::memcmp(driverHeader.pipelineCacheUUID, expected.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+				data.clear();
+			}
+		}
+		else {
+			data.clear();
+		}
+
+		VkPipelineCacheCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		createInfo.initialDataSize = data.size();
+		createInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+		if (vkCreatePipelineCache(m_Device.getDevice(), &createInfo, nullptr, &m_PipelineCache) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to create pipeline cache!");
+		}
+
+		m_LoadedSize = data.size();
+	}
+
+	PipelineCache::~PipelineCache() {
+		save();
+		vkDestroyPipelineCache(m_Device.getDevice(), m_PipelineCache, nullptr);
+	}
+
+	void PipelineCache::save() {
+		size_t dataSize = 0;
+		if (vkGetPipelineCacheData(m_Device.getDevice(), m_PipelineCache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0) {
+			return;
+		}
+
+		std::vector<uint8_t> data(dataSize);
+		if (vkGetPipelineCacheData(m_Device.getDevice(), m_PipelineCache, &dataSize, data.data()) != VK_SUCCESS) {
+			return;
+		}
+
+		FileHeader header = getDeviceHeader();
+		header.dataSize = dataSize;
+		header.dataHash = hash(data.data(), dataSize);
+
+		// Failing to save is not fatal, the next start is merely a cold one
+		std::string tempPath = m_Path + ".tmp";
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+
+		if (!file.is_open()) {
+			std::cerr << "Failed to write pipeline cache to " << tempPath << '\n';
+			return;
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+		file.write(reinterpret_cast<const char*>(data.data()), dataSize);
+		file.close();
+
+		std::error_code error;
+
+		if (!file) {
+			std::cerr << "Failed to write pipeline cache to " << tempPath << '\n';
+			std::filesystem::remove(tempPath, error);
+			return;
+		}
+
+		std::filesystem::rename(tempPath, m_Path, error);
+
+		if (error) {
+			std::cerr << "Failed to replace pipeline cache " << m_Path << ": " << error.message() << '\n';
+			std::filesystem::remove(tempPath, error);
+		}
+	}
+
+	PipelineCache::FileHeader PipelineCache::getDeviceHeader() const {
+		VkPhysicalDeviceIDProperties idProperties{};
+		idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+
+		VkPhysicalDeviceProperties2 properties{};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties.pNext = &idProperties;
+		vkGetPhysicalDeviceProperties2(m_Device.getPhysicalDevice(), &properties);
+
+		FileHeader header{};
+		header.vendorID = properties.properties.vendorID;
+		header.deviceID = properties.properties.deviceID;
+		header.driverVersion = properties.properties.driverVersion;
+		std::memcpy(header.driverUUID, idProperties.driverUUID, VK_UUID_SIZE);
+		std::memcpy(header.pipelineCacheUUID, properties.properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+		return header;
+	}
+
+	bool PipelineCache::validateHeader(const FileHeader& header, const FileHeader& expected) const {
+		return header.magic == expected.magic && header.version == expected.version &&
+			header.vendorID == expected.vendorID && header.deviceID == expected.deviceID &&
+			header.driverVersion == expected.driverVersion &&
+			std::memcmp(header.driverUUID, expected.driverUUID, VK_UUID_SIZE) == 0 &&
+			std::memcmp(header.pipelineCacheUUID, expected.pipelineCacheUUID, VK_UUID_SIZE) == 0 &&
+			header.dataSize > 0;
+	}
+
+	uint64_t PipelineCache::hash(const uint8_t* data, size_t size) {
+		uint64_t hash = 14695981039346656037ull;
+
+		for (size_t i = 0; i < size; i++) {
+			hash ^= data[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+// primwalk
+#include "../../core.hpp"
+
+// std
+#include <cstdint>
+#include <string>
+
+// vendor
+#include <vulkan/vulkan.h>
+
+namespace pw {
+	// Forward declarations
+	class GraphicsDevice_Vulkan;
+
+	/*
+	* Device-wide VkPipelineCache that outlives the process. The data is loaded at startup if the file was written
+	* for the same GPU and driver (vendor, device and driver UUID, checked before the driver ever sees the data) and
+	* written back when the device is destroyed. Every pipeline is created through it, so warm starts skip most of
+	* the shader compilation.
+	*/
+	class PW_API PipelineCache {
+	public:
+		PipelineCache(GraphicsDevice_Vulkan& device, const std::string& path);
+		~PipelineCache(); // saves the cache
+
+		// Forbid copy and move semantics
+		PipelineCache(const PipelineCache&) = delete;
+		PipelineCache& operator=(const PipelineCache&) = delete;
+
+		void save(); // writes a temporary file and renames it over the old one, so a crash never leaves a torn cache
+
+		inline VkPipelineCache getVkPipelineCache() const { return m_PipelineCache; }
+		inline bool isWarm() const { return m_LoadedSize > 0; } // loaded from disk
+		inline size_t getLoadedSize() const { return m_LoadedSize; }
+
+	private:
+		// Precedes the driver's data in the file
+		struct FileHeader {
+			uint32_t magic = MAGIC;
+			uint32_t version = VERSION;
+			uint32_t vendorID = 0;
+			uint32_t deviceID = 0;
+			uint32_t driverVersion = 0;
+			uint8_t driverUUID[VK_UUID_SIZE]{};
+			uint8_t pipelineCacheUUID[VK_UUID_SIZE]{};
+			uint64_t dataSize = 0;
+			uint64_t dataHash = 0; // FNV-1a, catches truncated or corrupted files
+		};
+
+		FileHeader getDeviceHeader() const;
+		bool validateHeader(const FileHeader& header, const FileHeader& expected) const;
+		static uint64_t hash(const uint8_t* data, size_t size);
+
+		GraphicsDevice_Vulkan& m_Device;
+		VkPipelineCache m_PipelineCache = VK_NULL_HANDLE;
+		std::string m_Path;
+		size_t m_LoadedSize = 0;
+
+		static constexpr uint32_t MAGIC = 0x43505750; // "PWPC"
+		static constexpr uint32_t VERSION = 1;
+	};
+}
@@ -0,0 +1,114 @@
+#include "pipelineCompiler.hpp"
+
+// std
+#include <algorithm>
+
+namespace pw {
+
+	PipelineCompiler::PipelineCompiler(uint32_t workerCount) {
+		for (uint32_t i = 0; i < workerCount; i++) {
+			m_Workers.emplace_back(&PipelineCompiler::workerLoop, this);
+		}
+	}
+
+	PipelineCompiler::~PipelineCompiler() {
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stop = true;
+		}
+
+		m_JobAvailable.notify_all();
+
+		for (auto& worker : m_Workers) {
+			worker.join();
+		}
+
+		// Without workers nothing picked the remaining jobs up
+		while (!m_Queue.empty()) {
+			std::shared_ptr<Job> job = m_Queue.front();
+			m_Queue.pop_front();
+			job->started = true;
+			run(*job);
+		}
+	}
+
+	std::shared_ptr<PipelineCompiler::Job> PipelineCompiler::submit(std::function<VkPipeline()> compile) {
+		auto job = std::make_shared<Job>();
+		job->compile = std::move(compile);
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Queue.push_back(job);
+		}
+
+		m_JobAvailable.notify_one();
+		return job;
+	}
+
+	void PipelineCompiler::wait(Job& job) {
+		if (job.done.load(std::memory_order_acquire)) {
+			return;
+		}
+
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		if (!job.started) {
+			// Compiling it here is faster than waiting for a worker to get to it
+			auto it = std::find_if(m_Queue.begin(), m_Queue.end(), [&](const std::shared_ptr<Job>& queued) {
+				return queued.get() == &job;
+			});
+
+			if (it != m_Queue.end()) {
+				m_Queue.erase(it);
+			}
+
+			job.started = true;
+			lock.unlock();
+
+			run(job);
+			return;
+		}
+
+		m_JobDone.wait(lock, [&]() { return job.done.load(std::memory_order_acquire); });
+	}
+
+	void PipelineCompiler::workerLoop() {
+		while (true) {
+			std::shared_ptr<Job> job;
+
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_JobAvailable.wait(lock, [this]() { return m_Stop || !m_Queue.empty(); });
+
+				if (m_Queue.empty()) {
+					return;
+				}
+
+				job = m_Queue.front();
+				m_Queue.pop_front();
+				job->started = true;
+			}
+
+			run(*job);
+		}
+	}
+
+	void PipelineCompiler::run(Job& job) {
+		try {
+			job.pipeline = job.compile();
+		}
+		catch (...) {
+			job.error = std::current_exception();
+		}
+
+		job.compile = nullptr;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			job.done.store(true, std::memory_order_release);
+		}
+
+		m_JobDone.notify_all();
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+// primwalk
+#include "../../core.hpp"
+
+// std
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// vendor
+#include <vulkan/vulkan.h>
+
+namespace pw {
+	/*
+	* Compiles pipelines on worker threads, so that the passes can hand all of their pipelines over at startup and
+	* the driver compiles them in parallel. A pipeline is only waited for when it is bound for the first time, a
+	* pipeline nobody picked up yet is then compiled on the waiting thread instead. The pipeline cache is internally
+	* synchronized, every worker creates its pipelines through it.
+	*/
+	class PW_API PipelineCompiler {
+	public:
+		struct Job {
+			std::function<VkPipeline()> compile; // released once done
+			VkPipeline pipeline = VK_NULL_HANDLE;
+			std::exception_ptr error; // rethrown by whoever needs the pipeline
+			bool started = false; // guarded by the compiler
+			std::atomic<bool> done{ false };
+		};
+
+		PipelineCompiler(uint32_t workerCount);
+		~PipelineCompiler(); // compiles the jobs still queued
+
+		// Forbid copy and move semantics
+		PipelineCompiler(const PipelineCompiler&) = delete;
+		PipelineCompiler& operator=(const PipelineCompiler&) = delete;
+
+		std::shared_ptr<Job> submit(std::function<VkPipeline()> compile);
+		void wait(Job& job); // does not rethrow the job's error, thread safe
+
+		inline uint32_t getWorkerCount() const { return static_cast<uint32_t>(m_Workers.size()); }
+
+	private:
+		void workerLoop();
+		void run(Job& job);
+
+		std::vector<std::thread> m_Workers;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_JobAvailable;
+		std::condition_variable m_JobDone;
+		std::deque<std::shared_ptr<Job>> m_Queue; // in submission order
+		bool m_Stop = false;
+	};
+}
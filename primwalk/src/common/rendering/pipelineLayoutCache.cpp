@@ -0,0 +1,109 @@
+// primwalk
+#include "pipelineLayoutCache.hpp"
+#include "descriptors.hpp"
+#include "graphicsDevice_Vulkan.hpp"
+
+// std
+#include <stdexcept>
+
+namespace pw {
+	PipelineLayoutCache::~PipelineLayoutCache() {
+		for (auto& kv : m_PipelineLayouts) {
+			vkDestroyPipelineLayout(m_Device.getDevice(), kv.second, nullptr);
+		}
+	}
+
+	DescriptorSetLayout& PipelineLayoutCache::getSetLayout(const ShaderReflection& reflection, uint32_t set) {
+		Key key;
+		bool runtimeArray = false;
+
+		for (const auto& binding : reflection.bindings) {
+			if (binding.set != set) {
+				continue;
+			}
+
+			key.push_back((uint64_t(binding.binding) << 32) | binding.type);
+			key.push_back((uint64_t(binding.count) << 32) | binding.stages);
+			runtimeArray |= binding.count == 0;
+		}
+
+		if (runtimeArray) {
+			// The bindless texture set is only visible to fragment shaders
+			bool bindless = key.size() == 2 && (key[0] >> 32) == 0 &&
+				(key[0] & 0xFFFFFFFF) == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER &&
+				(key[1] & 0xFFFFFFFF & ~uint64_t(VK_SHADER_STAGE_FRAGMENT_BIT)) == 0;
+
+			if (!bindless) {
+				throw std::runtime_error("VULKAN ERROR: Runtime descriptor arrays are only supported in the bindless texture set!");
+			}
+
+			return m_Device.getBindlessTextureSetLayout();
+		}
+
+		auto it = m_SetLayouts.find(key);
+		if (it != m_SetLayouts.end()) {
+			return *it->second;
+		}
+
+		DescriptorSetLayout::Builder builder(m_Device);
+		for (const auto& binding : reflection.bindings) {
+			if (binding.set == set) {
+				builder.addBinding(binding.binding, binding.type, binding.stages, binding.count);
+			}
+		}
+
+		auto& setLayout = m_SetLayouts[key];
+		setLayout = builder.build();
+		return *setLayout;
+	}
+
+	VkPipelineLayout PipelineLayoutCache::getPipelineLayout(const ShaderReflection& reflection) {
+		uint32_t setCount = reflection.bindings.empty() ? 0 : reflection.bindings.back().set + 1;
+
+		std::vector<VkDescriptorSetLayout> setLayouts;
+		for (uint32_t set = 0; set < setCount; set++) {
+			setLayouts.push_back(getSetLayout(reflection, set).getDescriptorSetLayout());
+		}
+
+		Key key;
+		for (auto setLayout : setLayouts) {
+			key.push_back(reinterpret_cast<uint64_t>(setLayout));
+		}
+
+		for (const auto& range : reflection.pushConstants) {
+			key.push_back((uint64_t(range.offset) << 32) | range.size);
+			key.push_back(range.stageFlags);
+		}
+
+		auto it = m_PipelineLayouts.find(key);
+		if (it != m_PipelineLayouts.end()) {
+			return it->second;
+		}
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+		pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(reflection.pushConstants.size());
+		pipelineLayoutInfo.pPushConstantRanges = reflection.pushConstants.data();
+
+		VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+		if (vkCreatePipelineLayout(m_Device.getDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to create pipeline layout!");
+		}
+
+		m_PipelineLayouts[key] = pipelineLayout;
+		return pipelineLayout;
+	}
+
+	size_t PipelineLayoutCache::KeyHash::operator()(const Key& key) const {
+		// FNV-1a over the words
+		uint64_t hash = 14695981039346656037ull;
+		for (uint64_t word : key) {
+			hash ^= word;
+			hash *= 1099511628211ull;
+		}
+
+		return static_cast<size_t>(hash);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+// primwalk
+#include "../../core.hpp"
+#include "../data/shader.hpp"
+
+// std
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// vendor
+#include <vulkan/vulkan.h>
+
+namespace pw {
+	// Forward declarations
+	class DescriptorSetLayout;
+	class GraphicsDevice_Vulkan;
+
+	/*
+	* Creates descriptor set layouts and pipeline layouts from shader reflections, so that the passes do not have to
+	* repeat what their shaders already declare. Layouts are cached by their contents, pipelines with identical
+	* interfaces share one pipeline layout and can keep their descriptor sets bound when switching between them.
+	* A set holding nothing but a runtime array of combined image samplers at binding 0 is the device's bindless
+	* texture set. Sets skipped by the shaders get an empty layout. Main thread only.
+	*/
+	class PW_API PipelineLayoutCache {
+	public:
+		PipelineLayoutCache(GraphicsDevice_Vulkan& device) : m_Device(device) {};
+		~PipelineLayoutCache();
+
+		// Forbid copy and move semantics
+		PipelineLayoutCache(const PipelineLayoutCache&) = delete;
+		PipelineLayoutCache& operator=(const PipelineLayoutCache&) = delete;
+
+		DescriptorSetLayout& getSetLayout(const ShaderReflection& reflection, uint32_t set);
+		VkPipelineLayout getPipelineLayout(const ShaderReflection& reflection);
+
+		// Getters
+		inline size_t getSetLayoutCount() const { return m_SetLayouts.size(); }
+		inline size_t getPipelineLayoutCount() const { return m_PipelineLayouts.size(); }
+
+	private:
+		using Key = std::vector<uint64_t>;
+
+		struct KeyHash {
+			size_t operator()(const Key& key) const;
+		};
+
+		GraphicsDevice_Vulkan& m_Device;
+		std::unordered_map<Key, std::unique_ptr<DescriptorSetLayout>, KeyHash> m_SetLayouts; // by bindings
+		std::unordered_map<Key, VkPipelineLayout, KeyHash> m_PipelineLayouts; // by set layouts and push constants
+	};
+}
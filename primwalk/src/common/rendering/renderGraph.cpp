@@ -0,0 +1,575 @@
+#include "renderGraph.hpp"
+#include "graphicsDevice_Vulkan.hpp"
+
+// std
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+namespace pw {
+
+	static bool isDepthFormat(VkFormat format) {
+		return format == VK_FORMAT_D16_UNORM || format == VK_FORMAT_X8_D24_UNORM_PACK32 || format == VK_FORMAT_D32_SFLOAT ||
+			format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+	}
+
+	static bool hasStencilComponent(VkFormat format) {
+		return format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+	}
+
+	// ------ Pass Builder ------
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::read(RenderGraphResource resource, ResourceUsage usage) {
+		m_Graph.m_Passes[m_PassIndex].accesses.push_back({ resource, usage, false, VK_IMAGE_LAYOUT_UNDEFINED });
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::write(RenderGraphResource resource, ResourceUsage usage, VkImageLayout finalLayout) {
+		m_Graph.m_Passes[m_PassIndex].accesses.push_back({ resource, usage, true, finalLayout });
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::setSideEffects() {
+		m_Graph.m_Passes[m_PassIndex].sideEffects = true;
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::setAsyncCompute() {
+		m_Graph.m_Passes[m_PassIndex].asyncCompute = true;
+		return *this;
+	}
+
+	// ------ Render Graph ------
+	RenderGraph::RenderGraph(GraphicsDevice_Vulkan& device) : m_Device(device) {
+		QueueFamilyIndices indices = m_Device.findPhysicalQueueFamilies();
+		m_GraphicsFamily = indices.graphicsFamily.value();
+		m_ComputeFamily = indices.computeFamily.value_or(m_GraphicsFamily);
+	}
+
+	RenderGraph::~RenderGraph() {
+		reset();
+
+		for (VkSemaphore semaphore : m_ComputeSemaphores) {
+			vkDestroySemaphore(m_Device.getDevice(), semaphore, nullptr);
+		}
+
+		if (m_ComputeCommandPool != VK_NULL_HANDLE) {
+			vkDestroyCommandPool(m_Device.getDevice(), m_ComputeCommandPool, nullptr);
+		}
+	}
+
+	RenderGraphResource RenderGraph::importImage(const std::string& name, Image* image, VkImageLayout initialLayout) {
+		Resource resource{};
+		resource.name = name;
+		resource.image = image;
+		resource.initialLayout = initialLayout;
+
+		m_Resources.push_back(resource);
+		return static_cast<RenderGraphResource>(m_Resources.size() - 1);
+	}
+
+	RenderGraphResource RenderGraph::importBuffer(const std::string& name, BufferCallback buffers) {
+		Resource resource{};
+		resource.name = name;
+		resource.isImage = false;
+		resource.buffers = buffers;
+
+		m_Resources.push_back(resource);
+		return static_cast<RenderGraphResource>(m_Resources.size() - 1);
+	}
+
+	void RenderGraph::markOutput(RenderGraphResource resource) {
+		m_Resources[resource].output = true;
+	}
+
+	RenderGraph::PassBuilder RenderGraph::addPass(const std::string& name, ExecuteCallback execute) {
+		Pass pass{};
+		pass.name = name;
+		pass.execute = execute;
+
+		m_Passes.push_back(std::move(pass));
+		return PassBuilder(*this, static_cast<uint32_t>(m_Passes.size() - 1));
+	}
+
+	void RenderGraph::compile() {
+		m_Stats = {};
+		m_Stats.passCount = static_cast<uint32_t>(m_Passes.size());
+
+		cullPasses();
+		sortPasses();
+		scheduleQueues();
+		buildBarriers();
+
+		if (m_Stats.asyncComputePasses > 0 && m_ComputeCommandPool == VK_NULL_HANDLE) {
+			createComputeResources();
+		}
+	}
+
+	void RenderGraph::execute(VkCommandBuffer commandBuffer, size_t frameIndex) {
+		// Submitted first, so that the compute queue can start while the graphics work is still being recorded
+		if (m_Stats.asyncComputePasses > 0) {
+			submitComputePasses(frameIndex);
+		}
+
+		for (uint32_t p : m_ExecutionOrder) {
+			Pass& pass = m_Passes[p];
+
+			if (pass.computeQueue) {
+				continue;
+			}
+
+			if (!pass.acquires.empty()) {
+				recordQueueTransfers(commandBuffer, frameIndex, pass.acquires, false);
+			}
+
+			recordPass(commandBuffer, frameIndex, pass);
+		}
+	}
+
+	void RenderGraph::reset() {
+		m_Passes.clear();
+		m_Resources.clear();
+		m_ExecutionOrder.clear();
+		m_QueueTransfers.clear();
+		m_ComputeWaitStages = 0;
+		m_Stats = {};
+	}
+
+	Image* RenderGraph::getImage(RenderGraphResource resource) const {
+		return m_Resources[resource].image;
+	}
+
+	RenderGraph::UsageInfo RenderGraph::getUsageInfo(ResourceUsage usage, bool depthImage) {
+		switch (usage) {
+		case ResourceUsage::ColorAttachment:
+			return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+		case ResourceUsage::DepthAttachment:
+			return { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+				VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+		case ResourceUsage::SampledFragment:
+			return { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+				depthImage ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		case ResourceUsage::StorageReadFragment:
+			return { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL };
+		case ResourceUsage::StorageReadCompute:
+			return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL };
+		case ResourceUsage::StorageWriteCompute:
+			return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL };
+		}
+
+		throw std::invalid_argument("VULKAN ERROR: Unsupported render graph resource usage!");
+	}
+
+	void RenderGraph::cullPasses() {
+		// Walk backwards from every pass with side effects or writing to an output
+		std::vector<bool> needed(m_Passes.size(), false);
+		std::vector<uint32_t> stack;
+
+		for (uint32_t p = 0; p < m_Passes.size(); p++) {
+			bool writesOutput = false;
+
+			for (const auto& access : m_Passes[p].accesses) {
+				writesOutput |= access.write && m_Resources[access.resource].output;
+			}
+
+			if (m_Passes[p].sideEffects || writesOutput) {
+				needed[p] = true;
+				stack.push_back(p);
+			}
+		}
+
+		while (!stack.empty()) {
+			uint32_t p = stack.back();
+			stack.pop_back();
+
+			for (const auto& access : m_Passes[p].accesses) {
+				if (access.write) {
+					continue;
+				}
+
+				for (uint32_t writer = 0; writer < m_Passes.size(); writer++) {
+					if (needed[writer]) {
+						continue;
+					}
+
+					for (const auto& writerAccess : m_Passes[writer].accesses) {
+						if (writerAccess.write && writerAccess.resource == access.resource) {
+							needed[writer] = true;
+							stack.push_back(writer);
+							break;
+						}
+					}
+				}
+			}
+		}
+
+		for (uint32_t p = 0; p < m_Passes.size(); p++) {
+			m_Passes[p].culled = !needed[p];
+			m_Stats.culledPasses += m_Passes[p].culled ? 1 : 0;
+		}
+	}
+
+	void RenderGraph::sortPasses() {
+		// Dependencies follow declaration order per resource: a read depends on the latest write declared before it
+		// (or the first write if there is none), and a write depends on the previous write and the reads in between
+		std::vector<std::vector<uint32_t>> dependents(m_Passes.size());
+		std::vector<uint32_t> dependencyCount(m_Passes.size(), 0);
+
+		auto addEdge = [&](uint32_t from, uint32_t to) {
+			if (from == to) {
+				return;
+			}
+
+			dependents[from].push_back(to);
+			dependencyCount[to]++;
+		};
+
+		for (RenderGraphResource r = 0; r < m_Resources.size(); r++) {
+			int64_t lastWriter = -1;
+			std::vector<uint32_t> readers;
+			std::vector<uint32_t> pendingReaders; // reads declared before any write
+
+			for (uint32_t p = 0; p < m_Passes.size(); p++) {
+				if (m_Passes[p].culled) {
+					continue;
+				}
+
+				for (const auto& access : m_Passes[p].accesses) {
+					if (access.resource != r) {
+						continue;
+					}
+
+					if (!access.write) {
+						if (lastWriter >= 0) {
+							addEdge(static_cast<uint32_t>(lastWriter), p);
+							readers.push_back(p);
+						}
+						else {
+							pendingReaders.push_back(p);
+						}
+
+						continue;
+					}
+
+					if (lastWriter >= 0) {
+						addEdge(static_cast<uint32_t>(lastWriter), p);
+					}
+					else {
+						for (uint32_t reader : pendingReaders) {
+							addEdge(p, reader);
+						}
+					}
+
+					for (uint32_t reader : readers) {
+						addEdge(reader, p);
+					}
+
+					readers.clear();
+					lastWriter = p;
+				}
+			}
+		}
+
+		// Kahn's algorithm, ties are broken by declaration order
+		std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> ready;
+
+		for (uint32_t p = 0; p < m_Passes.size(); p++) {
+			if (!m_Passes[p].culled && dependencyCount[p] == 0) {
+				ready.push(p);
+			}
+		}
+
+		m_ExecutionOrder.clear();
+
+		while (!ready.empty()) {
+			uint32_t p = ready.top();
+			ready.pop();
+			m_ExecutionOrder.push_back(p);
+
+			for (uint32_t dependent : dependents[p]) {
+				if (--dependencyCount[dependent] == 0) {
+					ready.push(dependent);
+				}
+			}
+		}
+
+		if (m_ExecutionOrder.size() != m_Passes.size() - m_Stats.culledPasses) {
+			throw std::runtime_error("VULKAN ERROR: Render graph contains a dependency cycle!");
+		}
+	}
+
+	void RenderGraph::scheduleQueues() {
+		// The graphics queue never signals the compute queue, so a pass only moves over if every graphics pass it
+		// would depend on runs in a later frame
+		std::vector<bool> graphicsAccessed(m_Resources.size(), false);
+
+		for (uint32_t p : m_ExecutionOrder) {
+			Pass& pass = m_Passes[p];
+			pass.computeQueue = pass.asyncCompute && m_Device.hasAsyncComputeQueue();
+
+			for (const auto& access : pass.accesses) {
+				const Resource& resource = m_Resources[access.resource];
+				pass.computeQueue &= !resource.isImage && resource.buffers && !graphicsAccessed[access.resource];
+			}
+
+			if (pass.computeQueue) {
+				m_Stats.asyncComputePasses++;
+				continue;
+			}
+
+			for (const auto& access : pass.accesses) {
+				graphicsAccessed[access.resource] = true;
+			}
+		}
+	}
+
+	void RenderGraph::buildBarriers() {
+		struct ResourceState {
+			VkPipelineStageFlags stage = 0;
+			VkAccessFlags access = 0;
+			VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			bool lastWasWrite = false;
+			bool computeQueue = false; // last accessed on the async compute queue
+		};
+
+		std::vector<ResourceState> states(m_Resources.size());
+
+		for (RenderGraphResource r = 0; r < m_Resources.size(); r++) {
+			states[r].layout = m_Resources[r].initialLayout;
+		}
+
+		m_QueueTransfers.clear();
+		m_ComputeWaitStages = 0;
+
+		for (uint32_t p : m_ExecutionOrder) {
+			Pass& pass = m_Passes[p];
+			pass.imageBarriers.clear();
+			pass.acquires.clear();
+			pass.memoryBarrier = {};
+			pass.memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			pass.srcStageMask = 0;
+			pass.dstStageMask = 0;
+
+			for (const auto& access : pass.accesses) {
+				const Resource& resource = m_Resources[access.resource];
+				ResourceState& state = states[access.resource];
+
+				bool depthImage = resource.isImage && resource.image && isDepthFormat(resource.image->getFormat());
+				UsageInfo usage = getUsageInfo(access.usage, depthImage);
+
+				if (state.computeQueue && !pass.computeQueue) {
+					// Handed over by the compute queue, the semaphore and the ownership transfer replace the barrier
+					m_QueueTransfers.push_back({ access.resource, state.stage, state.lastWasWrite ? state.access : 0, usage.stage, usage.access });
+					pass.acquires.push_back(static_cast<uint32_t>(m_QueueTransfers.size() - 1));
+					m_ComputeWaitStages |= usage.stage;
+					state = {};
+				}
+
+				state.computeQueue = pass.computeQueue;
+
+				if (access.write) {
+					// WAR and WAW hazards only need ordering, render passes discard the old contents themselves
+					if (state.stage != 0) {
+						pass.srcStageMask |= state.stage;
+						pass.dstStageMask |= usage.stage;
+						pass.memoryBarrier.srcAccessMask |= state.lastWasWrite ? state.access : 0;
+						pass.memoryBarrier.dstAccessMask |= state.lastWasWrite ? usage.access : 0;
+					}
+
+					state.stage = usage.stage;
+					state.access = usage.access;
+					state.layout = resource.isImage ? access.finalLayout : VK_IMAGE_LAYOUT_UNDEFINED;
+					state.lastWasWrite = true;
+					continue;
+				}
+
+				if (resource.isImage && state.layout != usage.layout) {
+					// Layout transition, also makes preceding writes visible
+					VkImageMemoryBarrier barrier{};
+					barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+					barrier.oldLayout = state.layout;
+					barrier.newLayout = usage.layout;
+					barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+					barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+					barrier.image = resource.image->getVulkanImage();
+					barrier.subresourceRange.aspectMask = depthImage ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+					barrier.subresourceRange.baseMipLevel = 0;
+					barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+					barrier.subresourceRange.baseArrayLayer = 0;
+					barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+					barrier.srcAccessMask = state.lastWasWrite ? state.access : 0;
+					barrier.dstAccessMask = usage.access;
+
+					if (depthImage && hasStencilComponent(resource.image->getFormat())) {
+						barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+					}
+
+					pass.imageBarriers.push_back(barrier);
+					pass.srcStageMask |= state.stage != 0 ? state.stage : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+					pass.dstStageMask |= usage.stage;
+				}
+				else if (state.lastWasWrite) {
+					// Read after write in the expected layout, a memory barrier suffices
+					pass.srcStageMask |= state.stage;
+					pass.dstStageMask |= usage.stage;
+					pass.memoryBarrier.srcAccessMask |= state.access;
+					pass.memoryBarrier.dstAccessMask |= usage.access;
+				}
+
+				// Consecutive reads accumulate so that the next write waits for all of them
+				state.stage = state.lastWasWrite ? usage.stage : (state.stage | usage.stage);
+				state.access = usage.access;
+				state.layout = resource.isImage ? usage.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+				state.lastWasWrite = false;
+			}
+
+			// Execution-only dependencies (write after read) are batched without any memory barrier
+			m_Stats.memoryBarriers += (pass.memoryBarrier.srcAccessMask != 0 || pass.memoryBarrier.dstAccessMask != 0) ? 1 : 0;
+			m_Stats.imageBarriers += static_cast<uint32_t>(pass.imageBarriers.size());
+			m_Stats.barrierBatches += pass.srcStageMask != 0 ? 1 : 0;
+		}
+
+		m_Stats.queueTransfers = static_cast<uint32_t>(m_QueueTransfers.size());
+	}
+
+	void RenderGraph::recordPass(VkCommandBuffer commandBuffer, size_t frameIndex, Pass& pass) {
+		bool hasMemoryBarrier = pass.memoryBarrier.srcAccessMask != 0 || pass.memoryBarrier.dstAccessMask != 0;
+
+		if (pass.srcStageMask != 0) {
+			vkCmdPipelineBarrier(
+				commandBuffer,
+				pass.srcStageMask,
+				pass.dstStageMask,
+				0,
+				hasMemoryBarrier ? 1 : 0, &pass.memoryBarrier,
+				0, nullptr,
+				static_cast<uint32_t>(pass.imageBarriers.size()), pass.imageBarriers.data());
+		}
+
+		pass.execute(commandBuffer, frameIndex);
+	}
+
+	void RenderGraph::recordQueueTransfers(VkCommandBuffer commandBuffer, size_t frameIndex, const std::vector<uint32_t>& transfers, bool release) {
+		std::vector<VkBufferMemoryBarrier> barriers;
+		VkPipelineStageFlags srcStageMask = release ? 0 : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		VkPipelineStageFlags dstStageMask = release ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : 0;
+
+		for (uint32_t t : transfers) {
+			const QueueTransfer& transfer = m_QueueTransfers[t];
+
+			// The release only makes the writes available, the acquire only makes them visible
+			for (VkBuffer buffer : m_Resources[transfer.resource].buffers(frameIndex)) {
+				VkBufferMemoryBarrier barrier{};
+				barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+				barrier.srcAccessMask = release ? transfer.srcAccessMask : 0;
+				barrier.dstAccessMask = release ? 0 : transfer.dstAccessMask;
+				barrier.srcQueueFamilyIndex = m_ComputeFamily;
+				barrier.dstQueueFamilyIndex = m_GraphicsFamily;
+				barrier.buffer = buffer;
+				barrier.offset = 0;
+				barrier.size = VK_WHOLE_SIZE;
+				barriers.push_back(barrier);
+			}
+
+			srcStageMask |= release ? transfer.srcStageMask : 0;
+			dstStageMask |= release ? 0 : transfer.dstStageMask;
+		}
+
+		if (barriers.empty()) {
+			return;
+		}
+
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			srcStageMask,
+			dstStageMask,
+			0,
+			0, nullptr,
+			static_cast<uint32_t>(barriers.size()), barriers.data(),
+			0, nullptr);
+	}
+
+	void RenderGraph::submitComputePasses(size_t frameIndex) {
+		// Reused once the frame's fence was waited for, the graphics submission of the frame waits on the semaphore
+		VkCommandBuffer commandBuffer = m_ComputeCommandBuffers[frameIndex];
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to begin recording async compute command buffer!");
+		}
+
+		for (uint32_t p : m_ExecutionOrder) {
+			if (m_Passes[p].computeQueue) {
+				recordPass(commandBuffer, frameIndex, m_Passes[p]);
+			}
+		}
+
+		std::vector<uint32_t> transfers(m_QueueTransfers.size());
+
+		for (uint32_t t = 0; t < transfers.size(); t++) {
+			transfers[t] = t;
+		}
+
+		recordQueueTransfers(commandBuffer, frameIndex, transfers, true);
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to record async compute command buffer!");
+		}
+
+		// The passes might have written descriptors, which the renderer would only flush before the graphics submission
+		m_Device.getDescriptorBatcher().flush();
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &m_ComputeSemaphores[frameIndex];
+
+		if (vkQueueSubmit(m_Device.getComputeQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to submit async compute command buffer!");
+		}
+
+		// Waited on even if no graphics pass consumes anything, the frame's fence then covers the compute work as well
+		m_Device.addFrameWaitSemaphore(m_ComputeSemaphores[frameIndex],
+			m_ComputeWaitStages != 0 ? m_ComputeWaitStages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+	}
+
+	void RenderGraph::createComputeResources() {
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolInfo.queueFamilyIndex = m_ComputeFamily;
+
+		if (vkCreateCommandPool(m_Device.getDevice(), &poolInfo, nullptr, &m_ComputeCommandPool) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to create async compute command pool!");
+		}
+
+		m_ComputeCommandBuffers.resize(GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT);
+
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = m_ComputeCommandPool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = static_cast<uint32_t>(m_ComputeCommandBuffers.size());
+
+		if (vkAllocateCommandBuffers(m_Device.getDevice(), &allocInfo, m_ComputeCommandBuffers.data()) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to allocate async compute command buffers!");
+		}
+
+		m_ComputeSemaphores.resize(GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT);
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+		for (auto& semaphore : m_ComputeSemaphores) {
+			if (vkCreateSemaphore(m_Device.getDevice(), &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+				throw std::runtime_error("VULKAN ERROR: Failed to create async compute semaphore!");
+			}
+		}
+	}
+
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+// primwalk
+#include "../../core.hpp"
+#include "image.hpp"
+
+// std
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// vendor
+#include <vulkan/vulkan.h>
+
+namespace pw {
+	// Forward declarations
+	class GraphicsDevice_Vulkan;
+
+	using RenderGraphResource = uint32_t;
+
+	enum class ResourceUsage {
+		ColorAttachment, // written by a render pass
+		DepthAttachment, // written by a render pass
+		SampledFragment, // sampled in a fragment shader
+		StorageReadFragment, // storage buffer read in a fragment shader
+		StorageReadCompute,
+		StorageWriteCompute
+	};
+
+	/*
+	* Passes declare the resources they read and write, after which compile() orders them, culls every pass that
+	* does not contribute to an output (or has side effects) and precomputes the barriers between passes. execute()
+	* then only replays those.
+	* NOTE: Render passes still transition their own attachments, the graph only tracks the final layouts they leave behind.
+	*
+	* On devices with an async compute queue, passes marked with setAsyncCompute() are recorded into a separate command
+	* buffer that is submitted to that queue as soon as execute() is called, so that it overlaps with the graphics work
+	* recorded after it. The graphics submission of the frame waits on it at the stages of the passes consuming its
+	* results, and the buffers it hands over change queue family ownership. Everywhere else they run inline.
+	*/
+	class PW_API RenderGraph {
+	public:
+		struct Stats {
+			uint32_t passCount = 0;
+			uint32_t culledPasses = 0;
+			uint32_t imageBarriers = 0;
+			uint32_t memoryBarriers = 0;
+			uint32_t barrierBatches = 0; // vkCmdPipelineBarrier calls per frame
+			uint32_t asyncComputePasses = 0; // actually running on the async compute queue
+			uint32_t queueTransfers = 0; // resources handed from the async compute queue to the graphics queue per frame
+		};
+
+		class PassBuilder {
+		public:
+			PassBuilder& read(RenderGraphResource resource, ResourceUsage usage);
+			PassBuilder& write(RenderGraphResource resource, ResourceUsage usage,
+				VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL); // layout the render pass leaves the image in
+			PassBuilder& setSideEffects(); // never culled, e.g. presenting to the swapchain
+
+			// Allows running the pass on the async compute queue. Only honored if it accesses nothing but buffers imported
+			// with their handles and no graphics pass before it in the frame touches them, otherwise it runs inline.
+			// NOTE: The buffers it writes have to exist per frame in flight, and it may not read data uploaded or written
+			// on the graphics queue, as the queue only synchronizes with the graphics work of its own frame.
+			PassBuilder& setAsyncCompute();
+
+		private:
+			PassBuilder(RenderGraph& graph, uint32_t passIndex) : m_Graph(graph), m_PassIndex(passIndex) {}
+
+			RenderGraph& m_Graph;
+			uint32_t m_PassIndex;
+
+			friend class RenderGraph;
+		};
+
+		using ExecuteCallback = std::function<void(VkCommandBuffer commandBuffer, size_t frameIndex)>;
+		using BufferCallback = std::function<std::vector<VkBuffer>(size_t frameIndex)>; // the buffers behind a resource in a frame
+
+		RenderGraph(GraphicsDevice_Vulkan& device);
+		~RenderGraph();
+
+		/* Resources */
+		RenderGraphResource importImage(const std::string& name, Image* image, VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED);
+		RenderGraphResource importBuffer(const std::string& name, BufferCallback buffers = nullptr); // handles are needed by async compute only
+		void markOutput(RenderGraphResource resource);
+
+		/* Passes */
+		PassBuilder addPass(const std::string& name, ExecuteCallback execute);
+
+		void compile();
+		void execute(VkCommandBuffer commandBuffer, size_t frameIndex);
+		void reset(); // removes every pass and resource
+
+		Image* getImage(RenderGraphResource resource) const;
+		inline const Stats& getStats() const { return m_Stats; }
+
+	private:
+		struct Access {
+			RenderGraphResource resource;
+			ResourceUsage usage;
+			bool write;
+			VkImageLayout finalLayout;
+		};
+
+		struct Pass {
+			std::string name;
+			ExecuteCallback execute;
+			std::vector<Access> accesses;
+			bool sideEffects = false;
+			bool asyncCompute = false;
+			bool culled = false;
+
+			// Filled in by compile()
+			bool computeQueue = false;
+			std::vector<uint32_t> acquires; // queue transfers to acquire before the pass
+			std::vector<VkImageMemoryBarrier> imageBarriers;
+			VkMemoryBarrier memoryBarrier{};
+			VkPipelineStageFlags srcStageMask = 0;
+			VkPipelineStageFlags dstStageMask = 0;
+		};
+
+		struct Resource {
+			std::string name;
+			bool isImage = true;
+			bool output = false;
+			Image* image = nullptr;
+			VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			BufferCallback buffers;
+		};
+
+		// Ownership transfer of a resource from the async compute queue to the graphics queue
+		struct QueueTransfer {
+			RenderGraphResource resource;
+			VkPipelineStageFlags srcStageMask; // of the last access on the compute queue
+			VkAccessFlags srcAccessMask;
+			VkPipelineStageFlags dstStageMask; // of the first access on the graphics queue
+			VkAccessFlags dstAccessMask;
+		};
+
+		struct UsageInfo {
+			VkPipelineStageFlags stage;
+			VkAccessFlags access;
+			VkImageLayout layout;
+		};
+
+		static UsageInfo getUsageInfo(ResourceUsage usage, bool depthImage);
+
+		void cullPasses();
+		void sortPasses();
+		void scheduleQueues();
+		void buildBarriers();
+
+		void recordPass(VkCommandBuffer commandBuffer, size_t frameIndex, Pass& pass);
+		void recordQueueTransfers(VkCommandBuffer commandBuffer, size_t frameIndex, const std::vector<uint32_t>& transfers, bool release);
+		void submitComputePasses(size_t frameIndex);
+		void createComputeResources();
+
+		GraphicsDevice_Vulkan& m_Device;
+		uint32_t m_GraphicsFamily = 0;
+		uint32_t m_ComputeFamily = 0;
+
+		std::vector<Pass> m_Passes;
+		std::vector<Resource> m_Resources;
+		std::vector<uint32_t> m_ExecutionOrder;
+
+		// Async compute, created on first use
+		VkCommandPool m_ComputeCommandPool = VK_NULL_HANDLE;
+		std::vector<VkCommandBuffer> m_ComputeCommandBuffers; // per frame in flight
+		std::vector<VkSemaphore> m_ComputeSemaphores; // per frame in flight, waited on by the graphics submission
+		std::vector<QueueTransfer> m_QueueTransfers;
+		VkPipelineStageFlags m_ComputeWaitStages = 0;
+
+		Stats m_Stats{};
+	};
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+// primwalk
+#include "../../core.hpp"
+
+namespace pw {
+	enum class RenderPath {
+		Deferred, // G-buffer + full-screen lighting pass
+		ForwardPlus, // Depth pre-pass + single forward shading pass, lower bandwidth
+		VisibilityBuffer // Triangle ID pass + full-screen material resolve, shading cost independent of overdraw
+	};
+
+	/* Shading quality, selects specialized pipeline variants and can be changed at runtime (see Application::setShadingQuality()) */
+	struct PW_API ShadingQuality {
+		bool pcfShadows = true; // filtered shadow edges
+		int pcfRadius = 1; // (2 * pcfRadius + 1)^2 shadow map taps
+		float ambientIntensity = 0.3f;
+	};
+
+	/* Startup rendering configuration, changing it requires recreating the application */
+	struct PW_API RenderSettings {
+		RenderPath renderPath = RenderPath::Deferred;
+		bool mergeDeferredPasses = false; // Deferred only: geometry and lighting as subpasses of one render pass with a transient G-buffer
+
+		// Dynamic resolution (separate deferred passes only): the internal render size follows the measured GPU frame
+		// time, relative to half the window size. Targets are allocated at the maximum scale and rendered with a viewport.
+		bool dynamicResolution = false;
+		float minRenderScale = 0.5f;
+		float maxRenderScale = 1.0f;
+		float gpuFrameBudget = 16.6f; // milliseconds
+
+		// Temporal upsampling (separate deferred passes only): jittered rendering at a lower internal resolution,
+		// reconstructed to half the window size from the reprojected history. Without dynamic resolution the
+		// internal resolution is fixed at temporalRenderScale.
+		bool temporalUpsampling = false;
+		float temporalRenderScale = 0.5f;
+
+		ShadingQuality shadingQuality{}; // initial quality
+	};
+}
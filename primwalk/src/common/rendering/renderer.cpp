@@ -1,4 +1,7 @@
 #include "renderer.hpp"
+#include "commandRecorder.hpp"
+#include "geometryStore.hpp"
+#include "uploadManager.hpp"
 
 // std
 #include <algorithm>
@@ -11,7 +14,12 @@ namespace pw {
 		m_Device(device), m_Window(window) {
 
 		m_SwapChain = std::make_unique<SwapChain>(m_Device);
+		m_Profiler = std::make_unique<GPUProfiler>(m_Device);
 		createCommandBuffers();
+
+		// Sampled wherever a material has no texture
+		m_DefaultTexture = std::make_unique<Texture2D>(1, 1, std::vector<uint8_t>(4, 255).data());
+		m_Device.setDefaultBindlessImage(m_DefaultTexture->getImage()->getVulkanImageView());
 	}
 
 	Renderer::~Renderer() {
@@ -37,6 +45,15 @@ namespace pw {
 			throw std::runtime_error("VULKAN ERROR: Failed to acquire swap chain image!");
 		}
 
+		// The fence of the frame was waited for, its secondary command buffers, released bindless slots and geometry ranges can be reused
+		m_Device.beginFrame();
+		m_Device.getCommandRecorder().beginFrame(m_SwapChain->getCurrentFrameIndex());
+		m_Device.getUploadManager().update();
+		m_Device.getGeometryStore().update();
+
+		// Descriptor writes queued since the last frame are applied before recording
+		m_Device.getDescriptorBatcher().beginFrame();
+
 		auto commandBuffer = m_CommandBuffers[m_SwapChain->getCurrentFrameIndex()];
 
 		VkCommandBufferBeginInfo beginInfo{};
@@ -46,6 +63,9 @@ namespace pw {
 			throw std::runtime_error("VULKAN ERROR: Failed to begin recording command buffer!");
 		}
 
+		m_Profiler->beginFrame(commandBuffer, m_SwapChain->getCurrentFrameIndex());
+		m_Profiler->begin(commandBuffer, "Frame");
+
 		return commandBuffer;
 	}
 
@@ -59,10 +79,18 @@ namespace pw {
 
 	void Renderer::endFrame() {
 		auto commandBuffer = m_CommandBuffers[m_SwapChain->getCurrentFrameIndex()];
+		m_Profiler->end(commandBuffer, "Frame");
+
+		// Update-after-bind descriptors written while recording only have to be valid at submission
+		m_Device.getDescriptorBatcher().flush();
+
 		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
 			throw std::runtime_error("VULKAN ERROR: Failed to record command buffer!");
 		}
 
+		// Uploads recorded up to now are submitted first, the frame might already use them
+		m_Device.getUploadManager().flush();
+
 		// Submit command buffers
 		VkResult result = m_SwapChain->swapImage(commandBuffer);
 	}
@@ -5,8 +5,10 @@
 #include "../../window.hpp"
 #include "../color.hpp"
 #include "framebuffer.hpp"
+#include "gpuProfiler.hpp"
 #include "graphicsDevice_Vulkan.hpp"
 #include "swapChain.hpp"
+#include "texture2D.hpp"
 
 // std
 #include <atomic>
@@ -30,6 +32,8 @@ namespace pw {
 		inline VkRenderPass getVkRenderPass() const { return m_SwapChain->getRenderPass().getVulkanRenderPass(); }
 		inline uint32_t getSwapChainWidth() const { return m_SwapChain->getWidth(); }
 		inline uint32_t getSwapChainHeight() const { return m_SwapChain->getHeight(); }
+		inline GPUProfiler& getProfiler() { return *m_Profiler; }
+		inline float getGPUFrameTime() const { return m_Profiler->getTime("Frame"); } // milliseconds
 
 	private:
 		void createCommandBuffers();
@@ -38,6 +42,8 @@ namespace pw {
 		Window& m_Window;
 
 		std::unique_ptr<SwapChain> m_SwapChain;
+		std::unique_ptr<GPUProfiler> m_Profiler;
+		std::unique_ptr<Texture2D> m_DefaultTexture; // bindless slot 0
 		std::vector<VkCommandBuffer> m_CommandBuffers;
 	};
 }
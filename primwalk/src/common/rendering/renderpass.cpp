@@ -3,11 +3,31 @@
 #include "../color.hpp"
 
 // std
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <stdexcept>
 
 namespace pw {
 
+	static bool isDepthLayout(VkImageLayout layout) {
+		return layout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL || layout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+	}
+
+	// Only the viewport is rendered (and cleared), e.g. when rendering at a lower resolution into larger targets.
+	// Flipped viewports have a negative height.
+	static VkRect2D getRenderArea(Framebuffer& frameBuffer, const Viewport& viewport) {
+		float top = std::min(viewport.offsetY, viewport.offsetY + viewport.height);
+
+		VkRect2D area{};
+		area.offset.x = static_cast<int32_t>(std::max(viewport.offsetX, 0.0f));
+		area.offset.y = static_cast<int32_t>(std::max(top, 0.0f));
+		area.extent.width = std::min(static_cast<uint32_t>(std::ceil(std::abs(viewport.width))), frameBuffer.getWidth() - area.offset.x);
+		area.extent.height = std::min(static_cast<uint32_t>(std::ceil(std::abs(viewport.height))), frameBuffer.getHeight() - area.offset.y);
+
+		return area;
+	}
+
 	// TODO: This method assumes the depth attachment is passed last, fix this
 	RenderPass::RenderPass(const RenderPassInfo& createInfo) {
 		GraphicsDevice_Vulkan* device = (GraphicsDevice_Vulkan*&)pw::GetDevice();
@@ -32,7 +52,7 @@ namespace pw {
 			// TODO: Add check for depth
 			attachmentDescriptions[i].finalLayout = attachments[i].finalLayout;
 
-			if (attachmentDescriptions[i].finalLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
+			if (isDepthLayout(attachmentDescriptions[i].finalLayout)) {
 				m_ClearValues[i].depthStencil = { 1.0f, 0 };
 			}
 			else {
@@ -45,35 +65,66 @@ namespace pw {
 		bool hasDepthAttachment = false;
 
 		for (const auto& a : attachments) {
-			if (a.finalLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
+			if (isDepthLayout(a.finalLayout)) {
 				hasDepthAttachment = true;
 				break;
 			}
 		}
 
-		size_t depthAttachmentIndex = 0;
-		std::vector<VkAttachmentReference> colorAttachmentsRefs(hasDepthAttachment ? attachments.size() - 1 : attachments.size());
+		uint32_t colorAttachmentCount = static_cast<uint32_t>(hasDepthAttachment ? attachments.size() - 1 : attachments.size());
+		uint32_t depthAttachmentIndex = colorAttachmentCount; // makes sure the attachment ID is greater than all color attachments
+		std::vector<SubpassDescription> subpassDescriptions(subpassInfos.size());
 
-		for (size_t i = 0; i < colorAttachmentsRefs.size(); i++) {
-			colorAttachmentsRefs[i].attachment = i;
-			colorAttachmentsRefs[i].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-		}
+		for (size_t i = 0; i < subpassInfos.size(); i++) {
+			SubpassDescription& description = subpassDescriptions[i];
+			bool readsDepth = false;
 
-		VkSubpassDescription subpass{};
-		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-		subpass.colorAttachmentCount = colorAttachmentsRefs.size();
-		subpass.pColorAttachments = colorAttachmentsRefs.data();
+			// A single subpass renders to every color attachment
+			if (subpassInfos.size() == 1) {
+				for (uint32_t a = 0; a < colorAttachmentCount; a++) {
+					description.colorReferences.push_back({ a, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
+				}
+			}
+			else {
+				for (uint32_t a : subpassInfos[i].renderTargets) {
+					description.colorReferences.push_back({ a, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
+				}
+
+				for (uint32_t a : subpassInfos[i].subpassInputs) {
+					if (hasDepthAttachment && a == depthAttachmentIndex) {
+						description.inputReferences.push_back({ a, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL });
+						readsDepth = true;
+					}
+					else {
+						description.inputReferences.push_back({ a, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+					}
+				}
+			}
 
-		VkAttachmentReference depthAttachmentRef{};
-		depthAttachmentRef.attachment = colorAttachmentsRefs.size(); // makes sure the attachment ID is greater than all color attachments
-		depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			description.depthReference.attachment = depthAttachmentIndex;
+			description.depthReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
-		if (hasDepthAttachment) {
+			description.data.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+			description.data.colorAttachmentCount = static_cast<uint32_t>(description.colorReferences.size());
+			description.data.pColorAttachments = description.colorReferences.data();
+			description.data.inputAttachmentCount = static_cast<uint32_t>(description.inputReferences.size());
+			description.data.pInputAttachments = description.inputReferences.data();
 
+			// Subpasses reading depth as an input attachment can not write to it at the same time
+			if (hasDepthAttachment && !readsDepth) {
+				description.data.pDepthStencilAttachment = &description.depthReference;
+			}
+		}
+
+		std::vector<VkSubpassDescription> subpasses(subpassDescriptions.size());
 
-			subpass.pDepthStencilAttachment = &depthAttachmentRef;
+		for (size_t i = 0; i < subpassDescriptions.size(); i++) {
+			subpasses[i] = subpassDescriptions[i].data;
 		}
 
+		m_ColorAttachmentCount = colorAttachmentCount;
+		m_HasDepthAttachment = hasDepthAttachment;
+
 		// Dependencies
 		std::vector<VkSubpassDependency> dependencies;
 		if (subpassInfos.size() != 1)
@@ -84,20 +135,19 @@ namespace pw {
 			firstDependency.srcSubpass = VK_SUBPASS_EXTERNAL;
 			firstDependency.dstSubpass = 0;
 			firstDependency.srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-			firstDependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			firstDependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
 			firstDependency.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-			firstDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-			firstDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			firstDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 			firstDependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
 
 			for (size_t i = 1; i < (dependencies.size() - 1); i++)
 			{
 				dependencies[i].srcSubpass = i - 1;
 				dependencies[i].dstSubpass = i;
-				dependencies[i].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+				dependencies[i].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
 				dependencies[i].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-				dependencies[i].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-				dependencies[i].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+				dependencies[i].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+				dependencies[i].dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
 				dependencies[i].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
 			}
 
@@ -126,8 +176,8 @@ namespace pw {
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
 		renderPassInfo.attachmentCount = static_cast<uint32_t>(attachmentDescriptions.size());
 		renderPassInfo.pAttachments = attachmentDescriptions.data();
-		renderPassInfo.subpassCount = 1;
-		renderPassInfo.pSubpasses = &subpass;
+		renderPassInfo.subpassCount = static_cast<uint32_t>(subpasses.size());
+		renderPassInfo.pSubpasses = subpasses.data();
 		renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
 		renderPassInfo.pDependencies = dependencies.data();
 
@@ -142,18 +192,25 @@ namespace pw {
 		vkDestroyRenderPass(device->getDevice(), m_RenderPass, nullptr);
 	}
 
-	void RenderPass::begin(Framebuffer& frameBuffer, VkCommandBuffer commandBuffer, const Viewport& viewport) {
+	void RenderPass::begin(Framebuffer& frameBuffer, VkCommandBuffer commandBuffer, const Viewport& viewport, VkSubpassContents contents) {
 		VkRenderPassBeginInfo renderPassInfo{};
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
 		renderPassInfo.renderPass = m_RenderPass;
 		renderPassInfo.framebuffer = frameBuffer.getVkFramebuffer();
-		renderPassInfo.renderArea.offset = { 0, 0 };
-		renderPassInfo.renderArea.extent.width = frameBuffer.getWidth();
-		renderPassInfo.renderArea.extent.height = frameBuffer.getHeight();
+		renderPassInfo.renderArea = getRenderArea(frameBuffer, viewport);
 		renderPassInfo.clearValueCount = static_cast<uint32_t>(m_ClearValues.size());
 		renderPassInfo.pClearValues = m_ClearValues.data();
 
-		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+
+		// Only vkCmdExecuteCommands may be recorded into a subpass with secondary contents
+		if (contents == VK_SUBPASS_CONTENTS_INLINE) {
+			setViewport(commandBuffer, frameBuffer, viewport);
+		}
+	}
+
+	void RenderPass::setViewport(VkCommandBuffer commandBuffer, Framebuffer& frameBuffer, const Viewport& viewport) {
+		VkRect2D scissor = getRenderArea(frameBuffer, viewport);
 
 		VkViewport vkViewport{};
 		vkViewport.x = viewport.offsetX;
@@ -163,14 +220,14 @@ namespace pw {
 		vkViewport.minDepth = viewport.minDepth;
 		vkViewport.maxDepth = viewport.maxDepth;
 
-		VkRect2D scissor{};
-		scissor.offset = { 0, 0 };
-		scissor.extent = { frameBuffer.getWidth(), frameBuffer.getHeight() };
-
 		vkCmdSetViewport(commandBuffer, 0, 1, &vkViewport);
 		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 	}
 
+	void RenderPass::nextSubpass(VkCommandBuffer commandBuffer) {
+		vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+	}
+
 	void RenderPass::end(VkCommandBuffer commandBuffer) {
 		vkCmdEndRenderPass(commandBuffer);
 	}
@@ -21,9 +21,10 @@ namespace pw {
 		VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 	};
 
+	// NOTE: Render targets and inputs are only used with multiple subpasses, a single subpass renders to every color attachment
 	struct SubpassInfo {
 		std::vector<uint32_t> renderTargets{};
-		std::vector<uint32_t> subpassInputs{};
+		std::vector<uint32_t> subpassInputs{}; // input attachment indices follow the order of this list
 	};
 
 	struct RenderPassInfo {
@@ -45,9 +46,14 @@ namespace pw {
 		RenderPass(const RenderPassInfo& createInfo);
 		~RenderPass();
 
-		void begin(Framebuffer& frameBuffer, VkCommandBuffer commandBuffer, const Viewport& viewport);
+		// With secondary command buffer contents the viewport has to be set in every secondary instead
+		void begin(Framebuffer& frameBuffer, VkCommandBuffer commandBuffer, const Viewport& viewport,
+			VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+		void nextSubpass(VkCommandBuffer commandBuffer);
 		void end(VkCommandBuffer commandBuffer);
 
+		static void setViewport(VkCommandBuffer commandBuffer, Framebuffer& frameBuffer, const Viewport& viewport); // and the matching scissor
+
 		inline VkRenderPass getVulkanRenderPass() const { return m_RenderPass; }
 		
 		void setClearColor(uint32_t attachmentIndex, Color color);
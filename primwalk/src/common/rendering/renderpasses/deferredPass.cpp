@@ -0,0 +1,457 @@
+#include "deferredPass.hpp"
+#include "../geometryStore.hpp"
+#include "../pipelineLayoutCache.hpp"
+#include "../vertex3d.hpp"
+#include "../../components/camera.hpp"
+#include "../../components/directionLight.hpp"
+#include "../../components/renderable.hpp"
+#include "../../components/transform.hpp"
+#include "../../data/model.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace pw {
+
+	DeferredPass::DeferredPass(uint32_t width, uint32_t height, GraphicsDevice_Vulkan& device, LightCullingPass& lightCullingPass,
+		const ShadingQuality& shadingQuality) : m_Device(device), m_LightCullingPass(lightCullingPass) {
+		createImages(width, height);
+		createRenderpass();
+		createFramebuffer(width, height);
+		createDescriptorPool();
+		createBuffers();
+		createDescriptorSetLayout();
+		createPipelines();
+		setShadingQuality(shadingQuality);
+		createSamplers();
+	}
+
+	DeferredPass::~DeferredPass() {
+		m_Framebuffer->destroy();
+		m_OutputImage->destroy();
+		m_NormalBuffer->destroy();
+		m_AlbedoBuffer->destroy();
+		m_DepthBuffer->destroy();
+	}
+
+	void DeferredPass::draw(VkCommandBuffer commandBuffer, size_t frameIndex, std::set<entity_id>& entities, ComponentManager& manager,
+		Image* shadowMap, const glm::mat4& lightSpaceMatrix) {
+
+		UniformBuffer3D ubo{};
+		ubo.view = Camera::MainCamera->getViewMatrix();
+		ubo.proj = Camera::MainCamera->getProjectionMatrix();
+		ubo.viewProjection = Camera::MainCamera->getUnjitteredViewProjection();
+		ubo.previousViewProjection = Camera::MainCamera->getPreviousViewProjection();
+		m_UBOs[frameIndex]->writeToBuffer(&ubo);
+
+		UBOComposition compositionUBO{};
+		compositionUBO.inverseViewProjection = glm::inverse(ubo.proj * ubo.view);
+		compositionUBO.viewPosition = Camera::MainCamera->position;
+
+		// NOTE: Point lights are binned by the light culling pass
+		for (const auto& e : entities) {
+			if (manager.hasComponent<DirectionLight>(e)) {
+				auto& light = manager.getComponent<DirectionLight>(e);
+				compositionUBO.directionLight.color = light.color;
+				compositionUBO.directionLight.direction = light.direction;
+			}
+		}
+
+		m_CompositionUBOs[frameIndex]->writeToBuffer(&compositionUBO);
+
+		if (m_BoundShadowMap != shadowMap) {
+			writeInputDescriptorSet(shadowMap);
+		}
+
+		Viewport viewport{};
+		viewport.width = m_Framebuffer->getWidth();
+		viewport.height = m_Framebuffer->getHeight();
+
+		m_RenderPass->begin(*m_Framebuffer, commandBuffer, viewport);
+
+			// 1. Geometry subpass
+			m_GeometryPipeline->bind(commandBuffer);
+
+			VkDescriptorSet textureDescriptorSet = m_Device.getBindlessTextureSet();
+
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+				m_GeometryPipelineLayout, 0, 1, &m_UBODescriptorSets[frameIndex], 0, nullptr);
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+				m_GeometryPipelineLayout, 1, 1, &textureDescriptorSet, 0, nullptr);
+
+			uint32_t drawCount = 0;
+			m_LODSelector.setView(*Camera::MainCamera, viewport.height);
+
+			// Every model lives in the same buffers, only a change of the index type needs a rebind
+			GeometryStore& geometryStore = m_Device.getGeometryStore();
+			VkIndexType boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+
+			for (const auto& e : entities) {
+				if (!manager.hasComponent<Renderable>(e)) {
+					continue;
+				}
+
+				auto& component = manager.getComponent<Renderable>(e);
+				Model* model = component.model;
+
+				if (!model) {
+					continue;
+				}
+
+				if (model->getIndexType() != boundIndexType) {
+					boundIndexType = model->getIndexType();
+					geometryStore.bind(commandBuffer, boundIndexType);
+				}
+
+				const Transform& transform = manager.getComponent<Transform>(e);
+				std::vector<Mesh>& meshes = model->getMeshes();
+
+				for (uint32_t i = 0; i < meshes.size(); i++) {
+					if (drawCount == MAX_DRAWS) {
+						break;
+					}
+
+					Mesh mesh = meshes[i].getLOD(m_LODSelector.select(e, i, meshes[i], transform));
+
+					DrawData drawData{};
+					drawData.modelMatrix = glm::translate(drawData.modelMatrix, manager.getComponent<Transform>(e).position);
+					drawData.modelMatrix = glm::scale(drawData.modelMatrix, manager.getComponent<Transform>(e).scale);
+
+					std::shared_ptr<Texture2D> diffuseMap = model->getDiffuseMap(mesh.materialIndex);
+					std::shared_ptr<Texture2D> normalMap = model->getNormalMap(mesh.materialIndex);
+
+					glm::vec4 normColor = Color::normalize(component.color);
+					drawData.color = { normColor.r, normColor.g, normColor.b };
+
+					if (diffuseMap) {
+						drawData.diffuseTexIndex = diffuseMap->getImage()->getBindlessIndex();
+					}
+
+					if (normalMap) {
+						drawData.normalMapIndex = normalMap->getImage()->getBindlessIndex();
+					}
+
+					m_DrawBuffers[frameIndex]->writeToBuffer(&drawData, sizeof(DrawData), sizeof(DrawData) * drawCount);
+
+					// The draw index is passed as first instance
+					vkCmdDrawIndexed(commandBuffer, mesh.indices, 1, mesh.baseIndex, mesh.baseVertex, drawCount);
+					drawCount++;
+				}
+			}
+
+			// 2. Lighting subpass, the G-buffer is read from the input attachments
+			m_RenderPass->nextSubpass(commandBuffer);
+			m_LightingPipeline->bind(commandBuffer);
+
+			VkDescriptorSet clusterDescriptorSet = m_LightCullingPass.getDescriptorSet(frameIndex);
+			std::vector<VkDescriptorSet> descriptorSets = {
+				m_InputDescriptorSet,
+				m_CompositionUBODescriptorSets[frameIndex],
+				clusterDescriptorSet
+			};
+
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_LightingPipelineLayout,
+				0, static_cast<uint32_t>(descriptorSets.size()), descriptorSets.data(), 0, nullptr);
+
+			LightingPushConstant lightingPush{};
+			lightingPush.lightSpaceMatrix = lightSpaceMatrix;
+
+			vkCmdPushConstants(
+				commandBuffer,
+				m_LightingPipelineLayout,
+				VK_SHADER_STAGE_FRAGMENT_BIT,
+				0,
+				sizeof(LightingPushConstant),
+				&lightingPush);
+
+			vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+
+		m_RenderPass->end(commandBuffer);
+	}
+
+	void DeferredPass::resize(uint32_t width, uint32_t height) {
+		m_Device.waitForGPU();
+
+		m_Framebuffer->destroy();
+		m_OutputImage->destroy();
+		m_NormalBuffer->destroy();
+		m_AlbedoBuffer->destroy();
+		m_DepthBuffer->destroy();
+
+		createImages(width, height);
+		createFramebuffer(width, height);
+
+		m_BoundShadowMap = nullptr; // rewrites the input attachment descriptors on the next draw
+	}
+
+	void DeferredPass::setShadingQuality(const ShadingQuality& quality) {
+		m_LightingPipeline = &m_LightingPipelines->get(getLightingPermutation(quality));
+	}
+
+	void DeferredPass::createImages(uint32_t width, uint32_t height) {
+		// Output
+		ImageInfo outputImageInfo{};
+		outputImageInfo.width = width;
+		outputImageInfo.height = height;
+		outputImageInfo.depth = 1;
+		outputImageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		outputImageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+
+		// Normals (octahedral encoded)
+		ImageInfo normalImageInfo{};
+		normalImageInfo.width = width;
+		normalImageInfo.height = height;
+		normalImageInfo.depth = 1;
+		normalImageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+		normalImageInfo.format = VK_FORMAT_R16G16_SFLOAT;
+
+		// Albedo + specular intensity
+		ImageInfo albedoImageInfo{};
+		albedoImageInfo.width = width;
+		albedoImageInfo.height = height;
+		albedoImageInfo.depth = 1;
+		albedoImageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+		albedoImageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+
+		// Depth
+		ImageInfo depthImageInfo{};
+		depthImageInfo.width = width;
+		depthImageInfo.height = height;
+		depthImageInfo.depth = 1;
+		depthImageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+		depthImageInfo.format = m_Device.getSupportedDepthFormat();
+
+		m_OutputImage = std::make_unique<Image>(outputImageInfo);
+		m_NormalBuffer = std::make_unique<Image>(normalImageInfo);
+		m_AlbedoBuffer = std::make_unique<Image>(albedoImageInfo);
+		m_DepthBuffer = std::make_unique<Image>(depthImageInfo);
+	}
+
+	void DeferredPass::createRenderpass() {
+		SubpassInfo geometrySubpass{};
+		geometrySubpass.renderTargets = { 1, 2 };
+
+		SubpassInfo lightingSubpass{};
+		lightingSubpass.renderTargets = { 0 };
+		lightingSubpass.subpassInputs = { 3, 1, 2 }; // depth, normal, albedo
+
+		RenderPassAttachment outputAttachment = {
+			m_OutputImage,
+			VK_ATTACHMENT_LOAD_OP_CLEAR,
+			VK_ATTACHMENT_STORE_OP_STORE,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+		};
+
+		// The G-buffer is never stored
+		RenderPassAttachment normalAttachment = {
+			m_NormalBuffer,
+			VK_ATTACHMENT_LOAD_OP_CLEAR,
+			VK_ATTACHMENT_STORE_OP_DONT_CARE,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+		};
+
+		RenderPassAttachment albedoAttachment = {
+			m_AlbedoBuffer,
+			VK_ATTACHMENT_LOAD_OP_CLEAR,
+			VK_ATTACHMENT_STORE_OP_DONT_CARE,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+		};
+
+		RenderPassAttachment depthAttachment = {
+			m_DepthBuffer,
+			VK_ATTACHMENT_LOAD_OP_CLEAR,
+			VK_ATTACHMENT_STORE_OP_DONT_CARE,
+			VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+		};
+
+		std::vector<RenderPassAttachment> attachments = {
+			outputAttachment,
+			normalAttachment,
+			albedoAttachment,
+			depthAttachment
+		};
+
+		RenderPassInfo renderPassInfo = {
+			attachments,
+			{ geometrySubpass, lightingSubpass }
+		};
+
+		m_RenderPass = std::make_unique<RenderPass>(renderPassInfo);
+	}
+
+	void DeferredPass::createFramebuffer(uint32_t width, uint32_t height) {
+		FramebufferInfo framebufferInfo = {
+			width,
+			height,
+			m_RenderPass->getVulkanRenderPass(),
+			{ { m_OutputImage, m_NormalBuffer, m_AlbedoBuffer, m_DepthBuffer } }
+		};
+
+		m_Framebuffer = std::make_unique<Framebuffer>(framebufferInfo);
+	}
+
+	void DeferredPass::createDescriptorPool() {
+		const uint32_t frameCount = GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT;
+
+		m_UBODescriptorSets.resize(frameCount);
+		m_CompositionUBODescriptorSets.resize(frameCount);
+
+		m_DescriptorPool = DescriptorPool::Builder(m_Device)
+			.setMaxSets(frameCount * 2 + 1)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1) // shadow map, textures are bound from the device's bindless set
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, frameCount * 2)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frameCount) // draw data
+			.addPoolSize(VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 3) // depth, normal, albedo
+			.build();
+	}
+
+	void DeferredPass::createBuffers() {
+		const size_t frameCount = GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT;
+
+		m_UBOs.resize(frameCount);
+		m_DrawBuffers.resize(frameCount);
+		m_CompositionUBOs.resize(frameCount);
+
+		for (size_t i = 0; i < frameCount; i++) {
+			m_UBOs[i] = std::make_unique<Buffer>(
+				m_Device,
+				sizeof(UniformBuffer3D),
+				1,
+				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			m_UBOs[i]->map();
+
+			m_DrawBuffers[i] = std::make_unique<Buffer>(
+				m_Device,
+				sizeof(DrawData),
+				MAX_DRAWS,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			m_DrawBuffers[i]->map();
+
+			m_CompositionUBOs[i] = std::make_unique<Buffer>(
+				m_Device,
+				sizeof(UBOComposition),
+				1,
+				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			m_CompositionUBOs[i]->map();
+		}
+	}
+
+	void DeferredPass::createDescriptorSetLayout() {
+		// The geometry subpass uses the G-buffer shaders, textures come from the device's bindless set (set 1)
+		m_GeometryReflection = Shader_Vulkan::reflectFiles({ "assets/shaders/gbuffer.vert.spv", "assets/shaders/gbuffer.frag.spv" });
+		m_UBOSetLayout = &m_Device.getPipelineLayoutCache().getSetLayout(m_GeometryReflection, 0);
+
+		m_LightingReflection = Shader_Vulkan::reflectFiles({ "assets/shaders/deferred.vert.spv", "assets/shaders/deferredSubpass.frag.spv" });
+		m_LightingReflection.merge(m_LightCullingPass.getClusterReflection(CLUSTER_SET));
+		m_InputSetLayout = &m_Device.getPipelineLayoutCache().getSetLayout(m_LightingReflection, 0);
+		m_CompositionUBOSetLayout = &m_Device.getPipelineLayoutCache().getSetLayout(m_LightingReflection, 1);
+
+		for (size_t i = 0; i < m_UBODescriptorSets.size(); i++) {
+			auto bufferInfo = m_UBOs[i]->getDescriptorInfo();
+			auto drawBufferInfo = m_DrawBuffers[i]->getDescriptorInfo();
+			auto compositionBufferInfo = m_CompositionUBOs[i]->getDescriptorInfo();
+
+			DescriptorWriter(*m_UBOSetLayout, *m_DescriptorPool)
+				.writeBuffer(0, &bufferInfo)
+				.writeBuffer(1, &drawBufferInfo)
+				.build(m_UBODescriptorSets[i]);
+
+			DescriptorWriter(*m_CompositionUBOSetLayout, *m_DescriptorPool)
+				.writeBuffer(0, &compositionBufferInfo)
+				.build(m_CompositionUBODescriptorSets[i]);
+		}
+
+		// Written once the shadow map is known
+		DescriptorWriter(*m_InputSetLayout, *m_DescriptorPool)
+			.build(m_InputDescriptorSet);
+	}
+
+	void DeferredPass::createPipelines() {
+		// ------ Geometry Pipeline ------
+		m_GeometryPipelineLayout = m_Device.getPipelineLayoutCache().getPipelineLayout(m_GeometryReflection);
+
+		PipelineConfigInfo geometryConfigInfo{};
+		GraphicsPipeline::defaultPipelineConfigInfo(geometryConfigInfo);
+		geometryConfigInfo.bindingDescriptions = Vertex3D::getBindingDescriptions();
+		geometryConfigInfo.attributeDescriptions = Vertex3D::getAttributeDescriptions();
+		geometryConfigInfo.renderPass = m_RenderPass->getVulkanRenderPass();
+		geometryConfigInfo.pipelineLayout = m_GeometryPipelineLayout;
+		geometryConfigInfo.subpass = 0;
+
+		// Packed G-buffer data must never be blended
+		geometryConfigInfo.colorBlendAttachment.blendEnable = VK_FALSE;
+
+		std::vector<VkPipelineColorBlendAttachmentState> blendStates(2);
+		blendStates[0] = geometryConfigInfo.colorBlendAttachment;
+		blendStates[1] = geometryConfigInfo.colorBlendAttachment;
+
+		geometryConfigInfo.colorBlendInfo.attachmentCount = 2;
+		geometryConfigInfo.colorBlendInfo.pAttachments = blendStates.data();
+
+		m_GeometryPipeline = std::make_unique<GraphicsPipeline>(
+			m_Device,
+			"assets/shaders/gbuffer.vert.spv",
+			"assets/shaders/gbuffer.frag.spv",
+			geometryConfigInfo);
+
+		// ------ Lighting Pipeline ------
+		m_LightingPipelineLayout = m_Device.getPipelineLayoutCache().getPipelineLayout(m_LightingReflection);
+
+		// One variant per shading quality
+		m_LightingPipelines = std::make_unique<PipelinePermutations>(m_Device,
+			"assets/shaders/deferred.vert.spv",
+			"assets/shaders/deferredSubpass.frag.spv",
+			[this](PipelineConfigInfo& lightingConfigInfo) {
+				GraphicsPipeline::defaultPipelineConfigInfo(lightingConfigInfo);
+				lightingConfigInfo.bindingDescriptions = {};
+				lightingConfigInfo.attributeDescriptions = {};
+				lightingConfigInfo.renderPass = m_RenderPass->getVulkanRenderPass();
+				lightingConfigInfo.pipelineLayout = m_LightingPipelineLayout;
+				lightingConfigInfo.subpass = 1;
+				lightingConfigInfo.colorBlendAttachment.blendEnable = VK_FALSE;
+				lightingConfigInfo.depthStencilInfo.depthTestEnable = VK_FALSE; // depth is read as an input attachment
+				lightingConfigInfo.depthStencilInfo.depthWriteEnable = VK_FALSE;
+			});
+	}
+
+	void DeferredPass::createSamplers() {
+		SamplerCreateInfo shadowSamplerInfo{};
+		shadowSamplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+		shadowSamplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		shadowSamplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		shadowSamplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+		m_ShadowSampler = std::make_unique<Sampler>(shadowSamplerInfo, m_Device);
+	}
+
+	void DeferredPass::writeInputDescriptorSet(Image* shadowMap) {
+		VkDescriptorImageInfo depthInfo{};
+		depthInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		depthInfo.imageView = m_DepthBuffer->getVulkanImageView();
+
+		VkDescriptorImageInfo normalInfo{};
+		normalInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		normalInfo.imageView = m_NormalBuffer->getVulkanImageView();
+
+		VkDescriptorImageInfo albedoInfo{};
+		albedoInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		albedoInfo.imageView = m_AlbedoBuffer->getVulkanImageView();
+
+		VkDescriptorImageInfo shadowMapInfo{};
+		shadowMapInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		shadowMapInfo.imageView = shadowMap->getVulkanImageView();
+		shadowMapInfo.sampler = m_ShadowSampler->getVkSampler();
+
+		DescriptorWriter(*m_InputSetLayout, *m_DescriptorPool)
+			.writeImage(0, &depthInfo)
+			.writeImage(1, &normalInfo)
+			.writeImage(2, &albedoInfo)
+			.writeImage(3, &shadowMapInfo)
+			.overwrite(m_InputDescriptorSet);
+
+		m_BoundShadowMap = shadowMap;
+	}
+
+}
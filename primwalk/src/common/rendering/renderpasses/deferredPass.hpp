@@ -0,0 +1,131 @@
+#pragma once
+
+#include "../../../core.hpp"
+#include "../../components/component.hpp"
+#include "../../data/shader.hpp"
+#include "../buffer.hpp"
+#include "../descriptors.hpp"
+#include "../framebuffer.hpp"
+#include "../graphicsDevice_Vulkan.hpp"
+#include "../graphicsPipeline.hpp"
+#include "../image.hpp"
+#include "../lodSelector.hpp"
+#include "../renderpass.hpp"
+#include "../sampler.hpp"
+#include "../shaderPermutation.hpp"
+#include "../texture2D.hpp"
+#include "lightCullingPass.hpp"
+
+#include "../../managers/componentManager.hpp"
+
+// std
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace pw {
+	// Deferred shading in a single render pass: the geometry subpass fills the G-buffer and the lighting subpass
+	// reads it back as input attachments. The G-buffer is transient and never stored, so on tile-based GPUs it
+	// stays in on-chip memory and on desktop the store and reload of the separate passes is skipped.
+	class DeferredPass {
+	public:
+		static constexpr uint32_t MAX_DRAWS = 1u << 16;
+
+		DeferredPass(uint32_t width, uint32_t height, GraphicsDevice_Vulkan& device, LightCullingPass& lightCullingPass,
+			const ShadingQuality& shadingQuality);
+		~DeferredPass();
+
+		void draw(VkCommandBuffer commandBuffer, size_t frameIndex, std::set<entity_id>& entities, ComponentManager& manager,
+			Image* shadowMap, const glm::mat4& lightSpaceMatrix);
+		void resize(uint32_t width, uint32_t height);
+		void setShadingQuality(const ShadingQuality& quality); // the variant is compiled the first time it is selected
+
+		inline Image* getOutputImage() { return m_OutputImage.get(); }
+
+	private:
+		struct DirectionLightParams {
+			alignas(16) glm::vec3 direction{};
+			alignas(16) glm::vec3 color{};
+		};
+
+		struct UniformBuffer3D {
+			alignas(16) glm::mat4 view{ 1.0f };
+			alignas(16) glm::mat4 proj{ 1.0f };
+			alignas(16) glm::mat4 viewProjection{ 1.0f }; // unjittered, for motion vectors
+			alignas(16) glm::mat4 previousViewProjection{ 1.0f };
+		};
+
+		struct UBOComposition {
+			alignas(16) glm::mat4 inverseViewProjection{ 1.0f };
+			alignas(16) glm::vec3 viewPosition{};
+			DirectionLightParams directionLight{};
+		};
+
+		// Same layout as in GBufferPass, both use the G-buffer shaders
+		struct DrawData {
+			alignas(16) glm::mat4 modelMatrix{ 1.0f };
+			alignas(16) glm::vec3 color = { 1.0, 1.0, 1.0 };
+			alignas(4) uint32_t diffuseTexIndex = 0;
+			alignas(4) uint32_t normalMapIndex = 0;
+		};
+
+		struct LightingPushConstant {
+			alignas(16) glm::mat4 lightSpaceMatrix{ 1.0f };
+		};
+
+		static constexpr uint32_t CLUSTER_SET = 2; // NOTE: Must match deferredSubpass.frag
+
+		void createImages(uint32_t width, uint32_t height);
+		void createRenderpass();
+		void createFramebuffer(uint32_t width, uint32_t height);
+		void createDescriptorPool();
+		void createBuffers();
+		void createDescriptorSetLayout();
+		void createPipelines();
+		void createSamplers();
+
+		void writeInputDescriptorSet(Image* shadowMap);
+
+		GraphicsDevice_Vulkan& m_Device;
+		LightCullingPass& m_LightCullingPass;
+
+		std::unique_ptr<RenderPass> m_RenderPass;
+		std::unique_ptr<Framebuffer> m_Framebuffer;
+		std::unique_ptr<Image> m_OutputImage;
+
+		// Transient G-buffer (position is reconstructed from depth)
+		std::unique_ptr<Image> m_NormalBuffer;
+		std::unique_ptr<Image> m_AlbedoBuffer;
+		std::unique_ptr<Image> m_DepthBuffer;
+
+		std::unique_ptr<GraphicsPipeline> m_GeometryPipeline;
+		std::unique_ptr<PipelinePermutations> m_LightingPipelines;
+		GraphicsPipeline* m_LightingPipeline = nullptr; // variant of the current shading quality
+		VkPipelineLayout m_GeometryPipelineLayout = VK_NULL_HANDLE;
+		VkPipelineLayout m_LightingPipelineLayout = VK_NULL_HANDLE;
+
+		// Reflected from the shaders, layouts are owned by the device's PipelineLayoutCache
+		ShaderReflection m_GeometryReflection{};
+		ShaderReflection m_LightingReflection{};
+		std::unique_ptr<DescriptorPool> m_DescriptorPool;
+
+		// Geometry subpass
+		DescriptorSetLayout* m_UBOSetLayout = nullptr;
+		std::vector<VkDescriptorSet> m_UBODescriptorSets;
+		std::vector<std::unique_ptr<Buffer>> m_UBOs;
+		std::vector<std::unique_ptr<Buffer>> m_DrawBuffers;
+		LODSelector m_LODSelector;
+
+		// Lighting subpass
+		DescriptorSetLayout* m_InputSetLayout = nullptr;
+		VkDescriptorSet m_InputDescriptorSet = VK_NULL_HANDLE;
+		Image* m_BoundShadowMap = nullptr;
+
+		DescriptorSetLayout* m_CompositionUBOSetLayout = nullptr;
+		std::vector<VkDescriptorSet> m_CompositionUBODescriptorSets;
+		std::vector<std::unique_ptr<Buffer>> m_CompositionUBOs;
+
+		std::unique_ptr<Sampler> m_ShadowSampler;
+	};
+}
@@ -0,0 +1,322 @@
+#include "forwardPass.hpp"
+#include "../geometryStore.hpp"
+#include "../pipelineLayoutCache.hpp"
+#include "../vertex3d.hpp"
+#include "../../components/camera.hpp"
+#include "../../components/directionLight.hpp"
+#include "../../components/renderable.hpp"
+#include "../../components/transform.hpp"
+#include "../../data/model.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace pw {
+
+	ForwardPass::ForwardPass(uint32_t width, uint32_t height, GraphicsDevice_Vulkan& device, LightCullingPass& lightCullingPass,
+		const ShadingQuality& shadingQuality) : m_Device(device), m_LightCullingPass(lightCullingPass) {
+		createImages(width, height);
+		createRenderpass();
+		createFramebuffer(width, height);
+		createDescriptorPool();
+		createBuffers();
+		createDescriptorSetLayout();
+		createPipelines();
+		setShadingQuality(shadingQuality);
+		createSamplers();
+	}
+
+	ForwardPass::~ForwardPass() {
+		m_Framebuffer->destroy();
+		m_ColorImage->destroy();
+		m_DepthImage->destroy();
+	}
+
+	void ForwardPass::draw(VkCommandBuffer commandBuffer, size_t frameIndex, std::set<entity_id>& entities, ComponentManager& manager,
+		Image* shadowMap, const glm::mat4& lightSpaceMatrix) {
+
+		UniformBufferForward ubo{};
+		ubo.view = Camera::MainCamera->getViewMatrix();
+		ubo.proj = Camera::MainCamera->getProjectionMatrix();
+		ubo.lightSpaceMatrix = lightSpaceMatrix;
+		ubo.viewPosition = Camera::MainCamera->position;
+		ubo.invScreenSize = 1.0f / glm::vec2(m_Framebuffer->getWidth(), m_Framebuffer->getHeight());
+
+		// NOTE: Point lights are binned by the light culling pass
+		for (const auto& e : entities) {
+			if (manager.hasComponent<DirectionLight>(e)) {
+				auto& light = manager.getComponent<DirectionLight>(e);
+				ubo.directionLight.color = light.color;
+				ubo.directionLight.direction = light.direction;
+			}
+		}
+
+		m_UBOs[frameIndex]->writeToBuffer(&ubo);
+
+		// The shadow map is created once by the shadow pass, so the descriptor only has to be written once
+		if (m_ShadowDescriptorSet == VK_NULL_HANDLE) {
+			VkDescriptorImageInfo shadowMapInfo{};
+			shadowMapInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+			shadowMapInfo.imageView = shadowMap->getVulkanImageView();
+			shadowMapInfo.sampler = m_ShadowSampler->getVkSampler();
+
+			DescriptorWriter(*m_ShadowSetLayout, *m_DescriptorPool)
+				.writeImage(0, &shadowMapInfo)
+				.build(m_ShadowDescriptorSet);
+		}
+
+		Viewport viewport{};
+		viewport.width = m_Framebuffer->getWidth();
+		viewport.height = m_Framebuffer->getHeight();
+
+		m_RenderPass->begin(*m_Framebuffer, commandBuffer, viewport);
+
+			VkDescriptorSet clusterDescriptorSet = m_LightCullingPass.getDescriptorSet(frameIndex);
+			std::vector<VkDescriptorSet> descriptorSets = {
+				m_UBODescriptorSets[frameIndex],
+				m_Device.getBindlessTextureSet(),
+				m_ShadowDescriptorSet,
+				clusterDescriptorSet
+			};
+
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout,
+				0, static_cast<uint32_t>(descriptorSets.size()), descriptorSets.data(), 0, nullptr);
+
+			// Both passes draw the same levels, selection is stable within a frame
+			m_LODSelector.setView(*Camera::MainCamera, viewport.height);
+
+			// 1. Depth pre-pass
+			m_DepthPrepassPipeline->bind(commandBuffer);
+			drawEntities(commandBuffer, entities, manager);
+
+			// 2. Shading, only the closest surface passes the depth test
+			m_ShadingPipeline->bind(commandBuffer);
+			drawEntities(commandBuffer, entities, manager);
+
+		m_RenderPass->end(commandBuffer);
+	}
+
+	void ForwardPass::resize(uint32_t width, uint32_t height) {
+		m_Device.waitForGPU();
+
+		m_Framebuffer->destroy();
+		m_ColorImage->destroy();
+		m_DepthImage->destroy();
+
+		createImages(width, height);
+		createFramebuffer(width, height);
+	}
+
+	void ForwardPass::setShadingQuality(const ShadingQuality& quality) {
+		m_ShadingPipeline = &m_ShadingPipelines->get(getLightingPermutation(quality));
+	}
+
+	void ForwardPass::drawEntities(VkCommandBuffer commandBuffer, std::set<entity_id>& entities, ComponentManager& manager) {
+		// Every model lives in the same buffers, only a change of the index type needs a rebind
+		GeometryStore& geometryStore = m_Device.getGeometryStore();
+		VkIndexType boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+
+		for (const auto& e : entities) {
+			if (!manager.hasComponent<Renderable>(e)) {
+				continue;
+			}
+
+			auto& component = manager.getComponent<Renderable>(e);
+			Model* model = component.model;
+
+			if (!model) {
+				continue;
+			}
+
+			if (model->getIndexType() != boundIndexType) {
+				boundIndexType = model->getIndexType();
+				geometryStore.bind(commandBuffer, boundIndexType);
+			}
+
+			const Transform& transform = manager.getComponent<Transform>(e);
+			std::vector<Mesh>& meshes = model->getMeshes();
+
+			for (uint32_t i = 0; i < meshes.size(); i++) {
+				Mesh mesh = meshes[i].getLOD(m_LODSelector.select(e, i, meshes[i], transform));
+
+				ModelPushConstant push{};
+				push.modelMatrix = glm::translate(push.modelMatrix, manager.getComponent<Transform>(e).position);
+				push.modelMatrix = glm::scale(push.modelMatrix, manager.getComponent<Transform>(e).scale);
+
+				std::shared_ptr<Texture2D> diffuseMap = model->getDiffuseMap(mesh.materialIndex);
+				std::shared_ptr<Texture2D> normalMap = model->getNormalMap(mesh.materialIndex);
+
+				glm::vec4 normColor = Color::normalize(component.color);
+				push.color = { normColor.r, normColor.g, normColor.b };
+
+				if (diffuseMap) {
+					push.diffuseTexIndex = diffuseMap->getImage()->getBindlessIndex();
+				}
+
+				if (normalMap) {
+					push.normalMapIndex = normalMap->getImage()->getBindlessIndex();
+				}
+
+				vkCmdPushConstants(
+					commandBuffer,
+					m_PipelineLayout,
+					VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+					0,
+					sizeof(ModelPushConstant),
+					&push);
+
+				vkCmdDrawIndexed(commandBuffer, mesh.indices, 1, mesh.baseIndex, mesh.baseVertex, 0);
+			}
+		}
+	}
+
+	void ForwardPass::createImages(uint32_t width, uint32_t height) {
+		// Color
+		ImageInfo colorImageInfo{};
+		colorImageInfo.width = width;
+		colorImageInfo.height = height;
+		colorImageInfo.depth = 1;
+		colorImageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		colorImageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+
+		// Depth
+		ImageInfo depthImageInfo{};
+		depthImageInfo.width = width;
+		depthImageInfo.height = height;
+		depthImageInfo.depth = 1;
+		depthImageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		depthImageInfo.format = m_Device.getSupportedDepthFormat();
+
+		m_ColorImage = std::make_unique<Image>(colorImageInfo);
+		m_DepthImage = std::make_unique<Image>(depthImageInfo);
+	}
+
+	void ForwardPass::createRenderpass() {
+		SubpassInfo subpass{};
+		subpass.renderTargets = { 0 };
+
+		RenderPassAttachment colorAttachment = {
+			m_ColorImage,
+			VK_ATTACHMENT_LOAD_OP_CLEAR,
+			VK_ATTACHMENT_STORE_OP_STORE,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+		};
+
+		RenderPassAttachment depthAttachment = {
+			m_DepthImage,
+			VK_ATTACHMENT_LOAD_OP_CLEAR,
+			VK_ATTACHMENT_STORE_OP_DONT_CARE,
+			VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+		};
+
+		std::vector<RenderPassAttachment> attachments = {
+			colorAttachment,
+			depthAttachment
+		};
+
+		RenderPassInfo renderPassInfo = {
+			attachments,
+			{ subpass }
+		};
+
+		m_RenderPass = std::make_unique<RenderPass>(renderPassInfo);
+	}
+
+	void ForwardPass::createFramebuffer(uint32_t width, uint32_t height) {
+		FramebufferInfo framebufferInfo = {
+			width,
+			height,
+			m_RenderPass->getVulkanRenderPass(),
+			{ { m_ColorImage, m_DepthImage } }
+		};
+
+		m_Framebuffer = std::make_unique<Framebuffer>(framebufferInfo);
+	}
+
+	void ForwardPass::createDescriptorPool() {
+		m_UBODescriptorSets.resize(GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT);
+
+		m_DescriptorPool = DescriptorPool::Builder(m_Device)
+			.setMaxSets(GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT + 1)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1) // shadow map, textures are bound from the device's bindless set
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT) // UBO
+			.build();
+	}
+
+	void ForwardPass::createBuffers() {
+		m_UBOs.resize(GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT);
+
+		for (auto& ubo : m_UBOs) {
+			ubo = std::make_unique<Buffer>(
+				m_Device,
+				sizeof(UniformBufferForward),
+				1,
+				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+			ubo->map();
+		}
+	}
+
+	void ForwardPass::createDescriptorSetLayout() {
+		// Textures come from the device's bindless set (set 1), the clusters from the light culling pass
+		m_Reflection = Shader_Vulkan::reflectFiles({ "assets/shaders/forward.vert.spv", "assets/shaders/forward.frag.spv" });
+		m_Reflection.merge(m_LightCullingPass.getClusterReflection(CLUSTER_SET));
+
+		m_UBOSetLayout = &m_Device.getPipelineLayoutCache().getSetLayout(m_Reflection, 0);
+		m_ShadowSetLayout = &m_Device.getPipelineLayoutCache().getSetLayout(m_Reflection, 2);
+
+		for (size_t i = 0; i < m_UBODescriptorSets.size(); i++) {
+			auto bufferInfo = m_UBOs[i]->getDescriptorInfo();
+
+			DescriptorWriter(*m_UBOSetLayout, *m_DescriptorPool)
+				.writeBuffer(0, &bufferInfo)
+				.build(m_UBODescriptorSets[i]);
+		}
+	}
+
+	void ForwardPass::createPipelines() {
+		// Pipeline layout, shared by the depth pre-pass whose vertex stage declares a subset of it
+		m_PipelineLayout = m_Device.getPipelineLayoutCache().getPipelineLayout(m_Reflection);
+
+		// Depth pre-pass pipeline (vertex stage only, no color writes)
+		PipelineConfigInfo depthConfigInfo{};
+		GraphicsPipeline::defaultPipelineConfigInfo(depthConfigInfo);
+		depthConfigInfo.bindingDescriptions = Vertex3D::getBindingDescriptions();
+		depthConfigInfo.attributeDescriptions = Vertex3D::getAttributeDescriptions();
+		depthConfigInfo.renderPass = m_RenderPass->getVulkanRenderPass();
+		depthConfigInfo.pipelineLayout = m_PipelineLayout;
+		depthConfigInfo.colorBlendAttachment.colorWriteMask = 0;
+		depthConfigInfo.colorBlendAttachment.blendEnable = VK_FALSE;
+
+		m_DepthPrepassPipeline = GraphicsPipeline::Builder(m_Device, depthConfigInfo)
+			.addStage(VK_SHADER_STAGE_VERTEX_BIT, "assets/shaders/forward.vert.spv")
+			.build();
+
+		// Shading pipeline, depth is already resolved so only test against it
+		// One variant per shading quality
+		m_ShadingPipelines = std::make_unique<PipelinePermutations>(m_Device,
+			"assets/shaders/forward.vert.spv",
+			"assets/shaders/forward.frag.spv",
+			[this](PipelineConfigInfo& shadingConfigInfo) {
+				GraphicsPipeline::defaultPipelineConfigInfo(shadingConfigInfo);
+				shadingConfigInfo.bindingDescriptions = Vertex3D::getBindingDescriptions();
+				shadingConfigInfo.attributeDescriptions = Vertex3D::getAttributeDescriptions();
+				shadingConfigInfo.renderPass = m_RenderPass->getVulkanRenderPass();
+				shadingConfigInfo.pipelineLayout = m_PipelineLayout;
+				shadingConfigInfo.colorBlendAttachment.blendEnable = VK_FALSE;
+				shadingConfigInfo.depthStencilInfo.depthWriteEnable = VK_FALSE;
+				shadingConfigInfo.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+			});
+	}
+
+	void ForwardPass::createSamplers() {
+		SamplerCreateInfo shadowSamplerInfo{};
+		shadowSamplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+		shadowSamplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		shadowSamplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		shadowSamplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+		m_ShadowSampler = std::make_unique<Sampler>(shadowSamplerInfo, m_Device);
+	}
+
+}
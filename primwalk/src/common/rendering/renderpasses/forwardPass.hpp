@@ -0,0 +1,106 @@
+#pragma once
+
+#include "../../../core.hpp"
+#include "../../components/component.hpp"
+#include "../../data/shader.hpp"
+#include "../buffer.hpp"
+#include "../descriptors.hpp"
+#include "../framebuffer.hpp"
+#include "../graphicsDevice_Vulkan.hpp"
+#include "../graphicsPipeline.hpp"
+#include "../image.hpp"
+#include "../lodSelector.hpp"
+#include "../renderpass.hpp"
+#include "../sampler.hpp"
+#include "../shaderPermutation.hpp"
+#include "../texture2D.hpp"
+#include "lightCullingPass.hpp"
+
+#include "../../managers/componentManager.hpp"
+
+// std
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace pw {
+	// Forward+ alternative to the G-buffer and lighting passes. A depth-only pre-pass lays down the depth buffer,
+	// after which every visible pixel is shaded exactly once with the per-cluster light lists of the light culling pass.
+	// Only a color and a depth target are ever written, which saves a lot of bandwidth compared to the G-buffer.
+	class ForwardPass {
+	public:
+		ForwardPass(uint32_t width, uint32_t height, GraphicsDevice_Vulkan& device, LightCullingPass& lightCullingPass,
+			const ShadingQuality& shadingQuality);
+		~ForwardPass();
+
+		void draw(VkCommandBuffer commandBuffer, size_t frameIndex, std::set<entity_id>& entities, ComponentManager& manager,
+			Image* shadowMap, const glm::mat4& lightSpaceMatrix);
+		void resize(uint32_t width, uint32_t height);
+		void setShadingQuality(const ShadingQuality& quality); // the variant is compiled the first time it is selected
+
+		inline Image* getOutputImage() { return m_ColorImage.get(); }
+
+	private:
+		struct DirectionLightParams {
+			alignas(16) glm::vec3 direction{};
+			alignas(16) glm::vec3 color{};
+		};
+
+		struct UniformBufferForward {
+			alignas(16) glm::mat4 view{ 1.0f };
+			alignas(16) glm::mat4 proj{ 1.0f };
+			alignas(16) glm::mat4 lightSpaceMatrix{ 1.0f };
+			alignas(16) glm::vec3 viewPosition{};
+			DirectionLightParams directionLight{};
+			alignas(8) glm::vec2 invScreenSize{};
+		};
+
+		struct ModelPushConstant {
+			alignas(16) glm::mat4 modelMatrix{ 1.0f };
+			alignas(16) glm::vec3 color = { 1.0, 1.0, 1.0 };
+			alignas(4) uint32_t diffuseTexIndex = 0;
+			alignas(4) uint32_t normalMapIndex = 0;
+		};
+
+		static constexpr uint32_t CLUSTER_SET = 3; // NOTE: Must match forward.frag
+
+		void createImages(uint32_t width, uint32_t height);
+		void createRenderpass();
+		void createFramebuffer(uint32_t width, uint32_t height);
+		void createDescriptorPool();
+		void createBuffers();
+		void createDescriptorSetLayout();
+		void createPipelines();
+		void createSamplers();
+
+		void drawEntities(VkCommandBuffer commandBuffer, std::set<entity_id>& entities, ComponentManager& manager);
+
+		GraphicsDevice_Vulkan& m_Device;
+		LightCullingPass& m_LightCullingPass;
+
+		std::unique_ptr<RenderPass> m_RenderPass;
+		std::unique_ptr<Framebuffer> m_Framebuffer;
+		std::unique_ptr<Image> m_ColorImage;
+		std::unique_ptr<Image> m_DepthImage;
+
+		std::unique_ptr<GraphicsPipeline> m_DepthPrepassPipeline;
+		std::unique_ptr<PipelinePermutations> m_ShadingPipelines;
+		GraphicsPipeline* m_ShadingPipeline = nullptr; // variant of the current shading quality
+		VkPipelineLayout m_PipelineLayout = VK_NULL_HANDLE;
+		LODSelector m_LODSelector;
+
+		// Reflected from the shaders, layouts are owned by the device's PipelineLayoutCache
+		ShaderReflection m_Reflection{};
+		std::unique_ptr<DescriptorPool> m_DescriptorPool;
+
+		std::vector<VkDescriptorSet> m_UBODescriptorSets;
+		DescriptorSetLayout* m_UBOSetLayout = nullptr;
+		std::vector<std::unique_ptr<Buffer>> m_UBOs;
+
+		DescriptorSetLayout* m_ShadowSetLayout = nullptr;
+		VkDescriptorSet m_ShadowDescriptorSet = VK_NULL_HANDLE;
+
+		std::unique_ptr<Sampler> m_ShadowSampler;
+	};
+}
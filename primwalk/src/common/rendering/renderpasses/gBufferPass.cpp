@@ -1,8 +1,11 @@
 #include "gBufferPass.hpp"
 
 #include "../../components/camera.hpp"
+#include "../commandRecorder.hpp"
+#include "../geometryStore.hpp"
+#include "../pipelineLayoutCache.hpp"
 #include "../vertex3d.hpp"
-#include <stdexcept>
+#include <algorithm>
 
 #include <glm/gtc/matrix_transform.hpp>
 #include "../../components/directionLight.hpp"
@@ -12,99 +15,171 @@
 
 namespace pw {
 
-	GBufferPass::GBufferPass(uint32_t width, uint32_t height, GraphicsDevice_Vulkan& device) : m_Device(device) {
+	GBufferPass::GBufferPass(uint32_t width, uint32_t height, GraphicsDevice_Vulkan& device, bool motionVectors) :
+		m_Device(device), m_MotionVectors(motionVectors) {
 		createImages(width, height);
 		createRenderPasses();
 		createFramebuffers(width, height);
+		setRenderSize(width, height);
 
 		createDescriptorPool();
 		createBuffers();
 		createDescriptorSetLayout();
 		createPipelineLayouts();
 		createPipelines();
-		createSamplers();
 
-		// Textures
-		m_Textures.push_back(std::make_shared<Texture2D>(1, 1, std::vector<uint8_t>(4, 255).data())); // default 1x1 white texture
-		addTexture(m_Textures[0]->getImage());
-
-		//// TODO: Move cubemap code to separate class (HDRI should also be separate)
-		//m_Textures.push_back(std::make_shared<Texture2D>("assets/textures/cubemaps/skybox_default.hdr", 4, VK_FORMAT_R16G16B16A16_SFLOAT));
-		//addTexture(m_Textures[1]->getImage());
+		// Dense meshes are culled per meshlet, which needs the draw count to come from the GPU
+		if (m_Device.hasDrawIndirectCount()) {
+			m_MeshletCulling = std::make_unique<MeshletCullingPass>(m_Device);
+		}
 	}
 
 	GBufferPass::~GBufferPass() {
-		vkDestroyPipelineLayout(m_Device.getDevice(), m_GBufferPipelineLayout, nullptr);
-
 		m_DeferredFramebuffer->destroy();
-		m_PositionBuffer->destroy();
 		m_NormalBuffer->destroy();
 		m_AlbedoBuffer->destroy();
-		m_SpecularBuffer->destroy();
 		m_DeferredDepthBuffer->destroy();
+
+		if (m_MotionBuffer) {
+			m_MotionBuffer->destroy();
+		}
 	}
 
-	void GBufferPass::draw(VkCommandBuffer commandBuffer, size_t frameIndex, ComponentManager& manager) {
+	void GBufferPass::draw(VkCommandBuffer commandBuffer, size_t frameIndex, std::set<entity_id>& entities, ComponentManager& manager) {
 		UniformBuffer3D ubo{};
 		ubo.view = Camera::MainCamera->getViewMatrix();
 		ubo.proj = Camera::MainCamera->getProjectionMatrix();
+		ubo.viewProjection = Camera::MainCamera->getUnjitteredViewProjection();
+		ubo.previousViewProjection = Camera::MainCamera->getPreviousViewProjection();
 		m_UBOs[frameIndex]->writeToBuffer(&ubo);
 
 		Viewport viewport{};
-		viewport.width = m_DeferredFramebuffer->getWidth();
-		viewport.height = m_DeferredFramebuffer->getHeight();
+		viewport.width = static_cast<float>(m_RenderWidth);
+		viewport.height = static_cast<float>(m_RenderHeight);
 
-		// Geometry pass
-		m_GeometryPass->begin(*m_DeferredFramebuffer, commandBuffer, viewport);
+		// Resolve everything touching shared state up front, the draws are recorded on multiple threads
+		m_DrawCommands.clear();
+		m_DrawData.clear();
+		m_LODSelector.setView(*Camera::MainCamera, static_cast<float>(m_RenderHeight));
 
-			m_GBufferPipeline->bind(commandBuffer);
+		if (m_MeshletCulling) {
+			m_MeshletCulling->begin();
+		}
+
+		for (const auto& e : entities) {
+			auto& component = manager.getComponent<Renderable>(e);
+			Model* model = component.model;
 
-			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-				m_GBufferPipelineLayout, 0, 1, &m_UniformDescriptorSets[frameIndex], 0, nullptr);
-			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-				m_GBufferPipelineLayout, 1, 1, &m_TextureDescriptorSet, 0, nullptr);
+			if (!model) { // render default cube model
+				//drawDebugBox(manager.getComponent<Transform>(e).position, glm::vec3(1.0f));
+				continue;
+			}
 
-			for (const auto& e : m_Entities) {
-				auto& component = manager.getComponent<Renderable>(e);
-				Model* model = component.model;
+			const Transform& transform = manager.getComponent<Transform>(e);
+			std::vector<Mesh>& meshes = model->getMeshes();
 
-				if (!model) { // render default cube model
-					//drawDebugBox(manager.getComponent<Transform>(e).position, glm::vec3(1.0f));
-					continue;
+			for (uint32_t i = 0; i < meshes.size(); i++) {
+				if (m_DrawCommands.size() == MAX_DRAWS) {
+					break;
 				}
 
-				model->bind(commandBuffer);
+				const uint32_t lod = m_LODSelector.select(e, i, meshes[i], transform);
+				Mesh mesh = meshes[i].getLOD(lod);
 
-				for (const auto& mesh : model->getMeshes()) {
-					ModelPushConstant push{};
-					push.modelMatrix = glm::translate(push.modelMatrix, manager.getComponent<Transform>(e).position);
-					push.modelMatrix = glm::scale(push.modelMatrix, manager.getComponent<Transform>(e).scale);
+				DrawData drawData{};
+				drawData.modelMatrix = glm::translate(drawData.modelMatrix, manager.getComponent<Transform>(e).position);
+				drawData.modelMatrix = glm::scale(drawData.modelMatrix, manager.getComponent<Transform>(e).scale);
 
-					std::shared_ptr<Texture2D> diffuseMap = model->getDiffuseMap(mesh.materialIndex);
-					std::shared_ptr<Texture2D> normalMap = model->getNormalMap(mesh.materialIndex);
+				std::shared_ptr<Texture2D> diffuseMap = model->getDiffuseMap(mesh.materialIndex);
+				std::shared_ptr<Texture2D> normalMap = model->getNormalMap(mesh.materialIndex);
 
-					glm::vec4 normColor = Color::normalize(component.color);
-					push.color = { normColor.r, normColor.g, normColor.b };
+				glm::vec4 normColor = Color::normalize(component.color);
+				drawData.color = { normColor.r, normColor.g, normColor.b };
 
-					if (diffuseMap) {
-						push.diffuseTexIndex = addTexture(diffuseMap->getImage());
-					}
+				if (diffuseMap) {
+					drawData.diffuseTexIndex = diffuseMap->getImage()->getBindlessIndex();
+				}
 
-					if (normalMap) {
-						push.normalMapIndex = addTexture(normalMap->getImage());
-					}
+				if (normalMap) {
+					drawData.normalMapIndex = normalMap->getImage()->getBindlessIndex();
+				}
 
-					vkCmdPushConstants(
-						commandBuffer,
-						m_GBufferPipelineLayout,
-						VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-						0,
-						sizeof(ModelPushConstant),
-						&push);
+				// Meshlets only cover the full detail level
+				uint32_t cullDraw = MeshletCullingPass::INVALID_DRAW;
+				const uint32_t drawIndex = static_cast<uint32_t>(m_DrawCommands.size());
 
-					vkCmdDrawIndexed(commandBuffer, mesh.indices, 1, mesh.baseIndex, mesh.baseVertex, 0);
+				if (m_MeshletCulling && lod == 0) {
+					cullDraw = m_MeshletCulling->addDraw(*model, mesh, drawData.modelMatrix, transform.scale, drawIndex);
 				}
+
+				m_DrawData.push_back(drawData);
+				m_DrawCommands.push_back({ model, mesh, cullDraw });
 			}
+		}
+
+		if (!m_DrawData.empty()) {
+			m_DrawBuffers[frameIndex]->writeToBuffer(m_DrawData.data(), sizeof(DrawData) * m_DrawData.size());
+		}
+
+		// Recorded before the render pass begins, the dispatch cannot be part of it
+		if (m_MeshletCulling) {
+			m_MeshletCulling->dispatch(commandBuffer, frameIndex, ubo.proj * ubo.view, Camera::MainCamera->position);
+		}
+
+		// Only the draw list, the render area and the geometry buffers are baked into the commands, the rest is read from buffers
+		GeometryStore& geometryStore = m_Device.getGeometryStore();
+		uint64_t contentVersion = CommandCache::combine(m_RenderWidth, m_RenderHeight);
+		contentVersion = CommandCache::combine(contentVersion, geometryStore.getGeneration());
+
+		for (const auto& draw : m_DrawCommands) {
+			contentVersion = CommandCache::combine(contentVersion, draw.model->getIndexType());
+			contentVersion = CommandCache::combine(contentVersion, (static_cast<uint64_t>(draw.mesh.indices) << 32) | draw.mesh.baseIndex);
+			contentVersion = CommandCache::combine(contentVersion, draw.mesh.baseVertex);
+			contentVersion = CommandCache::combine(contentVersion, draw.cullDraw);
+		}
+
+		// Geometry pass
+		m_GeometryPass->begin(*m_DeferredFramebuffer, commandBuffer, viewport, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+			ParallelRecordInfo recordInfo = {
+				*m_GeometryPass,
+				*m_DeferredFramebuffer,
+				viewport
+			};
+			recordInfo.itemCount = static_cast<uint32_t>(m_DrawCommands.size());
+			recordInfo.cache = &m_CommandCache;
+			recordInfo.contentVersion = contentVersion;
+
+			VkDescriptorSet textureDescriptorSet = m_Device.getBindlessTextureSet();
+
+			m_Device.getCommandRecorder().record(commandBuffer, recordInfo, [&](VkCommandBuffer secondary, uint32_t first, uint32_t last) {
+				m_GBufferPipeline->bind(secondary);
+
+				vkCmdBindDescriptorSets(secondary, VK_PIPELINE_BIND_POINT_GRAPHICS,
+					m_GBufferPipelineLayout, 0, 1, &m_UniformDescriptorSets[frameIndex], 0, nullptr);
+				vkCmdBindDescriptorSets(secondary, VK_PIPELINE_BIND_POINT_GRAPHICS,
+					m_GBufferPipelineLayout, 1, 1, &textureDescriptorSet, 0, nullptr);
+
+				// Every model lives in the same buffers, only a change of the index type needs a rebind
+				VkIndexType boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+
+				for (uint32_t i = first; i < last; i++) {
+					const DrawCommand& draw = m_DrawCommands[i];
+
+					if (draw.model->getIndexType() != boundIndexType) {
+						boundIndexType = draw.model->getIndexType();
+						geometryStore.bind(secondary, boundIndexType);
+					}
+
+					// The draw index is passed as first instance, the culled commands carry it as well
+					if (draw.cullDraw != MeshletCullingPass::INVALID_DRAW) {
+						m_MeshletCulling->drawIndirect(secondary, frameIndex, draw.cullDraw);
+					}
+					else {
+						vkCmdDrawIndexed(secondary, draw.mesh.indices, 1, draw.mesh.baseIndex, draw.mesh.baseVertex, i);
+					}
+				}
+			});
 
 		m_GeometryPass->end(commandBuffer);
 	}
@@ -113,38 +188,41 @@ namespace pw {
 		m_Device.waitForGPU();
 
 		m_DeferredFramebuffer->destroy();
-		m_PositionBuffer->destroy();
 		m_NormalBuffer->destroy();
 		m_AlbedoBuffer->destroy();
-		m_SpecularBuffer->destroy();
 		m_DeferredDepthBuffer->destroy();
 
+		if (m_MotionBuffer) {
+			m_MotionBuffer->destroy();
+		}
+
 		//m_ComposedFramebuffer->destroy();
 		//m_ComposedImage->destroy();
 
 		createImages(width, height);
 		createFramebuffers(width, height);
+		setRenderSize(width, height);
+
+		// The new framebuffer might get the handle of the old one
+		m_CommandCache.invalidate();
+	}
+
+	void GBufferPass::setRenderSize(uint32_t width, uint32_t height) {
+		m_RenderWidth = std::max(std::min(width, m_DeferredFramebuffer->getWidth()), 1u);
+		m_RenderHeight = std::max(std::min(height, m_DeferredFramebuffer->getHeight()), 1u);
 	}
 
 	void GBufferPass::createImages(uint32_t width, uint32_t height) {
 		// ------ G-Buffer Images ------
-		// Position
-		ImageInfo positionImageInfo{};
-		positionImageInfo.width = width;
-		positionImageInfo.height = height;
-		positionImageInfo.depth = 1;
-		positionImageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-		positionImageInfo.format = VK_FORMAT_R16G16B16A16_SFLOAT;
-
-		// Normals
+		// Normals (octahedral encoded)
 		ImageInfo normalImageInfo{};
 		normalImageInfo.width = width;
 		normalImageInfo.height = height;
 		normalImageInfo.depth = 1;
 		normalImageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-		normalImageInfo.format = VK_FORMAT_R16G16B16A16_SFLOAT;
+		normalImageInfo.format = VK_FORMAT_R16G16_SFLOAT;
 
-		// Albedo
+		// Albedo + specular intensity
 		ImageInfo albedoImageInfo{};
 		albedoImageInfo.width = width;
 		albedoImageInfo.height = height;
@@ -152,27 +230,29 @@ namespace pw {
 		albedoImageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 		albedoImageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
 
-		// Specular
-		ImageInfo specularImageInfo{};
-		specularImageInfo.width = width;
-		specularImageInfo.height = height;
-		specularImageInfo.depth = 1;
-		specularImageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-		specularImageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
-
-		// Depth
+		// Depth (sampled by the lighting pass to reconstruct positions)
 		ImageInfo depthImageInfo{};
 		depthImageInfo.width = width;
 		depthImageInfo.height = height;
 		depthImageInfo.depth = 1;
-		depthImageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		depthImageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 		depthImageInfo.format = m_Device.getSupportedDepthFormat();
 
-		m_PositionBuffer = std::make_unique<Image>(positionImageInfo);
 		m_NormalBuffer = std::make_unique<Image>(normalImageInfo);
 		m_AlbedoBuffer = std::make_unique<Image>(albedoImageInfo);
-		m_SpecularBuffer = std::make_unique<Image>(specularImageInfo);
 		m_DeferredDepthBuffer = std::make_unique<Image>(depthImageInfo);
+
+		// Motion vectors (only needed for temporal upsampling)
+		if (m_MotionVectors) {
+			ImageInfo motionImageInfo{};
+			motionImageInfo.width = width;
+			motionImageInfo.height = height;
+			motionImageInfo.depth = 1;
+			motionImageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+			motionImageInfo.format = VK_FORMAT_R16G16_SFLOAT;
+
+			m_MotionBuffer = std::make_unique<Image>(motionImageInfo);
+		}
 	}
 
 	void GBufferPass::createRenderPasses() {
@@ -181,13 +261,6 @@ namespace pw {
 		subpass.renderTargets = { 0 };
 
 		// ------ G-Buffer Render Pass ------
-		RenderPassAttachment positionAttachment = {
-			m_PositionBuffer,
-			VK_ATTACHMENT_LOAD_OP_CLEAR,
-			VK_ATTACHMENT_STORE_OP_STORE,
-			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		};
-
 		RenderPassAttachment normalAttachment = {
 			m_NormalBuffer,
 			VK_ATTACHMENT_LOAD_OP_CLEAR,
@@ -202,9 +275,9 @@ namespace pw {
 			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
 		};
 
-		RenderPassAttachment specularAttachment = {
-			m_SpecularBuffer,
-			VK_ATTACHMENT_LOAD_OP_CLEAR,
+		RenderPassAttachment motionAttachment = {
+			m_MotionBuffer,
+			VK_ATTACHMENT_LOAD_OP_CLEAR, // cleared to zero motion
 			VK_ATTACHMENT_STORE_OP_STORE,
 			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
 		};
@@ -212,18 +285,21 @@ namespace pw {
 		RenderPassAttachment deferredDepthAttachment = {
 			m_DeferredDepthBuffer,
 			VK_ATTACHMENT_LOAD_OP_CLEAR,
-			VK_ATTACHMENT_STORE_OP_DONT_CARE,
-			VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+			VK_ATTACHMENT_STORE_OP_STORE,
+			VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
 		};
 
 		std::vector<RenderPassAttachment> deferredAttachments = {
-			positionAttachment,
 			normalAttachment,
-			albedoAttachment,
-			specularAttachment,
-			deferredDepthAttachment
+			albedoAttachment
 		};
 
+		if (m_MotionVectors) {
+			deferredAttachments.push_back(motionAttachment);
+		}
+
+		deferredAttachments.push_back(deferredDepthAttachment);
+
 		RenderPassInfo geometryPassInfo = {
 			deferredAttachments,
 			{ subpass }
@@ -234,19 +310,22 @@ namespace pw {
 
 	void GBufferPass::createFramebuffers(uint32_t width, uint32_t height) {
 		// Deferred framebuffer
+		std::vector<std::reference_wrapper<std::unique_ptr<Image>>> attachments = {
+			m_NormalBuffer,
+			m_AlbedoBuffer
+		};
+
+		if (m_MotionVectors) {
+			attachments.push_back(m_MotionBuffer);
+		}
+
+		attachments.push_back(m_DeferredDepthBuffer);
+
 		FramebufferInfo deferredInfo = {
 			width,
 			height,
 			m_GeometryPass->getVulkanRenderPass(),
-			{
-				{
-					m_PositionBuffer,
-					m_NormalBuffer,
-					m_AlbedoBuffer,
-					m_SpecularBuffer,
-					m_DeferredDepthBuffer
-				}
-			}
+			attachments
 		};
 
 		m_DeferredFramebuffer = std::make_unique<Framebuffer>(deferredInfo);
@@ -270,55 +349,42 @@ namespace pw {
 
 			ubo->map();
 		}
+
+		// Draw data
+		m_DrawBuffers.resize(GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT);
+
+		for (auto& drawBuffer : m_DrawBuffers) {
+			drawBuffer = std::make_unique<Buffer>(
+				m_Device,
+				sizeof(DrawData),
+				MAX_DRAWS,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+			drawBuffer->map();
+		}
 	}
 
 	void GBufferPass::createDescriptorSetLayout() {
 		// Descriptor set layouts
-		m_UBOSetLayout = DescriptorSetLayout::Builder(m_Device)
-			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT)
-			.build();
+		m_Reflection = Shader_Vulkan::reflectFiles({ "assets/shaders/gbuffer.vert.spv", "assets/shaders/gbuffer.frag.spv" });
+		m_UBOSetLayout = &m_Device.getPipelineLayoutCache().getSetLayout(m_Reflection, 0);
 
-		m_TextureSetLayout = DescriptorSetLayout::Builder(m_Device)
-			.setLayoutFlags(VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT)
-			.addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1024,
-				VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT)
-			.build();
-
-		// Main UBO
+		// Main UBO + draw data
 		for (size_t i = 0; i < m_UniformDescriptorSets.size(); i++) {
 			auto bufferInfo = m_UBOs[i]->getDescriptorInfo();
+			auto drawBufferInfo = m_DrawBuffers[i]->getDescriptorInfo();
 
 			DescriptorWriter(*m_UBOSetLayout, m_Device.getBindlessPool())
 				.writeBuffer(0, &bufferInfo)
+				.writeBuffer(1, &drawBufferInfo)
 				.build(m_UniformDescriptorSets[i]);
 		}
-
-		DescriptorWriter(*m_TextureSetLayout, m_Device.getBindlessPool())
-			.build(m_TextureDescriptorSet);
-
-		m_MainDescriptorSetLayouts = {
-			m_UBOSetLayout->getDescriptorSetLayout(),
-			m_TextureSetLayout->getDescriptorSetLayout()
-		};
 	}
 
 	void GBufferPass::createPipelineLayouts() {
-		// Main pipeline layout
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof(ModelPushConstant);
-
-		VkPipelineLayoutCreateInfo basePipelineLayoutInfo{};
-		basePipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		basePipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(m_MainDescriptorSetLayouts.size());
-		basePipelineLayoutInfo.pSetLayouts = m_MainDescriptorSetLayouts.data();
-		basePipelineLayoutInfo.pushConstantRangeCount = 1;
-		basePipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
-
-		if (vkCreatePipelineLayout(m_Device.getDevice(), &basePipelineLayoutInfo, nullptr, &m_GBufferPipelineLayout) != VK_SUCCESS) {
-			throw std::runtime_error("VULKAN ERROR: Failed to create pipeline layout!");
-		}
+		// Per-draw data comes from the draw buffer, textures from the device's bindless set (set 1)
+		m_GBufferPipelineLayout = m_Device.getPipelineLayoutCache().getPipelineLayout(m_Reflection);
 	}
 
 	void GBufferPass::createPipelines() {
@@ -331,13 +397,12 @@ namespace pw {
 		gBufferPipelineConfig.renderPass = m_GeometryPass->getVulkanRenderPass();
 		gBufferPipelineConfig.pipelineLayout = m_GBufferPipelineLayout;
 
-		std::vector<VkPipelineColorBlendAttachmentState> blendStates(4);
-		blendStates[0] = gBufferPipelineConfig.colorBlendAttachment;
-		blendStates[1] = gBufferPipelineConfig.colorBlendAttachment;
-		blendStates[2] = gBufferPipelineConfig.colorBlendAttachment;
-		blendStates[3] = gBufferPipelineConfig.colorBlendAttachment;
+		// Packed G-buffer data must never be blended
+		gBufferPipelineConfig.colorBlendAttachment.blendEnable = VK_FALSE;
+
+		std::vector<VkPipelineColorBlendAttachmentState> blendStates(m_MotionVectors ? 3 : 2, gBufferPipelineConfig.colorBlendAttachment);
 
-		gBufferPipelineConfig.colorBlendInfo.attachmentCount = 4;
+		gBufferPipelineConfig.colorBlendInfo.attachmentCount = static_cast<uint32_t>(blendStates.size());
 		gBufferPipelineConfig.colorBlendInfo.pAttachments = blendStates.data();
 
 		m_GBufferPipeline = std::make_unique<GraphicsPipeline>(
@@ -347,56 +412,4 @@ namespace pw {
 			gBufferPipelineConfig);
 	}
 
-	void GBufferPass::createSamplers() {
-		SamplerCreateInfo samplerInfo{};
-		m_Sampler = std::make_unique<Sampler>(samplerInfo, m_Device);
-	}
-
-	uint32_t GBufferPass::addTexture(Image* image) {
-		auto idSearch = m_TextureIDs.find(image);
-
-		if (idSearch == m_TextureIDs.end()) { // texture is not associated with any ID yet
-			uint32_t id = m_TextureIDs.size();
-
-			if (!m_VacantTextureIDs.empty()) {
-				id = *m_VacantTextureIDs.begin(); // get the lowest vacant ID
-				m_VacantTextureIDs.erase(m_VacantTextureIDs.begin());
-			}
-
-			VkDescriptorImageInfo imageInfo{};
-			imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			imageInfo.imageView = image->getVulkanImageView();
-			imageInfo.sampler = m_Sampler->getVkSampler();
-
-			DescriptorWriter(*m_TextureSetLayout, m_Device.getBindlessPool())
-				.writeImage(0, &imageInfo, id)
-				.overwrite(m_TextureDescriptorSet);
-
-			m_TextureIDs.insert({ image, id });
-			return id;
-		}
-
-		return idSearch->second;
-	}
-
-	void GBufferPass::freeTextureID(Image* image) {
-		//auto idSearch = m_TextureIDs.find(image);
-
-		//if (idSearch == m_TextureIDs.end()) { // texture has no ID, can not free ID
-		//	return;
-		//}
-
-		//// Clear the image from the texture descriptor
-		//VkDescriptorImageInfo imageInfo{};
-		//imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		//imageInfo.imageView = m_Textures[0]->getImageView(); // default 1x1 white texture
-		//imageInfo.sampler = Renderer::m_TextureSampler;
-
-		//DescriptorWriter(*m_TextureSetLayout, m_Device.getBindlessPool())
-		//	.writeImage(0, &imageInfo, idSearch->second)
-		//	.overwrite(m_TextureDescriptorSet);
-
-		//m_VacantTextureIDs.emplace(idSearch->second);
-		//m_TextureIDs.erase(image);
-	}
 }
\ No newline at end of file
@@ -2,12 +2,17 @@
 
 #include "../../../core.hpp"
 #include "../../components/component.hpp"
+#include "../../data/mesh.hpp"
+#include "../../data/shader.hpp"
 #include "../buffer.hpp"
+#include "../commandRecorder.hpp"
 #include "../graphicsDevice_Vulkan.hpp"
 #include "../graphicsPipeline.hpp"
+#include "../lodSelector.hpp"
 #include "../renderpass.hpp"
 #include "../sampler.hpp"
 #include "../texture2D.hpp"
+#include "meshletCullingPass.hpp"
 
 #include "../../managers/componentManager.hpp"
 
@@ -16,33 +21,50 @@
 #include <set>
 
 namespace pw {
+	// Forward declarations
+	class Model;
+
 	class GBufferPass {
 	public:
-		GBufferPass(uint32_t width, uint32_t height, GraphicsDevice_Vulkan& device);
+		static constexpr uint32_t MAX_DRAWS = 1u << 16;
+
+		GBufferPass(uint32_t width, uint32_t height, GraphicsDevice_Vulkan& device, bool motionVectors = false);
 		~GBufferPass();
 
-		void draw(VkCommandBuffer commandBuffer, size_t frameIndex, ComponentManager& manager);
+		void draw(VkCommandBuffer commandBuffer, size_t frameIndex, std::set<entity_id>& entities, ComponentManager& manager);
 		void resize(uint32_t width, uint32_t height);
+		void setRenderSize(uint32_t width, uint32_t height); // renders into the top-left part of the targets, no reallocation
 
-		inline Image* getPositionBuffer() { return m_PositionBuffer.get(); }
+		inline Image* getDepthBuffer() { return m_DeferredDepthBuffer.get(); }
 		inline Image* getNormalBuffer() { return m_NormalBuffer.get(); }
 		inline Image* getAlbedoBuffer() { return m_AlbedoBuffer.get(); }
-
-		std::set<entity_id> m_Entities;
+		inline Image* getMotionBuffer() { return m_MotionBuffer.get(); } // nullptr unless motion vectors are enabled
+		inline uint32_t getRenderWidth() const { return m_RenderWidth; }
+		inline uint32_t getRenderHeight() const { return m_RenderHeight; }
+		inline MeshletCullingPass* getMeshletCulling() { return m_MeshletCulling.get(); } // nullptr without draw indirect count support
 
 	private:
 		struct UniformBuffer3D {
 			alignas(16) glm::mat4 view{ 1.0f };
 			alignas(16) glm::mat4 proj{ 1.0f };
+			alignas(16) glm::mat4 viewProjection{ 1.0f }; // unjittered, for motion vectors
+			alignas(16) glm::mat4 previousViewProjection{ 1.0f };
 		};
 
-		struct ModelPushConstant {
+		// Per draw, indexed by the first instance so the recorded commands do not depend on it
+		struct DrawData {
 			alignas(16) glm::mat4 modelMatrix{ 1.0f };
 			alignas(16) glm::vec3 color = { 1.0, 1.0, 1.0 };
 			alignas(4) uint32_t diffuseTexIndex = 0;
 			alignas(4) uint32_t normalMapIndex = 0;
 		};
 
+		struct DrawCommand {
+			Model* model = nullptr;
+			Mesh mesh{};
+			uint32_t cullDraw = MeshletCullingPass::INVALID_DRAW; // drawn directly if invalid
+		};
+
 		void createImages(uint32_t width, uint32_t height);
 		void createRenderPasses();
 		void createFramebuffers(uint32_t width, uint32_t height);
@@ -51,42 +73,36 @@ namespace pw {
 		void createDescriptorSetLayout();
 		void createPipelineLayouts();
 		void createPipelines();
-		void createSamplers();
-
-		uint32_t addTexture(Image* image);
-		void freeTextureID(Image* image);
 
 		GraphicsDevice_Vulkan& m_Device;
-		
-		std::vector<VkDescriptorSetLayout> m_MainDescriptorSetLayouts;
-
-		
-		std::unordered_map<Image*, uint32_t> m_TextureIDs{};
-		std::set<uint32_t> m_VacantTextureIDs{};
 
 		std::vector<std::unique_ptr<Buffer>> m_UBOs;
+		std::vector<std::unique_ptr<Buffer>> m_DrawBuffers; // per frame in flight
+		std::vector<DrawCommand> m_DrawCommands; // rebuilt every frame, kept to reuse the allocation
+		std::vector<DrawData> m_DrawData;
+		CommandCache m_CommandCache;
+		LODSelector m_LODSelector;
+		std::unique_ptr<MeshletCullingPass> m_MeshletCulling;
 
-		// TODO: Bindless resources might fit better in a dedicated scene class
-		std::unique_ptr<DescriptorSetLayout> m_UBOSetLayout{};
-		std::unique_ptr<DescriptorSetLayout> m_TextureSetLayout{};
-
-		std::vector<std::shared_ptr<Texture2D>> m_Textures;
+		// Reflected from the shaders, owned by the device's PipelineLayoutCache
+		ShaderReflection m_Reflection{};
+		DescriptorSetLayout* m_UBOSetLayout = nullptr;
 
 		// Deferred render passes
 		std::unique_ptr<RenderPass> m_GeometryPass;
 
-		// G-Buffer
+		// G-Buffer (position is reconstructed from depth)
 		std::unique_ptr<Framebuffer> m_DeferredFramebuffer;
-		std::unique_ptr<Image> m_PositionBuffer;
-		std::unique_ptr<Image> m_AlbedoBuffer;
-		std::unique_ptr<Image> m_NormalBuffer;
-		std::unique_ptr<Image> m_SpecularBuffer;
+		uint32_t m_RenderWidth = 0;
+		uint32_t m_RenderHeight = 0;
+		std::unique_ptr<Image> m_AlbedoBuffer; // alpha holds the specular intensity
+		std::unique_ptr<Image> m_NormalBuffer; // octahedral encoded
+		std::unique_ptr<Image> m_MotionBuffer; // screen-space motion in UV units, for temporal upsampling
 		std::unique_ptr<Image> m_DeferredDepthBuffer;
+		bool m_MotionVectors = false;
 		std::unique_ptr<GraphicsPipeline> m_GBufferPipeline;
 		VkPipelineLayout m_GBufferPipelineLayout = VK_NULL_HANDLE;
 
 		std::vector<VkDescriptorSet> m_UniformDescriptorSets;
-		VkDescriptorSet m_TextureDescriptorSet;
-		std::unique_ptr<Sampler> m_Sampler;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,268 @@
+#include "lightCullingPass.hpp"
+#include "../../components/camera.hpp"
+#include "../../components/pointLight.hpp"
+#include "../../components/transform.hpp"
+#include "../pipelineLayoutCache.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace pw {
+
+	LightCullingPass::LightCullingPass(GraphicsDevice_Vulkan& device) : m_Device(device) {
+		createDescriptorPool();
+		createBuffers();
+		createDescriptorSetLayout();
+		createPipeline();
+	}
+
+	void LightCullingPass::dispatch(VkCommandBuffer commandBuffer, size_t frameIndex, std::set<entity_id>& entities, ComponentManager& manager) {
+		// The in-flight fence for this frame index has been waited on, so the results of its previous use are available
+		ClusterStats* gpuStats = static_cast<ClusterStats*>(m_StatsBuffers[frameIndex]->getMappedMemory());
+		m_Stats.lightCount = m_SubmittedLightCounts[frameIndex];
+		m_Stats.visibleLightIndices = gpuStats->visibleLightIndices;
+		m_Stats.activeClusters = gpuStats->activeClusters;
+		m_Stats.maxLightsPerCluster = gpuStats->maxLightsPerCluster;
+		m_Stats.overflowedClusters = gpuStats->overflowedClusters;
+
+		// Gather point lights
+		m_Lights.clear();
+
+		for (const auto& e : entities) {
+			if (manager.hasComponent<PointLight>(e)) {
+				auto& light = manager.getComponent<PointLight>(e);
+				const float maxChannel = std::max({ light.color.r, light.color.g, light.color.b });
+				const float intensity = maxChannel * light.color.w;
+
+				// Attenuation is inverse square, so intensity / d^2 = cutoff gives the radius of influence
+				PointLightParams params{};
+				params.positionRadius = glm::vec4(
+					manager.getComponent<Transform>(e).position,
+					std::sqrt(std::max(intensity, 0.0f) / LIGHT_INFLUENCE_CUTOFF));
+				params.color = light.color;
+
+				m_Lights.push_back(params);
+			}
+		}
+
+		const uint32_t lightCount = static_cast<uint32_t>(m_Lights.size());
+		reserveLights(frameIndex, lightCount);
+
+		if (lightCount > 0) {
+			m_LightBuffers[frameIndex]->writeToBuffer(m_Lights.data(), sizeof(PointLightParams) * lightCount);
+		}
+
+		m_SubmittedLightCounts[frameIndex] = lightCount;
+
+		auto& camera = Camera::MainCamera;
+
+		ClusterParams params{};
+		params.view = camera->getViewMatrix();
+		params.inverseProjection = glm::inverse(camera->getProjectionMatrix());
+		params.gridSize = { CLUSTER_GRID_X, CLUSTER_GRID_Y, CLUSTER_GRID_Z, lightCount };
+		params.zNear = camera->nearClip;
+		params.zFar = camera->farClip;
+		m_ParamsUBOs[frameIndex]->writeToBuffer(&params);
+
+		// Reset statistics
+		vkCmdFillBuffer(commandBuffer, m_StatsBuffers[frameIndex]->getBuffer(), 0, VK_WHOLE_SIZE, 0);
+
+		VkMemoryBarrier fillBarrier{};
+		fillBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		fillBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		fillBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0,
+			1, &fillBarrier,
+			0, nullptr,
+			0, nullptr);
+
+		// Cull lights
+		m_Pipeline->bind(commandBuffer);
+
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+			m_PipelineLayout, 0, 1, &m_ClusterDescriptorSets[frameIndex], 0, nullptr);
+
+		m_Pipeline->dispatch(commandBuffer, (CLUSTER_COUNT + 127) / 128); // NOTE: Local size of 128
+
+		// Make the statistics visible to the host, the render graph orders the light grid before the shading passes
+		VkBufferMemoryBarrier statsBarrier{};
+		statsBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		statsBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		statsBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		statsBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		statsBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		statsBarrier.buffer = m_StatsBuffers[frameIndex]->getBuffer();
+		statsBarrier.offset = 0;
+		statsBarrier.size = VK_WHOLE_SIZE;
+
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_HOST_BIT,
+			0,
+			0, nullptr,
+			1, &statsBarrier,
+			0, nullptr);
+	}
+
+	void LightCullingPass::reserveLights(size_t frameIndex, uint32_t lightCount) {
+		if (lightCount <= m_LightCapacities[frameIndex]) {
+			return;
+		}
+
+		uint32_t capacity = m_LightCapacities[frameIndex];
+		while (capacity < lightCount) {
+			capacity *= 2;
+		}
+
+		// Safe to release, the previous submission using this frame index has completed
+		m_LightBuffers[frameIndex] = std::make_unique<Buffer>(
+			m_Device,
+			sizeof(PointLightParams),
+			capacity,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			1,
+			true); // read on the async compute and the graphics queue
+
+		m_LightBuffers[frameIndex]->map();
+		m_LightCapacities[frameIndex] = capacity;
+
+		writeDescriptorSet(frameIndex, true);
+	}
+
+	void LightCullingPass::writeDescriptorSet(size_t frameIndex, bool overwrite) {
+		auto paramsInfo = m_ParamsUBOs[frameIndex]->getDescriptorInfo();
+		auto lightsInfo = m_LightBuffers[frameIndex]->getDescriptorInfo();
+		auto gridInfo = m_LightGridBuffers[frameIndex]->getDescriptorInfo();
+		auto indicesInfo = m_LightIndexBuffers[frameIndex]->getDescriptorInfo();
+		auto statsInfo = m_StatsBuffers[frameIndex]->getDescriptorInfo();
+
+		DescriptorWriter writer(*m_ClusterSetLayout, *m_DescriptorPool);
+		writer.writeBuffer(0, &paramsInfo)
+			.writeBuffer(1, &lightsInfo)
+			.writeBuffer(2, &gridInfo)
+			.writeBuffer(3, &indicesInfo)
+			.writeBuffer(4, &statsInfo);
+
+		if (overwrite) {
+			writer.overwrite(m_ClusterDescriptorSets[frameIndex]);
+		}
+		else {
+			writer.build(m_ClusterDescriptorSets[frameIndex]);
+		}
+	}
+
+	void LightCullingPass::createDescriptorPool() {
+		m_ClusterDescriptorSets.resize(GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT);
+
+		m_DescriptorPool = DescriptorPool::Builder(m_Device)
+			.setMaxSets(GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT * 4)
+			.build();
+	}
+
+	void LightCullingPass::createBuffers() {
+		const size_t frameCount = GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT;
+
+		m_ParamsUBOs.resize(frameCount);
+		m_LightBuffers.resize(frameCount);
+		m_LightCapacities.resize(frameCount, INITIAL_LIGHT_CAPACITY);
+		m_LightGridBuffers.resize(frameCount);
+		m_LightIndexBuffers.resize(frameCount);
+		m_StatsBuffers.resize(frameCount);
+		m_SubmittedLightCounts.resize(frameCount, 0);
+
+		for (size_t i = 0; i < frameCount; i++) {
+			m_ParamsUBOs[i] = std::make_unique<Buffer>(
+				m_Device,
+				sizeof(ClusterParams),
+				1,
+				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				1,
+				true); // read on the async compute and the graphics queue
+			m_ParamsUBOs[i]->map();
+
+			m_LightBuffers[i] = std::make_unique<Buffer>(
+				m_Device,
+				sizeof(PointLightParams),
+				INITIAL_LIGHT_CAPACITY,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				1,
+				true); // read on the async compute and the graphics queue
+			m_LightBuffers[i]->map();
+
+			// uvec2(offset, count) per cluster
+			m_LightGridBuffers[i] = std::make_unique<Buffer>(
+				m_Device,
+				sizeof(glm::uvec2),
+				CLUSTER_COUNT,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			m_LightIndexBuffers[i] = std::make_unique<Buffer>(
+				m_Device,
+				sizeof(uint32_t),
+				CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			m_StatsBuffers[i] = std::make_unique<Buffer>(
+				m_Device,
+				sizeof(ClusterStats),
+				1,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			m_StatsBuffers[i]->map();
+
+			ClusterStats emptyStats{};
+			m_StatsBuffers[i]->writeToBuffer(&emptyStats);
+		}
+	}
+
+	ShaderReflection LightCullingPass::getClusterReflection(uint32_t set) const {
+		ShaderReflection reflection{};
+		reflection.bindings = m_Reflection.bindings;
+
+		for (auto& binding : reflection.bindings) {
+			binding.set = set;
+		}
+
+		return reflection;
+	}
+
+	void LightCullingPass::createDescriptorSetLayout() {
+		// The shading passes read the clusters in their fragment shaders (see lighting.glsl), so the set is visible
+		// there as well. Merging getClusterReflection() into their reflections then yields this very set layout.
+		m_Reflection = Shader_Vulkan::reflectFiles({ "assets/shaders/clusterCulling.comp.spv" });
+
+		for (auto& binding : m_Reflection.bindings) {
+			binding.stages |= VK_SHADER_STAGE_FRAGMENT_BIT;
+		}
+
+		m_ClusterSetLayout = &m_Device.getPipelineLayoutCache().getSetLayout(m_Reflection, 0);
+
+		for (size_t i = 0; i < m_ClusterDescriptorSets.size(); i++) {
+			writeDescriptorSet(i, false);
+		}
+	}
+
+	void LightCullingPass::createPipeline() {
+		m_PipelineLayout = m_Device.getPipelineLayoutCache().getPipelineLayout(m_Reflection);
+
+		m_Pipeline = std::make_unique<ComputePipeline>(
+			m_Device,
+			"assets/shaders/clusterCulling.comp.spv",
+			m_PipelineLayout
+		);
+	}
+
+}
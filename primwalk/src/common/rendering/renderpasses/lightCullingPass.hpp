@@ -0,0 +1,107 @@
+#pragma once
+
+#include "../graphicsDevice_Vulkan.hpp"
+#include "../buffer.hpp"
+#include "../computePipeline.hpp"
+#include "../descriptors.hpp"
+#include "../../data/shader.hpp"
+#include "../../components/component.hpp"
+#include "../../managers/componentManager.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <vector>
+
+namespace pw {
+	// The light culling pass bins every point light in the scene into a 3D grid of view-space clusters ("froxels").
+	// Slices along the depth axis are distributed exponentially so that clusters stay roughly cubic, which means
+	// the lighting pass only has to evaluate the handful of lights that actually reach the cluster of a given pixel.
+	class LightCullingPass {
+	public:
+		struct Stats {
+			uint32_t lightCount = 0;
+			uint32_t visibleLightIndices = 0; // sum of all per-cluster light counts
+			uint32_t activeClusters = 0;
+			uint32_t maxLightsPerCluster = 0;
+			uint32_t overflowedClusters = 0; // clusters that had more than MAX_LIGHTS_PER_CLUSTER lights
+		};
+
+		LightCullingPass(GraphicsDevice_Vulkan& device);
+		~LightCullingPass() = default;
+
+		void dispatch(VkCommandBuffer commandBuffer, size_t frameIndex, std::set<entity_id>& entities, ComponentManager& manager);
+
+		inline DescriptorSetLayout& getDescriptorSetLayout() { return *m_ClusterSetLayout; }
+		ShaderReflection getClusterReflection(uint32_t set) const; // merged into the reflections of the shading passes
+		inline VkDescriptorSet getDescriptorSet(size_t frameIndex) const { return m_ClusterDescriptorSets[frameIndex]; }
+		inline std::vector<VkBuffer> getClusterBuffers(size_t frameIndex) const { // the light grid and index list read by the shading passes, the host written buffers are shared concurrently
+			return { m_LightGridBuffers[frameIndex]->getBuffer(), m_LightIndexBuffers[frameIndex]->getBuffer() };
+		}
+
+		/* Statistics of the most recently completed frame using the given frame index */
+		inline const Stats& getStats() const { return m_Stats; }
+
+		static constexpr uint32_t CLUSTER_GRID_X = 16;
+		static constexpr uint32_t CLUSTER_GRID_Y = 9;
+		static constexpr uint32_t CLUSTER_GRID_Z = 24;
+		static constexpr uint32_t CLUSTER_COUNT = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+		static constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 128; // NOTE: Must match clusterCulling.comp
+		static constexpr uint32_t INITIAL_LIGHT_CAPACITY = 1024;
+
+		// Lights contribute nothing beyond the distance where their attenuated intensity falls below this value
+		static constexpr float LIGHT_INFLUENCE_CUTOFF = 0.005f;
+
+	private:
+		struct PointLightParams {
+			alignas(16) glm::vec4 positionRadius{}; // xyz = world position, w = radius of influence
+			alignas(16) glm::vec4 color{}; // w component holds intensity
+		};
+
+		struct ClusterParams {
+			alignas(16) glm::mat4 view{ 1.0f };
+			alignas(16) glm::mat4 inverseProjection{ 1.0f };
+			alignas(16) glm::uvec4 gridSize{}; // w component holds the point light count
+			alignas(4) float zNear = 0.0f;
+			alignas(4) float zFar = 0.0f;
+		};
+
+		struct ClusterStats {
+			uint32_t visibleLightIndices = 0;
+			uint32_t activeClusters = 0;
+			uint32_t maxLightsPerCluster = 0;
+			uint32_t overflowedClusters = 0;
+		};
+
+		void createDescriptorPool();
+		void createBuffers();
+		void createDescriptorSetLayout();
+		void createPipeline();
+
+		void reserveLights(size_t frameIndex, uint32_t lightCount);
+		void writeDescriptorSet(size_t frameIndex, bool overwrite);
+
+		GraphicsDevice_Vulkan& m_Device;
+
+		std::unique_ptr<ComputePipeline> m_Pipeline;
+		VkPipelineLayout m_PipelineLayout = VK_NULL_HANDLE;
+
+		std::unique_ptr<DescriptorPool> m_DescriptorPool;
+		ShaderReflection m_Reflection{}; // layouts are owned by the device's PipelineLayoutCache
+		DescriptorSetLayout* m_ClusterSetLayout = nullptr;
+		std::vector<VkDescriptorSet> m_ClusterDescriptorSets;
+
+		std::vector<std::unique_ptr<Buffer>> m_ParamsUBOs;
+		std::vector<std::unique_ptr<Buffer>> m_LightBuffers;
+		std::vector<uint32_t> m_LightCapacities;
+		std::vector<std::unique_ptr<Buffer>> m_LightGridBuffers;
+		std::vector<std::unique_ptr<Buffer>> m_LightIndexBuffers;
+		std::vector<std::unique_ptr<Buffer>> m_StatsBuffers;
+		std::vector<uint32_t> m_SubmittedLightCounts;
+
+		std::vector<PointLightParams> m_Lights{};
+		Stats m_Stats{};
+	};
+}
@@ -1,21 +1,23 @@
 #include "lightingPass.hpp"
 #include "../../components/camera.hpp"
 #include "../../components/directionLight.hpp"
-#include "../../components/pointLight.hpp"
-#include "../../components/transform.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 
 namespace pw {
 
-	LightingPass::LightingPass(uint32_t width, uint32_t height, GraphicsDevice_Vulkan& device) : m_Device(device) {
+	LightingPass::LightingPass(uint32_t width, uint32_t height, GraphicsDevice_Vulkan& device, LightCullingPass& lightCullingPass,
+		const ShadingQuality& shadingQuality) : m_Device(device), m_LightCullingPass(lightCullingPass) {
 		createImages(width, height);
 		createRenderpass();
 		createFramebuffer(width, height);
+		setRenderSize(width, height);
 		createDescriptorPool();
 		createBuffers();
 		createDescriptorSetLayout();
 		createPipeline();
+		setShadingQuality(shadingQuality);
 		createSampler();
 	}
 
@@ -27,24 +29,14 @@ namespace pw {
 	}
 
 	void LightingPass::draw(VkCommandBuffer commandBuffer, size_t frameIndex, std::set<entity_id>& entities, ComponentManager& manager,
-		Image* positionBuffer, Image* normalBuffer, Image* albedoBuffer, Image* shadowMap, const glm::mat4& lightSpaceMatrix) {
+		Image* depthBuffer, Image* normalBuffer, Image* albedoBuffer, Image* shadowMap, const glm::mat4& lightSpaceMatrix) {
 
 		UBOComposition ubo{};
+		ubo.inverseViewProjection = glm::inverse(Camera::MainCamera->getProjectionMatrix() * Camera::MainCamera->getViewMatrix());
 		ubo.viewPosition = Camera::MainCamera->position;
 
-		uint32_t lightIndex = 0;
+		// NOTE: Point lights are binned by the light culling pass
 		for (const auto& e : entities) {
-			if (manager.hasComponent<PointLight>(e)) {
-				auto& light = manager.getComponent<PointLight>(e);
-				ubo.pointLights[lightIndex].position = manager.getComponent<Transform>(e).position;
-				ubo.pointLights[lightIndex].color = light.color;
-
-				ubo.pointLights[lightIndex].position = ubo.pointLights[lightIndex].position;
-				ubo.pointLights[lightIndex].color = ubo.pointLights[lightIndex].color;
-
-				lightIndex++;
-			}
-
 			if (manager.hasComponent<DirectionLight>(e)) {
 				auto& light = manager.getComponent<DirectionLight>(e);
 				ubo.directionLight.color = light.color;
@@ -52,12 +44,11 @@ namespace pw {
 			}
 		}
 
-		ubo.numPointLights = lightIndex;
 		m_CompositionUBOs[frameIndex]->writeToBuffer(&ubo);
 
 		Viewport viewport{};
-		viewport.width = m_CompositionFramebuffer->getWidth();
-		viewport.height = m_CompositionFramebuffer->getHeight();
+		viewport.width = static_cast<float>(m_RenderWidth);
+		viewport.height = static_cast<float>(m_RenderHeight);
 
 		m_LightingPass->begin(*m_CompositionFramebuffer, commandBuffer, viewport);
 		m_CompositionPipeline->bind(commandBuffer);
@@ -67,10 +58,14 @@ namespace pw {
 		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
 			m_CompositionPipelineLayout, 1, 1, &m_CompositionUBODescriptorSets[frameIndex], 0, nullptr);
 
-		VkDescriptorImageInfo positionImageInfo{};
-		positionImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		positionImageInfo.imageView = positionBuffer->getVulkanImageView();
-		positionImageInfo.sampler = m_Sampler->getVkSampler();
+		VkDescriptorSet clusterDescriptorSet = m_LightCullingPass.getDescriptorSet(frameIndex);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+			m_CompositionPipelineLayout, 2, 1, &clusterDescriptorSet, 0, nullptr);
+
+		VkDescriptorImageInfo depthImageInfo{};
+		depthImageInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		depthImageInfo.imageView = depthBuffer->getVulkanImageView();
+		depthImageInfo.sampler = m_Sampler->getVkSampler();
 
 		VkDescriptorImageInfo normalImageInfo{};
 		normalImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
@@ -88,11 +83,10 @@ namespace pw {
 		shadowMapInfo.sampler = m_ShadowSampler->getVkSampler();
 
 		DescriptorWriter(*m_GBufferSetLayout, *m_GBufferDescriptorPool)
-			.writeImage(0, &positionImageInfo)
+			.writeImage(0, &depthImageInfo)
 			.writeImage(1, &normalImageInfo)
 			.writeImage(2, &albedoImageInfo)
-			// TODO: Specular buffer
-			.writeImage(4, &shadowMapInfo)
+			.writeImage(3, &shadowMapInfo)
 			.overwrite(m_GBufferDescriptorSet);
 
 		// Push constants
@@ -120,6 +114,16 @@ namespace pw {
 
 		createImages(width, height);
 		createFramebuffer(width, height);
+		setRenderSize(width, height);
+	}
+
+	void LightingPass::setShadingQuality(const ShadingQuality& quality) {
+		m_CompositionPipeline = &m_CompositionPipelines->get(getLightingPermutation(quality));
+	}
+
+	void LightingPass::setRenderSize(uint32_t width, uint32_t height) {
+		m_RenderWidth = std::max(std::min(width, m_CompositionFramebuffer->getWidth()), 1u);
+		m_RenderHeight = std::max(std::min(height, m_CompositionFramebuffer->getHeight()), 1u);
 	}
 
 	void LightingPass::createImages(uint32_t width, uint32_t height) {
@@ -209,18 +213,18 @@ namespace pw {
 		// Composition
 		m_GBufferSetLayout = DescriptorSetLayout::Builder(m_Device)
 			.setLayoutFlags(VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT)
-			.addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1, VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) // position buffer
+			.addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1, VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) // depth buffer
 			.addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1, VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) // normal buffer
 			.addBinding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1, VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) // albedo buffer
-			.addBinding(3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1, VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) // specular buffer
-			.addBinding(4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1, VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) // shadow map
+			.addBinding(3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1, VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) // shadow map
 			.build();
 
 		DescriptorWriter(*m_GBufferSetLayout, *m_GBufferDescriptorPool).build(m_GBufferDescriptorSet);
 
 		m_DescriptorSetLayouts = {
 			m_GBufferSetLayout->getDescriptorSetLayout(),
-			m_CompositionUBOSetLayout->getDescriptorSetLayout()
+			m_CompositionUBOSetLayout->getDescriptorSetLayout(),
+			m_LightCullingPass.getDescriptorSetLayout().getDescriptorSetLayout()
 		};
 	}
 
@@ -243,20 +247,17 @@ namespace pw {
 			throw std::runtime_error("VULKAN ERROR: Failed to create deferred pipeline layout!");
 		}
 
-		// Pipeline
-		PipelineConfigInfo configInfo{};
-		GraphicsPipeline::defaultPipelineConfigInfo(configInfo);
-		configInfo.bindingDescriptions = {};
-		configInfo.attributeDescriptions = {};
-		configInfo.renderPass = m_LightingPass->getVulkanRenderPass();
-		configInfo.pipelineLayout = m_CompositionPipelineLayout;
-
-		m_CompositionPipeline = std::make_unique<GraphicsPipeline>(
-			m_Device,
+		// Pipeline, one variant per shading quality
+		m_CompositionPipelines = std::make_unique<PipelinePermutations>(m_Device,
 			"assets/shaders/deferred.vert.spv",
 			"assets/shaders/deferred.frag.spv",
-			configInfo
-		);
+			[this](PipelineConfigInfo& configInfo) {
+				GraphicsPipeline::defaultPipelineConfigInfo(configInfo);
+				configInfo.bindingDescriptions = {};
+				configInfo.attributeDescriptions = {};
+				configInfo.renderPass = m_LightingPass->getVulkanRenderPass();
+				configInfo.pipelineLayout = m_CompositionPipelineLayout;
+			});
 	}
 
 	void LightingPass::createSampler() {
@@ -8,6 +8,8 @@
 #include "../image.hpp"
 #include "../renderpass.hpp"
 #include "../sampler.hpp"
+#include "../shaderPermutation.hpp"
+#include "lightCullingPass.hpp"
 #include "../../components/component.hpp"
 #include "../../managers/componentManager.hpp"
 
@@ -17,37 +19,34 @@
 #include <set>
 #include <vector>
 
-#define MAX_LIGHTS 32
-
 namespace pw {
 	// The lighting pass acts as a "composition pass" where all the deferred images are "composed" into the final lit image
 	class LightingPass {
 	public:
-		LightingPass(uint32_t width, uint32_t height, GraphicsDevice_Vulkan& device);
+		LightingPass(uint32_t width, uint32_t height, GraphicsDevice_Vulkan& device, LightCullingPass& lightCullingPass,
+			const ShadingQuality& shadingQuality);
 		~LightingPass();
 
 		void draw(VkCommandBuffer commandBuffer, size_t frameIndex, std::set<entity_id>& entities, ComponentManager& manager,
-			Image* positionBuffer, Image* normalBuffer, Image* albedoBuffer, Image* shadowMap, const glm::mat4& lightSpaceMatrix);
+			Image* depthBuffer, Image* normalBuffer, Image* albedoBuffer, Image* shadowMap, const glm::mat4& lightSpaceMatrix);
 		void resize(uint32_t width, uint32_t height);
+		void setShadingQuality(const ShadingQuality& quality); // the variant is compiled the first time it is selected
+		void setRenderSize(uint32_t width, uint32_t height); // renders into the top-left part of the targets, no reallocation
 
 		inline Image* getOutputImage() { return m_CompositionImage.get(); }
+		inline uint32_t getRenderWidth() const { return m_RenderWidth; }
+		inline uint32_t getRenderHeight() const { return m_RenderHeight; }
 
 	private:
-		struct PointLightParams {
-			alignas(16) glm::vec3 position{};
-			alignas(16) glm::vec4 color{}; // w component holds intensity
-		};
-
 		struct DirectionLightParams {
 			alignas(16) glm::vec3 direction{};
 			alignas(16) glm::vec3 color{};
 		};
 
 		struct UBOComposition {
+			alignas(16) glm::mat4 inverseViewProjection{ 1.0f };
 			alignas(16) glm::vec3 viewPosition{};
 			DirectionLightParams directionLight{};
-			PointLightParams pointLights[MAX_LIGHTS];
-			alignas(4) uint32_t numPointLights = 0;
 		};
 
 		struct PushConstant {
@@ -64,11 +63,15 @@ namespace pw {
 		void createSampler();
 
 		GraphicsDevice_Vulkan& m_Device;
+		LightCullingPass& m_LightCullingPass;
 
 		std::unique_ptr<Framebuffer> m_CompositionFramebuffer;
+		uint32_t m_RenderWidth = 0;
+		uint32_t m_RenderHeight = 0;
 		std::unique_ptr<RenderPass> m_LightingPass;
 		std::unique_ptr<Image> m_CompositionImage;
-		std::unique_ptr<GraphicsPipeline> m_CompositionPipeline;
+		std::unique_ptr<PipelinePermutations> m_CompositionPipelines;
+		GraphicsPipeline* m_CompositionPipeline = nullptr; // variant of the current shading quality
 		VkPipelineLayout m_CompositionPipelineLayout;
 
 		std::vector<VkDescriptorSetLayout> m_DescriptorSetLayouts;
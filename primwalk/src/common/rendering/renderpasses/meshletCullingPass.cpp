@@ -0,0 +1,324 @@
+#include "meshletCullingPass.hpp"
+#include "../../data/model.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace pw {
+
+	MeshletCullingPass::MeshletCullingPass(GraphicsDevice_Vulkan& device) : m_Device(device) {
+		for (uint32_t i = MAX_MODELS; i > 0; i--) {
+			m_FreeModelSlots.push_back(i - 1);
+		}
+
+		createDescriptorPool();
+		createBuffers();
+		createDescriptorSetLayouts();
+		createPipeline();
+	}
+
+	MeshletCullingPass::~MeshletCullingPass() {
+		vkDestroyPipelineLayout(m_Device.getDevice(), m_PipelineLayout, nullptr);
+	}
+
+	void MeshletCullingPass::begin() {
+		m_Draws.clear();
+		m_MeshletCount = 0;
+
+		releaseModelSlots();
+	}
+
+	uint32_t MeshletCullingPass::addDraw(const Model& model, const Mesh& mesh, const glm::mat4& modelMatrix, const glm::vec3& scale, uint32_t drawIndex) {
+		if (mesh.meshletCount < MIN_MESHLETS || m_Draws.size() == MAX_DRAWS || m_MeshletCount + mesh.meshletCount > MAX_COMMANDS) {
+			return INVALID_DRAW;
+		}
+
+		uint32_t modelSlot = acquireModelSlot(model);
+
+		if (modelSlot == INVALID_DRAW) {
+			return INVALID_DRAW;
+		}
+
+		// Bounding spheres grow with the largest axis, the cones are only preserved by uniform positive scales
+		const float maxScale = std::max({ std::abs(scale.x), std::abs(scale.y), std::abs(scale.z) });
+		const bool uniformScale = scale.x > 0.0f && scale.x == scale.y && scale.x == scale.z;
+
+		CullDraw draw{};
+		draw.modelMatrix = modelMatrix;
+		draw.modelID = modelSlot;
+		draw.meshletOffset = mesh.meshletOffset;
+		draw.meshletCount = mesh.meshletCount;
+		draw.commandOffset = m_MeshletCount;
+		draw.baseIndex = mesh.baseIndex;
+		draw.baseVertex = static_cast<int32_t>(mesh.baseVertex);
+		draw.drawIndex = drawIndex;
+		draw.scale = maxScale;
+		draw.coneCulling = uniformScale ? 1 : 0;
+
+		m_Draws.push_back(draw);
+		m_MeshletCount += mesh.meshletCount;
+
+		return static_cast<uint32_t>(m_Draws.size() - 1);
+	}
+
+	void MeshletCullingPass::dispatch(VkCommandBuffer commandBuffer, size_t frameIndex, const glm::mat4& viewProjection, const glm::vec3& cameraPosition) {
+		// The in-flight fence for this frame index has been waited on, so the results of its previous use are available
+		m_Stats = m_SubmittedStats[frameIndex];
+
+		if (m_Stats.meshlets > 0) { // otherwise nothing was dispatched
+			CullStats* gpuStats = static_cast<CullStats*>(m_StatsBuffers[frameIndex]->getMappedMemory());
+			m_Stats.frustumCulled = gpuStats->frustumCulled;
+			m_Stats.backfaceCulled = gpuStats->backfaceCulled;
+		}
+
+		m_SubmittedStats[frameIndex] = { static_cast<uint32_t>(m_Draws.size()), m_MeshletCount, 0, 0 };
+
+		if (m_Draws.empty()) {
+			return;
+		}
+
+		// Reset the draw counts and statistics
+		vkCmdFillBuffer(commandBuffer, m_CountBuffers[frameIndex]->getBuffer(), 0, VK_WHOLE_SIZE, 0);
+		vkCmdFillBuffer(commandBuffer, m_StatsBuffers[frameIndex]->getBuffer(), 0, VK_WHOLE_SIZE, 0);
+
+		m_DrawBuffers[frameIndex]->writeToBuffer(m_Draws.data(), sizeof(CullDraw) * m_Draws.size());
+
+		VkMemoryBarrier fillBarrier{};
+		fillBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		fillBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		fillBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0,
+			1, &fillBarrier,
+			0, nullptr,
+			0, nullptr);
+
+		// Gribb-Hartmann plane extraction, the depth range is [0, 1] so the near plane is the third row alone
+		CullPush push{};
+		glm::vec4 rows[4];
+
+		for (int i = 0; i < 4; i++) {
+			rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+		}
+
+		push.frustumPlanes[0] = rows[3] + rows[0]; // left
+		push.frustumPlanes[1] = rows[3] - rows[0]; // right
+		push.frustumPlanes[2] = rows[3] + rows[1]; // bottom
+		push.frustumPlanes[3] = rows[3] - rows[1]; // top
+		push.frustumPlanes[4] = rows[2]; // near
+		push.frustumPlanes[5] = rows[3] - rows[2]; // far
+
+		for (auto& plane : push.frustumPlanes) {
+			plane /= glm::length(glm::vec3(plane));
+		}
+
+		push.cameraPosition = glm::vec4(cameraPosition, 1.0f);
+		push.drawCount = static_cast<uint32_t>(m_Draws.size());
+		push.meshletCount = m_MeshletCount;
+		push.coneCulling = m_ConeCulling ? 1 : 0;
+
+		// Cull meshlets, one thread each
+		m_Pipeline->bind(commandBuffer);
+
+		VkDescriptorSet descriptorSets[] = { m_CullDescriptorSets[frameIndex], m_MeshletDescriptorSet };
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+			m_PipelineLayout, 0, 2, descriptorSets, 0, nullptr);
+		vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPush), &push);
+
+		m_Pipeline->dispatch(commandBuffer, (m_MeshletCount + LOCAL_SIZE - 1) / LOCAL_SIZE);
+
+		// The commands and counts are read by the draws of the following render pass, the statistics by the host
+		VkMemoryBarrier cullBarrier{};
+		cullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		cullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		cullBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+			0,
+			1, &cullBarrier,
+			0, nullptr,
+			0, nullptr);
+	}
+
+	void MeshletCullingPass::drawIndirect(VkCommandBuffer commandBuffer, size_t frameIndex, uint32_t cullDraw) const {
+		const CullDraw& draw = m_Draws[cullDraw];
+
+		vkCmdDrawIndexedIndirectCount(
+			commandBuffer,
+			m_CommandBuffers[frameIndex]->getBuffer(),
+			VkDeviceSize(draw.commandOffset) * sizeof(VkDrawIndexedIndirectCommand),
+			m_CountBuffers[frameIndex]->getBuffer(),
+			VkDeviceSize(cullDraw) * sizeof(uint32_t),
+			draw.meshletCount,
+			sizeof(VkDrawIndexedIndirectCommand));
+	}
+
+	uint32_t MeshletCullingPass::acquireModelSlot(const Model& model) {
+		auto slotSearch = m_ModelSlots.find(model.getID());
+
+		if (slotSearch != m_ModelSlots.end()) {
+			slotSearch->second.lastFrame = m_Device.getFrameCount();
+			return slotSearch->second.index;
+		}
+
+		if (m_FreeModelSlots.empty()) {
+			return INVALID_DRAW;
+		}
+
+		// No frame in flight reads a free slot, so it can be rewritten while the set is bound
+		ModelSlot slot{ m_FreeModelSlots.back(), m_Device.getFrameCount() };
+		m_FreeModelSlots.pop_back();
+
+		auto meshletBufferInfo = model.getMeshletBuffer()->getDescriptorInfo();
+
+		DescriptorWriter(*m_MeshletSetLayout, *m_DescriptorPool)
+			.writeBuffer(0, &meshletBufferInfo, slot.index)
+			.overwrite(m_MeshletDescriptorSet);
+
+		m_ModelSlots.insert({ model.getID(), slot });
+		return slot.index;
+	}
+
+	void MeshletCullingPass::releaseModelSlots() {
+		// Slots of models that were destroyed or went out of view, a slot is handed out again when it is next drawn
+		uint64_t frameCount = m_Device.getFrameCount();
+
+		for (auto it = m_ModelSlots.begin(); it != m_ModelSlots.end();) {
+			if (it->second.lastFrame + GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT <= frameCount) {
+				m_FreeModelSlots.push_back(it->second.index);
+				it = m_ModelSlots.erase(it);
+			}
+			else {
+				it++;
+			}
+		}
+	}
+
+	void MeshletCullingPass::createDescriptorPool() {
+		const uint32_t frameCount = GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT;
+
+		m_CullDescriptorSets.resize(frameCount);
+
+		m_DescriptorPool = DescriptorPool::Builder(m_Device)
+			.setMaxSets(frameCount + 1)
+			.setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frameCount * 4 + MAX_MODELS) // draws/commands/counts/statistics + meshlet buffers
+			.build();
+	}
+
+	void MeshletCullingPass::createBuffers() {
+		const size_t frameCount = GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT;
+
+		m_DrawBuffers.resize(frameCount);
+		m_CommandBuffers.resize(frameCount);
+		m_CountBuffers.resize(frameCount);
+		m_StatsBuffers.resize(frameCount);
+		m_SubmittedStats.resize(frameCount);
+
+		for (size_t i = 0; i < frameCount; i++) {
+			m_DrawBuffers[i] = std::make_unique<Buffer>(
+				m_Device,
+				sizeof(CullDraw),
+				MAX_DRAWS,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			m_DrawBuffers[i]->map();
+
+			m_CommandBuffers[i] = std::make_unique<Buffer>(
+				m_Device,
+				sizeof(VkDrawIndexedIndirectCommand),
+				MAX_COMMANDS,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			m_CountBuffers[i] = std::make_unique<Buffer>(
+				m_Device,
+				sizeof(uint32_t),
+				MAX_DRAWS,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			m_StatsBuffers[i] = std::make_unique<Buffer>(
+				m_Device,
+				sizeof(CullStats),
+				1,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			m_StatsBuffers[i]->map();
+
+			CullStats emptyStats{};
+			m_StatsBuffers[i]->writeToBuffer(&emptyStats);
+		}
+	}
+
+	void MeshletCullingPass::createDescriptorSetLayouts() {
+		m_CullSetLayout = DescriptorSetLayout::Builder(m_Device)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT) // draws
+			.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT) // indirect commands
+			.addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT) // draw counts
+			.addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT) // statistics
+			.build();
+
+		m_MeshletSetLayout = DescriptorSetLayout::Builder(m_Device)
+			.setLayoutFlags(VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, MAX_MODELS,
+				VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) // meshlet buffers
+			.build();
+
+		for (size_t i = 0; i < m_CullDescriptorSets.size(); i++) {
+			auto drawsInfo = m_DrawBuffers[i]->getDescriptorInfo();
+			auto commandsInfo = m_CommandBuffers[i]->getDescriptorInfo();
+			auto countsInfo = m_CountBuffers[i]->getDescriptorInfo();
+			auto statsInfo = m_StatsBuffers[i]->getDescriptorInfo();
+
+			DescriptorWriter(*m_CullSetLayout, *m_DescriptorPool)
+				.writeBuffer(0, &drawsInfo)
+				.writeBuffer(1, &commandsInfo)
+				.writeBuffer(2, &countsInfo)
+				.writeBuffer(3, &statsInfo)
+				.build(m_CullDescriptorSets[i]);
+		}
+
+		DescriptorWriter(*m_MeshletSetLayout, *m_DescriptorPool)
+			.build(m_MeshletDescriptorSet);
+	}
+
+	void MeshletCullingPass::createPipeline() {
+		VkDescriptorSetLayout setLayouts[] = {
+			m_CullSetLayout->getDescriptorSetLayout(),
+			m_MeshletSetLayout->getDescriptorSetLayout()
+		};
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(CullPush);
+
+		// Pipeline layout
+		VkPipelineLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		layoutInfo.setLayoutCount = 2;
+		layoutInfo.pSetLayouts = setLayouts;
+		layoutInfo.pushConstantRangeCount = 1;
+		layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+		if (vkCreatePipelineLayout(m_Device.getDevice(), &layoutInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to create meshlet culling pipeline layout!");
+		}
+
+		m_Pipeline = std::make_unique<ComputePipeline>(
+			m_Device,
+			"assets/shaders/meshletCulling.comp.spv",
+			m_PipelineLayout
+		);
+	}
+
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "../graphicsDevice_Vulkan.hpp"
+#include "../buffer.hpp"
+#include "../computePipeline.hpp"
+#include "../descriptors.hpp"
+#include "../../data/mesh.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace pw {
+	// Forward declarations
+	class Model;
+
+	// The meshlet culling pass tests the meshlets of dense meshes against the view frustum and their normal cones on
+	// the GPU, before a pass draws them. Survivors are written as compacted indirect commands per draw, which the
+	// regular vertex pipeline consumes through vkCmdDrawIndexedIndirectCount, so no mesh shader support is needed.
+	// Draws are collected with addDraw() while building the draw list, dispatch() is recorded before the render pass.
+	class MeshletCullingPass {
+	public:
+		struct Stats {
+			uint32_t draws = 0;
+			uint32_t meshlets = 0; // tested
+			uint32_t frustumCulled = 0;
+			uint32_t backfaceCulled = 0;
+
+			float getCullRate() const { return meshlets > 0 ? float(frustumCulled + backfaceCulled) / float(meshlets) : 0.0f; }
+		};
+
+		MeshletCullingPass(GraphicsDevice_Vulkan& device);
+		~MeshletCullingPass();
+
+		void begin(); // clears the draws of the previous frame
+		uint32_t addDraw(const Model& model, const Mesh& mesh, const glm::mat4& modelMatrix, const glm::vec3& scale, uint32_t drawIndex); // INVALID_DRAW if it has to be drawn directly
+		void dispatch(VkCommandBuffer commandBuffer, size_t frameIndex, const glm::mat4& viewProjection, const glm::vec3& cameraPosition);
+		void drawIndirect(VkCommandBuffer commandBuffer, size_t frameIndex, uint32_t cullDraw) const; // expects the model to be bound
+
+		inline void setConeCulling(bool enabled) { m_ConeCulling = enabled; } // only valid for closed meshes with consistent winding
+
+		/* Statistics of the most recently completed frame using the given frame index */
+		inline const Stats& getStats() const { return m_Stats; }
+
+		static constexpr uint32_t INVALID_DRAW = ~0u;
+		static constexpr uint32_t MAX_DRAWS = 4096;
+		static constexpr uint32_t MAX_COMMANDS = 1u << 18; // meshlets of all draws
+		static constexpr uint32_t MAX_MODELS = 256; // drawn within MAX_FRAMES_IN_FLIGHT frames, others are drawn directly
+		static constexpr uint32_t MIN_MESHLETS = 8; // smaller meshes are not worth the indirection
+		static constexpr uint32_t LOCAL_SIZE = 64; // NOTE: Must match meshletCulling.comp
+
+	private:
+		struct CullDraw {
+			alignas(16) glm::mat4 modelMatrix{ 1.0f };
+			alignas(4) uint32_t modelID = 0;
+			alignas(4) uint32_t meshletOffset = 0;
+			alignas(4) uint32_t meshletCount = 0;
+			alignas(4) uint32_t commandOffset = 0;
+			alignas(4) uint32_t baseIndex = 0;
+			alignas(4) int32_t baseVertex = 0;
+			alignas(4) uint32_t drawIndex = 0;
+			alignas(4) float scale = 1.0f;
+			alignas(4) uint32_t coneCulling = 0;
+		};
+
+		struct CullPush {
+			alignas(16) glm::vec4 frustumPlanes[6]{};
+			alignas(16) glm::vec4 cameraPosition{ 0.0f };
+			alignas(4) uint32_t drawCount = 0;
+			alignas(4) uint32_t meshletCount = 0;
+			alignas(4) uint32_t coneCulling = 0;
+		};
+
+		struct CullStats {
+			uint32_t frustumCulled = 0;
+			uint32_t backfaceCulled = 0;
+		};
+
+		struct ModelSlot {
+			uint32_t index = 0; // into the meshlet buffer array
+			uint64_t lastFrame = 0; // frame count of the last draw
+		};
+
+		void createDescriptorPool();
+		void createBuffers();
+		void createDescriptorSetLayouts();
+		void createPipeline();
+
+		uint32_t acquireModelSlot(const Model& model); // INVALID_DRAW if every slot is taken
+		void releaseModelSlots(); // of models that no frame in flight draws anymore, e.g. because they were destroyed
+
+		GraphicsDevice_Vulkan& m_Device;
+
+		std::unique_ptr<ComputePipeline> m_Pipeline;
+		VkPipelineLayout m_PipelineLayout = VK_NULL_HANDLE;
+
+		std::unique_ptr<DescriptorPool> m_DescriptorPool;
+		std::unique_ptr<DescriptorSetLayout> m_CullSetLayout;
+		std::unique_ptr<DescriptorSetLayout> m_MeshletSetLayout;
+		std::vector<VkDescriptorSet> m_CullDescriptorSets; // per frame in flight
+		VkDescriptorSet m_MeshletDescriptorSet = VK_NULL_HANDLE;
+
+		std::vector<std::unique_ptr<Buffer>> m_DrawBuffers;
+		std::vector<std::unique_ptr<Buffer>> m_CommandBuffers;
+		std::vector<std::unique_ptr<Buffer>> m_CountBuffers;
+		std::vector<std::unique_ptr<Buffer>> m_StatsBuffers;
+		std::vector<Stats> m_SubmittedStats;
+
+		std::unordered_map<uint64_t, ModelSlot> m_ModelSlots{}; // by model ID
+		std::vector<uint32_t> m_FreeModelSlots{};
+		std::vector<CullDraw> m_Draws{};
+		uint32_t m_MeshletCount = 0;
+		bool m_ConeCulling = true;
+		Stats m_Stats{};
+	};
+}
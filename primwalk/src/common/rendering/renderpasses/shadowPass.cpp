@@ -1,4 +1,7 @@
 #include "shadowPass.hpp"
+#include "../commandRecorder.hpp"
+#include "../geometryStore.hpp"
+#include "../pipelineLayoutCache.hpp"
 #include "../vertex3d.hpp"
 #include "../../components/camera.hpp"
 #include "../../components/directionLight.hpp"
@@ -10,7 +13,6 @@
 
 #include <iostream>
 #include <limits>
-#include <stdexcept>
 
 namespace pw {
 
@@ -26,8 +28,6 @@ namespace pw {
 	}
 
 	ShadowPass::~ShadowPass() {
-		vkDestroyPipelineLayout(m_Device.getDevice(), m_PipelineLayout, nullptr);
-
 		m_Framebuffer->destroy();
 		m_DepthImage->destroy();
 	}
@@ -96,11 +96,10 @@ namespace pw {
 		viewport.width = m_Framebuffer->getWidth();
 		viewport.height = m_Framebuffer->getHeight();
 		
-		m_RenderPass->begin(*m_Framebuffer, commandBuffer, viewport);
-		m_Pipeline->bind(commandBuffer);
-
-		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-			m_PipelineLayout, 0, 1, &m_UBODescriptorSets[frameIndex], 0, nullptr);
+		// Gather the draws on this thread, they are recorded on multiple threads
+		m_DrawCommands.clear();
+		m_ModelMatrices.clear();
+		m_LODSelector.setView(*Camera::MainCamera, viewport.height);
 
 		for (const auto& e : entities) {
 			auto& component = manager.getComponent<Renderable>(e);
@@ -110,25 +109,71 @@ namespace pw {
 				continue;
 			}
 
-			model->bind(commandBuffer);
+			const Transform& transform = manager.getComponent<Transform>(e);
+			glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), transform.position);
+			modelMatrix = glm::scale(modelMatrix, transform.scale);
 
-			for (const auto& mesh : model->getMeshes()) {
-				PushConstants push{};
-				push.modelMatrix = glm::translate(push.modelMatrix, manager.getComponent<Transform>(e).position);
-				push.modelMatrix = glm::scale(push.modelMatrix, manager.getComponent<Transform>(e).scale);
+			std::vector<Mesh>& meshes = model->getMeshes();
 
-				vkCmdPushConstants(
-					commandBuffer,
-					m_PipelineLayout,
-					VK_SHADER_STAGE_VERTEX_BIT,
-					0,
-					sizeof(PushConstants),
-					&push);
+			for (uint32_t i = 0; i < meshes.size(); i++) {
+				if (m_DrawCommands.size() == MAX_DRAWS) {
+					break;
+				}
 
-				vkCmdDrawIndexed(commandBuffer, mesh.indices, 1, mesh.baseIndex, mesh.baseVertex, 0);
+				Mesh mesh = meshes[i].getLOD(m_LODSelector.select(e, i, meshes[i], transform));
+
+				m_ModelMatrices.push_back(modelMatrix);
+				m_DrawCommands.push_back({ model, mesh });
 			}
 		}
 
+		if (!m_ModelMatrices.empty()) {
+			m_DrawBuffers[frameIndex]->writeToBuffer(m_ModelMatrices.data(), sizeof(glm::mat4) * m_ModelMatrices.size());
+		}
+
+		// Only the draw list and the geometry buffers are baked into the commands, the matrices are read from the draw buffer
+		GeometryStore& geometryStore = m_Device.getGeometryStore();
+		uint64_t contentVersion = geometryStore.getGeneration();
+
+		for (const auto& draw : m_DrawCommands) {
+			contentVersion = CommandCache::combine(contentVersion, draw.model->getIndexType());
+			contentVersion = CommandCache::combine(contentVersion, (static_cast<uint64_t>(draw.mesh.indices) << 32) | draw.mesh.baseIndex);
+			contentVersion = CommandCache::combine(contentVersion, draw.mesh.baseVertex);
+		}
+
+		m_RenderPass->begin(*m_Framebuffer, commandBuffer, viewport, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+		ParallelRecordInfo recordInfo = {
+			*m_RenderPass,
+			*m_Framebuffer,
+			viewport
+		};
+		recordInfo.itemCount = static_cast<uint32_t>(m_DrawCommands.size());
+		recordInfo.cache = &m_CommandCache;
+		recordInfo.contentVersion = contentVersion;
+
+		m_Device.getCommandRecorder().record(commandBuffer, recordInfo, [&](VkCommandBuffer secondary, uint32_t first, uint32_t last) {
+			m_Pipeline->bind(secondary);
+
+			vkCmdBindDescriptorSets(secondary, VK_PIPELINE_BIND_POINT_GRAPHICS,
+				m_PipelineLayout, 0, 1, &m_UBODescriptorSets[frameIndex], 0, nullptr);
+
+			// Every model lives in the same buffers, only a change of the index type needs a rebind
+			VkIndexType boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+
+			for (uint32_t i = first; i < last; i++) {
+				const DrawCommand& draw = m_DrawCommands[i];
+
+				if (draw.model->getIndexType() != boundIndexType) {
+					boundIndexType = draw.model->getIndexType();
+					geometryStore.bindPositions(secondary, boundIndexType);
+				}
+
+				// The draw index is passed as first instance
+				vkCmdDrawIndexed(secondary, draw.mesh.indices, 1, draw.mesh.baseIndex, draw.mesh.baseVertex, i);
+			}
+		});
+
 		m_RenderPass->end(commandBuffer);
 	}
 
@@ -184,6 +229,7 @@ namespace pw {
 			.setMaxSets(4)
 			.setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT)
 			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT) // UBO
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT) // draw data
 			.build();
 	}
 
@@ -200,53 +246,47 @@ namespace pw {
 
 			ubo->map();
 		}
+
+		m_DrawBuffers.resize(GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT);
+
+		for (auto& drawBuffer : m_DrawBuffers) {
+			drawBuffer = std::make_unique<Buffer>(
+				m_Device,
+				sizeof(glm::mat4),
+				MAX_DRAWS,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+			drawBuffer->map();
+		}
 	}
 
 	void ShadowPass::createDescriptorSetLayout() {
-		m_UBOSetLayout = DescriptorSetLayout::Builder(m_Device)
-			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
-			.build();
+		m_Reflection = Shader_Vulkan::reflectFiles({ "assets/shaders/shadowMapping.vert.spv" });
+		m_UBOSetLayout = &m_Device.getPipelineLayoutCache().getSetLayout(m_Reflection, 0);
 
 		for (size_t i = 0; i < m_UBODescriptorSets.size(); i++) {
 			auto bufferInfo = m_UBOs[i]->getDescriptorInfo();
+			auto drawBufferInfo = m_DrawBuffers[i]->getDescriptorInfo();
 
 			DescriptorWriter(*m_UBOSetLayout, *m_DescriptorPool)
 				.writeBuffer(0, &bufferInfo)
+				.writeBuffer(1, &drawBufferInfo)
 				.build(m_UBODescriptorSets[i]);
 		}
-
-		m_DescriptorSetLayouts = {
-			m_UBOSetLayout->getDescriptorSetLayout()
-		};
 	}
 
 	void ShadowPass::createPipeline() {
 		// Pipeline layout
-		VkPipelineLayoutCreateInfo layoutInfo{};
-		layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		layoutInfo.setLayoutCount = static_cast<uint32_t>(m_DescriptorSetLayouts.size());
-		layoutInfo.pSetLayouts = m_DescriptorSetLayouts.data();
-
-		// Push constants
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof(PushConstants);
-
-		layoutInfo.pushConstantRangeCount = 1;
-		layoutInfo.pPushConstantRanges = &pushConstantRange;
-
-		if (vkCreatePipelineLayout(m_Device.getDevice(), &layoutInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS) {
-			throw std::runtime_error("VULKAN ERROR: Failed to create deferred pipeline layout!");
-		}
+		m_PipelineLayout = m_Device.getPipelineLayoutCache().getPipelineLayout(m_Reflection);
 
 		// Pipeline
 		PipelineConfigInfo configInfo{};
 		GraphicsPipeline::defaultPipelineConfigInfo(configInfo);
 
 		// Binding descriptions
-		configInfo.bindingDescriptions = Vertex3D::getBindingDescriptions();
-		configInfo.attributeDescriptions = Vertex3D::getAttributeDescriptions();
+		configInfo.bindingDescriptions = Vertex3D::getPositionBindingDescriptions();
+		configInfo.attributeDescriptions = Vertex3D::getPositionAttributeDescriptions();
 		configInfo.renderPass = m_RenderPass->getVulkanRenderPass();
 		configInfo.pipelineLayout = m_PipelineLayout;
 
@@ -2,13 +2,17 @@
 
 #include "../graphicsDevice_Vulkan.hpp"
 #include "../buffer.hpp"
+#include "../commandRecorder.hpp"
 #include "../descriptors.hpp"
 #include "../framebuffer.hpp"
 #include "../graphicsPipeline.hpp"
 #include "../image.hpp"
+#include "../lodSelector.hpp"
 #include "../renderpass.hpp"
 #include "../sampler.hpp"
 #include "../../components/component.hpp"
+#include "../../data/mesh.hpp"
+#include "../../data/shader.hpp"
 #include "../../managers/componentManager.hpp"
 
 
@@ -17,14 +21,18 @@
 #include <set>
 #include <vector>
 
-#define MAX_LIGHTS 32
-
 namespace pw {
+	// Forward declarations
+	class Model;
+
 	// TODO: Right now, the shadow pass only works for ONE directional light, and does not work for point lights at all.
 	// A solution to this would be to investigate Doom 2016's "megatexture" technique where one depth image
 	// holds multiple shadow maps in varying resolutions.
 	class ShadowPass {
 	public:
+		static constexpr uint32_t MAX_DRAWS = 1u << 16;
+		static constexpr uint32_t SHADOW_LOD_BIAS = 1; // shadow casters use one level coarser than the camera would
+
 		ShadowPass(GraphicsDevice_Vulkan& device, uint32_t shadowResolution = 1024);
 		~ShadowPass();
 
@@ -52,8 +60,9 @@ namespace pw {
 			DirectionLightParams directionLight{};
 		};
 
-		struct PushConstants {
-			alignas(16) glm::mat4 modelMatrix{ 1.0f };
+		struct DrawCommand {
+			Model* model = nullptr;
+			Mesh mesh{};
 		};
 
 		void createImages(uint32_t width, uint32_t height);
@@ -71,14 +80,20 @@ namespace pw {
 		std::unique_ptr<RenderPass> m_RenderPass;
 		std::unique_ptr<Image> m_DepthImage;
 		std::unique_ptr<GraphicsPipeline> m_Pipeline;
-		VkPipelineLayout m_PipelineLayout;
+		VkPipelineLayout m_PipelineLayout = VK_NULL_HANDLE;
 
-		std::vector<VkDescriptorSetLayout> m_DescriptorSetLayouts;
+		// Reflected from the shader, owned by the device's PipelineLayoutCache
+		ShaderReflection m_Reflection{};
 		std::unique_ptr<DescriptorPool> m_DescriptorPool;
 
 		std::vector<VkDescriptorSet> m_UBODescriptorSets;
-		std::unique_ptr<DescriptorSetLayout> m_UBOSetLayout{};
+		DescriptorSetLayout* m_UBOSetLayout = nullptr;
 		std::vector<std::unique_ptr<Buffer>> m_UBOs;
+		std::vector<std::unique_ptr<Buffer>> m_DrawBuffers; // model matrices indexed by the first instance, per frame in flight
+		std::vector<DrawCommand> m_DrawCommands; // rebuilt every frame, kept to reuse the allocation
+		std::vector<glm::mat4> m_ModelMatrices;
+		CommandCache m_CommandCache;
+		LODSelector m_LODSelector{ SHADOW_LOD_BIAS };
 
 		std::unique_ptr<Sampler> m_Sampler;
 
@@ -0,0 +1,231 @@
+#include "temporalUpsamplePass.hpp"
+
+#include <stdexcept>
+
+namespace pw {
+
+	TemporalUpsamplePass::TemporalUpsamplePass(uint32_t width, uint32_t height, GraphicsDevice_Vulkan& device) : m_Device(device) {
+		createImages(width, height);
+		createRenderpass();
+		createFramebuffers(width, height);
+		createDescriptorPool();
+		createDescriptorSetLayout();
+		createPipeline();
+		createSampler();
+	}
+
+	TemporalUpsamplePass::~TemporalUpsamplePass() {
+		vkDestroyPipelineLayout(m_Device.getDevice(), m_PipelineLayout, nullptr);
+
+		for (size_t i = 0; i < m_HistoryImages.size(); i++) {
+			m_Framebuffers[i]->destroy();
+			m_HistoryImages[i]->destroy();
+		}
+	}
+
+	void TemporalUpsamplePass::draw(VkCommandBuffer commandBuffer, size_t frameIndex, Image* color, Image* motionVectors,
+		uint32_t renderWidth, uint32_t renderHeight, glm::vec2 jitter) {
+
+		// Resolve into the image that held the history of the previous frame
+		m_HistoryIndex = 1 - m_HistoryIndex;
+
+		VkDescriptorImageInfo colorInfo{};
+		colorInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		colorInfo.imageView = color->getVulkanImageView();
+		colorInfo.sampler = m_Sampler->getVkSampler();
+
+		VkDescriptorImageInfo motionInfo{};
+		motionInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		motionInfo.imageView = motionVectors->getVulkanImageView();
+		motionInfo.sampler = m_Sampler->getVkSampler();
+
+		VkDescriptorImageInfo historyInfo{};
+		historyInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		historyInfo.imageView = getHistoryImage()->getVulkanImageView();
+		historyInfo.sampler = m_Sampler->getVkSampler();
+
+		DescriptorWriter(*m_InputSetLayout, *m_DescriptorPool)
+			.writeImage(0, &colorInfo)
+			.writeImage(1, &motionInfo)
+			.writeImage(2, &historyInfo)
+			.overwrite(m_InputDescriptorSets[frameIndex]);
+
+		Framebuffer& framebuffer = *m_Framebuffers[m_HistoryIndex];
+
+		Viewport viewport{};
+		viewport.width = static_cast<float>(framebuffer.getWidth());
+		viewport.height = static_cast<float>(framebuffer.getHeight());
+
+		m_RenderPass->begin(framebuffer, commandBuffer, viewport);
+		m_Pipeline->bind(commandBuffer);
+
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+			m_PipelineLayout, 0, 1, &m_InputDescriptorSets[frameIndex], 0, nullptr);
+
+		PushConstant push{};
+		push.jitter = jitter * 0.5f; // NDC to UV
+		push.renderSize = glm::vec2(renderWidth, renderHeight);
+		push.inputSize = glm::vec2(color->getWidth(), color->getHeight());
+		push.historyValid = m_HistoryValid ? 1 : 0;
+
+		vkCmdPushConstants(
+			commandBuffer,
+			m_PipelineLayout,
+			VK_SHADER_STAGE_FRAGMENT_BIT,
+			0,
+			sizeof(PushConstant),
+			&push);
+
+		vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+
+		m_RenderPass->end(commandBuffer);
+
+		m_HistoryValid = true;
+	}
+
+	void TemporalUpsamplePass::resize(uint32_t width, uint32_t height) {
+		m_Device.waitForGPU();
+
+		for (size_t i = 0; i < m_HistoryImages.size(); i++) {
+			m_Framebuffers[i]->destroy();
+			m_HistoryImages[i]->destroy();
+		}
+
+		createImages(width, height);
+		createFramebuffers(width, height);
+		resetHistory();
+	}
+
+	void TemporalUpsamplePass::createImages(uint32_t width, uint32_t height) {
+		// Half floats, accumulating in 8 bits would band
+		ImageInfo imageInfo{};
+		imageInfo.width = width;
+		imageInfo.height = height;
+		imageInfo.depth = 1;
+		imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageInfo.format = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+		for (auto& image : m_HistoryImages) {
+			image = std::make_unique<Image>(imageInfo);
+		}
+
+		// The history of the first frame is bound (but not read) before it was ever rendered to
+		VkCommandBuffer commandBuffer = m_Device.beginSingleTimeCommands();
+
+		for (auto& image : m_HistoryImages) {
+			m_Device.transitionImageLayout(commandBuffer, image->getVulkanImage(), imageInfo.format,
+				VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		}
+
+		m_Device.endSingleTimeCommands(commandBuffer);
+	}
+
+	void TemporalUpsamplePass::createRenderpass() {
+		SubpassInfo subpass{};
+		subpass.renderTargets = { 0 };
+
+		// Every pixel is written, nothing to clear
+		RenderPassAttachment outputAttachment = {
+			m_HistoryImages[0],
+			VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+			VK_ATTACHMENT_STORE_OP_STORE,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+		};
+
+		std::vector<RenderPassAttachment> attachments = {
+			outputAttachment
+		};
+
+		RenderPassInfo renderPassInfo = {
+			attachments,
+			{ subpass }
+		};
+
+		m_RenderPass = std::make_unique<RenderPass>(renderPassInfo);
+	}
+
+	void TemporalUpsamplePass::createFramebuffers(uint32_t width, uint32_t height) {
+		for (size_t i = 0; i < m_HistoryImages.size(); i++) {
+			FramebufferInfo framebufferInfo = {
+				width,
+				height,
+				m_RenderPass->getVulkanRenderPass(),
+				{ { m_HistoryImages[i] } }
+			};
+
+			m_Framebuffers[i] = std::make_unique<Framebuffer>(framebufferInfo);
+		}
+	}
+
+	void TemporalUpsamplePass::createDescriptorPool() {
+		m_InputDescriptorSets.resize(GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT);
+
+		m_DescriptorPool = DescriptorPool::Builder(m_Device)
+			.setMaxSets(GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT)
+			.setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 3 * GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT)
+			.build();
+	}
+
+	void TemporalUpsamplePass::createDescriptorSetLayout() {
+		m_InputSetLayout = DescriptorSetLayout::Builder(m_Device)
+			.setLayoutFlags(VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1, VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) // current color
+			.addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1, VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) // motion vectors
+			.addBinding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1, VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) // history
+			.build();
+
+		for (auto& descriptorSet : m_InputDescriptorSets) {
+			DescriptorWriter(*m_InputSetLayout, *m_DescriptorPool).build(descriptorSet);
+		}
+	}
+
+	void TemporalUpsamplePass::createPipeline() {
+		// Push constants
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(PushConstant);
+
+		// Pipeline layout
+		VkDescriptorSetLayout setLayout = m_InputSetLayout->getDescriptorSetLayout();
+
+		VkPipelineLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		layoutInfo.setLayoutCount = 1;
+		layoutInfo.pSetLayouts = &setLayout;
+		layoutInfo.pushConstantRangeCount = 1;
+		layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+		if (vkCreatePipelineLayout(m_Device.getDevice(), &layoutInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to create temporal upsampling pipeline layout!");
+		}
+
+		// Pipeline
+		PipelineConfigInfo configInfo{};
+		GraphicsPipeline::defaultPipelineConfigInfo(configInfo);
+		configInfo.bindingDescriptions = {};
+		configInfo.attributeDescriptions = {};
+		configInfo.colorBlendAttachment.blendEnable = VK_FALSE;
+		configInfo.renderPass = m_RenderPass->getVulkanRenderPass();
+		configInfo.pipelineLayout = m_PipelineLayout;
+
+		m_Pipeline = std::make_unique<GraphicsPipeline>(
+			m_Device,
+			"assets/shaders/deferred.vert.spv",
+			"assets/shaders/temporalUpsample.frag.spv",
+			configInfo
+		);
+	}
+
+	void TemporalUpsamplePass::createSampler() {
+		SamplerCreateInfo samplerInfo{};
+		samplerInfo.anisotropicFiltering = false;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+		m_Sampler = std::make_unique<Sampler>(samplerInfo, m_Device);
+	}
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "../graphicsDevice_Vulkan.hpp"
+#include "../descriptors.hpp"
+#include "../framebuffer.hpp"
+#include "../graphicsPipeline.hpp"
+#include "../image.hpp"
+#include "../renderpass.hpp"
+#include "../sampler.hpp"
+
+// std
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// vendor
+#include <glm/glm.hpp>
+
+namespace pw {
+	// Reconstructs the output resolution from the jittered lighting output and the reprojected history of the
+	// previous frames. The two history images are used alternately as output and as history of the next frame,
+	// outside of the pass both always stay in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+	class TemporalUpsamplePass {
+	public:
+		TemporalUpsamplePass(uint32_t width, uint32_t height, GraphicsDevice_Vulkan& device);
+		~TemporalUpsamplePass();
+
+		void draw(VkCommandBuffer commandBuffer, size_t frameIndex, Image* color, Image* motionVectors,
+			uint32_t renderWidth, uint32_t renderHeight, glm::vec2 jitter);
+		void resize(uint32_t width, uint32_t height);
+		inline void resetHistory() { m_HistoryValid = false; }
+
+		inline Image* getOutputImage() { return m_HistoryImages[m_HistoryIndex].get(); } // most recently resolved frame
+		inline Image* getHistoryImage() { return m_HistoryImages[1 - m_HistoryIndex].get(); }
+
+	private:
+		struct PushConstant {
+			alignas(8) glm::vec2 jitter{}; // UV units
+			alignas(8) glm::vec2 renderSize{};
+			alignas(8) glm::vec2 inputSize{};
+			alignas(4) float currentWeight = 0.1f;
+			alignas(4) uint32_t historyValid = 0;
+		};
+
+		void createImages(uint32_t width, uint32_t height);
+		void createRenderpass();
+		void createFramebuffers(uint32_t width, uint32_t height);
+		void createDescriptorPool();
+		void createDescriptorSetLayout();
+		void createPipeline();
+		void createSampler();
+
+		GraphicsDevice_Vulkan& m_Device;
+
+		std::unique_ptr<RenderPass> m_RenderPass;
+		std::array<std::unique_ptr<Image>, 2> m_HistoryImages;
+		std::array<std::unique_ptr<Framebuffer>, 2> m_Framebuffers;
+		uint32_t m_HistoryIndex = 0;
+		bool m_HistoryValid = false;
+
+		std::unique_ptr<GraphicsPipeline> m_Pipeline;
+		VkPipelineLayout m_PipelineLayout = VK_NULL_HANDLE;
+
+		std::unique_ptr<DescriptorPool> m_DescriptorPool;
+		std::unique_ptr<DescriptorSetLayout> m_InputSetLayout{};
+		std::vector<VkDescriptorSet> m_InputDescriptorSets; // per frame in flight, rewritten every frame
+
+		std::unique_ptr<Sampler> m_Sampler;
+	};
+}
@@ -0,0 +1,533 @@
+#include "visibilityBufferPass.hpp"
+#include "../geometryStore.hpp"
+#include "../vertex3d.hpp"
+#include "../../components/camera.hpp"
+#include "../../components/directionLight.hpp"
+#include "../../components/renderable.hpp"
+#include "../../components/transform.hpp"
+#include "../../data/model.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <iostream>
+#include <stdexcept>
+
+namespace pw {
+
+	VisibilityBufferPass::VisibilityBufferPass(uint32_t width, uint32_t height, GraphicsDevice_Vulkan& device, LightCullingPass& lightCullingPass,
+		const ShadingQuality& shadingQuality) : m_Device(device), m_LightCullingPass(lightCullingPass) {
+		createImages(width, height);
+		createRenderPasses();
+		createFramebuffers(width, height);
+		createDescriptorPool();
+		createBuffers();
+		createSamplers();
+		createDescriptorSetLayout();
+		createPipelines();
+		setShadingQuality(shadingQuality);
+	}
+
+	VisibilityBufferPass::~VisibilityBufferPass() {
+		vkDestroyPipelineLayout(m_Device.getDevice(), m_GeometryPipelineLayout, nullptr);
+		vkDestroyPipelineLayout(m_Device.getDevice(), m_ResolvePipelineLayout, nullptr);
+
+		m_GeometryFramebuffer->destroy();
+		m_ResolveFramebuffer->destroy();
+		m_VisibilityBuffer->destroy();
+		m_DepthBuffer->destroy();
+		m_OutputImage->destroy();
+	}
+
+	void VisibilityBufferPass::draw(VkCommandBuffer commandBuffer, size_t frameIndex, std::set<entity_id>& entities, ComponentManager& manager,
+		Image* shadowMap, const glm::mat4& lightSpaceMatrix) {
+
+		auto& camera = Camera::MainCamera;
+
+		GeometryUBO geometryUBO{};
+		geometryUBO.view = camera->getViewMatrix();
+		geometryUBO.proj = camera->getProjectionMatrix();
+		m_GeometryUBOs[frameIndex]->writeToBuffer(&geometryUBO);
+
+		ResolveUBO resolveUBO{};
+		resolveUBO.view = geometryUBO.view;
+		resolveUBO.proj = geometryUBO.proj;
+		resolveUBO.lightSpaceMatrix = lightSpaceMatrix;
+		resolveUBO.viewPosition = camera->position;
+		resolveUBO.screenSize = glm::vec2(m_ResolveFramebuffer->getWidth(), m_ResolveFramebuffer->getHeight());
+
+		// NOTE: Point lights are binned by the light culling pass
+		for (const auto& e : entities) {
+			if (manager.hasComponent<DirectionLight>(e)) {
+				auto& light = manager.getComponent<DirectionLight>(e);
+				resolveUBO.directionLight.color = light.color;
+				resolveUBO.directionLight.direction = light.direction;
+			}
+		}
+
+		m_ResolveUBOs[frameIndex]->writeToBuffer(&resolveUBO);
+
+		if (m_BoundShadowMap != shadowMap) {
+			writeResolveDescriptorSets(shadowMap);
+		}
+
+		GeometryStore& geometryStore = m_Device.getGeometryStore();
+
+		if (m_GeometryGeneration != geometryStore.getGeneration()) {
+			writeGeometryDescriptorSet();
+		}
+
+		Viewport viewport{};
+		viewport.width = m_GeometryFramebuffer->getWidth();
+		viewport.height = m_GeometryFramebuffer->getHeight();
+
+		// 1. Geometry pass, every mesh draw gets an ID pointing into this frame's draw data
+		uint32_t drawCount = 0;
+		m_LODSelector.setView(*camera, viewport.height);
+
+		m_GeometryPass->begin(*m_GeometryFramebuffer, commandBuffer, viewport);
+
+			m_GeometryPipeline->bind(commandBuffer);
+
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+				m_GeometryPipelineLayout, 0, 1, &m_GeometryDescriptorSets[frameIndex], 0, nullptr);
+
+			// Every model lives in the same buffers, only a change of the index type needs a rebind
+			VkIndexType boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+
+			for (const auto& e : entities) {
+				if (!manager.hasComponent<Renderable>(e)) {
+					continue;
+				}
+
+				Model* model = manager.getComponent<Renderable>(e).model;
+
+				if (!model) {
+					continue;
+				}
+
+				if (model->getIndexType() != boundIndexType) {
+					boundIndexType = model->getIndexType();
+					geometryStore.bindPositions(commandBuffer, boundIndexType);
+				}
+
+				const Transform& transform = manager.getComponent<Transform>(e);
+				glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), transform.position);
+				modelMatrix = glm::scale(modelMatrix, transform.scale);
+
+				std::vector<Mesh>& meshes = model->getMeshes();
+
+				for (uint32_t i = 0; i < meshes.size(); i++) {
+					if (drawCount == MAX_DRAWS) {
+						break;
+					}
+
+					Mesh mesh = meshes[i].getLOD(m_LODSelector.select(e, i, meshes[i], transform));
+
+					// The primitive ID would overflow into the draw ID bits of the visibility buffer
+					if (mesh.indices / 3 > MAX_DRAW_TRIANGLES) {
+						if (!m_TriangleOverflowReported) {
+							std::cerr << "Visibility buffer: skipping a mesh with " << mesh.indices / 3
+								<< " triangles, at most " << MAX_DRAW_TRIANGLES << " fit in a draw\n";
+							m_TriangleOverflowReported = true;
+						}
+
+						continue;
+					}
+
+					DrawData drawData{};
+					drawData.modelMatrix = modelMatrix;
+					drawData.baseIndex = mesh.baseIndex;
+					drawData.baseVertex = static_cast<int32_t>(mesh.baseVertex);
+					drawData.shortIndices = model->getIndexType() == VK_INDEX_TYPE_UINT16 ? 1 : 0;
+
+					std::shared_ptr<Texture2D> diffuseMap = model->getDiffuseMap(mesh.materialIndex);
+					std::shared_ptr<Texture2D> normalMap = model->getNormalMap(mesh.materialIndex);
+
+					if (diffuseMap) {
+						drawData.diffuseTexIndex = diffuseMap->getImage()->getBindlessIndex();
+					}
+
+					if (normalMap) {
+						drawData.normalMapIndex = normalMap->getImage()->getBindlessIndex();
+					}
+
+					m_DrawBuffers[frameIndex]->writeToBuffer(&drawData, sizeof(DrawData), sizeof(DrawData) * drawCount);
+
+					GeometryPushConstant push{};
+					push.modelMatrix = modelMatrix;
+					push.drawID = drawCount;
+
+					vkCmdPushConstants(
+						commandBuffer,
+						m_GeometryPipelineLayout,
+						VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+						0,
+						sizeof(GeometryPushConstant),
+						&push);
+
+					vkCmdDrawIndexed(commandBuffer, mesh.indices, 1, mesh.baseIndex, mesh.baseVertex, 0);
+					drawCount++;
+				}
+			}
+
+		m_GeometryPass->end(commandBuffer);
+
+		// 2. Resolve pass
+		viewport.width = m_ResolveFramebuffer->getWidth();
+		viewport.height = m_ResolveFramebuffer->getHeight();
+
+		m_ResolvePass->begin(*m_ResolveFramebuffer, commandBuffer, viewport);
+
+			m_ResolvePipeline->bind(commandBuffer);
+
+			VkDescriptorSet clusterDescriptorSet = m_LightCullingPass.getDescriptorSet(frameIndex);
+			std::vector<VkDescriptorSet> descriptorSets = {
+				m_ResolveDescriptorSets[frameIndex],
+				m_Device.getBindlessTextureSet(),
+				m_GeometryStoreDescriptorSet,
+				clusterDescriptorSet
+			};
+
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_ResolvePipelineLayout,
+				0, static_cast<uint32_t>(descriptorSets.size()), descriptorSets.data(), 0, nullptr);
+
+			vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+
+		m_ResolvePass->end(commandBuffer);
+	}
+
+	void VisibilityBufferPass::resize(uint32_t width, uint32_t height) {
+		m_Device.waitForGPU();
+
+		m_GeometryFramebuffer->destroy();
+		m_ResolveFramebuffer->destroy();
+		m_VisibilityBuffer->destroy();
+		m_DepthBuffer->destroy();
+		m_OutputImage->destroy();
+
+		createImages(width, height);
+		createFramebuffers(width, height);
+
+		m_BoundShadowMap = nullptr; // rewrites the visibility buffer descriptors on the next draw
+	}
+
+	void VisibilityBufferPass::setShadingQuality(const ShadingQuality& quality) {
+		m_ResolvePipeline = &m_ResolvePipelines->get(getLightingPermutation(quality));
+	}
+
+	void VisibilityBufferPass::createImages(uint32_t width, uint32_t height) {
+		// Visibility buffer
+		ImageInfo visibilityImageInfo{};
+		visibilityImageInfo.width = width;
+		visibilityImageInfo.height = height;
+		visibilityImageInfo.depth = 1;
+		visibilityImageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		visibilityImageInfo.format = VK_FORMAT_R32_UINT;
+
+		// Depth
+		ImageInfo depthImageInfo{};
+		depthImageInfo.width = width;
+		depthImageInfo.height = height;
+		depthImageInfo.depth = 1;
+		depthImageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		depthImageInfo.format = m_Device.getSupportedDepthFormat();
+
+		// Output
+		ImageInfo outputImageInfo{};
+		outputImageInfo.width = width;
+		outputImageInfo.height = height;
+		outputImageInfo.depth = 1;
+		outputImageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		outputImageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+
+		m_VisibilityBuffer = std::make_unique<Image>(visibilityImageInfo);
+		m_DepthBuffer = std::make_unique<Image>(depthImageInfo);
+		m_OutputImage = std::make_unique<Image>(outputImageInfo);
+	}
+
+	void VisibilityBufferPass::createRenderPasses() {
+		SubpassInfo subpass{};
+		subpass.renderTargets = { 0 };
+
+		// ------ Geometry Render Pass ------
+		RenderPassAttachment visibilityAttachment = {
+			m_VisibilityBuffer,
+			VK_ATTACHMENT_LOAD_OP_CLEAR, // cleared to 0, i.e. no triangle
+			VK_ATTACHMENT_STORE_OP_STORE,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+		};
+
+		RenderPassAttachment depthAttachment = {
+			m_DepthBuffer,
+			VK_ATTACHMENT_LOAD_OP_CLEAR,
+			VK_ATTACHMENT_STORE_OP_DONT_CARE,
+			VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+		};
+
+		std::vector<RenderPassAttachment> geometryAttachments = {
+			visibilityAttachment,
+			depthAttachment
+		};
+
+		RenderPassInfo geometryPassInfo = {
+			geometryAttachments,
+			{ subpass }
+		};
+
+		m_GeometryPass = std::make_unique<RenderPass>(geometryPassInfo);
+
+		// ------ Resolve Render Pass ------
+		RenderPassAttachment outputAttachment = {
+			m_OutputImage,
+			VK_ATTACHMENT_LOAD_OP_CLEAR,
+			VK_ATTACHMENT_STORE_OP_STORE,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+		};
+
+		std::vector<RenderPassAttachment> resolveAttachments = {
+			outputAttachment
+		};
+
+		RenderPassInfo resolvePassInfo = {
+			resolveAttachments,
+			{ subpass }
+		};
+
+		m_ResolvePass = std::make_unique<RenderPass>(resolvePassInfo);
+	}
+
+	void VisibilityBufferPass::createFramebuffers(uint32_t width, uint32_t height) {
+		FramebufferInfo geometryInfo = {
+			width,
+			height,
+			m_GeometryPass->getVulkanRenderPass(),
+			{ { m_VisibilityBuffer, m_DepthBuffer } }
+		};
+
+		FramebufferInfo resolveInfo = {
+			width,
+			height,
+			m_ResolvePass->getVulkanRenderPass(),
+			{ { m_OutputImage } }
+		};
+
+		m_GeometryFramebuffer = std::make_unique<Framebuffer>(geometryInfo);
+		m_ResolveFramebuffer = std::make_unique<Framebuffer>(resolveInfo);
+	}
+
+	void VisibilityBufferPass::createDescriptorPool() {
+		const uint32_t frameCount = GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT;
+
+		m_GeometryDescriptorSets.resize(frameCount);
+		m_ResolveDescriptorSets.resize(frameCount);
+
+		m_DescriptorPool = DescriptorPool::Builder(m_Device)
+			.setMaxSets(frameCount * 2 + 1)
+			.setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, frameCount * 2) // visibility buffer and shadow map, textures are bound from the device's bindless set
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, frameCount * 2)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 + frameCount) // geometry store buffers + draw data
+			.build();
+	}
+
+	void VisibilityBufferPass::createBuffers() {
+		const size_t frameCount = GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT;
+
+		m_GeometryUBOs.resize(frameCount);
+		m_ResolveUBOs.resize(frameCount);
+		m_DrawBuffers.resize(frameCount);
+
+		for (size_t i = 0; i < frameCount; i++) {
+			m_GeometryUBOs[i] = std::make_unique<Buffer>(
+				m_Device,
+				sizeof(GeometryUBO),
+				1,
+				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			m_GeometryUBOs[i]->map();
+
+			m_ResolveUBOs[i] = std::make_unique<Buffer>(
+				m_Device,
+				sizeof(ResolveUBO),
+				1,
+				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			m_ResolveUBOs[i]->map();
+
+			m_DrawBuffers[i] = std::make_unique<Buffer>(
+				m_Device,
+				sizeof(DrawData),
+				MAX_DRAWS,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			m_DrawBuffers[i]->map();
+		}
+	}
+
+	void VisibilityBufferPass::createSamplers() {
+		SamplerCreateInfo pointSamplerInfo{};
+		pointSamplerInfo.bilinearFiltering = false;
+		pointSamplerInfo.anisotropicFiltering = false;
+
+		SamplerCreateInfo shadowSamplerInfo{};
+		shadowSamplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+		shadowSamplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		shadowSamplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		shadowSamplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+		m_PointSampler = std::make_unique<Sampler>(pointSamplerInfo, m_Device);
+		m_ShadowSampler = std::make_unique<Sampler>(shadowSamplerInfo, m_Device);
+	}
+
+	void VisibilityBufferPass::createDescriptorSetLayout() {
+		m_GeometrySetLayout = DescriptorSetLayout::Builder(m_Device)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+			.build();
+
+		m_ResolveSetLayout = DescriptorSetLayout::Builder(m_Device)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT) // visibility buffer
+			.addBinding(1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT) // draw data
+			.addBinding(3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT) // shadow map
+			.build();
+
+		// Rewritten whenever the geometry store reallocates its buffers
+		m_GeometryStoreSetLayout = DescriptorSetLayout::Builder(m_Device)
+			.setLayoutFlags(VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, 1,
+				VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) // vertices
+			.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, 1,
+				VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) // 32-bit indices
+			.addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, 1,
+				VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) // positions
+			.addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, 1,
+				VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) // 16-bit indices
+			.build();
+
+		for (size_t i = 0; i < m_GeometryDescriptorSets.size(); i++) {
+			auto bufferInfo = m_GeometryUBOs[i]->getDescriptorInfo();
+
+			DescriptorWriter(*m_GeometrySetLayout, *m_DescriptorPool)
+				.writeBuffer(0, &bufferInfo)
+				.build(m_GeometryDescriptorSets[i]);
+
+			// Written once the shadow map is known
+			DescriptorWriter(*m_ResolveSetLayout, *m_DescriptorPool)
+				.build(m_ResolveDescriptorSets[i]);
+		}
+
+		DescriptorWriter(*m_GeometryStoreSetLayout, *m_DescriptorPool)
+			.build(m_GeometryStoreDescriptorSet);
+	}
+
+	void VisibilityBufferPass::createPipelines() {
+		// ------ Geometry Pipeline ------
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(GeometryPushConstant);
+
+		VkDescriptorSetLayout geometrySetLayout = m_GeometrySetLayout->getDescriptorSetLayout();
+
+		VkPipelineLayoutCreateInfo geometryLayoutInfo{};
+		geometryLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		geometryLayoutInfo.setLayoutCount = 1;
+		geometryLayoutInfo.pSetLayouts = &geometrySetLayout;
+		geometryLayoutInfo.pushConstantRangeCount = 1;
+		geometryLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+		if (vkCreatePipelineLayout(m_Device.getDevice(), &geometryLayoutInfo, nullptr, &m_GeometryPipelineLayout) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to create visibility buffer pipeline layout!");
+		}
+
+		PipelineConfigInfo geometryConfigInfo{};
+		GraphicsPipeline::defaultPipelineConfigInfo(geometryConfigInfo);
+		geometryConfigInfo.bindingDescriptions = Vertex3D::getPositionBindingDescriptions();
+		geometryConfigInfo.attributeDescriptions = Vertex3D::getPositionAttributeDescriptions();
+		geometryConfigInfo.renderPass = m_GeometryPass->getVulkanRenderPass();
+		geometryConfigInfo.pipelineLayout = m_GeometryPipelineLayout;
+		geometryConfigInfo.colorBlendAttachment.blendEnable = VK_FALSE; // integer attachments can not be blended
+
+		m_GeometryPipeline = std::make_unique<GraphicsPipeline>(
+			m_Device,
+			"assets/shaders/visibility.vert.spv",
+			"assets/shaders/visibility.frag.spv",
+			geometryConfigInfo);
+
+		// ------ Resolve Pipeline ------
+		std::vector<VkDescriptorSetLayout> resolveSetLayouts = {
+			m_ResolveSetLayout->getDescriptorSetLayout(),
+			m_Device.getBindlessTextureSetLayout().getDescriptorSetLayout(),
+			m_GeometryStoreSetLayout->getDescriptorSetLayout(),
+			m_LightCullingPass.getDescriptorSetLayout().getDescriptorSetLayout()
+		};
+
+		VkPipelineLayoutCreateInfo resolveLayoutInfo{};
+		resolveLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		resolveLayoutInfo.setLayoutCount = static_cast<uint32_t>(resolveSetLayouts.size());
+		resolveLayoutInfo.pSetLayouts = resolveSetLayouts.data();
+		resolveLayoutInfo.pushConstantRangeCount = 0;
+		resolveLayoutInfo.pPushConstantRanges = nullptr;
+
+		if (vkCreatePipelineLayout(m_Device.getDevice(), &resolveLayoutInfo, nullptr, &m_ResolvePipelineLayout) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to create visibility resolve pipeline layout!");
+		}
+
+		// One variant per shading quality
+		m_ResolvePipelines = std::make_unique<PipelinePermutations>(m_Device,
+			"assets/shaders/deferred.vert.spv",
+			"assets/shaders/visibilityResolve.frag.spv",
+			[this](PipelineConfigInfo& resolveConfigInfo) {
+				GraphicsPipeline::defaultPipelineConfigInfo(resolveConfigInfo);
+				resolveConfigInfo.bindingDescriptions = {};
+				resolveConfigInfo.attributeDescriptions = {};
+				resolveConfigInfo.renderPass = m_ResolvePass->getVulkanRenderPass();
+				resolveConfigInfo.pipelineLayout = m_ResolvePipelineLayout;
+			});
+	}
+
+	void VisibilityBufferPass::writeResolveDescriptorSets(Image* shadowMap) {
+		VkDescriptorImageInfo visibilityInfo{};
+		visibilityInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		visibilityInfo.imageView = m_VisibilityBuffer->getVulkanImageView();
+		visibilityInfo.sampler = m_PointSampler->getVkSampler();
+
+		VkDescriptorImageInfo shadowMapInfo{};
+		shadowMapInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		shadowMapInfo.imageView = shadowMap->getVulkanImageView();
+		shadowMapInfo.sampler = m_ShadowSampler->getVkSampler();
+
+		for (size_t i = 0; i < m_ResolveDescriptorSets.size(); i++) {
+			auto uboInfo = m_ResolveUBOs[i]->getDescriptorInfo();
+			auto drawInfo = m_DrawBuffers[i]->getDescriptorInfo();
+
+			DescriptorWriter(*m_ResolveSetLayout, *m_DescriptorPool)
+				.writeImage(0, &visibilityInfo)
+				.writeBuffer(1, &uboInfo)
+				.writeBuffer(2, &drawInfo)
+				.writeImage(3, &shadowMapInfo)
+				.overwrite(m_ResolveDescriptorSets[i]);
+		}
+
+		m_BoundShadowMap = shadowMap;
+	}
+
+	void VisibilityBufferPass::writeGeometryDescriptorSet() {
+		GeometryStore& geometryStore = m_Device.getGeometryStore();
+
+		auto vertexBufferInfo = geometryStore.getVertexBuffer()->getDescriptorInfo();
+		auto indexBufferInfo = geometryStore.getIndexBuffer(VK_INDEX_TYPE_UINT32)->getDescriptorInfo();
+		auto positionBufferInfo = geometryStore.getPositionBuffer()->getDescriptorInfo();
+		auto shortIndexBufferInfo = geometryStore.getIndexBuffer(VK_INDEX_TYPE_UINT16)->getDescriptorInfo();
+
+		DescriptorWriter(*m_GeometryStoreSetLayout, *m_DescriptorPool)
+			.writeBuffer(0, &vertexBufferInfo)
+			.writeBuffer(1, &indexBufferInfo)
+			.writeBuffer(2, &positionBufferInfo)
+			.writeBuffer(3, &shortIndexBufferInfo)
+			.overwrite(m_GeometryStoreDescriptorSet);
+
+		m_GeometryGeneration = geometryStore.getGeneration();
+	}
+
+}
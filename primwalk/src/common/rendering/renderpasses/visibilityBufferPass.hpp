@@ -0,0 +1,133 @@
+#pragma once
+
+#include "../../../core.hpp"
+#include "../../components/component.hpp"
+#include "../buffer.hpp"
+#include "../descriptors.hpp"
+#include "../framebuffer.hpp"
+#include "../graphicsDevice_Vulkan.hpp"
+#include "../graphicsPipeline.hpp"
+#include "../image.hpp"
+#include "../lodSelector.hpp"
+#include "../renderpass.hpp"
+#include "../sampler.hpp"
+#include "../shaderPermutation.hpp"
+#include "../texture2D.hpp"
+#include "lightCullingPass.hpp"
+
+#include "../../managers/componentManager.hpp"
+
+// std
+#include <memory>
+#include <set>
+#include <vector>
+
+namespace pw {
+	// Visibility buffer rendering: the geometry pass only writes a packed (draw ID, triangle ID) per pixel plus depth.
+	// A full-screen resolve then fetches the triangle from the geometry store, reconstructs barycentrics and their
+	// derivatives, and shades every pixel exactly once regardless of overdraw.
+	class VisibilityBufferPass {
+	public:
+		VisibilityBufferPass(uint32_t width, uint32_t height, GraphicsDevice_Vulkan& device, LightCullingPass& lightCullingPass,
+			const ShadingQuality& shadingQuality);
+		~VisibilityBufferPass();
+
+		void draw(VkCommandBuffer commandBuffer, size_t frameIndex, std::set<entity_id>& entities, ComponentManager& manager,
+			Image* shadowMap, const glm::mat4& lightSpaceMatrix);
+		void resize(uint32_t width, uint32_t height);
+		void setShadingQuality(const ShadingQuality& quality); // the variant is compiled the first time it is selected
+
+		inline Image* getOutputImage() { return m_OutputImage.get(); }
+
+		// NOTE: Must match visibility.frag and visibilityResolve.frag
+		static constexpr uint32_t TRIANGLE_ID_BITS = 20;
+		static constexpr uint32_t MAX_DRAWS = (1u << (32 - TRIANGLE_ID_BITS)) - 1; // draw ID 0 marks empty pixels
+		static constexpr uint32_t MAX_DRAW_TRIANGLES = 1u << TRIANGLE_ID_BITS; // larger meshes are skipped
+
+	private:
+		struct DirectionLightParams {
+			alignas(16) glm::vec3 direction{};
+			alignas(16) glm::vec3 color{};
+		};
+
+		struct GeometryUBO {
+			alignas(16) glm::mat4 view{ 1.0f };
+			alignas(16) glm::mat4 proj{ 1.0f };
+		};
+
+		struct ResolveUBO {
+			alignas(16) glm::mat4 view{ 1.0f };
+			alignas(16) glm::mat4 proj{ 1.0f };
+			alignas(16) glm::mat4 lightSpaceMatrix{ 1.0f };
+			alignas(16) glm::vec3 viewPosition{};
+			DirectionLightParams directionLight{};
+			alignas(8) glm::vec2 screenSize{};
+		};
+
+		struct DrawData {
+			alignas(16) glm::mat4 modelMatrix{ 1.0f };
+			alignas(4) uint32_t baseIndex = 0;
+			alignas(4) int32_t baseVertex = 0;
+			alignas(4) uint32_t diffuseTexIndex = 0;
+			alignas(4) uint32_t normalMapIndex = 0;
+			alignas(4) uint32_t shortIndices = 0; // indices are read from the 16-bit buffer
+		};
+
+		struct GeometryPushConstant {
+			alignas(16) glm::mat4 modelMatrix{ 1.0f };
+			alignas(4) uint32_t drawID = 0;
+		};
+
+		void createImages(uint32_t width, uint32_t height);
+		void createRenderPasses();
+		void createFramebuffers(uint32_t width, uint32_t height);
+		void createDescriptorPool();
+		void createBuffers();
+		void createSamplers();
+		void createDescriptorSetLayout();
+		void createPipelines();
+
+		void writeResolveDescriptorSets(Image* shadowMap);
+		void writeGeometryDescriptorSet(); // the geometry store's buffers
+
+		GraphicsDevice_Vulkan& m_Device;
+		LightCullingPass& m_LightCullingPass;
+
+		// Geometry pass
+		std::unique_ptr<RenderPass> m_GeometryPass;
+		std::unique_ptr<Framebuffer> m_GeometryFramebuffer;
+		std::unique_ptr<Image> m_VisibilityBuffer;
+		std::unique_ptr<Image> m_DepthBuffer;
+		std::unique_ptr<GraphicsPipeline> m_GeometryPipeline;
+		VkPipelineLayout m_GeometryPipelineLayout = VK_NULL_HANDLE;
+
+		// Resolve pass
+		std::unique_ptr<RenderPass> m_ResolvePass;
+		std::unique_ptr<Framebuffer> m_ResolveFramebuffer;
+		std::unique_ptr<Image> m_OutputImage;
+		std::unique_ptr<PipelinePermutations> m_ResolvePipelines;
+		GraphicsPipeline* m_ResolvePipeline = nullptr; // variant of the current shading quality
+		VkPipelineLayout m_ResolvePipelineLayout = VK_NULL_HANDLE;
+
+		std::unique_ptr<DescriptorPool> m_DescriptorPool;
+
+		std::unique_ptr<DescriptorSetLayout> m_GeometrySetLayout{};
+		std::vector<VkDescriptorSet> m_GeometryDescriptorSets;
+		std::vector<std::unique_ptr<Buffer>> m_GeometryUBOs;
+		bool m_TriangleOverflowReported = false; // the diagnostic is printed only once
+
+		std::unique_ptr<DescriptorSetLayout> m_ResolveSetLayout{};
+		std::vector<VkDescriptorSet> m_ResolveDescriptorSets;
+		std::vector<std::unique_ptr<Buffer>> m_ResolveUBOs;
+		std::vector<std::unique_ptr<Buffer>> m_DrawBuffers;
+		LODSelector m_LODSelector;
+		Image* m_BoundShadowMap = nullptr;
+
+		std::unique_ptr<DescriptorSetLayout> m_GeometryStoreSetLayout{};
+		VkDescriptorSet m_GeometryStoreDescriptorSet = VK_NULL_HANDLE;
+		uint64_t m_GeometryGeneration = UINT64_MAX; // of the buffers in the set
+
+		std::unique_ptr<Sampler> m_PointSampler;
+		std::unique_ptr<Sampler> m_ShadowSampler;
+	};
+}
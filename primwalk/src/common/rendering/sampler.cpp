@@ -37,6 +37,7 @@ namespace pw {
 	}
 
 	Sampler::~Sampler() {
+		m_Device.getDescriptorBatcher().forgetSampler(m_Sampler);
 		vkDestroySampler(m_Device.getDevice(), m_Sampler, nullptr);
 	}
 
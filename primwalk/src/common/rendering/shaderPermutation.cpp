@@ -0,0 +1,118 @@
+// primwalk
+#include "shaderPermutation.hpp"
+#include "graphicsPipeline.hpp"
+
+// std
+#include <algorithm>
+#include <cstring>
+
+namespace pw {
+	// ------ ShaderPermutation ------
+	ShaderPermutation& ShaderPermutation::setBool(uint32_t constantID, bool value) {
+		return setWord(constantID, value ? VK_TRUE : VK_FALSE);
+	}
+
+	ShaderPermutation& ShaderPermutation::setInt(uint32_t constantID, int32_t value) {
+		return setWord(constantID, static_cast<uint32_t>(value));
+	}
+
+	ShaderPermutation& ShaderPermutation::setUint(uint32_t constantID, uint32_t value) {
+		return setWord(constantID, value);
+	}
+
+	ShaderPermutation& ShaderPermutation::setFloat(uint32_t constantID, float value) {
+		uint32_t word = 0;
+		std::memcpy(&word, &value, sizeof(word));
+
+		return setWord(constantID, word);
+	}
+
+	ShaderPermutation& ShaderPermutation::setWord(uint32_t constantID, uint32_t word) {
+		auto it = std::lower_bound(m_Entries.begin(), m_Entries.end(), constantID, [](const VkSpecializationMapEntry& entry, uint32_t id) {
+			return entry.constantID < id;
+		});
+
+		size_t index = static_cast<size_t>(it - m_Entries.begin());
+		if (it != m_Entries.end() && it->constantID == constantID) {
+			m_Data[index] = word;
+			return *this;
+		}
+
+		VkSpecializationMapEntry entry{};
+		entry.constantID = constantID;
+		entry.size = sizeof(uint32_t);
+
+		m_Entries.insert(it, entry);
+		m_Data.insert(m_Data.begin() + index, word);
+
+		for (size_t i = 0; i < m_Entries.size(); i++) {
+			m_Entries[i].offset = static_cast<uint32_t>(i * sizeof(uint32_t));
+		}
+
+		return *this;
+	}
+
+	VkSpecializationInfo ShaderPermutation::getSpecializationInfo() const {
+		VkSpecializationInfo info{};
+		info.mapEntryCount = static_cast<uint32_t>(m_Entries.size());
+		info.pMapEntries = m_Entries.data();
+		info.dataSize = m_Data.size() * sizeof(uint32_t);
+		info.pData = m_Data.data();
+
+		return info;
+	}
+
+	uint64_t ShaderPermutation::getHash() const {
+		// FNV-1a over the IDs and values
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t i = 0; i < m_Entries.size(); i++) {
+			hash = (hash ^ m_Entries[i].constantID) * 1099511628211ull;
+			hash = (hash ^ m_Data[i]) * 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	bool ShaderPermutation::operator==(const ShaderPermutation& other) const {
+		if (m_Data != other.m_Data || m_Entries.size() != other.m_Entries.size()) {
+			return false;
+		}
+
+		for (size_t i = 0; i < m_Entries.size(); i++) {
+			if (m_Entries[i].constantID != other.m_Entries[i].constantID) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// ------ PipelinePermutations ------
+	PipelinePermutations::PipelinePermutations(GraphicsDevice_Vulkan& device, const std::string& vertPath, const std::string& fragPath,
+		ConfigFunction configure) : m_Device(device), m_VertPath(vertPath), m_FragPath(fragPath), m_Configure(std::move(configure)) {}
+
+	PipelinePermutations::~PipelinePermutations() = default; // GraphicsPipeline is incomplete in the header
+
+	GraphicsPipeline& PipelinePermutations::get(const ShaderPermutation& permutation) {
+		auto it = m_Variants.find(permutation);
+		if (it != m_Variants.end()) {
+			return *it->second;
+		}
+
+		PipelineConfigInfo configInfo{};
+		m_Configure(configInfo);
+		configInfo.permutation = permutation;
+
+		auto variant = std::make_unique<GraphicsPipeline>(m_Device, m_VertPath, m_FragPath, configInfo);
+		return *m_Variants.emplace(permutation, std::move(variant)).first->second;
+	}
+
+	ShaderPermutation getLightingPermutation(const ShadingQuality& quality) {
+		ShaderPermutation permutation{};
+		permutation.setBool(0, quality.pcfShadows);
+		permutation.setInt(1, quality.pcfRadius);
+		permutation.setFloat(2, quality.ambientIntensity);
+
+		return permutation;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+
+// primwalk
+#include "../../core.hpp"
+#include "renderSettings.hpp"
+
+// std
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// vendor
+#include <vulkan/vulkan.h>
+
+namespace pw {
+	// Forward declarations
+	class GraphicsDevice_Vulkan;
+	class GraphicsPipeline;
+	struct PipelineConfigInfo;
+
+	/*
+	* Values for the specialization constants of a pipeline's shaders (layout (constant_id = N) const ...). The driver
+	* compiles them in as literals, so branches on them are removed instead of being evaluated for every invocation.
+	* Stages ignore constants they do not declare. Permutations holding the same values compare equal, no matter the
+	* order they were set in.
+	*/
+	class PW_API ShaderPermutation {
+	public:
+		ShaderPermutation& setBool(uint32_t constantID, bool value);
+		ShaderPermutation& setInt(uint32_t constantID, int32_t value);
+		ShaderPermutation& setUint(uint32_t constantID, uint32_t value);
+		ShaderPermutation& setFloat(uint32_t constantID, float value);
+
+		VkSpecializationInfo getSpecializationInfo() const; // points into the permutation
+		uint64_t getHash() const;
+		inline bool isEmpty() const { return m_Entries.empty(); }
+
+		bool operator==(const ShaderPermutation& other) const;
+
+		struct Hash {
+			size_t operator()(const ShaderPermutation& permutation) const { return static_cast<size_t>(permutation.getHash()); }
+		};
+
+	private:
+		ShaderPermutation& setWord(uint32_t constantID, uint32_t word);
+
+		std::vector<VkSpecializationMapEntry> m_Entries; // sorted by constant ID
+		std::vector<uint32_t> m_Data; // every supported constant type is 4 bytes wide
+	};
+
+	/*
+	* The variants of one graphics pipeline. A variant is created the first time its permutation is requested and
+	* kept until the pass is destroyed, switching back and forth is free. The compile runs on the device's
+	* PipelineCompiler, so requesting a variant before the frame that binds it hides most of it. Main thread only.
+	*/
+	class PW_API PipelinePermutations {
+	public:
+		using ConfigFunction = std::function<void(PipelineConfigInfo&)>; // everything but the permutation
+
+		PipelinePermutations(GraphicsDevice_Vulkan& device, const std::string& vertPath, const std::string& fragPath,
+			ConfigFunction configure);
+		~PipelinePermutations();
+
+		// Forbid copy and move semantics
+		PipelinePermutations(const PipelinePermutations&) = delete;
+		PipelinePermutations& operator=(const PipelinePermutations&) = delete;
+
+		GraphicsPipeline& get(const ShaderPermutation& permutation);
+
+		// Getters
+		inline size_t getVariantCount() const { return m_Variants.size(); }
+
+	private:
+		GraphicsDevice_Vulkan& m_Device;
+		std::string m_VertPath;
+		std::string m_FragPath;
+		ConfigFunction m_Configure;
+		std::unordered_map<ShaderPermutation, std::unique_ptr<GraphicsPipeline>, ShaderPermutation::Hash> m_Variants;
+	};
+
+	// Specialization constants declared by lighting.glsl
+	PW_API ShaderPermutation getLightingPermutation(const ShadingQuality& quality);
+}
@@ -3,6 +3,8 @@
 #include "../buffer.hpp"
 #include "../graphicsDevice_Vulkan.hpp"
 #include "../graphicsPipeline.hpp"
+#include "../pipelineLayoutCache.hpp"
+#include "../uploadManager.hpp"
 
 #include "../descriptors.hpp"
 #include "../texture2D.hpp"
@@ -32,16 +34,10 @@ namespace pw {
 		createPipeline(renderPass);
 		createVertexBuffer();
 		createIndexBuffer();
-		createSamplers();
-
-		// Textures
-		m_Textures.push_back(std::make_shared<Texture2D>(1, 1, std::vector<uint8_t>(4, 255).data())); // default 1x1 white texture
-		addTexture(m_Textures[0]->getImage());
 	}
 
 	UIRenderSystem::~UIRenderSystem() {
-		vkDestroyPipelineLayout(m_Device.getDevice(), m_BasePipelineLayout, nullptr);
-		vkDestroyPipelineLayout(m_Device.getDevice(), m_FontPipelineLayout, nullptr);
+
 	}
 
 	void UIRenderSystem::onUpdate(const FrameInfo& frameInfo) {
@@ -70,12 +66,14 @@ namespace pw {
 		vkCmdBindVertexBuffers(frameInfo.commandBuffer, 0, 1, vertexBuffers, offsets);
 		vkCmdBindIndexBuffer(frameInfo.commandBuffer, m_IndexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT16);
 
+		VkDescriptorSet textureDescriptorSet = m_Device.getBindlessTextureSet();
+
 		vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
 			m_BasePipelineLayout, 0, 1, &m_UniformDescriptorSets[frameInfo.frameIndex], 0, nullptr);
 		vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
 			m_BasePipelineLayout, 1, 1, &m_StorageDescriptorSets[frameInfo.frameIndex], 0, nullptr);
 		vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-			m_BasePipelineLayout, 2, 1, &m_TextureDescriptorSet, 0, nullptr);
+			m_BasePipelineLayout, 2, 1, &textureDescriptorSet, 0, nullptr);
 		vkCmdDrawIndexed(frameInfo.commandBuffer, static_cast<uint32_t>(m_Indices.size()), static_cast<uint32_t>(m_RenderParams.size()), 0, 0, 0);
 
 		// Font pipeline rendering
@@ -89,10 +87,6 @@ namespace pw {
 		m_FontRenderParams.clear();
 	}
 
-	void UIRenderSystem::removeImage(Image* image) {
-		freeTextureID(image);
-	}
-
 	void UIRenderSystem::drawRect(glm::vec2 position, float width, float height,
 		Color color, int borderRadius, std::shared_ptr<Texture2D> texture,
 		glm::vec2 scissorPos, int scissorWidth, int scissorHeight) {
@@ -100,23 +94,7 @@ namespace pw {
 		uint32_t texIndex = 0;
 
 		if (texture != nullptr) {
-			texIndex = addTexture(texture->getImage());
-
-			////
-			//bool hasID = m_Device.getTextureID(texture->getImage(), &texIndex);
-
-			//if (!hasID) {
-			//	texIndex = m_Device.addTextureID(texture->getImage());
-
-			//	VkDescriptorImageInfo imageInfo{};
-			//	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			//	imageInfo.imageView = texture->getImageView();
-			//	imageInfo.sampler = Renderer::m_TextureSampler;
-
-			//	DescriptorWriter(*m_TextureSetLayout, m_Device.getBindlessPool())
-			//		.writeImage(0, &imageInfo, texIndex)
-			//		.overwrite(m_TextureDescriptorSet);
-			//}
+			texIndex = texture->getImage()->getBindlessIndex();
 		}
 
 		RenderParams params{};
@@ -158,11 +136,7 @@ namespace pw {
 		double xPos = position.x;
 		double yPos = position.y;
 		double scale = fontSize / font->getFontSize();
-		uint32_t texIndex = 2;
-
-		if (font != nullptr) {
-			texIndex = addTexture(font->getTextureAtlas().getImage());
-		}
+		uint32_t texIndex = font->getTextureAtlas().getImage()->getBindlessIndex();
 
 
 		for (size_t i = 0; i < text.length(); i++) {
@@ -214,13 +188,13 @@ namespace pw {
 		drawText(newPosition, text, fontSize, color, font);
 	}
 
-	void UIRenderSystem::drawFramebuffer(Image* image, glm::vec2 position, int width, int height) {
+	void UIRenderSystem::drawFramebuffer(Image* image, glm::vec2 position, int width, int height, glm::vec2 uvExtent) {
 		if (width == 0 && height == 0) {
 			width = image->getWidth();
 			height = image->getHeight();
 		}
 
-		uint32_t texIndex = addTexture(image);
+		uint32_t texIndex = image->getBindlessIndex();
 
 		RenderParams params{};
 		params.position = position;
@@ -234,29 +208,21 @@ namespace pw {
 		glm::vec2 normScissorTR = { 1, 1 };
 		glm::vec2 normScissorTL = { 0, 1 };
 
-		params.texCoords[0] = normScissorBL;
-		params.texCoords[1] = normScissorBR;
-		params.texCoords[2] = normScissorTR;
-		params.texCoords[3] = normScissorTL;
+		params.texCoords[0] = normScissorBL * uvExtent;
+		params.texCoords[1] = normScissorBR * uvExtent;
+		params.texCoords[2] = normScissorTR * uvExtent;
+		params.texCoords[3] = normScissorTL * uvExtent;
 
 		m_RenderParams.push_back(params);
 	}
 
 	void UIRenderSystem::createDescriptorSetLayout() {
-		// Descriptor set layouts
-		uniformSetLayout = DescriptorSetLayout::Builder(m_Device)
-			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
-			.build();
-
-		storageSetLayout = DescriptorSetLayout::Builder(m_Device)
-			.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
-			.build();
+		// Descriptor set layouts, both pipelines declare the same interface
+		m_BaseReflection = Shader_Vulkan::reflectFiles({ "assets/shaders/shader.vert.spv", "assets/shaders/shader.frag.spv" });
+		m_FontReflection = Shader_Vulkan::reflectFiles({ "assets/shaders/glyphShader.vert.spv", "assets/shaders/glyphShader.frag.spv" });
 
-		m_TextureSetLayout = DescriptorSetLayout::Builder(m_Device)
-			.setLayoutFlags(VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT)
-			.addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1024,
-				VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT)
-			.build();
+		uniformSetLayout = &m_Device.getPipelineLayoutCache().getSetLayout(m_BaseReflection, 0);
+		storageSetLayout = &m_Device.getPipelineLayoutCache().getSetLayout(m_BaseReflection, 1);
 
 		// Uniform buffer
 		for (size_t i = 0; i < m_UniformDescriptorSets.size(); i++) {
@@ -283,45 +249,13 @@ namespace pw {
 				.writeBuffer(0, &bufferInfo)
 				.build(m_FontStorageDescriptorSets[i]);
 		}
-
-		DescriptorWriter(*m_TextureSetLayout, m_Device.getBindlessPool())
-			.build(m_TextureDescriptorSet);
-
-		m_BaseDescriptorSetLayouts = {
-			uniformSetLayout->getDescriptorSetLayout(),
-			storageSetLayout->getDescriptorSetLayout(),
-			m_TextureSetLayout->getDescriptorSetLayout()
-		};
-
-		m_FontDescriptorSetLayouts = {
-			uniformSetLayout->getDescriptorSetLayout(),
-			storageSetLayout->getDescriptorSetLayout(),
-			m_TextureSetLayout->getDescriptorSetLayout()
-		};
 	}
 
 	void UIRenderSystem::createPipelineLayout() {
-		// Base pipeline layout
-		VkPipelineLayoutCreateInfo basePipelineLayoutInfo{};
-		basePipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		basePipelineLayoutInfo.pushConstantRangeCount = 0;
-		basePipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(m_BaseDescriptorSetLayouts.size());
-		basePipelineLayoutInfo.pSetLayouts = m_BaseDescriptorSetLayouts.data();
-
-		if (vkCreatePipelineLayout(m_Device.getDevice(), &basePipelineLayoutInfo, nullptr, &m_BasePipelineLayout) != VK_SUCCESS) {
-			throw std::runtime_error("VULKAN ERROR: Failed to create pipeline layout!");
-		}
-
-		// Font pipeline layout
-		VkPipelineLayoutCreateInfo fontPipelineLayoutInfo{};
-		fontPipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		fontPipelineLayoutInfo.pushConstantRangeCount = 0;
-		fontPipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(m_FontDescriptorSetLayouts.size());
-		fontPipelineLayoutInfo.pSetLayouts = m_FontDescriptorSetLayouts.data();
-
-		if (vkCreatePipelineLayout(m_Device.getDevice(), &fontPipelineLayoutInfo, nullptr, &m_FontPipelineLayout) != VK_SUCCESS) {
-			throw std::runtime_error("VULKAN ERROR: Failed to create pipeline layout!");
-		}
+		// Textures come from the device's bindless set (set 2). The layouts are cached by their contents, so both
+		// pipelines end up with the same one and the font pipeline only has to rebind set 1.
+		m_BasePipelineLayout = m_Device.getPipelineLayoutCache().getPipelineLayout(m_BaseReflection);
+		m_FontPipelineLayout = m_Device.getPipelineLayoutCache().getPipelineLayout(m_FontReflection);
 	}
 
 	void UIRenderSystem::createPipeline(VkRenderPass renderPass) {
@@ -356,13 +290,6 @@ namespace pw {
 		uint32_t vertexCount = static_cast<uint32_t>(m_Vertices.size());
 		uint32_t vertexSize = sizeof(m_Vertices[0]);
 
-		// Staging buffer
-		Buffer stagingBuffer(m_Device, vertexSize, vertexCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*)m_Vertices.data());
-		stagingBuffer.unmap();
-
 		m_VertexBuffer = std::make_unique<Buffer>(
 			m_Device,
 			vertexSize,
@@ -371,7 +298,7 @@ namespace pw {
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
 		);
 
-		m_Device.copyBuffer(stagingBuffer.getBuffer(), m_VertexBuffer->getBuffer(), bufferSize);
+		m_Device.getUploadManager().uploadBuffer(*m_VertexBuffer, m_Vertices.data(), bufferSize);
 	}
 
 	void UIRenderSystem::createIndexBuffer() {
@@ -379,13 +306,6 @@ namespace pw {
 		uint32_t indexCount = static_cast<uint32_t>(m_Indices.size());
 		uint32_t indexSize = sizeof(m_Indices[0]);
 
-		// Staging buffer
-		Buffer stagingBuffer(m_Device, indexSize, indexCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*)m_Indices.data());
-		stagingBuffer.unmap();
-
 		// Index buffer
 		m_IndexBuffer = std::make_unique<Buffer>(
 			m_Device,
@@ -395,12 +315,7 @@ namespace pw {
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
 		);
 
-		m_Device.copyBuffer(stagingBuffer.getBuffer(), m_IndexBuffer->getBuffer(), bufferSize);
-	}
-
-	void UIRenderSystem::createSamplers() {
-		SamplerCreateInfo samplerInfo{};
-		m_Sampler = std::make_unique<Sampler>(samplerInfo, m_Device);
+		m_Device.getUploadManager().uploadBuffer(*m_IndexBuffer, m_Indices.data(), bufferSize);
 	}
 
 	void UIRenderSystem::createUniformBuffers() {
@@ -456,53 +371,4 @@ namespace pw {
 		m_FontStorageDescriptorSets.resize(GraphicsDevice_Vulkan::MAX_FRAMES_IN_FLIGHT);
 	}
 
-	// TODO: Add check for nullptr
-	uint32_t UIRenderSystem::addTexture(Image* image) {
-		auto idSearch = m_TextureIDs.find(image);
-
-		if (idSearch == m_TextureIDs.end()) { // texture is not associated with any ID yet
-			uint32_t id = m_TextureIDs.size();
-
-			if (!m_VacantTextureIDs.empty()) {
-				id = *m_VacantTextureIDs.begin(); // get the lowest vacant ID
-				m_VacantTextureIDs.erase(m_VacantTextureIDs.begin());
-			}
-
-			VkDescriptorImageInfo imageInfo{};
-			imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			imageInfo.imageView = image->getVulkanImageView();
-			imageInfo.sampler = m_Sampler->getVkSampler();
-
-			DescriptorWriter(*m_TextureSetLayout, m_Device.getBindlessPool())
-				.writeImage(0, &imageInfo, id)
-				.overwrite(m_TextureDescriptorSet);
-
-			m_TextureIDs.insert({ image, id });
-			return id;
-		}
-
-		return idSearch->second;
-	}
-
-	void UIRenderSystem::freeTextureID(Image* image) {
-		auto idSearch = m_TextureIDs.find(image);
-
-		if (idSearch == m_TextureIDs.end()) { // texture has no ID, can not free ID
-			return;
-		}
-
-		// Clear the image from the texture descriptor
-		VkDescriptorImageInfo imageInfo{};
-		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		imageInfo.imageView = m_Textures[0]->getImageView(); // default 1x1 white texture
-		imageInfo.sampler = m_Sampler->getVkSampler();
-
-		DescriptorWriter(*m_TextureSetLayout, m_Device.getBindlessPool())
-			.writeImage(0, &imageInfo, idSearch->second)
-			.overwrite(m_TextureDescriptorSet);
-
-		m_VacantTextureIDs.emplace(idSearch->second);
-		m_TextureIDs.erase(image);
-	}
-
 }
\ No newline at end of file
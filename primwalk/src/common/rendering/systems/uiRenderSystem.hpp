@@ -4,6 +4,7 @@
 #include "../../../core.hpp"
 #include "../../color.hpp"
 #include "../../math/hitbox.hpp"
+#include "../../data/shader.hpp"
 #include "../frameInfo.hpp"
 #include "../vertex.hpp"
 #include "../sampler.hpp"
@@ -54,7 +55,6 @@ namespace pw {
 		// Events
 		void onUpdate(const FrameInfo& frameInfo);
 		void onRender(const FrameInfo& frameInfo);
-		void removeImage(Image* image);
 
 		void drawRect(glm::vec2 position,float width, float height,
 			Color color, int borderRadius = 0, std::shared_ptr<Texture2D> texture = nullptr,
@@ -63,7 +63,7 @@ namespace pw {
 		void drawTextCentered(glm::vec2 position, const std::string& text, Color color, double fontSize = 0, std::shared_ptr<Font> font = nullptr);
 
 		// Draw a framebuffer image, default width = 0, height = 0 means the image will be drawn at its original resolution
-		void drawFramebuffer(Image* image, glm::vec2 position, int width = 0, int height = 0);
+		void drawFramebuffer(Image* image, glm::vec2 position, int width = 0, int height = 0, glm::vec2 uvExtent = { 1.0f, 1.0f }); // uvExtent < 1 shows only the top-left part
 
 	private:
 		struct UniformBufferObject {
@@ -77,14 +77,6 @@ namespace pw {
 		void createPipeline(VkRenderPass renderPass);
 		void createVertexBuffer();
 		void createIndexBuffer();
-		void createSamplers();
-
-		uint32_t addTexture(Image* image);
-
-		// TODO: It will not remove texture from m_Textures if the related Vulkan image was bounded through Texture2D object
-		void freeTextureID(Image* image);
-		std::unordered_map<Image*, uint32_t> m_TextureIDs{};
-		std::set<uint32_t> m_VacantTextureIDs{};
 
 		std::vector<RenderParams> m_RenderParams;
 		std::vector<FontRenderParams> m_FontRenderParams;
@@ -96,13 +88,12 @@ namespace pw {
 		VkPipelineLayout m_BasePipelineLayout = VK_NULL_HANDLE;
 		VkPipelineLayout m_FontPipelineLayout = VK_NULL_HANDLE;
 
-		std::vector<VkDescriptorSetLayout> m_BaseDescriptorSetLayouts;
-		std::vector<VkDescriptorSetLayout> m_FontDescriptorSetLayouts;
-		std::unique_ptr<DescriptorSetLayout> uniformSetLayout{};
-		std::unique_ptr<DescriptorSetLayout> storageSetLayout{};
-		std::unique_ptr<DescriptorSetLayout> m_TextureSetLayout{};
+		// Reflected from the shaders, owned by the device's PipelineLayoutCache
+		ShaderReflection m_BaseReflection{};
+		ShaderReflection m_FontReflection{};
+		DescriptorSetLayout* uniformSetLayout = nullptr;
+		DescriptorSetLayout* storageSetLayout = nullptr;
 
-		std::vector<std::shared_ptr<Texture2D>> m_Textures;
 		std::vector<std::shared_ptr<Font>> m_Fonts;
 
 		std::unique_ptr<Buffer> m_VertexBuffer;
@@ -113,8 +104,6 @@ namespace pw {
 		std::vector<VkDescriptorSet> m_UniformDescriptorSets;
 		std::vector<VkDescriptorSet> m_StorageDescriptorSets;
 		std::vector<VkDescriptorSet> m_FontStorageDescriptorSets;
-		VkDescriptorSet m_TextureDescriptorSet = VK_NULL_HANDLE;
-		std::unique_ptr<Sampler> m_Sampler;
 
 		const std::vector<Vertex> m_Vertices = {
 			{ { 0.0f, 0.0f }, { 0.0f, 0.0f }, 0 },
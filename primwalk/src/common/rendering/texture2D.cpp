@@ -71,6 +71,11 @@ namespace pw {
 		return m_Image->getVulkanImageView();
 	}
 
+	bool Texture2D::isReady() const {
+		GraphicsDevice_Vulkan* device = (GraphicsDevice_Vulkan*&)pw::GetDevice();
+		return device->getUploadManager().isComplete(m_UploadTicket);
+	}
+
 	// NOTE: Might be used some day in the future, for now, let it do nothing
 	void Texture2D::updateData(unsigned char* pixels)
 	{
@@ -140,20 +145,6 @@ namespace pw {
 	void Texture2D::createImage(void* pixels, VkDeviceSize imageSize, VkFormat imageFormat) {
 		GraphicsDevice_Vulkan* device = (GraphicsDevice_Vulkan*&)pw::GetDevice();
 
-		void* data = nullptr;
-		Buffer stagingBuffer = {
-			*device,
-			imageSize,
-			1,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			0
-		};
-
-		stagingBuffer.map(imageSize);
-		stagingBuffer.writeToBuffer(pixels);
-		stagingBuffer.unmap();
-
 		// Vulkan image creation
 		ImageInfo createInfo{};
 		createInfo.width = m_Width;
@@ -165,13 +156,8 @@ namespace pw {
 		createInfo.generateMipMaps = false;
 		m_Image = Image::create(createInfo);
 
-		VkCommandBuffer commandBuffer = device->beginSingleTimeCommands();
-
-		m_Image->transitionLayout(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-		stagingBuffer.copyToImage(commandBuffer, *m_Image);
-		m_Image->transitionLayout(commandBuffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-		device->endSingleTimeCommands(commandBuffer);
+		// The pixels are copied into the staging ring, the caller can free them right away
+		m_UploadTicket = device->getUploadManager().uploadImage(*m_Image, pixels, imageSize);
 	}
 
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 // primwalk
 #include "../../core.hpp"
 #include "image.hpp"
+#include "uploadManager.hpp"
 #include <vulkan/vulkan.h>
 
 // std
@@ -25,6 +26,7 @@ namespace pw {
 		inline int getHeight() const { return m_Height; }
 		Image* getImage() const { return m_Image.get(); }
 		VkImageView getImageView() const;
+		bool isReady() const; // the pixels were uploaded, frames can sample the texture before that already
 		void updateData(unsigned char* pixels);
 
 	private:
@@ -35,6 +37,7 @@ namespace pw {
 		int m_Height = 0;
 		int m_Channels = 0;
 		std::unique_ptr<Image> m_Image;
+		UploadTicket m_UploadTicket = 0;
 	};
 }
 
@@ -0,0 +1,475 @@
+#include "uploadManager.hpp"
+#include "buffer.hpp"
+#include "graphicsDevice_Vulkan.hpp"
+#include "image.hpp"
+
+// std
+#include <cstring>
+#include <stdexcept>
+
+namespace pw {
+
+	UploadManager::UploadManager(GraphicsDevice_Vulkan& device, VkDeviceSize stagingSize) : m_Device(device) {
+		QueueFamilyIndices queueFamilyIndices = m_Device.findPhysicalQueueFamilies();
+		m_DedicatedQueue = m_Device.hasDedicatedTransferQueue();
+		m_GraphicsFamily = queueFamilyIndices.graphicsFamily.value();
+		m_TransferFamily = queueFamilyIndices.transferFamily.value_or(m_GraphicsFamily);
+
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolInfo.queueFamilyIndex = m_TransferFamily;
+
+		if (vkCreateCommandPool(m_Device.getDevice(), &poolInfo, nullptr, &m_CommandPool) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to create upload command pool!");
+		}
+
+		if (m_DedicatedQueue) {
+			poolInfo.queueFamilyIndex = m_GraphicsFamily;
+
+			if (vkCreateCommandPool(m_Device.getDevice(), &poolInfo, nullptr, &m_AcquireCommandPool) != VK_SUCCESS) {
+				throw std::runtime_error("VULKAN ERROR: Failed to create upload command pool!");
+			}
+		}
+
+		m_StagingBuffer = std::make_unique<Buffer>(
+			m_Device,
+			stagingSize,
+			1,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+		m_StagingBuffer->map();
+	}
+
+	UploadManager::~UploadManager() {
+		flush();
+
+		while (!m_SubmittedBatches.empty()) {
+			retireOldestBatch(true);
+		}
+
+		for (auto fence : m_FreeFences) {
+			vkDestroyFence(m_Device.getDevice(), fence, nullptr);
+		}
+
+		for (auto semaphore : m_FreeSemaphores) {
+			vkDestroySemaphore(m_Device.getDevice(), semaphore, nullptr);
+		}
+
+		// Destroying the pools frees their command buffers
+		vkDestroyCommandPool(m_Device.getDevice(), m_CommandPool, nullptr);
+
+		if (m_AcquireCommandPool != VK_NULL_HANDLE) {
+			vkDestroyCommandPool(m_Device.getDevice(), m_AcquireCommandPool, nullptr);
+		}
+
+		m_StagingBuffer.reset();
+	}
+
+	UploadTicket UploadManager::uploadBuffer(Buffer& buffer, const void* data, VkDeviceSize size, VkDeviceSize offset /*= 0*/) {
+		VkDeviceSize stagingOffset = 0;
+		VkBuffer stagingBuffer = allocateStaging(data, size, stagingOffset);
+		Batch& batch = getOpenBatch();
+
+		VkBufferCopy region{};
+		region.srcOffset = stagingOffset;
+		region.dstOffset = offset;
+		region.size = size;
+
+		vkCmdCopyBuffer(batch.commandBuffer, stagingBuffer, buffer.getBuffer(), 1, &region);
+
+		if (m_DedicatedQueue) {
+			VkBufferMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+			barrier.srcQueueFamilyIndex = m_TransferFamily;
+			barrier.dstQueueFamilyIndex = m_GraphicsFamily;
+			barrier.buffer = buffer.getBuffer();
+			barrier.offset = offset;
+			barrier.size = size;
+
+			batch.bufferBarriers.push_back(barrier);
+		}
+
+		return batch.ticket;
+	}
+
+	UploadTicket UploadManager::uploadImage(Image& image, const void* data, VkDeviceSize size) {
+		VkDeviceSize stagingOffset = 0;
+		VkBuffer stagingBuffer = allocateStaging(data, size, stagingOffset);
+		Batch& batch = getOpenBatch();
+
+		VkBufferImageCopy region{};
+		region.bufferOffset = stagingOffset;
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = image.getLayerCount();
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { image.getWidth(), image.getHeight(), image.getDepth() };
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.image = image.getVulkanImage();
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = image.getMipLevels();
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = image.getLayerCount();
+
+		if (m_DedicatedQueue) {
+			// Transfer queues know no shader stages, the image is overwritten as a whole so its contents are discarded
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+			vkCmdPipelineBarrier(
+				batch.commandBuffer,
+				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+				0,
+				0, nullptr,
+				0, nullptr,
+				1, &barrier);
+		}
+		else {
+			image.transitionLayout(batch.commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+		}
+
+		vkCmdCopyBufferToImage(
+			batch.commandBuffer,
+			stagingBuffer,
+			image.getVulkanImage(),
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			1,
+			&region);
+
+		if (m_DedicatedQueue) {
+			// The layout transition is part of the ownership transfer
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			barrier.srcQueueFamilyIndex = m_TransferFamily;
+			barrier.dstQueueFamilyIndex = m_GraphicsFamily;
+
+			batch.imageBarriers.push_back(barrier);
+			image.setLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		}
+		else {
+			image.transitionLayout(batch.commandBuffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		}
+
+		return batch.ticket;
+	}
+
+	void UploadManager::flush() {
+		if (!m_OpenBatch) {
+			return;
+		}
+
+		Batch& batch = *m_OpenBatch;
+
+		if (m_DedicatedQueue) {
+			submitDedicated(batch);
+
+			m_SubmittedBatches.push_back(std::move(batch));
+			m_OpenBatch.reset();
+			return;
+		}
+
+		// Makes the copies visible to everything submitted to the queue afterwards
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+
+		vkCmdPipelineBarrier(
+			batch.commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			0,
+			1, &barrier,
+			0, nullptr,
+			0, nullptr);
+
+		if (vkEndCommandBuffer(batch.commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to record upload command buffer!");
+		}
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &batch.commandBuffer;
+
+		if (vkQueueSubmit(m_Device.getGraphicsQueue(), 1, &submitInfo, batch.fence) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to submit upload batch!");
+		}
+
+		m_SubmittedBatches.push_back(std::move(batch));
+		m_OpenBatch.reset();
+	}
+
+	void UploadManager::update() {
+		while (!m_SubmittedBatches.empty() && vkGetFenceStatus(m_Device.getDevice(), m_SubmittedBatches.front().fence) == VK_SUCCESS) {
+			retireOldestBatch(false);
+		}
+	}
+
+	bool UploadManager::isComplete(UploadTicket ticket) {
+		update();
+		return ticket <= m_CompletedTicket;
+	}
+
+	void UploadManager::wait(UploadTicket ticket) {
+		if (m_OpenBatch && ticket >= m_OpenBatch->ticket) {
+			flush();
+		}
+
+		while (ticket > m_CompletedTicket && !m_SubmittedBatches.empty()) {
+			retireOldestBatch(true);
+		}
+	}
+
+	VkBuffer UploadManager::allocateStaging(const void* data, VkDeviceSize size, VkDeviceSize& offset) {
+		VkDeviceSize capacity = m_StagingBuffer->getBufferSize();
+
+		// Large uploads (e.g. HDR environment maps) would drain the ring, they get a staging buffer of their own
+		if (size > capacity / 2) {
+			auto overflowBuffer = std::make_unique<Buffer>(
+				m_Device,
+				size,
+				1,
+				VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+			overflowBuffer->map();
+			overflowBuffer->writeToBuffer(const_cast<void*>(data));
+
+			VkBuffer buffer = overflowBuffer->getBuffer();
+			getOpenBatch().overflowBuffers.push_back(std::move(overflowBuffer));
+
+			offset = 0;
+			return buffer;
+		}
+
+		uint64_t start = (m_StagingHead + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+
+		// A copy cannot wrap around, the end of the ring is skipped instead
+		if (start % capacity + size > capacity) {
+			start = (start / capacity + 1) * capacity;
+		}
+
+		// Wait until older batches have handed back enough of the ring
+		while (start + size - m_StagingTail > capacity) {
+			if (m_SubmittedBatches.empty() && !m_OpenBatch) {
+				m_StagingTail = start; // nothing in flight, the whole ring is free
+				break;
+			}
+
+			if (m_SubmittedBatches.empty()) {
+				flush();
+			}
+
+			retireOldestBatch(true);
+		}
+
+		offset = start % capacity;
+		memcpy(static_cast<char*>(m_StagingBuffer->getMappedMemory()) + offset, data, size);
+
+		m_StagingHead = start + size;
+		getOpenBatch().stagingEnd = m_StagingHead;
+
+		return m_StagingBuffer->getBuffer();
+	}
+
+	UploadManager::Batch& UploadManager::getOpenBatch() {
+		if (m_OpenBatch) {
+			return *m_OpenBatch;
+		}
+
+		m_OpenBatch = std::make_unique<Batch>();
+		m_OpenBatch->ticket = m_NextTicket++;
+		m_OpenBatch->stagingEnd = m_StagingHead;
+
+		m_OpenBatch->commandBuffer = allocateCommandBuffer(m_CommandPool, m_FreeCommandBuffers);
+
+		if (m_DedicatedQueue) {
+			m_OpenBatch->acquireCommandBuffer = allocateCommandBuffer(m_AcquireCommandPool, m_FreeAcquireCommandBuffers);
+
+			if (!m_FreeSemaphores.empty()) {
+				m_OpenBatch->semaphore = m_FreeSemaphores.back();
+				m_FreeSemaphores.pop_back();
+			}
+			else {
+				VkSemaphoreCreateInfo semaphoreInfo{};
+				semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+				if (vkCreateSemaphore(m_Device.getDevice(), &semaphoreInfo, nullptr, &m_OpenBatch->semaphore) != VK_SUCCESS) {
+					throw std::runtime_error("VULKAN ERROR: Failed to create upload semaphore!");
+				}
+			}
+		}
+
+		if (!m_FreeFences.empty()) {
+			m_OpenBatch->fence = m_FreeFences.back();
+			m_FreeFences.pop_back();
+		}
+		else {
+			VkFenceCreateInfo fenceInfo{};
+			fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+			if (vkCreateFence(m_Device.getDevice(), &fenceInfo, nullptr, &m_OpenBatch->fence) != VK_SUCCESS) {
+				throw std::runtime_error("VULKAN ERROR: Failed to create upload fence!");
+			}
+		}
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		if (vkBeginCommandBuffer(m_OpenBatch->commandBuffer, &beginInfo) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to begin recording upload command buffer!");
+		}
+
+		return *m_OpenBatch;
+	}
+
+	void UploadManager::retireOldestBatch(bool wait) {
+		Batch& batch = m_SubmittedBatches.front();
+
+		if (wait) {
+			vkWaitForFences(m_Device.getDevice(), 1, &batch.fence, VK_TRUE, UINT64_MAX);
+		}
+
+		m_StagingTail = batch.stagingEnd;
+		m_CompletedTicket = batch.ticket;
+
+		vkResetFences(m_Device.getDevice(), 1, &batch.fence);
+		vkResetCommandBuffer(batch.commandBuffer, 0);
+		m_FreeFences.push_back(batch.fence);
+		m_FreeCommandBuffers.push_back(batch.commandBuffer);
+
+		// The acquire waited on the semaphore, which left it unsignaled
+		if (m_DedicatedQueue) {
+			vkResetCommandBuffer(batch.acquireCommandBuffer, 0);
+			m_FreeAcquireCommandBuffers.push_back(batch.acquireCommandBuffer);
+			m_FreeSemaphores.push_back(batch.semaphore);
+		}
+
+		// Frees the overflow staging buffers
+		m_SubmittedBatches.pop_front();
+	}
+
+	void UploadManager::submitDedicated(Batch& batch) {
+		// Release on the transfer queue, the destination access is ignored
+		std::vector<VkBufferMemoryBarrier> bufferBarriers = batch.bufferBarriers;
+		std::vector<VkImageMemoryBarrier> imageBarriers = batch.imageBarriers;
+
+		for (auto& barrier : bufferBarriers) {
+			barrier.dstAccessMask = 0;
+		}
+
+		for (auto& barrier : imageBarriers) {
+			barrier.dstAccessMask = 0;
+		}
+
+		vkCmdPipelineBarrier(
+			batch.commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0,
+			0, nullptr,
+			static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+			static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+
+		if (vkEndCommandBuffer(batch.commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to record upload command buffer!");
+		}
+
+		VkSubmitInfo transferSubmitInfo{};
+		transferSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		transferSubmitInfo.commandBufferCount = 1;
+		transferSubmitInfo.pCommandBuffers = &batch.commandBuffer;
+		transferSubmitInfo.signalSemaphoreCount = 1;
+		transferSubmitInfo.pSignalSemaphores = &batch.semaphore;
+
+		if (vkQueueSubmit(m_Device.getTransferQueue(), 1, &transferSubmitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to submit upload batch!");
+		}
+
+		// Acquire on the graphics queue, the source access is ignored
+		bufferBarriers = batch.bufferBarriers;
+		imageBarriers = batch.imageBarriers;
+
+		for (auto& barrier : bufferBarriers) {
+			barrier.srcAccessMask = 0;
+		}
+
+		for (auto& barrier : imageBarriers) {
+			barrier.srcAccessMask = 0;
+		}
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		if (vkBeginCommandBuffer(batch.acquireCommandBuffer, &beginInfo) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to begin recording upload command buffer!");
+		}
+
+		vkCmdPipelineBarrier(
+			batch.acquireCommandBuffer,
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			0,
+			0, nullptr,
+			static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+			static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+
+		if (vkEndCommandBuffer(batch.acquireCommandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to record upload command buffer!");
+		}
+
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+		VkSubmitInfo acquireSubmitInfo{};
+		acquireSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		acquireSubmitInfo.waitSemaphoreCount = 1;
+		acquireSubmitInfo.pWaitSemaphores = &batch.semaphore;
+		acquireSubmitInfo.pWaitDstStageMask = &waitStage;
+		acquireSubmitInfo.commandBufferCount = 1;
+		acquireSubmitInfo.pCommandBuffers = &batch.acquireCommandBuffer;
+
+		if (vkQueueSubmit(m_Device.getGraphicsQueue(), 1, &acquireSubmitInfo, batch.fence) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to submit upload batch!");
+		}
+	}
+
+	VkCommandBuffer UploadManager::allocateCommandBuffer(VkCommandPool commandPool, std::vector<VkCommandBuffer>& freeCommandBuffers) {
+		if (!freeCommandBuffers.empty()) {
+			VkCommandBuffer commandBuffer = freeCommandBuffers.back();
+			freeCommandBuffers.pop_back();
+
+			return commandBuffer;
+		}
+
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = commandPool;
+		allocInfo.commandBufferCount = 1;
+
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+
+		if (vkAllocateCommandBuffers(m_Device.getDevice(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("VULKAN ERROR: Failed to allocate upload command buffer!");
+		}
+
+		return commandBuffer;
+	}
+
+}
\ No newline at end of file
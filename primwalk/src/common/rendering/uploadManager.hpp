@@ -0,0 +1,99 @@
+#pragma once
+
+// primwalk
+#include "../../core.hpp"
+
+// std
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+// vendor
+#include <vulkan/vulkan.h>
+
+namespace pw {
+	// Forward declarations
+	class Buffer;
+	class GraphicsDevice_Vulkan;
+	class Image;
+
+	// Identifies the batch an upload went into, tickets of later batches are always larger
+	using UploadTicket = uint64_t;
+
+	/*
+	* Streams data into device local buffers and images without stalling the CPU. The data is copied into a
+	* persistently mapped staging ring right away, the copies are recorded into the open batch and submitted together
+	* by flush(), which the renderer calls before submitting a frame. Every batch signals a fence, completed batches
+	* hand their part of the ring back. Frames submitted afterwards see the data without waiting on the ticket, the
+	* tickets are for code reading the data on the CPU or destroying the destination. Main thread only.
+	*
+	* With a dedicated transfer queue the copies run there and end in queue family ownership releases. A small
+	* submission on the graphics queue waits on the batch's semaphore and acquires the resources, only that one (and
+	* not the copies) is ordered before the frame. Without one the copies go through the graphics queue.
+	*/
+	class PW_API UploadManager {
+	public:
+		UploadManager(GraphicsDevice_Vulkan& device, VkDeviceSize stagingSize = DEFAULT_STAGING_SIZE);
+		~UploadManager();
+
+		// Forbid copy and move semantics
+		UploadManager(const UploadManager&) = delete;
+		UploadManager& operator=(const UploadManager&) = delete;
+
+		// The data can be freed once these return, the destination has to stay alive until the upload completed
+		UploadTicket uploadBuffer(Buffer& buffer, const void* data, VkDeviceSize size, VkDeviceSize offset = 0);
+		UploadTicket uploadImage(Image& image, const void* data, VkDeviceSize size); // ends in SHADER_READ_ONLY_OPTIMAL
+
+		void flush(); // submits the open batch, if anything was recorded into it
+		void update(); // hands back the staging memory of completed batches
+		bool isComplete(UploadTicket ticket);
+		void wait(UploadTicket ticket); // submits the ticket's batch first if necessary
+
+		static constexpr VkDeviceSize DEFAULT_STAGING_SIZE = 32ull * 1024 * 1024;
+		static constexpr VkDeviceSize STAGING_ALIGNMENT = 16; // covers the texel size of every uploaded format
+
+	private:
+		struct Batch {
+			UploadTicket ticket = 0;
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			VkFence fence = VK_NULL_HANDLE; // signaled by the last submission of the batch
+
+			// Dedicated transfer queue only
+			VkCommandBuffer acquireCommandBuffer = VK_NULL_HANDLE; // graphics queue
+			VkSemaphore semaphore = VK_NULL_HANDLE; // copies done, signaled on the transfer queue
+			std::vector<VkBufferMemoryBarrier> bufferBarriers; // ownership transfers, recorded as release and acquire
+			std::vector<VkImageMemoryBarrier> imageBarriers;
+
+			uint64_t stagingEnd = 0; // ring position after the last copy of the batch
+			std::vector<std::unique_ptr<Buffer>> overflowBuffers; // uploads that do not fit into the ring
+		};
+
+		VkBuffer allocateStaging(const void* data, VkDeviceSize size, VkDeviceSize& offset);
+		Batch& getOpenBatch();
+		void retireOldestBatch(bool wait);
+		void submitDedicated(Batch& batch);
+		VkCommandBuffer allocateCommandBuffer(VkCommandPool commandPool, std::vector<VkCommandBuffer>& freeCommandBuffers);
+
+		GraphicsDevice_Vulkan& m_Device;
+		bool m_DedicatedQueue = false;
+		uint32_t m_GraphicsFamily = 0;
+		uint32_t m_TransferFamily = 0;
+		VkCommandPool m_CommandPool = VK_NULL_HANDLE; // transfer queue family
+		VkCommandPool m_AcquireCommandPool = VK_NULL_HANDLE; // graphics queue family, dedicated transfer queue only
+
+		// Ring positions are counted up forever, the offset into the buffer is the position modulo its size
+		std::unique_ptr<Buffer> m_StagingBuffer;
+		uint64_t m_StagingHead = 0;
+		uint64_t m_StagingTail = 0; // start of the oldest batch still in flight
+
+		std::unique_ptr<Batch> m_OpenBatch;
+		std::deque<Batch> m_SubmittedBatches; // in submission order
+		std::vector<VkCommandBuffer> m_FreeCommandBuffers;
+		std::vector<VkCommandBuffer> m_FreeAcquireCommandBuffers;
+		std::vector<VkFence> m_FreeFences;
+		std::vector<VkSemaphore> m_FreeSemaphores;
+		UploadTicket m_NextTicket = 1;
+		UploadTicket m_CompletedTicket = 0;
+	};
+}
@@ -0,0 +1,59 @@
+#include "vertex3d.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+
+namespace pw {
+
+	namespace {
+		glm::vec2 signNotZero(const glm::vec2& v) {
+			return glm::vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+		}
+
+		// NOTE: Must match octEncode() in packing.glsl
+		glm::vec2 octEncode(const glm::vec3& n) {
+			glm::vec2 p = glm::vec2(n.x, n.y) * (1.0f / (std::abs(n.x) + std::abs(n.y) + std::abs(n.z)));
+
+			if (n.z <= 0.0f) {
+				p = (1.0f - glm::abs(glm::vec2(p.y, p.x))) * signNotZero(p);
+			}
+
+			return p;
+		}
+
+		int16_t toSnorm16(float value) {
+			return static_cast<int16_t>(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+		}
+	}
+
+	Vertex3D Vertex3D::pack(const glm::vec3& normal, const glm::vec3& tangent, const glm::vec3& bitangent, const glm::vec2& texCoord) {
+		glm::vec3 n = glm::normalize(normal);
+
+		// Gram-Schmidt, the shader assumes an orthonormal frame
+		glm::vec3 t = tangent - n * glm::dot(n, tangent);
+
+		if (glm::dot(t, t) < 1e-12f) {
+			t = glm::cross(n, std::abs(n.x) > 0.9f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f));
+		}
+
+		t = glm::normalize(t);
+		float bitangentSign = glm::dot(glm::cross(n, t), bitangent) < 0.0f ? -1.0f : 1.0f;
+
+		glm::vec2 encodedNormal = octEncode(n);
+		glm::vec2 encodedTangent = octEncode(t);
+
+		// Remap y to [0, 1] so it can carry the sign, never zero or the sign would be lost
+		float tangentY = std::max(encodedTangent.y * 0.5f + 0.5f, 1.0f / 32767.0f);
+
+		Vertex3D vertex{};
+		vertex.normal[0] = toSnorm16(encodedNormal.x);
+		vertex.normal[1] = toSnorm16(encodedNormal.y);
+		vertex.tangent[0] = toSnorm16(encodedTangent.x);
+		vertex.tangent[1] = toSnorm16(tangentY * bitangentSign);
+		vertex.texCoord = texCoord;
+
+		return vertex;
+	}
+
+}
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "../../core.hpp"
 
 // std
+#include <cstdint>
 #include <vector>
 
 // vendor
@@ -11,31 +12,47 @@
 #include <vulkan/vulkan.h>
 
 namespace pw {
+	/*
+	* Compact mesh vertex, split into two streams. Binding 0 holds the positions (12 bytes) so depth-only passes
+	* fetch nothing else, binding 1 holds this struct (16 bytes). Normal and tangent are octahedral encoded as
+	* SNORM16 and the bitangent is rebuilt in the shader from their cross product and a sign stored in the
+	* tangent, see decodeTangentFrame() in packing.glsl.
+	*/
 	struct PW_API Vertex3D {
-		alignas(16) glm::vec3 position;
-		alignas(16) glm::vec3 normal;
-		alignas(16) glm::vec3 tangent;
-		alignas(16) glm::vec3 bitangent;
-		alignas(8) glm::vec2 texCoord;
+		int16_t normal[2];
+		int16_t tangent[2]; // sign of y is the bitangent sign
+		glm::vec2 texCoord;
+
+		// A zero tangent (mesh without texture coordinates) is replaced by any vector perpendicular to the normal
+		static Vertex3D pack(const glm::vec3& normal, const glm::vec3& tangent, const glm::vec3& bitangent, const glm::vec2& texCoord);
 
 		static std::vector<VkVertexInputBindingDescription> getBindingDescriptions() {
-			std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
+			std::vector<VkVertexInputBindingDescription> bindingDescriptions = getPositionBindingDescriptions();
 
-			bindingDescriptions.push_back({ 0, sizeof(Vertex3D), VK_VERTEX_INPUT_RATE_VERTEX });
+			bindingDescriptions.push_back({ 1, sizeof(Vertex3D), VK_VERTEX_INPUT_RATE_VERTEX });
 
 			return bindingDescriptions;
 		}
 
 		static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions() {
-			std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+			std::vector<VkVertexInputAttributeDescription> attributeDescriptions = getPositionAttributeDescriptions();
 
-			attributeDescriptions.push_back({ 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex3D, position) });
-			attributeDescriptions.push_back({ 1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex3D, normal) });
-			attributeDescriptions.push_back({ 2, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex3D, tangent) });
-			attributeDescriptions.push_back({ 3, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex3D, bitangent) });
-			attributeDescriptions.push_back({ 4, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex3D, texCoord) });
+			attributeDescriptions.push_back({ 1, 1, VK_FORMAT_R16G16_SNORM, offsetof(Vertex3D, normal) });
+			attributeDescriptions.push_back({ 2, 1, VK_FORMAT_R16G16_SNORM, offsetof(Vertex3D, tangent) });
+			attributeDescriptions.push_back({ 3, 1, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex3D, texCoord) });
 
 			return attributeDescriptions;
 		}
+
+		// Position stream only, for depth-only passes
+		static std::vector<VkVertexInputBindingDescription> getPositionBindingDescriptions() {
+			return { { 0, sizeof(glm::vec3), VK_VERTEX_INPUT_RATE_VERTEX } };
+		}
+
+		static std::vector<VkVertexInputAttributeDescription> getPositionAttributeDescriptions() {
+			return { { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0 } };
+		}
 	};
+
+	static_assert(sizeof(Vertex3D) == 16, "Vertex3D must match the Vertex struct in visibilityResolve.frag");
 }
\ No newline at end of file